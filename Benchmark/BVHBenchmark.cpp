@@ -0,0 +1,186 @@
+#include "BenchmarkUtil.h"
+#include "Core/DataStructure/BVH.h"
+
+#include <random>
+#include <vector>
+
+// Compares BVH build / query cost with a brute-force scan over the same boxes.
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	constexpr float WORLD_HALF_SIZE = 1000.f;
+	constexpr uint32_t QUERY_COUNT = 1000;
+	constexpr uint32_t RAY_COUNT = 10000;
+
+	std::vector<Box> GenerateBoxes(size_t count, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> pos(-WORLD_HALF_SIZE, WORLD_HALF_SIZE);
+		std::uniform_real_distribution<float> size(0.5f, 10.f);
+		std::vector<Box> boxes(count);
+		for (Box& box : boxes)
+		{
+			Vector3 center(pos(rng), pos(rng), pos(rng));
+			Vector3 extent(size(rng), size(rng), size(rng));
+			box = Box(center - extent, center + extent);
+		}
+		return boxes;
+	}
+
+	float IntersectRayBox(const Vector3& origin, const Vector3& dir, float maxDistance, const Box& box)
+	{
+		const float o[3] = { origin.x, origin.y, origin.z };
+		const float d[3] = { dir.x, dir.y, dir.z };
+		const float bmin[3] = { box.GetMin().x, box.GetMin().y, box.GetMin().z };
+		const float bmax[3] = { box.GetMax().x, box.GetMax().y, box.GetMax().z };
+		float tmin = 0.f, tmax = maxDistance;
+		for (int i = 0; i < 3; ++i)
+		{
+			float inv = 1.f / (IsZero(d[i]) ? EPISILON : d[i]);
+			float t0 = (bmin[i] - o[i]) * inv;
+			float t1 = (bmax[i] - o[i]) * inv;
+			if (t0 > t1)
+				std::swap(t0, t1);
+			tmin = Max(tmin, t0);
+			tmax = Min(tmax, t1);
+		}
+		return tmin <= tmax ? tmin : MAX_NUM;
+	}
+
+	Frustum MakeFrustum(const Vector3& eye)
+	{
+		Matrix4x3 view;
+		view.SetTranslation(-eye);
+		const float n = 0.1f, f = 800.f, h = 1.f / std::tan(DegreeToRadian(45.f) * 0.5f);
+		Matrix4x4 proj(
+			h, 0, 0, 0,
+			0, h, 0, 0,
+			0, 0, f / (n - f), -1,
+			0, 0, -(f * n) / (f - n), 0
+		);
+		return Frustum(view, proj);
+	}
+
+	void RunCase(size_t count, std::mt19937& rng)
+	{
+		std::vector<Box> boxes = GenerateBoxes(count, rng);
+
+		BVH bvh;
+		Timer timer;
+		bvh.Build(boxes, 1);
+		Report("bvh", "build_single_thread", count, "ms", timer.ElapsedMs());
+
+		timer.Reset();
+		bvh.Build(boxes);
+		Report("bvh", "build_parallel", count, "ms", timer.ElapsedMs());
+		Report("bvh", "node_count", count, "nodes", bvh.GetNodeCount());
+
+		timer.Reset();
+		bvh.Refit(boxes);
+		Report("bvh", "refit", count, "ms", timer.ElapsedMs());
+
+		std::uniform_real_distribution<float> pos(-WORLD_HALF_SIZE, WORLD_HALF_SIZE);
+		std::vector<Box> queries(QUERY_COUNT);
+		for (Box& query : queries)
+		{
+			Vector3 center(pos(rng), pos(rng), pos(rng));
+			query = Box(center - Vector3(50.f), center + Vector3(50.f));
+		}
+
+		// box query
+		std::vector<uint32_t> result;
+		size_t bvhHits = 0, bruteHits = 0;
+		timer.Reset();
+		for (const Box& query : queries)
+		{
+			result.clear();
+			bvh.Query(query, result);
+			bvhHits += result.size();
+		}
+		Report("bvh", "box_query", count, "queries_per_ms", QUERY_COUNT / timer.ElapsedMs());
+
+		timer.Reset();
+		for (const Box& query : queries)
+		{
+			for (const Box& box : boxes)
+				bruteHits += query.Intersect(box) ? 1 : 0;
+		}
+		Report("brute", "box_query", count, "queries_per_ms", QUERY_COUNT / timer.ElapsedMs());
+		Check("bvh", "box_query_match", count, bvhHits == bruteHits);
+
+		// frustum query
+		std::vector<Frustum> frustums;
+		for (uint32_t i = 0; i < QUERY_COUNT / 10; ++i)
+			frustums.push_back(MakeFrustum(Vector3(pos(rng), pos(rng), pos(rng))));
+
+		bvhHits = bruteHits = 0;
+		timer.Reset();
+		for (const Frustum& frustum : frustums)
+		{
+			result.clear();
+			bvh.Query(frustum, result);
+			bvhHits += result.size();
+		}
+		Report("bvh", "frustum_query", count, "queries_per_ms", frustums.size() / timer.ElapsedMs());
+
+		timer.Reset();
+		for (const Frustum& frustum : frustums)
+		{
+			for (const Box& box : boxes)
+				bruteHits += frustum.Intersect(box) ? 1 : 0;
+		}
+		Report("brute", "frustum_query", count, "queries_per_ms", frustums.size() / timer.ElapsedMs());
+		Check("bvh", "frustum_query_match", count, bvhHits == bruteHits);
+
+		// nearest ray hit
+		std::uniform_real_distribution<float> dir(-1.f, 1.f);
+		std::vector<std::pair<Vector3, Vector3>> rays(RAY_COUNT);
+		for (auto& ray : rays)
+		{
+			Vector3 d(dir(rng), dir(rng), dir(rng));
+			d.Normalize();
+			ray = { Vector3(pos(rng), pos(rng), pos(rng)), d };
+		}
+
+		std::vector<uint32_t> bvhRayHits(RAY_COUNT);
+		timer.Reset();
+		for (uint32_t i = 0; i < RAY_COUNT; ++i)
+			bvhRayHits[i] = bvh.Raycast(rays[i].first, rays[i].second, 4 * WORLD_HALF_SIZE);
+		Report("bvh", "raycast", count, "rays_per_ms", RAY_COUNT / timer.ElapsedMs());
+
+		// brute force only on a subset for the large cases
+		const uint32_t bruteRays = count > 10000 ? RAY_COUNT / 10 : RAY_COUNT;
+		uint32_t mismatches = 0;
+		timer.Reset();
+		for (uint32_t i = 0; i < bruteRays; ++i)
+		{
+			float best = 4 * WORLD_HALF_SIZE;
+			uint32_t bestIndex = BVH::INVALID_INDEX;
+			for (uint32_t j = 0; j < count; ++j)
+			{
+				float t = IntersectRayBox(rays[i].first, rays[i].second, best, boxes[j]);
+				if (t < best)
+				{
+					best = t;
+					bestIndex = j;
+				}
+			}
+			mismatches += bestIndex != bvhRayHits[i] ? 1 : 0;
+		}
+		Report("brute", "raycast", count, "rays_per_ms", bruteRays / timer.ElapsedMs());
+		Check("bvh", "raycast_match", count, mismatches == 0);
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(20221017);
+	ReportHeader();
+	for (size_t count : { 1000, 10000, 100000 })
+	{
+		RunCase(count, rng);
+	}
+	return ExitCode();
+}
\ No newline at end of file
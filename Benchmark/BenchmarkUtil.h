@@ -0,0 +1,97 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+
+namespace zyh
+{
+	namespace Benchmark
+	{
+		class Timer
+		{
+		public:
+			Timer() : mStart_(std::chrono::high_resolution_clock::now()) {}
+			void Reset() { mStart_ = std::chrono::high_resolution_clock::now(); }
+			double ElapsedMs() const
+			{
+				return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - mStart_).count();
+			}
+
+		private:
+			std::chrono::high_resolution_clock::time_point mStart_;
+		};
+
+		// keep the compiler from removing a computed value: it has to exist in memory here
+#if defined(_MSC_VER)
+		template<typename T>
+		inline void DoNotOptimize(const T& value)
+		{
+			_ReadWriteBarrier();
+			const char first = *reinterpret_cast<const volatile char*>(&value);
+			(void)first;
+			_ReadWriteBarrier();
+		}
+#else
+		template<typename T>
+		inline void DoNotOptimize(const T& value)
+		{
+			asm volatile("" : : "m"(value) : "memory");
+		}
+#endif
+
+		// one csv row per measurement: suite,case,count,metric,value
+		inline void ReportHeader()
+		{
+			std::printf("suite,case,count,metric,value\n");
+		}
+
+		inline void Report(const std::string& suite, const std::string& name, size_t count, const std::string& metric, double value)
+		{
+			std::printf("%s,%s,%zu,%s,%.6f\n", suite.c_str(), name.c_str(), count, metric.c_str(), value);
+			std::fflush(stdout);
+		}
+
+		inline uint32_t& FailedChecks()
+		{
+			static uint32_t failed = 0;
+			return failed;
+		}
+
+		// reported as a bool row, a failure is also printed to stderr and makes ExitCode() nonzero
+		inline bool Check(const std::string& suite, const std::string& name, size_t count, bool passed)
+		{
+			Report(suite, name, count, "bool", passed ? 1.0 : 0.0);
+			if (!passed)
+			{
+				++FailedChecks();
+				std::fprintf(stderr, "check failed: %s,%s,%zu\n", suite.c_str(), name.c_str(), count);
+			}
+			return passed;
+		}
+
+		// reported as an error row, fails above tolerance
+		inline bool CheckError(const std::string& suite, const std::string& name, size_t count, const std::string& metric, double error, double tolerance)
+		{
+			Report(suite, name, count, metric, error);
+			// written so a NaN error fails too
+			const bool passed = error <= tolerance;
+			if (!passed)
+			{
+				++FailedChecks();
+				std::fprintf(stderr, "check failed: %s,%s,%zu %s %g above %g\n", suite.c_str(), name.c_str(), count, metric.c_str(), error, tolerance);
+			}
+			return passed;
+		}
+
+		// returned from main, so a regression fails the run
+		inline int ExitCode()
+		{
+			return FailedChecks() == 0 ? 0 : 1;
+		}
+	}
+}
\ No newline at end of file
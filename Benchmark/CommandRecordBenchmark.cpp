@@ -0,0 +1,233 @@
+#include "BenchmarkUtil.h"
+#include "Core/JobSystem.h"
+#include "Graphics/Common/DrawBindFilter.h"
+
+#include <random>
+#include <vector>
+
+// CPU side of VulkanRenderPass recording a sorted draw list: everything into one command stream
+// on the calling thread, against chunks recorded through JobSystem::ParallelFor into per slot
+// streams the way secondary command buffers are. Binds go through FilterDrawBinds, the filter
+// VulkanRenderElement::_bindState uses, and are encoded into plain words instead of calling the
+// driver. Replaying the chunks in order must give the serial draws, and no bind may be redundant.
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	constexpr uint32_t FRAME_COUNT = 50;
+	constexpr size_t MIN_CHUNK = 64;
+
+	enum Command : uint32_t
+	{
+		SET_DYNAMIC_STATE,
+		BIND_PIPELINE,
+		BIND_DESCRIPTOR_SET,
+		BIND_VERTEX_BUFFER,
+		BIND_INDEX_BUFFER,
+		PUSH_UNIFORMS,
+		DRAW_INDEXED,
+	};
+
+	// handles are plain ids here, 0 is the null handle
+	using FakeBindings = DrawBindings<uint32_t, uint32_t, uint32_t, uint32_t>;
+	using DrawState = DrawBindState<uint32_t, uint32_t, uint32_t, uint32_t>;
+
+	struct FakeDraw
+	{
+		FakeBindings Bindings;
+		uint32_t IndexCount;
+		float Model[16];
+	};
+
+	void Emit(std::vector<uint32_t>& stream, Command command, uint32_t value)
+	{
+		stream.push_back(command);
+		stream.push_back(value);
+	}
+
+	struct StreamRecorder
+	{
+		std::vector<uint32_t>& Stream;
+
+		void SetDynamicState() { Emit(Stream, SET_DYNAMIC_STATE, 0); }
+		void BindPipeline(uint32_t pipeline) { Emit(Stream, BIND_PIPELINE, pipeline); }
+		// the layout follows the pipeline here, only the set is replayed
+		void BindDescriptorSet(uint32_t, uint32_t set) { Emit(Stream, BIND_DESCRIPTOR_SET, set); }
+		void BindVertexBuffer(uint32_t buffer) { Emit(Stream, BIND_VERTEX_BUFFER, buffer); }
+		void BindIndexBuffer(uint32_t buffer) { Emit(Stream, BIND_INDEX_BUFFER, buffer); }
+	};
+
+	void Record(std::vector<uint32_t>& stream, const std::vector<FakeDraw>& draws, size_t begin, size_t end, DrawState& state)
+	{
+		StreamRecorder recorder{ stream };
+		for (size_t i = begin; i < end; ++i)
+		{
+			const FakeDraw& draw = draws[i];
+			FilterDrawBinds(draw.Bindings, state, recorder);
+			stream.push_back(PUSH_UNIFORMS);
+			for (float value : draw.Model)
+				stream.push_back(uint32_t(value * 1024.f));
+			Emit(stream, DRAW_INDEXED, draw.IndexCount);
+		}
+	}
+
+	// binds a recording without redundant ones needs: every change of state, plus every draw of a set
+	// with dynamic offsets
+	uint32_t CountNeededBinds(const std::vector<FakeDraw>& draws)
+	{
+		uint32_t binds = 0;
+		const FakeBindings* last = nullptr;
+		for (const FakeDraw& draw : draws)
+		{
+			const FakeBindings& bindings = draw.Bindings;
+			binds += !last || last->Pipeline != bindings.Pipeline;
+			binds += !last || bindings.HasDynamicOffsets || last->DescriptorSet != bindings.DescriptorSet || last->PipelineLayout != bindings.PipelineLayout;
+			binds += !last || last->VertexBuffer != bindings.VertexBuffer;
+			binds += !last || last->IndexBuffer != bindings.IndexBuffer;
+			last = &bindings;
+		}
+		return binds;
+	}
+
+	uint32_t GetBinds(const DrawState& state)
+	{
+		return state.Stats.GetBinds() - state.Stats.DynamicStateSets;
+	}
+
+	struct ReplayedDraw
+	{
+		uint32_t Pipeline, DescriptorSet, VertexBuffer, IndexBuffer, IndexCount;
+		bool operator==(const ReplayedDraw&) const = default;
+	};
+
+	// what the GPU sees: every draw with the state bound at that point, state starts empty per stream
+	void Replay(const std::vector<uint32_t>& stream, std::vector<ReplayedDraw>& out)
+	{
+		ReplayedDraw current{ 0, 0, 0, 0, 0 };
+		for (size_t i = 0; i < stream.size();)
+		{
+			const uint32_t command = stream[i++];
+			if (command == PUSH_UNIFORMS)
+			{
+				i += 16;
+				continue;
+			}
+			const uint32_t value = stream[i++];
+			switch (command)
+			{
+			case BIND_PIPELINE: current.Pipeline = value; break;
+			case BIND_DESCRIPTOR_SET: current.DescriptorSet = value; break;
+			case BIND_VERTEX_BUFFER: current.VertexBuffer = value; break;
+			case BIND_INDEX_BUFFER: current.IndexBuffer = value; break;
+			case DRAW_INDEXED: current.IndexCount = value; out.push_back(current); break;
+			default: break;
+			}
+		}
+	}
+
+	std::vector<FakeDraw> MakeDraws(size_t count)
+	{
+		// already sorted by pipeline then descriptor set, like mSortItems_. ids start at 1, 0 is null
+		std::mt19937 rng(7);
+		std::vector<FakeDraw> draws(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			FakeDraw& draw = draws[i];
+			FakeBindings& bindings = draw.Bindings;
+			bindings.Pipeline = 1 + uint32_t(i * 8 / count);
+			bindings.PipelineLayout = bindings.Pipeline;
+			bindings.DescriptorSet = 1 + uint32_t(i / 4);
+			// one pipeline in four takes per object uniforms at dynamic offsets
+			bindings.HasDynamicOffsets = bindings.Pipeline % 4 == 0;
+			bindings.VertexBuffer = 1 + rng() % 32;
+			bindings.IndexBuffer = bindings.VertexBuffer;
+			draw.IndexCount = 36 + rng() % 1000;
+			for (int k = 0; k < 16; ++k)
+				draw.Model[k] = float(rng() % 1000) / 100.f;
+		}
+		return draws;
+	}
+
+	std::vector<uint32_t> ThreadCounts()
+	{
+		const uint32_t hardware = Max(std::thread::hardware_concurrency(), 1u);
+		std::vector<uint32_t> counts;
+		for (uint32_t count = 1; count < hardware; count *= 2)
+			counts.push_back(count);
+		counts.push_back(hardware);
+		return counts;
+	}
+
+	void Run(size_t drawCount)
+	{
+		const std::vector<FakeDraw> draws = MakeDraws(drawCount);
+
+		std::vector<uint32_t> serialStream;
+		DrawState serialState;
+		{
+			Timer timer;
+			for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				serialStream.clear();
+				serialState = DrawState{};
+				Record(serialStream, draws, 0, drawCount, serialState);
+				DoNotOptimize(serialStream);
+			}
+			Report("command_record", "inline", drawCount, "us_per_frame", timer.ElapsedMs() * 1000.0 / FRAME_COUNT);
+			Report("command_record", "inline", drawCount, "binds", double(GetBinds(serialState)));
+			Check("command_record", "inline_binds_needed", drawCount, GetBinds(serialState) == CountNeededBinds(draws));
+		}
+		std::vector<ReplayedDraw> expected;
+		Replay(serialStream, expected);
+
+		for (uint32_t threadCount : ThreadCounts())
+		{
+			JobSystem jobs(threadCount);
+			// one stream per slot, kept across frames like the pooled secondary buffers
+			const size_t chunkCount = Min((drawCount + MIN_CHUNK - 1) / MIN_CHUNK, size_t(jobs.GetThreadCount()));
+			const size_t chunkSize = (drawCount + chunkCount - 1) / chunkCount;
+			std::vector<std::vector<uint32_t>> streams(chunkCount);
+			std::vector<size_t> binds(chunkCount);
+
+			Timer timer;
+			for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				jobs.ParallelFor(0, chunkCount, 1, [&](size_t first, size_t last)
+					{
+						for (size_t chunk = first; chunk < last; ++chunk)
+						{
+							streams[chunk].clear();
+							DrawState state;
+							const size_t begin = chunk * chunkSize;
+							Record(streams[chunk], draws, begin, Min(begin + chunkSize, drawCount), state);
+							binds[chunk] = GetBinds(state);
+						}
+					});
+				DoNotOptimize(streams);
+			}
+			const double elapsed = timer.ElapsedMs();
+			size_t totalBinds = 0;
+			for (size_t chunkBinds : binds)
+				totalBinds += chunkBinds;
+			const std::string name = "secondary_t" + std::to_string(threadCount);
+			Report("command_record", name, drawCount, "us_per_frame", elapsed * 1000.0 / FRAME_COUNT);
+			Report("command_record", name, drawCount, "binds", double(totalBinds));
+
+			// executed in chunk order, the draws and their bound state equal the inline recording
+			std::vector<ReplayedDraw> replayed;
+			for (const auto& stream : streams)
+				Replay(stream, replayed);
+			Check("command_record", "match_t" + std::to_string(threadCount), drawCount, replayed == expected);
+		}
+	}
+}
+
+int main()
+{
+	ReportHeader();
+	for (size_t count : { 256, 4096, 65536 })
+		Run(count);
+	return ExitCode();
+}
\ No newline at end of file
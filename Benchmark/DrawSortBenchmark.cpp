@@ -0,0 +1,101 @@
+#include "BenchmarkUtil.h"
+#include "Graphics/Common/DrawSortKey.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+// Radix sort of DrawSortKey against std::stable_sort, and the state changes a pass binds when
+// draws are recorded in insertion order against sorted by key.
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	constexpr uint32_t REPEAT = 50;
+	constexpr uint32_t PIPELINE_COUNT = 8;
+	constexpr uint32_t MATERIAL_COUNT = 64;
+
+	struct FakeDraw
+	{
+		uint32_t Set;
+		uint32_t Pipeline;
+		uint32_t Material;
+		uint32_t DescriptorSet;
+		float Depth;
+	};
+
+	// state changes between consecutive draws, what the filtered VulkanRenderElement::draw binds
+	uint32_t CountBinds(const std::vector<FakeDraw>& draws, const std::vector<DrawSortItem>& order)
+	{
+		uint32_t binds = 0;
+		const FakeDraw* last = nullptr;
+		for (const DrawSortItem& item : order)
+		{
+			const FakeDraw& draw = draws[item.Index];
+			binds += !last || last->Pipeline != draw.Pipeline;
+			binds += !last || last->DescriptorSet != draw.DescriptorSet;
+			last = &draw;
+		}
+		return binds;
+	}
+
+	void Run(size_t drawCount)
+	{
+		std::mt19937 rng(7);
+		std::vector<FakeDraw> draws(drawCount);
+		std::vector<DrawSortItem> items(drawCount);
+		for (size_t i = 0; i < drawCount; ++i)
+		{
+			FakeDraw& draw = draws[i];
+			draw.Set = uint32_t(rng() % 2);
+			draw.Material = uint32_t(rng() % MATERIAL_COUNT);
+			draw.Pipeline = draw.Material % PIPELINE_COUNT;
+			// materials share a descriptor set by groups of four
+			draw.DescriptorSet = draw.Material / 4;
+			draw.Depth = 1.f + float(rng() % 100000) * 0.01f;
+			items[i] = DrawSortItem{ DrawSortKey::Make(draw.Set, draw.Pipeline, draw.Material, draw.DescriptorSet, DrawSortKey::QuantizeDepth(draw.Depth)), uint32_t(i) };
+		}
+
+		std::vector<DrawSortItem> stableSorted;
+		{
+			Timer timer;
+			for (uint32_t i = 0; i < REPEAT; ++i)
+			{
+				stableSorted = items;
+				std::stable_sort(stableSorted.begin(), stableSorted.end(), [](const DrawSortItem& a, const DrawSortItem& b) { return a.Key < b.Key; });
+			}
+			Report("draw_sort", "stable_sort", drawCount, "us_per_sort", timer.ElapsedMs() * 1000.0 / REPEAT);
+		}
+		std::vector<DrawSortItem> radixSorted;
+		std::vector<DrawSortItem> scratch;
+		{
+			Timer timer;
+			for (uint32_t i = 0; i < REPEAT; ++i)
+			{
+				radixSorted = items;
+				RadixSortDrawItems(radixSorted, scratch);
+			}
+			Report("draw_sort", "radix_sort", drawCount, "us_per_sort", timer.ElapsedMs() * 1000.0 / REPEAT);
+		}
+
+		bool match = radixSorted.size() == stableSorted.size();
+		for (size_t i = 0; match && i < radixSorted.size(); ++i)
+		{
+			match = radixSorted[i].Key == stableSorted[i].Key && radixSorted[i].Index == stableSorted[i].Index;
+		}
+		Check("draw_sort", "match", drawCount, match);
+
+		Report("draw_sort", "insertion_order", drawCount, "binds", CountBinds(draws, items));
+		Report("draw_sort", "sorted", drawCount, "binds", CountBinds(draws, radixSorted));
+	}
+}
+
+int main()
+{
+	ReportHeader();
+	for (size_t count : { 256, 1024, 4096, 65536 })
+		Run(count);
+	return ExitCode();
+}
\ No newline at end of file
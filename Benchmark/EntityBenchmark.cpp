@@ -0,0 +1,233 @@
+#include "BenchmarkUtil.h"
+#include "Core/ECS/EntityRegistry.h"
+#include "Core/DataStructure/SlotMap.h"
+#include "Core/JobSystem.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+// Ticks N entities through the old object layout (entity -> heap components -> virtual Tick)
+// and through EntityRegistry systems over packed component arrays.
+// Both are also ticked across all hardware threads the way ClientScene::DispatchTickEvent does.
+// Also compares scene registration (std::find over a vector vs SlotMap handles).
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	constexpr uint32_t FRAME_COUNT = 60;
+	constexpr float DELTA_TIME = 1.f / 60.f;
+	// both sides run the same float operations per entity
+	constexpr double TICK_TOLERANCE = 1e-6;
+
+	struct Position { float x, y, z; };
+	struct Velocity { float x, y, z; };
+	struct Lifetime { float Remaining; };
+
+	// same shape as IEntity / IComponent
+	class ObjectComponent
+	{
+	public:
+		virtual ~ObjectComponent() {}
+		virtual bool IsTickable() { return true; }
+		virtual void Tick(float deltaTime) = 0;
+	};
+
+	class ObjectEntity
+	{
+	public:
+		void Tick(float deltaTime)
+		{
+			for (auto& comp : mComponents_)
+			{
+				if (comp->IsTickable())
+					comp->Tick(deltaTime);
+			}
+		}
+		std::vector<std::unique_ptr<ObjectComponent>> mComponents_;
+		Position mPosition_{};
+	};
+
+	class MovementComponent : public ObjectComponent
+	{
+	public:
+		MovementComponent(ObjectEntity* owner, const Velocity& velocity) : mOwner_(owner), mVelocity_(velocity) {}
+		virtual void Tick(float deltaTime) override
+		{
+			mOwner_->mPosition_.x += mVelocity_.x * deltaTime;
+			mOwner_->mPosition_.y += mVelocity_.y * deltaTime;
+			mOwner_->mPosition_.z += mVelocity_.z * deltaTime;
+		}
+		ObjectEntity* mOwner_;
+		Velocity mVelocity_;
+	};
+
+	class LifetimeComponent : public ObjectComponent
+	{
+	public:
+		virtual void Tick(float deltaTime) override { mRemaining_ -= deltaTime; }
+		float mRemaining_{ 10.f };
+	};
+
+	void RunCase(size_t count, std::mt19937& rng, JobSystem& jobs)
+	{
+		std::uniform_real_distribution<float> value(-10.f, 10.f);
+		std::vector<Velocity> velocities(count);
+		for (Velocity& v : velocities)
+			v = { value(rng), value(rng), value(rng) };
+
+		// object layout
+		std::vector<ObjectEntity*> objects;
+		Timer timer;
+		for (size_t i = 0; i < count; ++i)
+		{
+			ObjectEntity* entity = new ObjectEntity();
+			entity->mComponents_.push_back(std::make_unique<MovementComponent>(entity, velocities[i]));
+			if (i % 4 == 0)
+				entity->mComponents_.push_back(std::make_unique<LifetimeComponent>());
+			objects.push_back(entity);
+		}
+		Report("object", "create", count, "ms", timer.ElapsedMs());
+
+		timer.Reset();
+		for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			for (ObjectEntity* entity : objects)
+				entity->Tick(DELTA_TIME);
+		}
+		Report("object", "tick", count, "ms_per_frame", timer.ElapsedMs() / FRAME_COUNT);
+
+		// registry layout
+		EntityRegistry registry;
+		std::vector<EntityId> ids;
+		timer.Reset();
+		for (size_t i = 0; i < count; ++i)
+		{
+			EntityId id = registry.Create();
+			registry.Add<Position>(id, Position{});
+			registry.Add<Velocity>(id, velocities[i]);
+			if (i % 4 == 0)
+				registry.Add<Lifetime>(id, Lifetime{ 10.f });
+			ids.push_back(id);
+		}
+		Report("registry", "create", count, "ms", timer.ElapsedMs());
+
+		timer.Reset();
+		for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			registry.Each<Velocity, Position>([](EntityId, Velocity& v, Position& p) {
+				p.x += v.x * DELTA_TIME;
+				p.y += v.y * DELTA_TIME;
+				p.z += v.z * DELTA_TIME;
+			});
+			registry.Each<Lifetime>([](EntityId, Lifetime& lifetime) { lifetime.Remaining -= DELTA_TIME; });
+		}
+		Report("registry", "tick", count, "ms_per_frame", timer.ElapsedMs() / FRAME_COUNT);
+
+		// both layouts must end up at the same place
+		double maxError = 0.0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Position& a = objects[i]->mPosition_;
+			const Position& b = registry.Get<Position>(ids[i]);
+			maxError = std::max<double>(maxError, std::abs(a.x - b.x) + std::abs(a.y - b.y) + std::abs(a.z - b.z));
+		}
+		CheckError("registry", "tick_max_error", count, "abs", maxError, TICK_TOLERANCE);
+
+		// parallel update phase, entities only write their own state
+		constexpr size_t BATCH_SIZE = 64;
+		timer.Reset();
+		for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			jobs.ParallelFor(0, objects.size(), BATCH_SIZE, [&objects](size_t begin, size_t end) {
+				for (size_t i = begin; i < end; ++i)
+					objects[i]->Tick(DELTA_TIME);
+			});
+		}
+		Report("object", "parallel_tick", count, "ms_per_frame", timer.ElapsedMs() / FRAME_COUNT);
+
+		timer.Reset();
+		for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+		{
+			registry.ParallelEach<Velocity, Position>(jobs, BATCH_SIZE * 16, [](EntityId, Velocity& v, Position& p) {
+				p.x += v.x * DELTA_TIME;
+				p.y += v.y * DELTA_TIME;
+				p.z += v.z * DELTA_TIME;
+			});
+			registry.ParallelEach<Lifetime>(jobs, BATCH_SIZE * 16, [](EntityId, Lifetime& lifetime) { lifetime.Remaining -= DELTA_TIME; });
+		}
+		Report("registry", "parallel_tick", count, "ms_per_frame", timer.ElapsedMs() / FRAME_COUNT);
+
+		maxError = 0.0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const Position& a = objects[i]->mPosition_;
+			const Position& b = registry.Get<Position>(ids[i]);
+			maxError = std::max<double>(maxError, std::abs(a.x - b.x) + std::abs(a.y - b.y) + std::abs(a.z - b.z));
+		}
+		CheckError("registry", "parallel_tick_max_error", count, "abs", maxError, TICK_TOLERANCE);
+
+		timer.Reset();
+		for (ObjectEntity* entity : objects)
+			delete entity;
+		Report("object", "destroy", count, "ms", timer.ElapsedMs());
+
+		timer.Reset();
+		for (EntityId id : ids)
+			registry.Destroy(id);
+		Report("registry", "destroy", count, "ms", timer.ElapsedMs());
+	}
+	// the old ClientScene::AddEntity / DelEntity pattern against SlotMap
+	void RunRegistration(size_t count)
+	{
+		std::vector<std::unique_ptr<ObjectEntity>> storage(count);
+		std::vector<ObjectEntity*> objects(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			storage[i] = std::make_unique<ObjectEntity>();
+			objects[i] = storage[i].get();
+		}
+
+		std::vector<ObjectEntity*> list;
+		Timer timer;
+		for (ObjectEntity* entity : objects)
+		{
+			HYBRID_CHECK(std::find(list.begin(), list.end(), entity) == list.end());
+			list.push_back(entity);
+		}
+		for (ObjectEntity* entity : objects)
+		{
+			auto itr = std::find(list.begin(), list.end(), entity);
+			if (itr != list.end())
+				list.erase(itr);
+		}
+		Report("vector_find", "add_remove", count, "ms", timer.ElapsedMs());
+
+		SlotMap<ObjectEntity*> slots;
+		std::vector<SlotHandle> handles;
+		timer.Reset();
+		slots.InsertRange(objects.data(), objects.size(), handles);
+		for (SlotHandle handle : handles)
+			slots.Remove(handle);
+		Report("slot_map", "add_remove", count, "ms", timer.ElapsedMs());
+		Check("slot_map", "add_remove_empty", count, slots.Empty() && list.empty());
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(20221017);
+	JobSystem jobs;
+	ReportHeader();
+	for (size_t count : { 1000, 10000, 100000 })
+	{
+		RunCase(count, rng, jobs);
+	}
+	for (size_t count : { 1000, 10000, 50000 })
+	{
+		RunRegistration(count);
+	}
+	return ExitCode();
+}
\ No newline at end of file
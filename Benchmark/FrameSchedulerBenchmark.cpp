@@ -0,0 +1,76 @@
+#include "BenchmarkUtil.h"
+#include "Core/FrameScheduler.h"
+
+#include <cmath>
+#include <ctime>
+
+// Frame pacing of FrameScheduler: frame time distribution under a frame rate cap, cpu time burnt while
+// waiting, and how closely the fixed timestep step count tracks wall time.
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	constexpr uint32_t FRAME_COUNT = 240;
+
+	void RunCapped(float framesPerSecond)
+	{
+		FrameScheduler scheduler;
+		scheduler.SetMaxFrameRate(framesPerSecond);
+		scheduler.BeginFrame();
+
+		const std::clock_t cpuStart = std::clock();
+		Timer timer;
+		for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+			scheduler.BeginFrame();
+		const double wallMs = timer.ElapsedMs();
+		const double cpuMs = double(std::clock() - cpuStart) * 1000.0 / CLOCKS_PER_SEC;
+
+		const FrameTimeStats stats = scheduler.GetFrameTimeStats();
+		const std::string name = "cap_" + std::to_string(uint32_t(framesPerSecond));
+		Report("capped", name, FRAME_COUNT, "target_ms", 1000.0 / framesPerSecond);
+		Report("capped", name, FRAME_COUNT, "p50_ms", stats.P50);
+		Report("capped", name, FRAME_COUNT, "p95_ms", stats.P95);
+		Report("capped", name, FRAME_COUNT, "p99_ms", stats.P99);
+		Report("capped", name, FRAME_COUNT, "max_ms", stats.Max);
+		Report("capped", name, FRAME_COUNT, "cpu_wall_ratio", cpuMs / wallMs);
+	}
+
+	// simulated steps must follow wall time regardless of the render rate
+	void RunFixedStep(float framesPerSecond, float stepsPerSecond)
+	{
+		FrameScheduler scheduler;
+		scheduler.SetMaxFrameRate(framesPerSecond);
+		scheduler.SetFixedTimestep(1.f / stepsPerSecond);
+		scheduler.BeginFrame();
+
+		uint32_t steps = 0;
+		bool alphaInRange = true;
+		Timer timer;
+		for (uint32_t i = 0; i < FRAME_COUNT; ++i)
+		{
+			scheduler.BeginFrame();
+			steps += scheduler.GetStepCount();
+			const float alpha = scheduler.GetInterpolationAlpha();
+			alphaInRange &= alpha >= 0.f && alpha < 1.f;
+		}
+		const double simulated = steps / stepsPerSecond;
+		const double wall = timer.ElapsedMs() / 1000.0;
+
+		const std::string name = "render_" + std::to_string(uint32_t(framesPerSecond)) + "_step_" + std::to_string(uint32_t(stepsPerSecond));
+		Report("fixed_step", name, FRAME_COUNT, "steps", steps);
+		Report("fixed_step", name, FRAME_COUNT, "drift_ms", std::abs(simulated - wall) * 1000.0);
+		Check("fixed_step", name + "_alpha_in_range", FRAME_COUNT, alphaInRange);
+	}
+}
+
+int main()
+{
+	ReportHeader();
+	RunCapped(60.f);
+	RunCapped(144.f);
+	RunFixedStep(144.f, 60.f);
+	RunFixedStep(30.f, 60.f);
+	return ExitCode();
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include "BenchmarkUtil.h"
+#include "Graphics/Common/InstanceBatcher.h"
+
+#include <cstring>
+#include <vector>
+
+// CPU side of drawing N copies of a few meshes: a uniform block and a draw per element against the
+// InstanceBatcher that VulkanInstancer runs on, which groups them by mesh and material, packs the world
+// matrices into one instance stream per batch and records a single instanced draw. No GPU is involved,
+// draws are counted not issued.
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	constexpr uint32_t FRAME_COUNT = 100;
+	constexpr size_t MESH_COUNT = 4;
+	constexpr size_t MATERIAL_COUNT = 2;
+	// VulkanInstancer::INSTANCING_MIN_COUNT and BATCH_RELEASE_FRAMES, which need the Vulkan headers
+	constexpr size_t INSTANCING_MIN_COUNT = 2;
+	constexpr uint32_t BATCH_RELEASE_FRAMES = 120;
+
+	// same layout as UniformBufferObject / InstanceData, which need the Vulkan headers
+	struct Uniforms
+	{
+		glm::mat4 model;
+		glm::mat4 view;
+		glm::mat4 proj;
+	};
+
+	struct Instance
+	{
+		glm::mat4 model;
+	};
+
+	struct FakeElement
+	{
+		size_t Mesh;
+		size_t Material;
+	};
+
+	// mirrors RenderItem / VulkanDrawEntry, RenderSnapshot.h needs the Vulkan headers
+	struct FakeItem
+	{
+		Matrix4x3 WorldTransform;
+	};
+
+	struct DrawEntry
+	{
+		const FakeElement* Element;
+		const FakeItem* Item;
+		uint32_t SetOrder;
+	};
+
+	class FakeBatch : public InstanceBatch<DrawEntry, Instance>
+	{
+	public:
+		FakeBatch(size_t mesh, size_t material) : Mesh(mesh), Material(material) {}
+		bool IsCompatible(size_t material) const { return material == Material; }
+
+		size_t Mesh;
+		size_t Material;
+	};
+
+	struct DrawRecord
+	{
+		const FakeBatch* Batch;
+		uint32_t InstanceCount;
+		size_t FirstInstance;
+	};
+
+	void Run(size_t elementCount)
+	{
+		std::vector<FakeElement> elements(elementCount);
+		std::vector<FakeItem> items(elementCount);
+		for (size_t i = 0; i < elementCount; ++i)
+		{
+			elements[i].Mesh = i % MESH_COUNT;
+			elements[i].Material = i / MESH_COUNT % MATERIAL_COUNT;
+			items[i].WorldTransform.SetTranslation(Vector3(float(i % 100), float(i / 100 % 100), float(i / 10000)));
+		}
+		Matrix4x3 view;
+		Matrix4x4 proj;
+		proj.SetIdentity();
+
+		// per element: its own uniform block, a draw each
+		std::vector<Uniforms> uniformBuffers(elementCount);
+		size_t draws = 0;
+		{
+			Timer timer;
+			for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				draws = 0;
+				for (size_t i = 0; i < elementCount; ++i)
+				{
+					Uniforms uniforms{ ToGlm(items[i].WorldTransform), ToGlm(view), ToGlm(proj) };
+					memcpy(&uniformBuffers[i], &uniforms, sizeof(Uniforms));
+					++draws;
+				}
+				DoNotOptimize(uniformBuffers);
+			}
+			Report("instancing", "per_element", elementCount, "us_per_frame", timer.ElapsedMs() * 1000.0 / FRAME_COUNT);
+			Report("instancing", "per_element", elementCount, "draws", double(draws));
+		}
+
+		// instanced: grouped by the batcher, one instance stream, a draw per batch
+		InstanceBatcher<size_t, FakeBatch> batcher;
+		size_t created = 0;
+		std::vector<DrawEntry> singles;
+		std::vector<Instance> instanceBuffer(elementCount);
+		std::vector<DrawRecord> instancedDraws;
+		size_t packed = 0;
+		Uniforms batchUniforms{};
+		{
+			Timer timer;
+			for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				batcher.Begin();
+				for (size_t i = 0; i < elementCount; ++i)
+				{
+					const FakeElement& element = elements[i];
+					FakeBatch* batch = batcher.GetBatch(element.Mesh, [&]() { ++created; return new FakeBatch(element.Mesh, element.Material); }, element.Material);
+					batcher.Add(batch, DrawEntry{ &element, &items[i], 0 });
+				}
+
+				singles.clear();
+				instancedDraws.clear();
+				packed = 0;
+				batcher.End(INSTANCING_MIN_COUNT, singles, [&](FakeBatch* batch)
+					{
+						batch->PackInstances();
+						const std::vector<Instance>& instances = batch->GetInstances();
+						memcpy(instanceBuffer.data() + packed, instances.data(), instances.size() * sizeof(Instance));
+						instancedDraws.push_back(DrawRecord{ batch, uint32_t(instances.size()), packed });
+						packed += instances.size();
+					});
+				batcher.ReleaseIdle(BATCH_RELEASE_FRAMES, [](FakeBatch* batch) { delete batch; });
+				batchUniforms = Uniforms{ glm::mat4(1.f), ToGlm(view), ToGlm(proj) };
+				DoNotOptimize(instanceBuffer);
+				DoNotOptimize(batchUniforms);
+			}
+			Report("instancing", "instanced", elementCount, "us_per_frame", timer.ElapsedMs() * 1000.0 / FRAME_COUNT);
+			Report("instancing", "instanced", elementCount, "draws", double(instancedDraws.size() + singles.size()));
+		}
+
+		// every element's model matrix reaches the GPU either way, each batch holds one mesh / material
+		bool match = packed + singles.size() == elementCount && instancedDraws.size() == MESH_COUNT * MATERIAL_COUNT;
+		for (const DrawRecord& draw : instancedDraws)
+		{
+			const std::vector<DrawEntry>& entries = draw.Batch->GetEntries();
+			for (uint32_t i = 0; match && i < draw.InstanceCount; ++i)
+			{
+				const size_t index = size_t(entries[i].Item - items.data());
+				match = entries[i].Element->Mesh == draw.Batch->Mesh
+					&& entries[i].Element->Material == draw.Batch->Material
+					&& memcmp(&instanceBuffer[draw.FirstInstance + i].model, &uniformBuffers[index].model, sizeof(glm::mat4)) == 0;
+			}
+		}
+		Check("instancing", "match", elementCount, match);
+
+		// batches nothing was added to are handed back once they stayed empty long enough
+		size_t released = 0;
+		for (uint32_t frame = 0; frame <= BATCH_RELEASE_FRAMES; ++frame)
+		{
+			batcher.Begin();
+			batcher.End(INSTANCING_MIN_COUNT, singles, [](FakeBatch*) {});
+			batcher.ReleaseIdle(BATCH_RELEASE_FRAMES, [&](FakeBatch* batch) { ++released; delete batch; });
+		}
+		Check("instancing", "idle_release", elementCount, released == created && batcher.GetBatchCount() == 0);
+	}
+}
+
+int main()
+{
+	ReportHeader();
+	for (size_t count : { 1000, 10000 })
+		Run(count);
+	return ExitCode();
+}
\ No newline at end of file
@@ -0,0 +1,193 @@
+#include "BenchmarkUtil.h"
+#include "Core/JobSystem.h"
+#include "Math/Frustum.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+// Scaling of JobSystem::ParallelFor from 1 to hardware_concurrency threads on a compute bound
+// loop and on frustum culling, plus job overhead and a dependency ordering check.
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	constexpr uint32_t REPEAT = 10;
+	constexpr size_t ITEM_COUNT = 1 << 20;
+	constexpr size_t GRAIN_SIZE = 4096;
+
+	std::vector<uint32_t> ThreadCounts()
+	{
+		const uint32_t hardware = Max(std::thread::hardware_concurrency(), 1u);
+		std::vector<uint32_t> counts;
+		for (uint32_t count = 1; count < hardware; count *= 2)
+			counts.push_back(count);
+		counts.push_back(hardware);
+		return counts;
+	}
+
+	Frustum MakeFrustum()
+	{
+		Matrix4x3 view;
+		view.SetTranslation(Vector3(0.f, 0.f, -200.f));
+		const float n = 0.1f, f = 800.f, h = 1.f / std::tan(DegreeToRadian(60.f) * 0.5f);
+		Matrix4x4 proj(
+			h, 0, 0, 0,
+			0, h, 0, 0,
+			0, 0, f / (n - f), -1,
+			0, 0, -(f * n) / (f - n), 0
+		);
+		return Frustum(view, proj);
+	}
+
+	BoundsStream GenerateBounds(size_t count, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> pos(-1000.f, 1000.f);
+		std::uniform_real_distribution<float> size(0.5f, 10.f);
+		BoundsStream bounds;
+		for (size_t i = 0; i < count; ++i)
+		{
+			Vector3 center(pos(rng), pos(rng), pos(rng));
+			Vector3 extent(size(rng), size(rng), size(rng));
+			bounds.Add(Box(center - extent, center + extent), Sphere(center, extent.GetLength()));
+		}
+		return bounds;
+	}
+
+	// a few hundred cycles per item, stands in for per entity game logic
+	float Work(float value)
+	{
+		for (int i = 0; i < 32; ++i)
+			value = std::sqrt(value * value + 1.f) * 0.5f;
+		return value;
+	}
+
+	void RunScaling(const std::vector<float>& input, const BoundsStream& bounds, const Frustum& frustum)
+	{
+		std::vector<float> reference(input.size());
+		for (size_t i = 0; i < input.size(); ++i)
+			reference[i] = Work(input[i]);
+		std::vector<uint8_t> referenceVisible(bounds.Size());
+		frustum.TestBounds(bounds, referenceVisible.data());
+
+		double computeBase = 0.0, cullingBase = 0.0;
+		for (uint32_t threadCount : ThreadCounts())
+		{
+			JobSystem jobs(threadCount);
+
+			std::vector<float> output(input.size());
+			Timer timer;
+			for (uint32_t r = 0; r < REPEAT; ++r)
+			{
+				jobs.ParallelFor(0, input.size(), GRAIN_SIZE, [&](size_t begin, size_t end)
+					{
+						for (size_t i = begin; i < end; ++i)
+							output[i] = Work(input[i]);
+					});
+			}
+			const double computeMs = timer.ElapsedMs() / REPEAT;
+			computeBase = threadCount == 1 ? computeMs : computeBase;
+			Report("compute", "parallel_for", threadCount, "ms", computeMs);
+			Report("compute", "speedup", threadCount, "x", computeBase / computeMs);
+			Check("compute", "match", threadCount, output == reference);
+
+			std::vector<uint8_t> visible(bounds.Size());
+			timer.Reset();
+			for (uint32_t r = 0; r < REPEAT; ++r)
+			{
+				jobs.ParallelFor(0, bounds.Size(), GRAIN_SIZE, [&](size_t begin, size_t end)
+					{
+						frustum.TestBounds(bounds, begin, end, visible.data());
+					});
+			}
+			const double cullingMs = timer.ElapsedMs() / REPEAT;
+			cullingBase = threadCount == 1 ? cullingMs : cullingBase;
+			Report("culling", "parallel_for", threadCount, "ms", cullingMs);
+			Report("culling", "speedup", threadCount, "x", cullingBase / cullingMs);
+			Check("culling", "match", threadCount, visible == referenceVisible);
+		}
+	}
+
+	void RunOverhead(uint32_t threadCount)
+	{
+		constexpr size_t JOB_COUNT = 100000;
+		JobSystem jobs(threadCount);
+		std::atomic<size_t> executed{ 0 };
+		JobCounter counter;
+		Timer timer;
+		for (size_t i = 0; i < JOB_COUNT; ++i)
+			jobs.Run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &counter);
+		jobs.Wait(counter);
+		Report("overhead", "empty_job", threadCount, "ns_per_job", timer.ElapsedMs() * 1e6 / JOB_COUNT);
+		Check("overhead", "all_executed", threadCount, executed.load() == JOB_COUNT);
+
+		// jobs spawning jobs, children land on the spawning worker's deque and get stolen by the others
+		constexpr size_t PARENT_COUNT = 256, CHILD_COUNT = 256;
+		executed = 0;
+		JobCounter nested;
+		timer.Reset();
+		for (size_t i = 0; i < PARENT_COUNT; ++i)
+		{
+			jobs.Run([&]()
+				{
+					JobCounter children;
+					for (size_t c = 0; c < CHILD_COUNT; ++c)
+						jobs.Run([&executed]() { executed.fetch_add(1, std::memory_order_relaxed); }, &children);
+					jobs.Wait(children);
+				}, &nested);
+		}
+		jobs.Wait(nested);
+		Report("overhead", "nested_job", threadCount, "ns_per_job", timer.ElapsedMs() * 1e6 / (PARENT_COUNT * CHILD_COUNT));
+		Check("overhead", "nested_all_executed", threadCount, executed.load() == PARENT_COUNT * CHILD_COUNT);
+	}
+
+	// stage i only starts once every job of stage i - 1 finished
+	void RunDependencies(uint32_t threadCount)
+	{
+		constexpr size_t STAGE_COUNT = 8, STAGE_WIDTH = 64;
+		JobSystem jobs(threadCount);
+		std::vector<JobCounter> stages(STAGE_COUNT);
+		std::atomic<size_t> finished[STAGE_COUNT] = {};
+		std::atomic<bool> ordered{ true };
+		for (size_t s = 0; s < STAGE_COUNT; ++s)
+		{
+			for (size_t j = 0; j < STAGE_WIDTH; ++j)
+			{
+				auto job = [&, s]()
+					{
+						if (s > 0 && finished[s - 1].load() != STAGE_WIDTH)
+							ordered = false;
+						finished[s].fetch_add(1);
+					};
+				if (s == 0)
+					jobs.Run(job, &stages[s]);
+				else
+					jobs.RunAfter(stages[s - 1], job, &stages[s]);
+			}
+		}
+		jobs.Wait(stages.back());
+		Check("dependency", "stage_order", threadCount, ordered.load() && finished[STAGE_COUNT - 1].load() == STAGE_WIDTH);
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(20221017);
+	ReportHeader();
+
+	std::uniform_real_distribution<float> value(0.f, 100.f);
+	std::vector<float> input(ITEM_COUNT);
+	for (float& v : input)
+		v = value(rng);
+	BoundsStream bounds = GenerateBounds(ITEM_COUNT, rng);
+	RunScaling(input, bounds, MakeFrustum());
+
+	for (uint32_t threadCount : ThreadCounts())
+	{
+		RunOverhead(threadCount);
+		RunDependencies(threadCount);
+	}
+	return ExitCode();
+}
\ No newline at end of file
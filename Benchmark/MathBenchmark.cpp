@@ -0,0 +1,200 @@
+#include "BenchmarkUtil.h"
+#include "Math/GlmConvert.h"
+
+#include <glm/gtc/matrix_inverse.hpp>
+#include <random>
+#include <vector>
+
+// Compares the engine math types with glm for the operations used per element per frame.
+// Every row is ns per operation, *_max_error rows check that both sides compute the same thing and fail the run above tolerance.
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	// each measurement runs at least this many operations so small batches are not just timer noise
+	constexpr size_t MIN_OPS_PER_CASE = 1 << 22;
+	// relative to max(1, |reference|)
+	constexpr double MATRIX_TOLERANCE = 1e-5;
+	// Slerp lerps and renormalizes above cos 0.9995, glm only above 1 - epsilon
+	constexpr double SLERP_TOLERANCE = 1e-5;
+
+	struct Inputs
+	{
+		std::vector<Matrix4x3> Affines;
+		std::vector<Matrix4x4> Projectives;
+		std::vector<Vector3> Points;
+		std::vector<Quaternion> Rotations;
+
+		std::vector<glm::mat4> GlmAffines;
+		std::vector<glm::mat4> GlmProjectives;
+		std::vector<glm::vec4> GlmPoints;
+		std::vector<glm::quat> GlmRotations;
+	};
+
+	Quaternion RandomRotation(std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> value(-1.f, 1.f);
+		Quaternion q(value(rng), value(rng), value(rng), value(rng));
+		q.Normalize();
+		return q;
+	}
+
+	Inputs GenerateInputs(size_t count, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> pos(-100.f, 100.f);
+		std::uniform_real_distribution<float> scale(0.5f, 2.f);
+		Inputs in;
+		for (size_t i = 0; i < count; ++i)
+		{
+			Matrix4x3 affine(Matrix3x3(RandomRotation(rng)));
+			affine.SetScale(Vector3(scale(rng), scale(rng), scale(rng)));
+			affine.SetTranslation(Vector3(pos(rng), pos(rng), pos(rng)));
+			in.Affines.push_back(affine);
+
+			Matrix4x4 projective(affine);
+			projective.m03 = scale(rng) * 0.1f;
+			projective.m13 = scale(rng) * 0.1f;
+			in.Projectives.push_back(projective);
+
+			in.Points.push_back(Vector3(pos(rng), pos(rng), pos(rng)));
+			in.Rotations.push_back(RandomRotation(rng));
+
+			in.GlmAffines.push_back(ToGlm(affine));
+			in.GlmProjectives.push_back(ToGlm(projective));
+			in.GlmPoints.push_back(glm::vec4(ToGlm(in.Points.back()), 1.f));
+			in.GlmRotations.push_back(ToGlm(in.Rotations.back()));
+		}
+		return in;
+	}
+
+	// calls func(i) for every element of the batch, repeated until MIN_OPS_PER_CASE, returns ns per call
+	template<typename TFunc>
+	double Measure(size_t count, TFunc&& func)
+	{
+		const size_t repeat = count >= MIN_OPS_PER_CASE ? 1 : MIN_OPS_PER_CASE / count;
+		Timer timer;
+		for (size_t r = 0; r < repeat; ++r)
+		{
+			for (size_t i = 0; i < count; ++i)
+				func(i);
+		}
+		return timer.ElapsedMs() * 1e6 / double(repeat * count);
+	}
+
+	float MaxError(const float* lhs, const float* rhs, size_t n)
+	{
+		float error = 0.f;
+		for (size_t i = 0; i < n; ++i)
+			error = Max(error, Fabs(lhs[i] - rhs[i]) / Max(1.f, Fabs(rhs[i])));
+		return error;
+	}
+
+	float MaxError(const glm::mat4& lhs, const glm::mat4& rhs) { return MaxError(&lhs[0][0], &rhs[0][0], 16); }
+
+	float MaxError(const Quaternion& lhs, const glm::quat& rhs)
+	{
+		const float l[4] = { lhs.x, lhs.y, lhs.z, lhs.w };
+		const float r[4] = { rhs.x, rhs.y, rhs.z, rhs.w };
+		return MaxError(l, r, 4);
+	}
+
+	void RunCase(size_t count, std::mt19937& rng)
+	{
+		Inputs in = GenerateInputs(count, rng);
+		const size_t last = count - 1;
+		auto next = [count](size_t i) { return i + 1 == count ? 0 : i + 1; };
+
+		// multiply, zyh is row vector so a * b matches glm b * a
+		{
+			std::vector<Matrix4x3> out(count);
+			std::vector<Matrix4x4> out44(count);
+			std::vector<glm::mat4> glmOut(count);
+			Report("zyh", "mat4x3_multiply", count, "ns_per_op", Measure(count, [&](size_t i) { out[i] = in.Affines[i] * in.Affines[next(i)]; }));
+			Report("zyh", "mat4x4_multiply", count, "ns_per_op", Measure(count, [&](size_t i) { out44[i] = in.Projectives[i] * in.Projectives[next(i)]; }));
+			Report("glm", "mat4_multiply", count, "ns_per_op", Measure(count, [&](size_t i) { glmOut[i] = in.GlmProjectives[next(i)] * in.GlmProjectives[i]; }));
+			DoNotOptimize(out); DoNotOptimize(out44); DoNotOptimize(glmOut);
+
+			float error = Max(
+				MaxError(ToGlm(out44[last]), glmOut[last]),
+				MaxError(ToGlm(out[last]), in.GlmAffines[next(last)] * in.GlmAffines[last])
+			);
+			CheckError("zyh", "multiply_max_error", count, "relative", error, MATRIX_TOLERANCE);
+		}
+
+		// inverse
+		{
+			std::vector<Matrix4x3> out(count);
+			std::vector<Matrix4x4> out44(count);
+			std::vector<glm::mat4> glmOut(count), glmAffineOut(count);
+			Report("zyh", "mat4x3_inverse", count, "ns_per_op", Measure(count, [&](size_t i) { out[i] = in.Affines[i].GetInverse(); }));
+			Report("zyh", "mat4x4_inverse", count, "ns_per_op", Measure(count, [&](size_t i) { out44[i] = in.Projectives[i].GetInverse(); }));
+			Report("glm", "mat4_affine_inverse", count, "ns_per_op", Measure(count, [&](size_t i) { glmAffineOut[i] = glm::affineInverse(in.GlmAffines[i]); }));
+			Report("glm", "mat4_inverse", count, "ns_per_op", Measure(count, [&](size_t i) { glmOut[i] = glm::inverse(in.GlmProjectives[i]); }));
+			DoNotOptimize(out); DoNotOptimize(out44); DoNotOptimize(glmOut); DoNotOptimize(glmAffineOut);
+
+			float error = Max(MaxError(ToGlm(out[last]), glmAffineOut[last]), MaxError(ToGlm(out44[last]), glmOut[last]));
+			CheckError("zyh", "inverse_max_error", count, "relative", error, MATRIX_TOLERANCE);
+		}
+
+		// point transform
+		{
+			std::vector<Vector3> out(count);
+			std::vector<glm::vec4> glmOut(count);
+			Report("zyh", "mat4x3_transform_point", count, "ns_per_op", Measure(count, [&](size_t i) { out[i] = in.Affines[i].TransformPoint(in.Points[i]); }));
+			Report("glm", "mat4_transform_point", count, "ns_per_op", Measure(count, [&](size_t i) { glmOut[i] = in.GlmAffines[i] * in.GlmPoints[i]; }));
+			DoNotOptimize(out); DoNotOptimize(glmOut);
+
+			const float l[3] = { out[last].x, out[last].y, out[last].z };
+			const float r[3] = { glmOut[last].x, glmOut[last].y, glmOut[last].z };
+			CheckError("zyh", "transform_point_max_error", count, "relative", MaxError(l, r, 3), MATRIX_TOLERANCE);
+		}
+
+		// slerp
+		{
+			std::vector<Quaternion> out(count);
+			std::vector<glm::quat> glmOut(count);
+			Report("zyh", "quat_slerp", count, "ns_per_op", Measure(count, [&](size_t i) { out[i] = Quaternion::Slerp(in.Rotations[i], in.Rotations[next(i)], 0.3f); }));
+			Report("glm", "quat_slerp", count, "ns_per_op", Measure(count, [&](size_t i) { glmOut[i] = glm::slerp(in.GlmRotations[i], in.GlmRotations[next(i)], 0.3f); }));
+			DoNotOptimize(out); DoNotOptimize(glmOut);
+
+			float error = 0.f;
+			for (size_t i = 0; i < count; ++i)
+				error = Max(error, MaxError(out[i], glmOut[i]));
+			CheckError("zyh", "slerp_max_error", count, "relative", error, SLERP_TOLERANCE);
+
+			// random pairs are rarely close, nudge each rotation so the near parallel path is covered too
+			error = 0.f;
+			for (size_t i = 0; i < count; ++i)
+			{
+				const Quaternion& q0 = in.Rotations[i];
+				const Quaternion q1 = Quaternion(q0.x + 0.01f, q0.y - 0.01f, q0.z, q0.w + 0.005f).GetNormalized();
+				error = Max(error, MaxError(Quaternion::Slerp(q0, q1, 0.3f), glm::slerp(ToGlm(q0), ToGlm(q1), 0.3f)));
+			}
+			CheckError("zyh", "slerp_near_max_error", count, "relative", error, SLERP_TOLERANCE);
+		}
+
+		// conversion, what updateUniformBuffer pays per element
+		{
+			std::vector<glm::mat4> out(count);
+			Report("zyh", "convert_mat4x4_to_glm", count, "ns_per_op", Measure(count, [&](size_t i) { out[i] = ToGlm(in.Projectives[i]); }));
+			Report("zyh", "convert_mat4x3_to_glm", count, "ns_per_op", Measure(count, [&](size_t i) { out[i] = ToGlm(in.Affines[i]); }));
+			Report("zyh", "convert_mat4x3_via_mat4x4_to_glm", count, "ns_per_op", Measure(count, [&](size_t i) { out[i] = ToGlm(Matrix4x4(in.Affines[i])); }));
+			Report("zyh", "convert_quat_to_mat3x3", count, "ns_per_op", Measure(count, [&](size_t i) { out[i][0][0] = Matrix3x3(in.Rotations[i]).m00; }));
+			Report("glm", "convert_quat_to_mat3", count, "ns_per_op", Measure(count, [&](size_t i) { out[i][0][0] = glm::mat3_cast(in.GlmRotations[i])[0][0]; }));
+			DoNotOptimize(out);
+		}
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(20221017);
+	ReportHeader();
+	for (size_t count : { 1, 10, 100, 1000, 10000, 100000, 1000000 })
+	{
+		RunCase(count, rng);
+	}
+	return ExitCode();
+}
\ No newline at end of file
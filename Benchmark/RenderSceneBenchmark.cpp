@@ -0,0 +1,142 @@
+#include "BenchmarkUtil.h"
+#include "Graphics/Common/IRenderScene.h"
+
+#include <map>
+#include <vector>
+
+// Per frame collect / lookup of IRenderScene against the previous map based storage that
+// copied every set into the caller's vector, and the clear-and-rebuild collect against incremental
+// add / remove of the elements whose visibility changed.
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	constexpr uint32_t FRAME_COUNT = 2000;
+	constexpr RenderSet SETS[] = { RenderSet::NONE, RenderSet::SCENE, RenderSet::XRAY, RenderSet::UI, RenderSet::POSTPROCESS };
+
+	// previous implementation, kept here as the baseline
+	class MapRenderScene
+	{
+	public:
+		void Clear(RenderSet renderSet)
+		{
+			mRenderElements_[renderSet].clear();
+			mIsDirtys_.clear();
+		}
+
+		void AddRenderElement(RenderSet renderSet, IRenderElement* element)
+		{
+			mRenderElements_[renderSet].push_back(element);
+			mIsDirtys_[renderSet] = true;
+		}
+
+		void GetRenderElements(RenderSet renderSet, std::vector<IRenderElement*>& elements)
+		{
+			elements.clear();
+			if (mRenderElements_.find(renderSet) != mRenderElements_.end())
+				elements = mRenderElements_[renderSet];
+		}
+
+	private:
+		std::map<RenderSet, std::vector<IRenderElement*>> mRenderElements_;
+		std::map<RenderSet, bool> mIsDirtys_;
+	};
+
+	// a slowly panning camera, every frame 1 / 64 of the elements leave and as many come back into view
+	bool IsVisible(size_t i, uint32_t frame)
+	{
+		return (i + frame) % 64 != 0;
+	}
+
+	void Run(size_t elementCount)
+	{
+		// most elements are scene geometry, a handful are ui / post process
+		auto setOf = [](size_t i) { return i % 16 == 0 ? SETS[i / 16 % 5] : RenderSet::SCENE; };
+
+		std::vector<IRenderElement> pool(elementCount);
+		auto indexOf = [&pool](IRenderElement* element) { return size_t(element - pool.data()) + 1; };
+
+		// sums are order independent, the incremental sets are not in insertion order
+		size_t checksumMap = 0, checksumArray = 0, checksumIncremental = 0;
+		{
+			MapRenderScene scene;
+			std::vector<IRenderElement*> elements;
+			Timer timer;
+			for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				for (RenderSet set : SETS)
+					scene.Clear(set);
+				for (size_t i = 0; i < elementCount; ++i)
+				{
+					if (IsVisible(i, frame))
+						scene.AddRenderElement(setOf(i), &pool[i]);
+				}
+				for (RenderSet set : SETS)
+				{
+					scene.GetRenderElements(set, elements);
+					for (IRenderElement* element : elements)
+						checksumMap += indexOf(element);
+				}
+			}
+			Report("render_scene", "map_copy", elementCount, "us_per_frame", timer.ElapsedMs() * 1000.0 / FRAME_COUNT);
+		}
+		{
+			IRenderScene scene;
+			Timer timer;
+			for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				for (RenderSet set : SETS)
+					scene.Clear(set);
+				for (size_t i = 0; i < elementCount; ++i)
+				{
+					if (IsVisible(i, frame))
+						scene.AddRenderElement(setOf(i), &pool[i]);
+				}
+				for (RenderSet set : SETS)
+				{
+					for (IRenderElement* element : scene.GetRenderElements(set))
+						checksumArray += indexOf(element);
+				}
+			}
+			Report("render_scene", "array_span", elementCount, "us_per_frame", timer.ElapsedMs() * 1000.0 / FRAME_COUNT);
+			for (RenderSet set : SETS)
+				scene.Clear(set);
+		}
+		{
+			IRenderScene scene;
+			Timer timer;
+			for (uint32_t frame = 0; frame < FRAME_COUNT; ++frame)
+			{
+				// only the elements entering / leaving the view touch the scene
+				for (size_t i = 0; i < elementCount; ++i)
+				{
+					const bool visible = IsVisible(i, frame);
+					if (visible != pool[i].IsInRenderScene())
+					{
+						if (visible)
+							scene.AddRenderElement(setOf(i), &pool[i]);
+						else
+							scene.RemoveRenderElement(setOf(i), &pool[i]);
+					}
+				}
+				for (RenderSet set : SETS)
+				{
+					for (IRenderElement* element : scene.GetRenderElements(set))
+						checksumIncremental += indexOf(element);
+				}
+			}
+			Report("render_scene", "incremental", elementCount, "us_per_frame", timer.ElapsedMs() * 1000.0 / FRAME_COUNT);
+		}
+		Check("render_scene", "match", elementCount, checksumMap == checksumArray && checksumMap == checksumIncremental);
+	}
+}
+
+int main()
+{
+	ReportHeader();
+	for (size_t count : { 256, 4096, 65536 })
+		Run(count);
+	return ExitCode();
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#include "BenchmarkUtil.h"
+#include "Graphics/Common/RenderTargetAliasing.h"
+
+#include <random>
+#include <vector>
+
+// Render target memory with a dedicated allocation per target against PlanRenderTargetAliasing, for the
+// default pipeline of Renderer::SetupPipeline and for random graphs. Sizes are estimated as
+// width * height * bytes per pixel * samples rounded to 64 KiB, drivers pad a little more.
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	constexpr uint64_t ALIGNMENT = 64 * 1024;
+	constexpr uint32_t REPEAT = 100;
+
+	uint64_t TargetSize(uint32_t width, uint32_t height, uint32_t bytesPerPixel, uint32_t samples)
+	{
+		const uint64_t size = uint64_t(width) * height * bytesPerPixel * samples;
+		return (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+	}
+
+	double ToMB(uint64_t bytes)
+	{
+		return double(bytes) / (1024.0 * 1024.0);
+	}
+
+	uint64_t Sum(const std::vector<uint64_t>& sizes)
+	{
+		uint64_t sum = 0;
+		for (uint64_t size : sizes)
+			sum += size;
+		return sum;
+	}
+
+	// requests alive at the same time never share a byte
+	bool IsValid(const std::vector<AliasRequest>& requests, const std::vector<uint64_t>& offsets, const std::vector<uint64_t>& heapSizes)
+	{
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			if (offsets[i] % requests[i].Alignment != 0 || offsets[i] + requests[i].Size > heapSizes[requests[i].Heap])
+				return false;
+			for (size_t j = i + 1; j < requests.size(); ++j)
+			{
+				if (AliasLifetimesOverlap(requests[i], requests[j]) && AliasRangesOverlap(offsets[i], requests[i].Size, offsets[j], requests[j].Size))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	void RunDefaultPipeline(uint32_t width, uint32_t height)
+	{
+		// Detonate, Scene, XRayWriter, XRayPostProcess, Final; everything is 8x MSAA
+		const std::vector<AliasRequest> requests = {
+			{ TargetSize(width, height, 16, 8), ALIGNMENT, 0, 4, 0 },	// scene color, A32R32G32B32F, sampled by Final
+			{ TargetSize(width, height, 8, 8), ALIGNMENT, 0, 3, 0 },	// depth stencil, D32_SFLOAT_S8_UINT
+			{ TargetSize(width, height, 4, 8), ALIGNMENT, 4, 4, 0 },	// Final color, R8G8B8A8, resolved to the swapchain
+		};
+		std::vector<uint64_t> offsets;
+		std::vector<uint64_t> heapSizes;
+		PlanRenderTargetAliasing(requests, offsets, heapSizes);
+
+		uint64_t dedicated = 0;
+		for (const AliasRequest& request : requests)
+			dedicated += request.Size;
+		const std::string name = "default_" + std::to_string(width) + "x" + std::to_string(height);
+		Report("rt_alias", name, requests.size(), "dedicated_mb", ToMB(dedicated));
+		Report("rt_alias", name, requests.size(), "aliased_mb", ToMB(Sum(heapSizes)));
+		Check("rt_alias", name, requests.size(), IsValid(requests, offsets, heapSizes));
+	}
+
+	void RunRandom(size_t targetCount, uint32_t passCount)
+	{
+		std::mt19937 rng(11);
+		std::vector<AliasRequest> requests(targetCount);
+		uint64_t dedicated = 0;
+		for (AliasRequest& request : requests)
+		{
+			// mostly short lived intermediates, a few that live through the whole frame
+			const uint32_t length = rng() % 8 == 0 ? passCount : 1 + rng() % 4;
+			request.FirstPass = rng() % passCount;
+			request.LastPass = std::min(request.FirstPass + length - 1, passCount - 1);
+			const uint32_t scale = 1 + rng() % 4;
+			request.Size = TargetSize(1920 / scale, 1080 / scale, 4 << (rng() % 3), 1);
+			request.Alignment = ALIGNMENT;
+			request.Heap = rng() % 2;
+			dedicated += request.Size;
+		}
+
+		std::vector<uint64_t> offsets;
+		std::vector<uint64_t> heapSizes;
+		Timer timer;
+		for (uint32_t i = 0; i < REPEAT; ++i)
+		{
+			PlanRenderTargetAliasing(requests, offsets, heapSizes);
+			DoNotOptimize(offsets);
+		}
+		Report("rt_alias", "random", targetCount, "plan_us", timer.ElapsedMs() * 1000.0 / REPEAT);
+		Report("rt_alias", "random", targetCount, "dedicated_mb", ToMB(dedicated));
+		Report("rt_alias", "random", targetCount, "aliased_mb", ToMB(Sum(heapSizes)));
+		Check("rt_alias", "random", targetCount, IsValid(requests, offsets, heapSizes));
+	}
+}
+
+int main()
+{
+	ReportHeader();
+	RunDefaultPipeline(800, 600);
+	RunDefaultPipeline(1920, 1080);
+	for (size_t count : { 16, 64, 256 })
+		RunRandom(count, 32);
+	return ExitCode();
+}
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "BenchmarkUtil.h"
+#include "Math/VectorStream.h"
+
+#include <random>
+#include <vector>
+
+// Compares the batched Vector3 / bounds kernels with their scalar reference versions.
+// The *_max_error rows double as the equivalence check for the SIMD paths, the run fails above tolerance.
+
+using namespace zyh;
+using namespace zyh::Benchmark;
+
+namespace
+{
+	constexpr uint32_t REPEAT = 20;
+	// the kernels do the same operations in the same order as their scalar versions
+	constexpr double SIMD_TOLERANCE = 1e-5;
+	// Box::Transform goes through the corners instead of the absolute matrix
+	constexpr double BOX_TOLERANCE = 1e-4;
+
+	Vector3Stream GenerateStream(size_t count, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> value(-100.f, 100.f);
+		Vector3Stream stream;
+		for (size_t i = 0; i < count; ++i)
+			stream.PushBack(Vector3(value(rng), value(rng), value(rng)));
+		// exercise the zero length branch of Normalize
+		if (count > 0)
+			stream.Set(count / 2, Vector3(0.f));
+		return stream;
+	}
+
+	BoundsStream GenerateBounds(size_t count, std::mt19937& rng)
+	{
+		std::uniform_real_distribution<float> pos(-1000.f, 1000.f);
+		std::uniform_real_distribution<float> size(0.5f, 10.f);
+		BoundsStream bounds;
+		for (size_t i = 0; i < count; ++i)
+		{
+			Vector3 center(pos(rng), pos(rng), pos(rng));
+			Vector3 extent(size(rng), size(rng), size(rng));
+			bounds.Add(Box(center - extent, center + extent), Sphere(center, extent.GetLength()));
+		}
+		return bounds;
+	}
+
+	Matrix4x3 GenerateMatrix()
+	{
+		Matrix4x3 mat;
+		mat.SetPitchYawRoll(DegreeToRadian(30.f), DegreeToRadian(45.f), DegreeToRadian(60.f));
+		mat.SetScale(Vector3(1.5f, 0.5f, 2.f));
+		mat.SetTranslation(Vector3(10.f, -20.f, 5.f));
+		return mat;
+	}
+
+	float MaxError(const float* lhs, const float* rhs, size_t count)
+	{
+		float error = 0.f;
+		for (size_t i = 0; i < count; ++i)
+			error = Max(error, Fabs(lhs[i] - rhs[i]) / Max(1.f, Fabs(rhs[i])));
+		return error;
+	}
+
+	float MaxError(const Vector3Stream& lhs, const Vector3Stream& rhs)
+	{
+		return Max(MaxError(lhs.X(), rhs.X(), lhs.Size()), MaxError(lhs.Y(), rhs.Y(), lhs.Size()), MaxError(lhs.Z(), rhs.Z(), lhs.Size()));
+	}
+
+	float MaxError(const BoundsStream& lhs, const BoundsStream& rhs)
+	{
+		const size_t n = lhs.Size();
+		return Max(
+			Max(MaxError(lhs.CenterX.data(), rhs.CenterX.data(), n), MaxError(lhs.CenterY.data(), rhs.CenterY.data(), n), MaxError(lhs.CenterZ.data(), rhs.CenterZ.data(), n)),
+			Max(MaxError(lhs.ExtentX.data(), rhs.ExtentX.data(), n), MaxError(lhs.ExtentY.data(), rhs.ExtentY.data(), n), MaxError(lhs.ExtentZ.data(), rhs.ExtentZ.data(), n)),
+			MaxError(lhs.Radius.data(), rhs.Radius.data(), n)
+		);
+	}
+
+	template<typename TFunc>
+	double Measure(TFunc&& func)
+	{
+		Timer timer;
+		for (uint32_t i = 0; i < REPEAT; ++i)
+			func();
+		return timer.ElapsedMs() / REPEAT;
+	}
+
+	template<typename TOutput, typename TSimd, typename TScalar>
+	void RunKernel(const char* name, size_t count, TOutput& simdOut, TOutput& scalarOut, TSimd&& simd, TScalar&& scalar)
+	{
+		Report("simd", name, count, "ms", Measure(simd));
+		Report("scalar", name, count, "ms", Measure(scalar));
+		CheckError("simd", std::string(name) + "_max_error", count, "relative", MaxError(simdOut, scalarOut), SIMD_TOLERANCE);
+	}
+
+	void RunCase(size_t count, std::mt19937& rng)
+	{
+		const Matrix4x3 mat = GenerateMatrix();
+		Vector3Stream lhs = GenerateStream(count, rng);
+		Vector3Stream rhs = GenerateStream(count, rng);
+		Vector3Stream simdOut, scalarOut;
+
+		RunKernel("transform_points", count, simdOut, scalarOut,
+			[&]() { VectorStream::TransformPoints(mat, lhs, simdOut); DoNotOptimize(simdOut); },
+			[&]() { VectorStream::Scalar::TransformPoints(mat, lhs, scalarOut); DoNotOptimize(scalarOut); });
+
+		RunKernel("transform_vectors", count, simdOut, scalarOut,
+			[&]() { VectorStream::TransformVectors(mat, lhs, simdOut); DoNotOptimize(simdOut); },
+			[&]() { VectorStream::Scalar::TransformVectors(mat, lhs, scalarOut); DoNotOptimize(scalarOut); });
+
+		RunKernel("cross", count, simdOut, scalarOut,
+			[&]() { VectorStream::Cross(lhs, rhs, simdOut); DoNotOptimize(simdOut); },
+			[&]() { VectorStream::Scalar::Cross(lhs, rhs, scalarOut); DoNotOptimize(scalarOut); });
+
+		RunKernel("normalize", count, simdOut, scalarOut,
+			[&]() { VectorStream::Normalize(lhs, simdOut); DoNotOptimize(simdOut); },
+			[&]() { VectorStream::Scalar::Normalize(lhs, scalarOut); DoNotOptimize(scalarOut); });
+
+		std::vector<float> simdDots(count), scalarDots(count);
+		Report("simd", "dot", count, "ms", Measure([&]() { VectorStream::Dot(lhs, rhs, simdDots.data()); DoNotOptimize(simdDots); }));
+		Report("scalar", "dot", count, "ms", Measure([&]() { VectorStream::Scalar::Dot(lhs, rhs, scalarDots.data()); DoNotOptimize(scalarDots); }));
+		CheckError("simd", "dot_max_error", count, "relative", MaxError(simdDots.data(), scalarDots.data(), count), SIMD_TOLERANCE);
+
+		// per element Matrix4x3 / Box path the kernels replace
+		std::vector<Vector3> aos(count);
+		for (size_t i = 0; i < count; ++i)
+			aos[i] = lhs.Get(i);
+		Report("aos", "transform_points", count, "ms", Measure([&]() {
+			for (Vector3& v : aos)
+				v = mat.TransformPoint(v);
+			DoNotOptimize(aos);
+		}));
+
+		BoundsStream bounds = GenerateBounds(count, rng);
+		BoundsStream simdBounds, scalarBounds;
+		RunKernel("transform_bounds", count, simdBounds, scalarBounds,
+			[&]() { VectorStream::TransformBounds(mat, bounds, simdBounds); DoNotOptimize(simdBounds); },
+			[&]() { VectorStream::Scalar::TransformBounds(mat, bounds, scalarBounds); DoNotOptimize(scalarBounds); });
+
+		// world = local * parentWorld as the transform hierarchy issues it, every other matrix is a parent
+		{
+			std::vector<Matrix4x3> locals(count, mat), simdWorlds(count, mat), scalarWorlds(count, mat);
+			for (size_t i = 0; i < count; ++i)
+				locals[i].SetTranslation(lhs.Get(i));
+			std::vector<uint32_t> indices, parents;
+			for (uint32_t i = 1; i < count; i += 2)
+			{
+				indices.push_back(i);
+				parents.push_back(i - 1);
+			}
+			Report("simd", "multiply_affine_indexed", count, "ms", Measure([&]() {
+				VectorStream::MultiplyAffineIndexed(locals.data(), simdWorlds.data(), simdWorlds.data(), indices.data(), parents.data(), indices.size());
+				DoNotOptimize(simdWorlds);
+			}));
+			Report("scalar", "multiply_affine_indexed", count, "ms", Measure([&]() {
+				VectorStream::Scalar::MultiplyAffineIndexed(locals.data(), scalarWorlds.data(), scalarWorlds.data(), indices.data(), parents.data(), indices.size());
+				DoNotOptimize(scalarWorlds);
+			}));
+			CheckError("simd", "multiply_affine_indexed_max_error", count, "relative", MaxError(
+				reinterpret_cast<const float*>(simdWorlds.data()), reinterpret_cast<const float*>(scalarWorlds.data()), count * Matrix4x3::DIMENSION), SIMD_TOLERANCE);
+		}
+
+		// the stream result must also agree with Box::Transform
+		float boxError = 0.f;
+		for (size_t i = 0; i < count; ++i)
+		{
+			Vector3 center(bounds.CenterX[i], bounds.CenterY[i], bounds.CenterZ[i]);
+			Vector3 extent(bounds.ExtentX[i], bounds.ExtentY[i], bounds.ExtentZ[i]);
+			Box box = Box(center - extent, center + extent).Transform(mat);
+			Vector3 c = box.GetCenter(), e = box.GetExtent();
+			const float expect[6] = { c.x, c.y, c.z, e.x, e.y, e.z };
+			const float actual[6] = { simdBounds.CenterX[i], simdBounds.CenterY[i], simdBounds.CenterZ[i], simdBounds.ExtentX[i], simdBounds.ExtentY[i], simdBounds.ExtentZ[i] };
+			boxError = Max(boxError, MaxError(actual, expect, 6));
+		}
+		CheckError("simd", "transform_bounds_box_error", count, "relative", boxError, BOX_TOLERANCE);
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(20221017);
+	ReportHeader();
+	for (size_t count : { 7, 1000, 100000, 1000000 })
+	{
+		RunCase(count, rng);
+	}
+	return ExitCode();
+}
\ No newline at end of file
@@ -6,6 +6,7 @@ echo %ROOT_DIR%
 
 %ROOT_DIR%\Libraries\VulkanSDK\glslc.exe shader.vert -O0 -o vert.spv
 %ROOT_DIR%\Libraries\VulkanSDK\glslc.exe shader.frag -O0 -o frag.spv
+%ROOT_DIR%\Libraries\VulkanSDK\glslc.exe instanced.vert -O0 -o instanced.vert.spv
 
 %ROOT_DIR%\Libraries\VulkanSDK\glslc.exe ui.vert -O0 -o ui.vert.spv
 %ROOT_DIR%\Libraries\VulkanSDK\glslc.exe ui.frag -O0 -o ui.frag.spv
@@ -2,7 +2,7 @@
 
 namespace zyh
 {
-	void Camera::handleInputKeyDown(WPARAM key)
+	void Camera::handleInputKeyDown(KEY_TYPE key)
 	{
 		switch (key)
 		{
@@ -26,7 +26,7 @@ namespace zyh
 		}
 	}
 
-	void Camera::handleInputKeyUp(WPARAM key)
+	void Camera::handleInputKeyUp(KEY_TYPE key)
 	{
 		switch (key)
 		{
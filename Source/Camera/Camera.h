@@ -1,11 +1,11 @@
 #pragma once
 #include "Math/Matrix4x3.h"
 #include "Math/Matrix4x4.h"
+#include "Math/Frustum.h"
 #include "Math/MathUtil.h"
 #include "Common/KeyCodes.h"
 #include "Core/InputSystem.h"
 #include "Core/Engine.h"
-#include <wtypes.h>
 #include <cstdint>
 
 
@@ -65,8 +65,8 @@ namespace zyh
 		void EventMouseMove(KEY_TYPE x, KEY_TYPE y) { this->handleMouseMove(x, y, GEngine->GetDeltaTime()); }
 
 	private:
-		void handleInputKeyDown(WPARAM key);
-		void handleInputKeyUp(WPARAM key);
+		void handleInputKeyDown(KEY_TYPE key);
+		void handleInputKeyUp(KEY_TYPE key);
 		void handleMouseButtonDown(EMOUSE_BUTTON key, int32_t x, int32_t y);
 		void handleMouseButtonUp(EMOUSE_BUTTON key, int32_t x, int32_t y);
 		void handleMouseWheel(short delta);
@@ -83,6 +83,7 @@ namespace zyh
 	public:
 		Matrix4x3 getViewMatrix() const { return mTransform_.GetInverse(); }
 		const Matrix4x4& getProjMatrix() const { return mProjMatrix_; }
+		Frustum getFrustum() const { return Frustum(getViewMatrix(), mProjMatrix_); }
 		const float getFov() { return mFov_; }
 
 	public:
@@ -30,10 +30,13 @@
 #include <vector>
 #include <map>
 #include <functional>
+#include <tuple>
 #include <stdint.h>
 #include <time.h>
 #include <chrono>
 #include <vector>
+#include <array>
+#include <span>
 
 
 enum RenderSet : uint32_t
@@ -46,6 +49,8 @@ enum RenderSet : uint32_t
 	POSTPROCESS = 5,
 
 };
+// RenderSet is dense from 0, per set data lives in arrays of this size
+constexpr size_t RENDER_SET_COUNT = RenderSet::POSTPROCESS + 1;
 
 typedef std::vector<RenderSet> TRenderSets;
 
@@ -61,7 +66,10 @@ struct MakeSeqs<1, I...>
 	template<class T, class _Fx>
 	static auto bind(T&& _Obj, _Fx&& _Func)
 	{
-		return std::bind(std::forward<_Fx>(_Func), std::forward<T>(_Obj), std::_Ph<I>{}...);
+		using namespace std::placeholders;
+		static_assert(sizeof...(I) <= 8, "bound member functions take at most 8 arguments");
+		const auto placeholders = std::make_tuple(_1, _2, _3, _4, _5, _6, _7, _8);
+		return std::bind(std::forward<_Fx>(_Func), std::forward<T>(_Obj), std::get<I - 1>(placeholders)...);
 	}
 };
 
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 
 #if defined(_WIN32)
 #define KEY_ESCAPE VK_ESCAPE 
@@ -12,6 +13,20 @@
 #define KEY_RSHIFT VK_RSHIFT
 #define KEY_LCTRL VK_LCONTROL
 #define KEY_RCTRL VK_RCONTROL
+#else
+// no input backend outside Win32 yet, the same virtual key values keep bindings portable
+#define KEY_ESCAPE 0x1B
+#define KEY_F1 0x70
+#define KEY_F2 0x71
+#define KEY_F3 0x72
+#define KEY_F4 0x73
+#define KEY_F5 0x74
+
+#define KEY_LSHIFT 0xA0
+#define KEY_RSHIFT 0xA1
+#define KEY_LCTRL 0xA2
+#define KEY_RCTRL 0xA3
+#endif
 
 #define KEY_W 0x57
 #define KEY_A 0x41
@@ -38,5 +53,4 @@ enum EMOUSE_BUTTON : char
 	RIGHT,
 };
 
-typedef uint32_t KEY_TYPE;
-#endif
\ No newline at end of file
+typedef uint32_t KEY_TYPE;
\ No newline at end of file
@@ -4,10 +4,23 @@
 
 namespace Setting
 {
-	static std::string AppTitle = "Vulkan";
-	static std::string EngineName = "VulkanEngineName";
-	static uint32_t AppWidth = 800;
-	static uint32_t AppHeight = 600;
-	static bool IsFullscreen = false;
-	static bool IsDebugMode = true;
+	// inline so a value changed at startup (command line) is seen by every translation unit
+	inline std::string AppTitle = "Vulkan";
+	inline std::string EngineName = "VulkanEngineName";
+	inline uint32_t AppWidth = 800;
+	inline uint32_t AppHeight = 600;
+	inline bool IsFullscreen = false;
+	inline bool IsDebugMode = true;
+	// seconds per simulation step, 0 steps once per frame with the measured delta time
+	inline float FixedTimestep = 0.f;
+	// 0 is uncapped
+	inline float MaxFrameRate = 0.f;
+	// no window / surface / swapchain, frames are rendered into offscreen images
+	inline bool IsHeadless = false;
+	// Engine::Run exits after this many frames, 0 runs until the window is closed
+	inline uint64_t FrameCount = 0;
+	// headless: the last frame is read back and written here as a binary ppm, empty skips it
+	inline std::string CapturePath = "";
+	// compiled pipelines are kept here between runs, empty compiles everything from SPIR-V every launch
+	inline std::string PipelineCachePath = "pipeline_cache.bin";
 }
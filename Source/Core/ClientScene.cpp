@@ -1,16 +1,37 @@
 #include "Core/ClientScene.h"
 #include "IEntity.h"
+#include "ECS/Components.h"
 #include "Graphics/Common/IRenderScene.h"
+#include "Graphics/Common/IRenderElement.h"
 #include "IPrimitivesComponent.h"
 #include "TerrainComponent.h"
 #include "Camera/Camera.h"
+#include "Core/JobSystem.h"
 #include "Graphics/Common/Renderer.h"
 
 #include "File/FileSystem.h"
+#include "Common/Setting.h"
+#include <iostream>
+#include <cstring>
 
 
 namespace zyh
 {
+	ClientScene::ClientScene(JobSystem& jobs) : mCommands_(jobs)
+	{
+		// local transforms set during the update reach the hierarchy in one linear walk over the pool
+		AddSystem([this](EntityRegistry& registry, float)
+			{
+				registry.Each<TransformComponent>([this](EntityId, TransformComponent& transform)
+					{
+						if (!transform.Dirty)
+							return;
+						mTransforms_.SetLocal(transform.Handle, transform.Local);
+						transform.Dirty = false;
+					});
+			}, ESystemPhase::COMMIT);
+	}
+
 	void ClientScene::Initialize()
 	{
 		mRenderScene_ = new IRenderScene();
@@ -19,48 +40,112 @@ namespace zyh
 
 		mRenderer_->Build();
 		LoadScene();
+		mRenderer_->Start();
 	}
 
 	void ClientScene::Tick()
 	{
 		DispatchOSMessage();
-		DispatchTickEvent();
-		mCamera_->tick(GEngine->GetDeltaTime());
 
-		// Tick Render Scene(TODO: MultiThread)
-		mRenderer_->Draw();
+		// with a fixed timestep a frame runs zero or more steps, the snapshot interpolates between the last two
+		const FrameScheduler& scheduler = GEngine->GetScheduler();
+		for (uint32_t step = 0; step < scheduler.GetStepCount(); ++step)
+		{
+			DispatchTickEvent();
+			FlushCommands();
+			UpdateTransforms();
+		}
+		mCamera_->tick(scheduler.GetFrameDeltaTime());
+		CollectAllRenderElements();
+
+		// the render thread draws it one frame behind
+		PublishRenderSnapshot(scheduler.IsFixedTimestep() ? scheduler.GetInterpolationAlpha() : 1.f);
 	}
 
 	void ClientScene::CleanUp()
 	{
+		mRenderer_->Stop();
+		if (Setting::IsHeadless)
+			mRenderer_->PrintDrawStats();
+		if (Setting::IsHeadless && !Setting::CapturePath.empty() && !mRenderer_->CaptureFrame(Setting::CapturePath))
+			std::cerr << "failed to capture frame to " << Setting::CapturePath << std::endl;
 		SafeDestroy(mRenderScene_);
 	}
 
 	void ClientScene::AddEntity(IEntity* entity)
 	{
-		HYBRID_CHECK(std::find(mEntitys_.begin(), mEntitys_.end(), entity) == mEntitys_.end());
-		mEntitys_.push_back(entity);
+		HYBRID_CHECK(!mUpdating_);
+		HYBRID_CHECK(!mEntitys_.Contains(entity->mSceneHandle_));
+		entity->mSceneHandle_ = mEntitys_.Insert(entity);
+		mTransformOwners_[entity->GetTransformHandle()] = entity;
 	}
 
 	void ClientScene::DelEntity(IEntity* entity)
 	{
-		auto itr = std::find(mEntitys_.begin(), mEntitys_.end(), entity);
-		if (itr != mEntitys_.end())
-			mEntitys_.erase(itr);
+		HYBRID_CHECK(!mUpdating_);
+		if (!mEntitys_.Remove(entity->mSceneHandle_))
+			return;
+		entity->mSceneHandle_ = SlotHandle();
+		mTransformOwners_.erase(entity->GetTransformHandle());
+	}
+
+	void ClientScene::AddEntities(const std::vector<IEntity*>& entities)
+	{
+		mEntitys_.Reserve(mEntitys_.Size() + entities.size());
+		mTransformOwners_.reserve(mTransformOwners_.size() + entities.size());
+		for (IEntity* entity : entities)
+		{
+			AddEntity(entity);
+		}
+	}
+
+	void ClientScene::DelEntities(const std::vector<IEntity*>& entities)
+	{
+		for (IEntity* entity : entities)
+		{
+			DelEntity(entity);
+		}
 	}
 
 	void ClientScene::AddPrimitive(IPrimitivesComponent* prim)
 	{
-		HYBRID_CHECK(std::find(mPrimitives_.begin(), mPrimitives_.end(), prim) == mPrimitives_.end());
-		mPrimitives_.push_back(prim);
+		HYBRID_CHECK(!mUpdating_);
+		HYBRID_CHECK(!mPrimitives_.Contains(prim->mSceneHandle_));
+		prim->mSceneHandle_ = mPrimitives_.Insert(prim);
 		mPrimitiveTree_.InsertNode(prim);
+		mCullingDirty_ = true;
 	}
 
 	void ClientScene::DelPrimitive(IPrimitivesComponent* prim)
 	{
-		auto itr = std::find(mPrimitives_.begin(), mPrimitives_.end(), prim);
-		if (itr != mPrimitives_.end())
-			mPrimitives_.erase(itr);
+		HYBRID_CHECK(!mUpdating_);
+		if (!mPrimitives_.Remove(prim->mSceneHandle_))
+			return;
+		prim->mSceneHandle_ = SlotHandle();
+		mPrimitiveTree_.RemoveNode(prim);
+		mCullingDirty_ = true;
+
+		// the render scene must not keep the elements of a deleted primitive until the next cull
+		if (prim->mIsVisible_ && mRenderScene_)
+			HidePrimitive(prim);
+		_SwapRemove(mVisiblePrimitives_, &IPrimitivesComponent::mVisibleIndex_, prim);
+		_SwapRemove(mRefreshPrimitives_, &IPrimitivesComponent::mRefreshIndex_, prim);
+	}
+
+	void ClientScene::UpdatePrimitive(IPrimitivesComponent* prim)
+	{
+		mPrimitiveTree_.UpdateNode(prim);
+		mCullingDirty_ = true;
+	}
+
+	void ClientScene::RefreshPrimitive(IPrimitivesComponent* prim)
+	{
+		HYBRID_CHECK(!mUpdating_);
+		if (!prim->mIsVisible_)
+			return;
+		HidePrimitive(prim);
+		prim->mRefreshIndex_ = uint32_t(mRefreshPrimitives_.size());
+		mRefreshPrimitives_.push_back(prim);
 	}
 
 	bool ClientScene::AddRenderElement(RenderSet renderSet, IRenderElement* element)
@@ -68,19 +153,17 @@ namespace zyh
 		return mRenderScene_->AddRenderElement(renderSet, element);
 	}
 
-	void ClientScene::GetRenderElements(RenderSet renderSet, std::vector<IRenderElement*>& elements)
+	std::span<IRenderElement* const> ClientScene::GetRenderElements(RenderSet renderSet) const
 	{
-		mRenderScene_->GetRenderElements(renderSet, elements);
+		return mRenderScene_->GetRenderElements(renderSet);
 	}
 
 	void ClientScene::LoadScene()
 	{
 		SceneXmlParser parser("Resource/files/scene.xml");
 		parser.Load();
-		for (auto* entity : parser.GetEntities())
-		{
-			AddEntity(entity);
-		}
+		AddEntities(parser.GetEntities());
+		UpdateTransforms();
 		CollectAllRenderElements();
 	}
 
@@ -93,17 +176,129 @@ namespace zyh
 
 	void ClientScene::DispatchTickEvent()
 	{
-		for (IEntity* entity : mEntitys_)
+		mUpdating_ = true;
+		RunSystems(ESystemPhase::UPDATE);
+
+		const std::vector<IEntity*>& entities = mEntitys_.GetValues();
+		GEngine->Jobs->ParallelFor(0, entities.size(), ENTITY_TICK_BATCH_SIZE, [&entities](size_t begin, size_t end)
+			{
+				for (size_t i = begin; i < end; ++i)
+				{
+					SceneCommandBuffer::SetSource(i);
+					entities[i]->Tick();
+				}
+				SceneCommandBuffer::ClearSource();
+			});
+		mUpdating_ = false;
+
+		// edits terrain shared by every entity, stays on the main thread
+		HeightMapManipulator::getInstance()->tick();
+	}
+
+	void ClientScene::FlushCommands()
+	{
+		mCommands_.Flush(*this);
+	}
+
+	void ClientScene::UpdateTransforms()
+	{
+		RunSystems(ESystemPhase::COMMIT);
+		mTransforms_.Update();
+		mTransformsChanged_ |= !mTransforms_.GetChangedHandles().empty();
+		for (TransformHierarchy::Handle handle : mTransforms_.GetChangedHandles())
 		{
-			entity->Tick();
+			auto iter = mTransformOwners_.find(handle);
+			if (iter != mTransformOwners_.end())
+				iter->second->OnWorldTransformChanged();
+		}
+	}
+
+	void ClientScene::RunSystems(ESystemPhase phase)
+	{
+		const float deltaTime = GEngine->GetDeltaTime();
+		for (SceneSystem& system : mSystems_[size_t(phase)])
+		{
+			system(mRegistry_, deltaTime);
 		}
-		HeightMapManipulator::getInstance()->tick();
 	}
 
 	void ClientScene::CollectAllRenderElements()
 	{
-		CollectRenderElements(RenderSet::SCENE);
-		CollectRenderElements(RenderSet::XRAY);
+		const Matrix4x3 view = mCamera_->getViewMatrix();
+		const Matrix4x4& proj = mCamera_->getProjMatrix();
+		if (mCullingDirty_ || !(view == mCulledView_) || memcmp(&proj, &mCulledProj_, sizeof(Matrix4x4)) != 0)
+		{
+			mCulledView_ = view;
+			mCulledProj_ = proj;
+			mCullingDirty_ = false;
+			Culling(Frustum(view, proj));
+			UpdateVisibleSet();
+		}
+
+		// withdrawn by RefreshPrimitive, back in if UpdateVisibleSet did not already show / hide them
+		for (IPrimitivesComponent* prim : mRefreshPrimitives_)
+		{
+			prim->mRefreshIndex_ = IPrimitivesComponent::INVALID_LIST_INDEX;
+			if (!prim->mIsVisible_ && prim->mVisibleStamp_ == mVisibleStamp_)
+				ShowPrimitive(prim);
+		}
+		mRefreshPrimitives_.clear();
+	}
+
+	void ClientScene::PublishRenderSnapshot(float alpha)
+	{
+		RenderSnapshot& snapshot = mRenderer_->BeginSnapshot();
+		snapshot.Frame = GEngine->GetCurrFrame();
+		snapshot.DeltaTime = GEngine->GetScheduler().GetFrameDeltaTime();
+		snapshot.ViewMatrix = mCamera_->getViewMatrix();
+		snapshot.ProjMatrix = mCamera_->getProjMatrix();
+		snapshot.Fov = mCamera_->getFov();
+		const HeightMapManipulator* manipulator = HeightMapManipulator::getInstance();
+		snapshot.TerrainEdit = TerrainEditSettings{ manipulator->mEnable_, manipulator->modifyTerrainOffset, manipulator->modifyTerrainRange };
+
+		snapshot.DirectionalLight = DirectionLight
+		(
+			Vector3(0.5f, 0.5f, 1.0f),
+			Vector3(0.1f, 0.1f, 0.1f),
+			Vector3(0.5f, 0.5f, 0.5f),
+			Vector3(0.2f, 0.2f, 0.2f)
+		);
+		snapshot.PointLights.push_back(PointLight
+		(
+			Vector3(-0.5f, -0.5f, 1.0f),
+			Vector3(0.1f, 0.1f, 0.1f),
+			Vector3(0.3f, 0.3f, 0.3f),
+			Vector3(0.3f, 0.3f, 0.3f)
+		));
+		snapshot.Spot = SpotLight
+		(
+			Vector3(0.5f, 0.5f, 1.0f),
+			Vector3(-0.5f, -0.5f, -1.0f),
+			Vector3(0.3f, 0.3f, 0.3f),
+			Vector3(0.5f, 0.5f, 0.5f),
+			Vector3(0.3f, 0.3f, 0.3f)
+		);
+
+		// changed handles still differ from their previous world matrix, so they move with alpha until the next step
+		const bool interpolated = !mTransforms_.GetChangedHandles().empty();
+		if (mTransformsChanged_ || interpolated || mPublishedInterpolated_)
+			++mTransformGeneration_;
+		mTransformsChanged_ = false;
+		mPublishedInterpolated_ = interpolated;
+		snapshot.TransformGeneration = mTransformGeneration_;
+
+		for (uint32_t renderSet = 0; renderSet < RENDER_SET_COUNT; ++renderSet)
+		{
+			snapshot.Generations[renderSet] = mRenderScene_->GetGeneration(RenderSet(renderSet));
+			std::span<IRenderElement* const> elements = mRenderScene_->GetRenderElements(RenderSet(renderSet));
+			std::vector<RenderItem>& items = snapshot.Items[renderSet];
+			items.reserve(elements.size());
+			for (IRenderElement* element : elements)
+			{
+				items.push_back(RenderItem{ element, element->GetWorldTransform(alpha) });
+			}
+		}
+		mRenderer_->SubmitSnapshot();
 	}
 
 	void ClientScene::Serialize(Archive* ar)
@@ -122,25 +317,85 @@ namespace zyh
 		ar->EndSection();
 	}
 
-	void ClientScene::CollectRenderElements(RenderSet renderSet)
+	void ClientScene::UpdateVisibleSet()
 	{
-		mPrimitivesAfterCulling_.clear();
-		mRenderScene_->Clear(renderSet);
+		// stamp this cull's primitives, whatever the last visible set has left unstamped went out of view
+		++mVisibleStamp_;
+		for (uint32_t i = 0; i < mPrimitivesAfterCulling_.size(); ++i)
+		{
+			IPrimitivesComponent* prim = mPrimitivesAfterCulling_[i];
+			prim->mVisibleStamp_ = mVisibleStamp_;
+			prim->mVisibleIndex_ = i;
+			if (!prim->mIsVisible_)
+				ShowPrimitive(prim);
+		}
+		for (IPrimitivesComponent* prim : mVisiblePrimitives_)
+		{
+			if (prim->mVisibleStamp_ == mVisibleStamp_)
+				continue;
+			prim->mVisibleIndex_ = IPrimitivesComponent::INVALID_LIST_INDEX;
+			if (prim->mIsVisible_)
+				HidePrimitive(prim);
+		}
+		mVisiblePrimitives_.swap(mPrimitivesAfterCulling_);
+	}
 
-		Culling(renderSet);
-		for (IPrimitivesComponent* prim : mPrimitivesAfterCulling_)
+	void ClientScene::ShowPrimitive(IPrimitivesComponent* prim)
+	{
+		for (RenderSet renderSet : VISIBLE_RENDER_SETS)
 		{
 			prim->EmitRenderElements(renderSet, *mRenderScene_);
 		}
+		prim->mIsVisible_ = true;
+	}
+
+	void ClientScene::HidePrimitive(IPrimitivesComponent* prim)
+	{
+		for (RenderSet renderSet : VISIBLE_RENDER_SETS)
+		{
+			prim->WithdrawRenderElements(renderSet, *mRenderScene_);
+		}
+		prim->mIsVisible_ = false;
 	}
 
-	void ClientScene::Culling(RenderSet renderSet)
+	void ClientScene::_SwapRemove(std::vector<IPrimitivesComponent*>& list, uint32_t IPrimitivesComponent::* index, IPrimitivesComponent* prim)
 	{
-		for (IPrimitivesComponent* prim : mPrimitives_)
+		const uint32_t slot = prim->*index;
+		if (slot >= list.size() || list[slot] != prim)
+			return;
+		IPrimitivesComponent* last = list.back();
+		list[slot] = last;
+		last->*index = slot;
+		list.pop_back();
+		prim->*index = IPrimitivesComponent::INVALID_LIST_INDEX;
+	}
+
+	void ClientScene::Culling(const Frustum& frustum)
+	{
+		mPrimitivesAfterCulling_.clear();
+		mCullingCandidates_.clear();
+		mPrimitiveTree_.Query(frustum, mPrimitivesAfterCulling_, mCullingCandidates_);
+
+		// primitives in partially visible nodes are tested in batch
+		mCullingBounds_.Clear();
+		for (IPrimitivesComponent* prim : mCullingCandidates_)
 		{
-			if (prim->Culling())
-				mPrimitivesAfterCulling_.push_back(prim);
+			mCullingBounds_.Add(prim->GetBoundingBox(), prim->GetBoundingSphere());
 		}
+		mCullingVisibility_.resize(mCullingCandidates_.size());
+		GEngine->Jobs->ParallelFor(0, mCullingBounds_.Size(), CULLING_BATCH_SIZE, [&](size_t begin, size_t end)
+			{
+				frustum.TestBounds(mCullingBounds_, begin, end, mCullingVisibility_.data());
+			});
+		for (size_t i = 0; i < mCullingCandidates_.size(); ++i)
+		{
+			if (mCullingVisibility_[i])
+				mPrimitivesAfterCulling_.push_back(mCullingCandidates_[i]);
+		}
+
+		auto iter = std::remove_if(mPrimitivesAfterCulling_.begin(), mPrimitivesAfterCulling_.end(),
+			[](IPrimitivesComponent* prim) { return !prim->Culling(); });
+		mPrimitivesAfterCulling_.erase(iter, mPrimitivesAfterCulling_.end());
 	}
 
 	void ClientScene::DispatchOSMessage()
@@ -151,6 +406,7 @@ namespace zyh
 			TranslateMessage(&msg);
 			DispatchMessage(&msg);
 			if (msg.message == WM_QUIT) {
+				GEngine->RequestExit();
 				return;
 			}
 		}
@@ -3,6 +3,10 @@
 #include "Core/Engine.h"
 #include "Core/IObject.h"
 #include "Core/DataStructure/Octree.h"
+#include "Core/DataStructure/SlotMap.h"
+#include "Core/TransformHierarchy.h"
+#include "Core/ECS/EntityRegistry.h"
+#include "Core/SceneCommandBuffer.h"
 
 
 namespace zyh
@@ -18,49 +22,124 @@ namespace zyh
 	class ClientScene : virtual IObject
 	{
 	public:
+		// runs once per tick over the registry on the main thread, may fan out itself with EntityRegistry::ParallelEach
+		using SceneSystem = std::function<void(EntityRegistry& registry, float deltaTime)>;
+		enum class ESystemPhase : uint8_t
+		{
+			// update phase, before the per entity Tick()
+			UPDATE,
+			// commit phase, after the recorded commands are applied and before the hierarchy update
+			COMMIT,
+			COUNT,
+		};
+
+	public:
+		explicit ClientScene(JobSystem& jobs);
+
 		void Initialize();
 		void Tick();
 		void CleanUp();
 
 		void AddEntity(IEntity* entity);
 		void DelEntity(IEntity* entity);
+		void AddEntities(const std::vector<IEntity*>& entities);
+		void DelEntities(const std::vector<IEntity*>& entities);
 
 		void AddPrimitive(IPrimitivesComponent* prim);
 		void DelPrimitive(IPrimitivesComponent* prim);
+		void UpdatePrimitive(IPrimitivesComponent* prim);
+		// runs from VulkanModel::ElementsChanging before the primitive's model changes its elements, they leave
+		// the render scene now and are emitted again by the next CollectAllRenderElements if still visible
+		void RefreshPrimitive(IPrimitivesComponent* prim);
 
 		/// RenderScene Utility
 		bool AddRenderElement(RenderSet renderset, IRenderElement* element);
-		void GetRenderElements(RenderSet renderSet, std::vector<IRenderElement*>& elements);
+		std::span<IRenderElement* const> GetRenderElements(RenderSet renderSet) const;
 
+		// reculls only when the camera or a primitive moved, then adds / removes the elements of
+		// primitives entering / leaving the visible set instead of rebuilding the render sets
 		void CollectAllRenderElements();
+		// copies the visible elements, their world matrices, camera and lights for the render thread.
+		// alpha interpolates the world matrices between the previous and the last simulation step
+		void PublishRenderSnapshot(float alpha = 1.f);
 
 	public:
 		virtual void Serialize(class Archive* ar) override;
 		IRenderScene* GetRenderScene() { return mRenderScene_; }
+		class Renderer* GetRenderer() { return mRenderer_; }
 
 	protected:
 		void LoadScene();
 		void SaveScene();
 
 	protected:
+		// update phase: systems, then entities ticked in parallel, structural changes are recorded
 		void DispatchTickEvent();
-		void CollectRenderElements(RenderSet renderSet);
-		void Culling(RenderSet renderSet);
+		// sync point: applies the recorded structural changes
+		void FlushCommands();
+		// commit phase: local transforms into the hierarchy, world matrices and bounds out of it
+		void UpdateTransforms();
+		void RunSystems(ESystemPhase phase);
+		void UpdateVisibleSet();
+		void ShowPrimitive(IPrimitivesComponent* prim);
+		void HidePrimitive(IPrimitivesComponent* prim);
+		void Culling(const Frustum& frustum);
+		// O(1) removal from a list indexed by the given IPrimitivesComponent slot member
+		void _SwapRemove(std::vector<IPrimitivesComponent*>& list, uint32_t IPrimitivesComponent::* index, IPrimitivesComponent* prim);
 		void DispatchOSMessage();
 
 	public:
 		Camera* GetCamera() { return mCamera_; }
+		TransformHierarchy& GetTransforms() { return mTransforms_; }
+		EntityRegistry& GetRegistry() { return mRegistry_; }
+		void AddSystem(const SceneSystem& system, ESystemPhase phase = ESystemPhase::UPDATE) { mSystems_[size_t(phase)].push_back(system); }
+		// record spawns / deletes / reparenting here while the scene updates
+		SceneCommandBuffer& GetCommands() { return mCommands_; }
+		// true during DispatchTickEvent, structural changes must be recorded instead of applied
+		bool IsUpdating() const { return mUpdating_; }
 
 	private:
-		std::vector<IEntity*> mEntitys_;
-		std::vector<IPrimitivesComponent*> mPrimitives_;
+		// handles are kept on the objects (IEntity / IPrimitivesComponent::mSceneHandle_)
+		SlotMap<IEntity*> mEntitys_;
+		SlotMap<IPrimitivesComponent*> mPrimitives_;
 		std::vector<IPrimitivesComponent*> mPrimitivesAfterCulling_;
+		// primitives whose elements are in the render scene, mVisibleStamp_ tags the current ones
+		std::vector<IPrimitivesComponent*> mVisiblePrimitives_;
+		std::vector<IPrimitivesComponent*> mRefreshPrimitives_;
+		uint32_t mVisibleStamp_{ 0 };
+		static constexpr RenderSet VISIBLE_RENDER_SETS[] = { RenderSet::SCENE, RenderSet::XRAY };
+
+		// culling reruns only if these changed or mCullingDirty_ is set by a primitive change
+		bool mCullingDirty_{ true };
+		Matrix4x3 mCulledView_;
+		Matrix4x4 mCulledProj_;
+
+		// per frame culling scratch, candidates are tested in jobs of CULLING_BATCH_SIZE
+		static constexpr size_t CULLING_BATCH_SIZE = 1024;
+		std::vector<IPrimitivesComponent*> mCullingCandidates_;
+		BoundsStream mCullingBounds_;
+		std::vector<uint8_t> mCullingVisibility_;
 
 		IRenderScene* mRenderScene_;
 		class Renderer* mRenderer_;
 		Camera* mCamera_;
 
 		Octree<IPrimitivesComponent> mPrimitiveTree_;
+
+		EntityRegistry mRegistry_;
+		std::array<std::vector<SceneSystem>, size_t(ESystemPhase::COUNT)> mSystems_;
+
+		SceneCommandBuffer mCommands_;
+		bool mUpdating_{ false };
+		static constexpr size_t ENTITY_TICK_BATCH_SIZE = 64;
+
+		TransformHierarchy mTransforms_;
+		// feeds RenderSnapshot::TransformGeneration
+		uint64_t mTransformGeneration_{ 0 };
+		bool mTransformsChanged_{ false };
+		bool mPublishedInterpolated_{ false };
+		// entity owning each transform handle
+		std::unordered_map<TransformHierarchy::Handle, IEntity*> mTransformOwners_;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,420 @@
+#include "BVH.h"
+
+#include <thread>
+#include <numeric>
+#include <algorithm>
+
+
+namespace zyh
+{
+	namespace
+	{
+		inline float HalfArea(const Box& box)
+		{
+			Vector3 d = box.GetMax() - box.GetMin();
+			return d.x * d.y + d.y * d.z + d.z * d.x;
+		}
+
+		inline float Component(const Vector3& v, uint32_t axis)
+		{
+			return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+		}
+
+		// slab test, returns entry distance or MAX_NUM on miss
+		inline float IntersectRayBox(const Vector3& origin, const Vector3& invDir, float maxDistance, const float bmin[3], const float bmax[3])
+		{
+			const float o[3] = { origin.x, origin.y, origin.z };
+			const float inv[3] = { invDir.x, invDir.y, invDir.z };
+			float tmin = 0.f;
+			float tmax = maxDistance;
+			for (int i = 0; i < 3; ++i)
+			{
+				float t0 = (bmin[i] - o[i]) * inv[i];
+				float t1 = (bmax[i] - o[i]) * inv[i];
+				if (t0 > t1)
+					std::swap(t0, t1);
+				tmin = Max(tmin, t0);
+				tmax = Min(tmax, t1);
+			}
+			return tmin <= tmax ? tmin : MAX_NUM;
+		}
+
+		inline float IntersectRayBox(const Vector3& origin, const Vector3& invDir, float maxDistance, const Box& box)
+		{
+			const float bmin[3] = { box.GetMin().x, box.GetMin().y, box.GetMin().z };
+			const float bmax[3] = { box.GetMax().x, box.GetMax().y, box.GetMax().z };
+			return IntersectRayBox(origin, invDir, maxDistance, bmin, bmax);
+		}
+
+		// popping a node and pushing both children keeps at most depth + 1 entries, SAH trees are not
+		// depth bounded so deep ones spill to the heap
+		class NodeStack
+		{
+		public:
+			static constexpr uint32_t INLINE_SIZE = 64;
+
+			explicit NodeStack(uint32_t depth)
+			{
+				if (depth + 1 > INLINE_SIZE)
+				{
+					mHeap_.resize(depth + 1);
+					mData_ = mHeap_.data();
+				}
+			}
+
+			bool IsEmpty() const { return mSize_ == 0; }
+			void Push(uint32_t nodeIndex) { mData_[mSize_++] = nodeIndex; }
+			uint32_t Pop() { return mData_[--mSize_]; }
+
+		private:
+			uint32_t mInline_[INLINE_SIZE];
+			std::vector<uint32_t> mHeap_;
+			uint32_t* mData_{ mInline_ };
+			uint32_t mSize_{ 0 };
+		};
+	}
+
+	void BVH::Build(const std::vector<Box>& bounds, uint32_t threadCount)
+	{
+		Clear();
+		const uint32_t count = static_cast<uint32_t>(bounds.size());
+		if (count == 0)
+			return;
+
+		mBounds_ = bounds;
+		mIndices_.resize(count);
+		std::iota(mIndices_.begin(), mIndices_.end(), 0);
+		mCentroids_.resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			mCentroids_[i] = mBounds_[i].GetCenter();
+		}
+
+		// a binary tree with at least one item per leaf has at most 2N-1 nodes,
+		// so nodes can be allocated from a fixed array by several threads
+		mNodes_.resize(2 * count - 1);
+		mNodeCount_ = 1;
+		mDepth_ = 0;
+
+		if (threadCount == 0)
+			threadCount = Max(1u, std::thread::hardware_concurrency());
+		uint32_t parallelDepth = 0;
+		while ((1u << parallelDepth) < threadCount)
+			++parallelDepth;
+
+		_BuildNode(0, 0, count, 0, parallelDepth);
+		mNodes_.resize(mNodeCount_);
+		mCentroids_.clear();
+		mCentroids_.shrink_to_fit();
+	}
+
+	void BVH::Refit(const std::vector<Box>& bounds)
+	{
+		HYBRID_CHECK(bounds.size() == mBounds_.size());
+		mBounds_ = bounds;
+
+		// children are always allocated after their parent, so a reverse sweep visits them first
+		for (size_t i = mNodes_.size(); i-- > 0;)
+		{
+			BVHNode& node = mNodes_[i];
+			Box box = Box::GetEmpty();
+			if (node.IsLeaf())
+			{
+				for (uint32_t j = 0; j < node.Count; ++j)
+					box.Merge(mBounds_[mIndices_[node.LeftFirst + j]]);
+			}
+			else
+			{
+				box.Merge(mNodes_[node.LeftFirst].GetBoundingBox());
+				box.Merge(mNodes_[node.LeftFirst + 1].GetBoundingBox());
+			}
+			node.SetBoundingBox(box);
+		}
+	}
+
+	void BVH::Clear()
+	{
+		mNodes_.clear();
+		mIndices_.clear();
+		mBounds_.clear();
+		mCentroids_.clear();
+		mNodeCount_ = 0;
+		mDepth_ = 0;
+	}
+
+	uint32_t BVH::Raycast(const Vector3& origin, const Vector3& direction, float maxDistance, float* outDistance) const
+	{
+		if (IsEmpty())
+			return INVALID_INDEX;
+
+		const Vector3 invDir(
+			1.f / (IsZero(direction.x) ? EPISILON : direction.x),
+			1.f / (IsZero(direction.y) ? EPISILON : direction.y),
+			1.f / (IsZero(direction.z) ? EPISILON : direction.z)
+		);
+
+		uint32_t hitIndex = INVALID_INDEX;
+		float closest = maxDistance;
+
+		NodeStack stack(mDepth_.load());
+		if (IntersectRayBox(origin, invDir, closest, mNodes_[0].BMin, mNodes_[0].BMax) != MAX_NUM)
+			stack.Push(0);
+
+		while (!stack.IsEmpty())
+		{
+			const BVHNode& node = mNodes_[stack.Pop()];
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = 0; i < node.Count; ++i)
+				{
+					uint32_t index = mIndices_[node.LeftFirst + i];
+					float t = IntersectRayBox(origin, invDir, closest, mBounds_[index]);
+					if (t < closest)
+					{
+						closest = t;
+						hitIndex = index;
+					}
+				}
+				continue;
+			}
+
+			uint32_t nearChild = node.LeftFirst;
+			uint32_t farChild = node.LeftFirst + 1;
+			float tNear = IntersectRayBox(origin, invDir, closest, mNodes_[nearChild].BMin, mNodes_[nearChild].BMax);
+			float tFar = IntersectRayBox(origin, invDir, closest, mNodes_[farChild].BMin, mNodes_[farChild].BMax);
+			if (tFar < tNear)
+			{
+				std::swap(nearChild, farChild);
+				std::swap(tNear, tFar);
+			}
+			// push the far child first so the near one is popped next
+			if (tFar != MAX_NUM)
+				stack.Push(farChild);
+			if (tNear != MAX_NUM)
+				stack.Push(nearChild);
+		}
+
+		if (outDistance && hitIndex != INVALID_INDEX)
+			*outDistance = closest;
+		return hitIndex;
+	}
+
+	void BVH::Query(const Box& box, std::vector<uint32_t>& outIndices) const
+	{
+		if (IsEmpty())
+			return;
+
+		NodeStack stack(mDepth_.load());
+		stack.Push(0);
+		while (!stack.IsEmpty())
+		{
+			uint32_t nodeIndex = stack.Pop();
+			const BVHNode& node = mNodes_[nodeIndex];
+			Box nodeBox = node.GetBoundingBox();
+			if (!box.Intersect(nodeBox))
+				continue;
+			if (box.Contains(nodeBox))
+			{
+				_CollectLeaves(nodeIndex, outIndices);
+				continue;
+			}
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = 0; i < node.Count; ++i)
+				{
+					uint32_t index = mIndices_[node.LeftFirst + i];
+					if (box.Intersect(mBounds_[index]))
+						outIndices.push_back(index);
+				}
+				continue;
+			}
+			stack.Push(node.LeftFirst + 1);
+			stack.Push(node.LeftFirst);
+		}
+	}
+
+	void BVH::Query(const Frustum& frustum, std::vector<uint32_t>& outIndices) const
+	{
+		if (IsEmpty())
+			return;
+
+		NodeStack stack(mDepth_.load());
+		stack.Push(0);
+		while (!stack.IsEmpty())
+		{
+			uint32_t nodeIndex = stack.Pop();
+			const BVHNode& node = mNodes_[nodeIndex];
+			EFrustumTest result = frustum.Test(node.GetBoundingBox());
+			if (result == EFrustumTest::OUTSIDE)
+				continue;
+			if (result == EFrustumTest::INSIDE)
+			{
+				_CollectLeaves(nodeIndex, outIndices);
+				continue;
+			}
+			if (node.IsLeaf())
+			{
+				for (uint32_t i = 0; i < node.Count; ++i)
+				{
+					uint32_t index = mIndices_[node.LeftFirst + i];
+					if (frustum.Intersect(mBounds_[index]))
+						outIndices.push_back(index);
+				}
+				continue;
+			}
+			stack.Push(node.LeftFirst + 1);
+			stack.Push(node.LeftFirst);
+		}
+	}
+
+	void BVH::_BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth, uint32_t parallelDepth)
+	{
+		BVHNode& node = mNodes_[nodeIndex];
+		uint32_t deepest = mDepth_.load();
+		while (depth > deepest && !mDepth_.compare_exchange_weak(deepest, depth));
+
+		Box box = Box::GetEmpty();
+		Box centroidBox = Box::GetEmpty();
+		for (uint32_t i = first; i < first + count; ++i)
+		{
+			uint32_t index = mIndices_[i];
+			box.Merge(mBounds_[index]);
+			centroidBox.Merge(mCentroids_[index]);
+		}
+		node.SetBoundingBox(box);
+		node.LeftFirst = first;
+		node.Count = count;
+
+		if (count <= MAX_LEAF_SIZE)
+			return;
+
+		uint32_t axis = 0;
+		float splitPos = 0.f;
+		uint32_t leftCount = 0;
+		if (_FindSplit(first, count, box, centroidBox, axis, splitPos))
+		{
+			auto begin = mIndices_.begin() + first;
+			auto middle = std::partition(begin, begin + count, [this, axis, splitPos](uint32_t index) {
+				return Component(mCentroids_[index], axis) < splitPos;
+			});
+			leftCount = static_cast<uint32_t>(middle - begin);
+		}
+		else if (count <= MAX_LEAF_SIZE * 4)
+		{
+			// splitting does not pay off
+			return;
+		}
+
+		// no usable plane, fall back to an object median split along the widest centroid axis
+		if (leftCount == 0 || leftCount == count)
+		{
+			const Vector3 extent = centroidBox.GetMax() - centroidBox.GetMin();
+			const uint32_t medianAxis = extent.x >= extent.y ? (extent.x >= extent.z ? 0 : 2) : (extent.y >= extent.z ? 1 : 2);
+			leftCount = count / 2;
+			auto begin = mIndices_.begin() + first;
+			std::nth_element(begin, begin + leftCount, begin + count, [this, medianAxis](uint32_t a, uint32_t b) {
+				return Component(mCentroids_[a], medianAxis) < Component(mCentroids_[b], medianAxis);
+			});
+		}
+
+		uint32_t left = _AllocateNodePair();
+		node.LeftFirst = left;
+		node.Count = 0;
+
+		if (depth < parallelDepth)
+		{
+			std::thread worker([=, this]() { _BuildNode(left, first, leftCount, depth + 1, parallelDepth); });
+			_BuildNode(left + 1, first + leftCount, count - leftCount, depth + 1, parallelDepth);
+			worker.join();
+		}
+		else
+		{
+			_BuildNode(left, first, leftCount, depth + 1, parallelDepth);
+			_BuildNode(left + 1, first + leftCount, count - leftCount, depth + 1, parallelDepth);
+		}
+	}
+
+	bool BVH::_FindSplit(uint32_t first, uint32_t count, const Box& box, const Box& centroidBox, uint32_t& outAxis, float& outPos) const
+	{
+		struct Bin
+		{
+			Box Bounds = Box::GetEmpty();
+			uint32_t Count = 0;
+		};
+
+		const float parentArea = Max(HalfArea(box), EPISILON);
+
+		// cost of a leaf is one test per item, a split costs one traversal step plus both children
+		float bestCost = static_cast<float>(count);
+		bool found = false;
+		for (uint32_t axis = 0; axis < 3; ++axis)
+		{
+			float cmin = Component(centroidBox.GetMin(), axis);
+			float cmax = Component(centroidBox.GetMax(), axis);
+			if (cmax - cmin <= EPISILON)
+				continue;
+
+			Bin bins[BIN_COUNT];
+			const float scale = BIN_COUNT / (cmax - cmin);
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				uint32_t index = mIndices_[i];
+				uint32_t b = Min(BIN_COUNT - 1, static_cast<uint32_t>((Component(mCentroids_[index], axis) - cmin) * scale));
+				bins[b].Count++;
+				bins[b].Bounds.Merge(mBounds_[index]);
+			}
+
+			// sweep from both sides to get the area/count on each side of every plane
+			float leftArea[BIN_COUNT - 1], rightArea[BIN_COUNT - 1];
+			uint32_t leftCount[BIN_COUNT - 1], rightCount[BIN_COUNT - 1];
+			Box leftBox = Box::GetEmpty(), rightBox = Box::GetEmpty();
+			uint32_t leftSum = 0, rightSum = 0;
+			for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+			{
+				leftSum += bins[i].Count;
+				leftBox.Merge(bins[i].Bounds);
+				leftCount[i] = leftSum;
+				leftArea[i] = leftBox.IsValid() ? HalfArea(leftBox) : 0.f;
+
+				rightSum += bins[BIN_COUNT - 1 - i].Count;
+				rightBox.Merge(bins[BIN_COUNT - 1 - i].Bounds);
+				rightCount[BIN_COUNT - 2 - i] = rightSum;
+				rightArea[BIN_COUNT - 2 - i] = rightBox.IsValid() ? HalfArea(rightBox) : 0.f;
+			}
+
+			for (uint32_t i = 0; i < BIN_COUNT - 1; ++i)
+			{
+				if (leftCount[i] == 0 || rightCount[i] == 0)
+					continue;
+				float cost = 1.f + (leftCount[i] * leftArea[i] + rightCount[i] * rightArea[i]) / parentArea;
+				if (cost < bestCost)
+				{
+					bestCost = cost;
+					outAxis = axis;
+					outPos = cmin + (i + 1) / scale;
+					found = true;
+				}
+			}
+		}
+		return found;
+	}
+
+	uint32_t BVH::_AllocateNodePair()
+	{
+		uint32_t index = mNodeCount_.fetch_add(2);
+		HYBRID_CHECK(index + 1 < mNodes_.size());
+		return index;
+	}
+
+	void BVH::_CollectLeaves(uint32_t nodeIndex, std::vector<uint32_t>& outIndices) const
+	{
+		const BVHNode& node = mNodes_[nodeIndex];
+		if (node.IsLeaf())
+		{
+			outIndices.insert(outIndices.end(), mIndices_.begin() + node.LeftFirst, mIndices_.begin() + node.LeftFirst + node.Count);
+			return;
+		}
+		_CollectLeaves(node.LeftFirst, outIndices);
+		_CollectLeaves(node.LeftFirst + 1, outIndices);
+	}
+}
\ No newline at end of file
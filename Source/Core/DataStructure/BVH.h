@@ -1,2 +1,77 @@
 #pragma once
-#include "Common/Config.h"
\ No newline at end of file
+#include "Common/Config.h"
+#include "Math/Box.h"
+#include "Math/Frustum.h"
+
+#include <atomic>
+
+
+namespace zyh
+{
+	// 32 bytes, two nodes fit in one cache line
+	struct BVHNode
+	{
+		float BMin[3];
+		uint32_t LeftFirst; // inner: index of left child(right child = LeftFirst + 1), leaf: first index in mIndices_
+		float BMax[3];
+		uint32_t Count; // 0 for inner node
+
+		bool IsLeaf() const { return Count != 0; }
+		Box GetBoundingBox() const { return Box(Vector3(BMin[0], BMin[1], BMin[2]), Vector3(BMax[0], BMax[1], BMax[2])); }
+		void SetBoundingBox(const Box& box)
+		{
+			BMin[0] = box.GetMin().x; BMin[1] = box.GetMin().y; BMin[2] = box.GetMin().z;
+			BMax[0] = box.GetMax().x; BMax[1] = box.GetMax().y; BMax[2] = box.GetMax().z;
+		}
+	};
+	static_assert(sizeof(BVHNode) == 32, "BVHNode should stay 32 bytes");
+
+	// Bounding volume hierarchy over a set of boxes, items are referred by their index in the input array.
+	// Built with binned SAH, the top levels are split across worker threads.
+	class BVH
+	{
+	public:
+		static constexpr uint32_t BIN_COUNT = 16;
+		static constexpr uint32_t MAX_LEAF_SIZE = 4;
+		static constexpr uint32_t INVALID_INDEX = MAX_UINT;
+
+	public:
+		BVH() = default;
+
+		// threadCount == 0 uses hardware concurrency
+		void Build(const std::vector<Box>& bounds, uint32_t threadCount = 0);
+
+		// bounds must keep the same count and order as the last Build, topology is kept
+		void Refit(const std::vector<Box>& bounds);
+
+		void Clear();
+
+		// nearest item whose box is hit by the ray, returns INVALID_INDEX on miss
+		uint32_t Raycast(const Vector3& origin, const Vector3& direction, float maxDistance, float* outDistance = nullptr) const;
+
+		void Query(const Box& box, std::vector<uint32_t>& outIndices) const;
+		void Query(const Frustum& frustum, std::vector<uint32_t>& outIndices) const;
+
+	public:
+		bool IsEmpty() const { return mNodes_.empty(); }
+		uint32_t GetNodeCount() const { return mNodeCount_.load(); }
+		// depth of the deepest node, the root is 0
+		uint32_t GetDepth() const { return mDepth_.load(); }
+		const std::vector<BVHNode>& GetNodes() const { return mNodes_; }
+		Box GetBoundingBox() const { return IsEmpty() ? Box::GetEmpty() : mNodes_[0].GetBoundingBox(); }
+
+	protected:
+		void _BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth, uint32_t parallelDepth);
+		bool _FindSplit(uint32_t first, uint32_t count, const Box& box, const Box& centroidBox, uint32_t& outAxis, float& outPos) const;
+		uint32_t _AllocateNodePair();
+		void _CollectLeaves(uint32_t nodeIndex, std::vector<uint32_t>& outIndices) const;
+
+	protected:
+		std::vector<BVHNode> mNodes_;
+		std::vector<uint32_t> mIndices_;
+		std::vector<Box> mBounds_;
+		std::vector<Vector3> mCentroids_;
+		std::atomic<uint32_t> mNodeCount_{ 0 };
+		std::atomic<uint32_t> mDepth_{ 0 };
+	};
+}
\ No newline at end of file
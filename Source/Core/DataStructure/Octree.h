@@ -1,6 +1,10 @@
 #pragma once
 #include "Common/Config.h"
 #include "Math/Box.h"
+#include "Math/Frustum.h"
+
+#include <unordered_map>
+#include <algorithm>
 
 
 namespace zyh
@@ -19,10 +23,16 @@ namespace zyh
 		Num = 8
 	};
 
+	// Loose octree node: the cell is [center - halfSize, center + halfSize], 
+	// but the bounding box used for queries is scaled by LOOSENESS, so an
+	// object only has to fit its center into a cell and its extent into halfSize.
 	template<typename TData>
 	class OctreeNode
 	{
+		template<typename> friend class Octree;
 	public:
+		static constexpr float LOOSENESS = 2.f;
+
 		OctreeNode() : mData_ {nullptr}
 		{
 		}
@@ -31,32 +41,269 @@ namespace zyh
 		{
 		}
 
+		OctreeNode(OctreeNode* parent, const Vector3& center, float halfSize, uint32_t depth)
+			: mParent_{ parent }
+			, mData_{ nullptr }
+			, mCenter_{ center }
+			, mHalfSize_{ halfSize }
+			, mDepth_{ depth }
+		{
+			Vector3 looseExtent(halfSize * LOOSENESS);
+			mBoundingBox_ = Box(center - looseExtent, center + looseExtent);
+		}
+
+		~OctreeNode()
+		{
+			for (OctreeNode*& child : mChildren_)
+				SafeDestroy(child);
+		}
+
 		TData* GetData()
 		{
 			return mData_;
 		}
 
+		const Box& GetBoundingBox() const { return mBoundingBox_; }
+		const std::vector<TData*>& GetDatas() const { return mDatas_; }
+		OctreeNode* GetChild(EOctreeDirection dir) { return mChildren_[size_t(dir)]; }
+
+		bool IsEmpty() const
+		{
+			if (!mDatas_.empty())
+				return false;
+			for (OctreeNode* child : mChildren_)
+			{
+				if (child)
+					return false;
+			}
+			return true;
+		}
+
+		static EOctreeDirection GetDirection(const Vector3& offset)
+		{
+			static constexpr EOctreeDirection directions[8] = {
+				EOctreeDirection::XN_YN_ZN, EOctreeDirection::XP_YN_ZN,
+				EOctreeDirection::XN_YP_ZN, EOctreeDirection::XP_YP_ZN,
+				EOctreeDirection::XN_YN_ZP, EOctreeDirection::XP_YN_ZP,
+				EOctreeDirection::XN_YP_ZP, EOctreeDirection::XP_YP_ZP,
+			};
+			uint32_t index = (offset.x >= 0.f ? 1 : 0) | (offset.y >= 0.f ? 2 : 0) | (offset.z >= 0.f ? 4 : 0);
+			return directions[index];
+		}
+
+		static Vector3 GetDirectionSign(EOctreeDirection dir)
+		{
+			static const Vector3 signs[8] = {
+				Vector3( 1.f,  1.f,  1.f), Vector3(-1.f,  1.f,  1.f),
+				Vector3(-1.f,  1.f, -1.f), Vector3( 1.f,  1.f, -1.f),
+				Vector3( 1.f, -1.f,  1.f), Vector3(-1.f, -1.f,  1.f),
+				Vector3(-1.f, -1.f, -1.f), Vector3( 1.f, -1.f, -1.f),
+			};
+			return signs[size_t(dir)];
+		}
+
 	protected:
 		OctreeNode* mParent_ { nullptr };
-		OctreeNode* mChildren_{ nullptr };
+		OctreeNode* mChildren_[size_t(EOctreeDirection::Num)]{ nullptr };
 		Box mBoundingBox_;
 
 	protected:
 		TData* mData_;
+		std::vector<TData*> mDatas_;
+		Vector3 mCenter_;
+		float mHalfSize_{ 0.f };
+		uint32_t mDepth_{ 0 };
 	};
 
+	// TData must provide `const Box& GetBoundingBox() const` in world space.
+	// Objects whose center lies outside the root cell are kept in the root.
 	template<typename TData>
 	class Octree
 	{
 	public:
-		Octree() = default;
+		using Node = OctreeNode<TData>;
+
+	public:
+		Octree(const Vector3& center = Vector3(0.f), float halfSize = 4096.f, uint32_t maxDepth = 8)
+			: mRoot_(nullptr, center, halfSize, 0)
+			, mMaxDepth_{ maxDepth }
+		{
+		}
+
+		Octree(const Octree&) = delete;
+		Octree& operator=(const Octree&) = delete;
+
+		void InsertNode(TData* data)
+		{
+			HYBRID_CHECK(mDataNodes_.find(data) == mDataNodes_.end());
+			Node* node = SearchSuitableNode(data->GetBoundingBox(), true);
+			node->mDatas_.push_back(data);
+			mDataNodes_[data] = node;
+		}
+
+		void RemoveNode(TData* data)
+		{
+			auto iter = mDataNodes_.find(data);
+			if (iter == mDataNodes_.end())
+				return;
+			Node* node = iter->second;
+			mDataNodes_.erase(iter);
+			_EraseData(node, data);
+			_Prune(node);
+		}
 
-		virtual void InsertNode(TData* data) {};
-		virtual void SearchSuitableNode(TData* data) {};
+		// call after the bounding box of data changed
+		void UpdateNode(TData* data)
+		{
+			auto iter = mDataNodes_.find(data);
+			if (iter == mDataNodes_.end())
+			{
+				InsertNode(data);
+				return;
+			}
+			Node* oldNode = iter->second;
+			Node* newNode = SearchSuitableNode(data->GetBoundingBox(), false);
+			if (newNode == oldNode)
+				return;
 
+			_EraseData(oldNode, data);
+			newNode = SearchSuitableNode(data->GetBoundingBox(), true);
+			newNode->mDatas_.push_back(data);
+			iter->second = newNode;
+			_Prune(oldNode);
+		}
+
+		// deepest node the box fits into; without create, stops at the deepest existing node
+		Node* SearchSuitableNode(const Box& box, bool create)
+		{
+			Vector3 center = box.GetCenter();
+			Vector3 extent = box.GetExtent();
+			float radius = Max(extent.x, extent.y, extent.z);
+
+			Node* node = &mRoot_;
+			if (!_InCell(node, center))
+				return node;
+			while (node->mDepth_ < mMaxDepth_ && radius <= node->mHalfSize_ * 0.5f)
+			{
+				EOctreeDirection dir = Node::GetDirection(center - node->mCenter_);
+				Node*& child = node->mChildren_[size_t(dir)];
+				if (!child)
+				{
+					if (!create)
+						break;
+					float childHalfSize = node->mHalfSize_ * 0.5f;
+					Vector3 childCenter = node->mCenter_ + Node::GetDirectionSign(dir) * childHalfSize;
+					child = new Node(node, childCenter, childHalfSize, node->mDepth_ + 1);
+				}
+				node = child;
+			}
+			return node;
+		}
+
+		void Query(const Frustum& frustum, std::vector<TData*>& outDatas) const
+		{
+			_Query(&mRoot_, outDatas, [&frustum](const Box& box) { return frustum.Test(box); });
+		}
+
+		// coarse query, datas in nodes fully inside go to outInside, datas in
+		// intersecting nodes go to outIntersect untested so they can be tested in batch
+		void Query(const Frustum& frustum, std::vector<TData*>& outInside, std::vector<TData*>& outIntersect) const
+		{
+			_QueryCoarse(&mRoot_, frustum, outInside, outIntersect);
+		}
+
+		void Query(const Box& box, std::vector<TData*>& outDatas) const
+		{
+			_Query(&mRoot_, outDatas, [&box](const Box& other) {
+				if (!box.Intersect(other))
+					return EFrustumTest::OUTSIDE;
+				return box.Contains(other) ? EFrustumTest::INSIDE : EFrustumTest::INTERSECT;
+			});
+		}
+
+		size_t GetDataCount() const { return mDataNodes_.size(); }
 
 	protected:
-		OctreeNode<TData> mRoot_;
+		bool _InCell(const Node* node, const Vector3& p) const
+		{
+			Vector3 d = p - node->mCenter_;
+			return Fabs(d.x) <= node->mHalfSize_ && Fabs(d.y) <= node->mHalfSize_ && Fabs(d.z) <= node->mHalfSize_;
+		}
 
+		void _EraseData(Node* node, TData* data)
+		{
+			auto& datas = node->mDatas_;
+			auto iter = std::find(datas.begin(), datas.end(), data);
+			HYBRID_CHECK(iter != datas.end());
+			*iter = datas.back();
+			datas.pop_back();
+		}
+
+		void _Prune(Node* node)
+		{
+			while (node != &mRoot_ && node->IsEmpty())
+			{
+				Node* parent = node->mParent_;
+				for (Node*& child : parent->mChildren_)
+				{
+					if (child == node)
+					{
+						SafeDestroy(child);
+						break;
+					}
+				}
+				node = parent;
+			}
+		}
+
+		static void _Collect(const Node* node, std::vector<TData*>& outDatas)
+		{
+			outDatas.insert(outDatas.end(), node->mDatas_.begin(), node->mDatas_.end());
+			for (const Node* child : node->mChildren_)
+			{
+				if (child)
+					_Collect(child, outDatas);
+			}
+		}
+
+		template<typename TTest>
+		static void _Query(const Node* node, std::vector<TData*>& outDatas, const TTest& test)
+		{
+			for (TData* data : node->mDatas_)
+			{
+				if (test(data->GetBoundingBox()) != EFrustumTest::OUTSIDE)
+					outDatas.push_back(data);
+			}
+			for (const Node* child : node->mChildren_)
+			{
+				if (!child)
+					continue;
+				EFrustumTest result = test(child->mBoundingBox_);
+				if (result == EFrustumTest::INSIDE)
+					_Collect(child, outDatas);
+				else if (result == EFrustumTest::INTERSECT)
+					_Query(child, outDatas, test);
+			}
+		}
+
+		static void _QueryCoarse(const Node* node, const Frustum& frustum, std::vector<TData*>& outInside, std::vector<TData*>& outIntersect)
+		{
+			outIntersect.insert(outIntersect.end(), node->mDatas_.begin(), node->mDatas_.end());
+			for (const Node* child : node->mChildren_)
+			{
+				if (!child)
+					continue;
+				EFrustumTest result = frustum.Test(child->mBoundingBox_);
+				if (result == EFrustumTest::INSIDE)
+					_Collect(child, outInside);
+				else if (result == EFrustumTest::INTERSECT)
+					_QueryCoarse(child, frustum, outInside, outIntersect);
+			}
+		}
+
+	protected:
+		Node mRoot_;
+		uint32_t mMaxDepth_;
+		std::unordered_map<TData*, Node*> mDataNodes_;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+#include <atomic>
+#include "Common/Config.h"
+
+
+namespace zyh
+{
+	// Bounded lock-free ring buffer for exactly one producer thread and one consumer thread.
+	// Head is only written by the consumer, tail only by the producer, each on its own cache line.
+	template<typename T, size_t Capacity>
+	class SPSCQueue
+	{
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+	public:
+		// producer only
+		bool TryPush(T value)
+		{
+			const size_t tail = mTail_.load(std::memory_order_relaxed);
+			if (tail - mHead_.load(std::memory_order_acquire) == Capacity)
+				return false;
+			mItems_[tail & (Capacity - 1)] = std::move(value);
+			mTail_.store(tail + 1, std::memory_order_release);
+			mTail_.notify_one();
+			return true;
+		}
+
+		// producer only, sleeps while full
+		void Push(T value)
+		{
+			while (true)
+			{
+				const size_t head = mHead_.load(std::memory_order_acquire);
+				if (mTail_.load(std::memory_order_relaxed) - head != Capacity)
+					break;
+				mHead_.wait(head, std::memory_order_acquire);
+			}
+			const bool pushed = TryPush(std::move(value));
+			HYBRID_CHECK(pushed);
+		}
+
+		// consumer only
+		bool TryPop(T& outValue)
+		{
+			const size_t head = mHead_.load(std::memory_order_relaxed);
+			if (head == mTail_.load(std::memory_order_acquire))
+				return false;
+			outValue = std::move(mItems_[head & (Capacity - 1)]);
+			mHead_.store(head + 1, std::memory_order_release);
+			mHead_.notify_one();
+			return true;
+		}
+
+		// consumer only, sleeps while empty
+		void Pop(T& outValue)
+		{
+			while (true)
+			{
+				const size_t tail = mTail_.load(std::memory_order_acquire);
+				if (mHead_.load(std::memory_order_relaxed) != tail)
+					break;
+				mTail_.wait(tail, std::memory_order_acquire);
+			}
+			const bool popped = TryPop(outValue);
+			HYBRID_CHECK(popped);
+		}
+
+		// only exact when called from the producer or consumer while the other side is idle
+		size_t Size() const { return mTail_.load(std::memory_order_acquire) - mHead_.load(std::memory_order_acquire); }
+		bool Empty() const { return Size() == 0; }
+
+	protected:
+		alignas(64) std::atomic<size_t> mHead_{ 0 };
+		alignas(64) std::atomic<size_t> mTail_{ 0 };
+		alignas(64) T mItems_[Capacity];
+	};
+}
\ No newline at end of file
@@ -0,0 +1,143 @@
+#pragma once
+#include "Common/Config.h"
+
+
+namespace zyh
+{
+	// index + generation, a slot reused after removal gets a new generation so stale handles are detected
+	struct SlotHandle
+	{
+		static constexpr uint32_t INVALID_INDEX = ~0u;
+
+		uint32_t Index{ INVALID_INDEX };
+		uint32_t Generation{ 0 };
+
+		bool IsValid() const { return Index != INVALID_INDEX; }
+		bool operator==(const SlotHandle& rhs) const { return Index == rhs.Index && Generation == rhs.Generation; }
+		bool operator!=(const SlotHandle& rhs) const { return !(*this == rhs); }
+	};
+
+	// O(1) insert / remove / lookup through generational handles, values stay packed in one array
+	// (swap-and-pop on removal), so iteration is linear and order is not preserved.
+	template<typename T>
+	class SlotMap
+	{
+	public:
+		using Handle = SlotHandle;
+
+	public:
+		Handle Insert(const T& value)
+		{
+			Handle handle = _AllocateSlot();
+			mValues_.push_back(value);
+			return handle;
+		}
+
+		Handle Insert(T&& value)
+		{
+			Handle handle = _AllocateSlot();
+			mValues_.push_back(std::move(value));
+			return handle;
+		}
+
+		// appends count values, outHandles receives one handle per value in the same order
+		void InsertRange(const T* values, size_t count, std::vector<Handle>& outHandles)
+		{
+			Reserve(mValues_.size() + count);
+			outHandles.reserve(outHandles.size() + count);
+			for (size_t i = 0; i < count; ++i)
+			{
+				outHandles.push_back(Insert(values[i]));
+			}
+		}
+
+		bool Remove(Handle handle)
+		{
+			if (!Contains(handle))
+				return false;
+			uint32_t dense = mSlots_[handle.Index];
+			uint32_t last = uint32_t(mValues_.size() - 1);
+			if (dense != last)
+			{
+				mValues_[dense] = std::move(mValues_[last]);
+				mDenseToSlot_[dense] = mDenseToSlot_[last];
+				mSlots_[mDenseToSlot_[dense]] = dense;
+			}
+			mValues_.pop_back();
+			mDenseToSlot_.pop_back();
+
+			mSlots_[handle.Index] = INVALID_DENSE;
+			++mGenerations_[handle.Index];
+			mFreeSlots_.push_back(handle.Index);
+			return true;
+		}
+
+		bool Contains(Handle handle) const
+		{
+			return handle.Index < mSlots_.size() && mGenerations_[handle.Index] == handle.Generation && mSlots_[handle.Index] != INVALID_DENSE;
+		}
+
+		T* Get(Handle handle) { return Contains(handle) ? &mValues_[mSlots_[handle.Index]] : nullptr; }
+		const T* Get(Handle handle) const { return Contains(handle) ? &mValues_[mSlots_[handle.Index]] : nullptr; }
+
+		size_t Size() const { return mValues_.size(); }
+		bool Empty() const { return mValues_.empty(); }
+
+		void Reserve(size_t count)
+		{
+			mValues_.reserve(count);
+			mDenseToSlot_.reserve(count);
+		}
+
+		void Clear()
+		{
+			for (uint32_t dense = 0; dense < mDenseToSlot_.size(); ++dense)
+			{
+				uint32_t slot = mDenseToSlot_[dense];
+				mSlots_[slot] = INVALID_DENSE;
+				++mGenerations_[slot];
+				mFreeSlots_.push_back(slot);
+			}
+			mValues_.clear();
+			mDenseToSlot_.clear();
+		}
+
+		// packed values
+		typename std::vector<T>::iterator begin() { return mValues_.begin(); }
+		typename std::vector<T>::iterator end() { return mValues_.end(); }
+		typename std::vector<T>::const_iterator begin() const { return mValues_.begin(); }
+		typename std::vector<T>::const_iterator end() const { return mValues_.end(); }
+		const std::vector<T>& GetValues() const { return mValues_; }
+
+	protected:
+		static constexpr uint32_t INVALID_DENSE = ~0u;
+
+		Handle _AllocateSlot()
+		{
+			Handle handle;
+			if (!mFreeSlots_.empty())
+			{
+				handle.Index = mFreeSlots_.back();
+				mFreeSlots_.pop_back();
+			}
+			else
+			{
+				handle.Index = uint32_t(mSlots_.size());
+				mSlots_.push_back(INVALID_DENSE);
+				mGenerations_.push_back(0);
+			}
+			handle.Generation = mGenerations_[handle.Index];
+			mSlots_[handle.Index] = uint32_t(mValues_.size());
+			mDenseToSlot_.push_back(handle.Index);
+			return handle;
+		}
+
+	protected:
+		std::vector<T> mValues_;
+		std::vector<uint32_t> mDenseToSlot_;
+		// indexed by handle
+		std::vector<uint32_t> mSlots_;
+		std::vector<uint32_t> mGenerations_;
+		std::vector<uint32_t> mFreeSlots_;
+	};
+}
\ No newline at end of file
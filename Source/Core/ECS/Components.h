@@ -0,0 +1,18 @@
+#pragma once
+#include "Common/Config.h"
+#include "Core/TransformHierarchy.h"
+
+
+namespace zyh
+{
+	// plain data components stored in ClientScene's EntityRegistry
+
+	// links a registry entity to its node in ClientScene's TransformHierarchy. Local is written by
+	// IEntity::SetTransform and pushed into the hierarchy by ClientScene's transform commit system
+	struct TransformComponent
+	{
+		TransformHierarchy::Handle Handle{ TransformHierarchy::INVALID_HANDLE };
+		Matrix4x3 Local;
+		bool Dirty{ false };
+	};
+}
\ No newline at end of file
@@ -0,0 +1,238 @@
+#pragma once
+#include <memory>
+#include <tuple>
+#include "Common/Config.h"
+#include "Core/DataStructure/SlotMap.h"
+#include "Core/JobSystem.h"
+
+
+namespace zyh
+{
+	// generational entity handle, a destroyed entity's slot is reused with a new generation so stale ids are detected
+	using EntityId = SlotHandle;
+
+	class IComponentPool
+	{
+	public:
+		virtual ~IComponentPool() {}
+		virtual bool Has(EntityId entity) const = 0;
+		virtual void Remove(EntityId entity) = 0;
+		virtual size_t Size() const = 0;
+	};
+
+	// sparse set: mSparse_ maps entity index to a slot in the densely packed component / entity arrays
+	template<typename T>
+	class ComponentPool : public IComponentPool
+	{
+	public:
+		static constexpr uint32_t INVALID_SLOT = ~0u;
+
+		template<typename... ArgsType>
+		T& Add(EntityId entity, ArgsType&&... args)
+		{
+			HYBRID_CHECK(!Has(entity));
+			if (entity.Index >= mSparse_.size())
+				mSparse_.resize(entity.Index + 1, INVALID_SLOT);
+			mSparse_[entity.Index] = uint32_t(mDense_.size());
+			mDense_.push_back(entity);
+			mComponents_.emplace_back(std::forward<ArgsType>(args)...);
+			return mComponents_.back();
+		}
+
+		// swap with the last element, keeps the arrays packed
+		virtual void Remove(EntityId entity) override
+		{
+			HYBRID_CHECK(Has(entity));
+			uint32_t slot = mSparse_[entity.Index];
+			uint32_t last = uint32_t(mDense_.size() - 1);
+			if (slot != last)
+			{
+				mDense_[slot] = mDense_[last];
+				mComponents_[slot] = std::move(mComponents_[last]);
+				mSparse_[mDense_[slot].Index] = slot;
+			}
+			mDense_.pop_back();
+			mComponents_.pop_back();
+			mSparse_[entity.Index] = INVALID_SLOT;
+		}
+
+		virtual bool Has(EntityId entity) const override
+		{
+			return entity.Index < mSparse_.size() && mSparse_[entity.Index] != INVALID_SLOT && mDense_[mSparse_[entity.Index]] == entity;
+		}
+
+		virtual size_t Size() const override { return mDense_.size(); }
+
+		T& Get(EntityId entity)
+		{
+			HYBRID_CHECK(Has(entity));
+			return mComponents_[mSparse_[entity.Index]];
+		}
+		const T& Get(EntityId entity) const
+		{
+			HYBRID_CHECK(Has(entity));
+			return mComponents_[mSparse_[entity.Index]];
+		}
+		T* TryGet(EntityId entity) { return Has(entity) ? &mComponents_[mSparse_[entity.Index]] : nullptr; }
+
+		// packed arrays, same order, for linear iteration
+		std::vector<T>& GetComponents() { return mComponents_; }
+		const std::vector<EntityId>& GetEntities() const { return mDense_; }
+
+	protected:
+		std::vector<uint32_t> mSparse_;
+		std::vector<EntityId> mDense_;
+		std::vector<T> mComponents_;
+	};
+
+	// Entities are plain ids, components are plain data stored per type in contiguous pools.
+	// References returned by Add / Get are invalidated by the next Add / Remove of the same type.
+	class EntityRegistry
+	{
+	public:
+		EntityId Create()
+		{
+			EntityId entity;
+			if (!mFreeIndices_.empty())
+			{
+				entity.Index = mFreeIndices_.back();
+				mFreeIndices_.pop_back();
+			}
+			else
+			{
+				entity.Index = uint32_t(mGenerations_.size());
+				mGenerations_.push_back(0);
+			}
+			entity.Generation = mGenerations_[entity.Index];
+			++mAliveCount_;
+			return entity;
+		}
+
+		void Destroy(EntityId entity)
+		{
+			HYBRID_CHECK(IsAlive(entity));
+			for (auto& pool : mPools_)
+			{
+				if (pool && pool->Has(entity))
+					pool->Remove(entity);
+			}
+			++mGenerations_[entity.Index];
+			mFreeIndices_.push_back(entity.Index);
+			--mAliveCount_;
+		}
+
+		bool IsAlive(EntityId entity) const
+		{
+			return entity.Index < mGenerations_.size() && mGenerations_[entity.Index] == entity.Generation;
+		}
+
+		size_t GetAliveCount() const { return mAliveCount_; }
+
+	public:
+		template<typename T, typename... ArgsType>
+		T& Add(EntityId entity, ArgsType&&... args)
+		{
+			HYBRID_CHECK(IsAlive(entity));
+			return GetPool<T>().Add(entity, std::forward<ArgsType>(args)...);
+		}
+
+		template<typename T>
+		void Remove(EntityId entity) { GetPool<T>().Remove(entity); }
+
+		template<typename T>
+		bool Has(EntityId entity) const
+		{
+			const ComponentPool<T>* pool = FindPool<T>();
+			return pool && pool->Has(entity);
+		}
+
+		template<typename T>
+		T& Get(EntityId entity) { return GetPool<T>().Get(entity); }
+
+		template<typename T>
+		T* TryGet(EntityId entity) { return GetPool<T>().TryGet(entity); }
+
+		template<typename T>
+		ComponentPool<T>& GetPool()
+		{
+			const uint32_t typeId = GetTypeId<T>();
+			if (typeId >= mPools_.size())
+				mPools_.resize(typeId + 1);
+			if (!mPools_[typeId])
+				mPools_[typeId] = std::make_unique<ComponentPool<T>>();
+			return *static_cast<ComponentPool<T>*>(mPools_[typeId].get());
+		}
+
+		// func(EntityId, T&, Others&...) for every entity having all the listed components.
+		// Single type iteration is a linear walk over the packed array, with several types the
+		// first type drives the walk, so list the rarest component first.
+		template<typename T, typename... Others, typename TFunc>
+		void Each(TFunc&& func)
+		{
+			ComponentPool<T>& pool = GetPool<T>();
+			std::tuple<ComponentPool<Others>*...> others{ &GetPool<Others>()... };
+			_EachRange<T, Others...>(pool, others, 0, pool.Size(), func);
+		}
+
+		// same as Each but chunks of grainSize entities run as jobs. func must only touch the components
+		// it is handed, adding or removing components while iterating is not allowed.
+		template<typename T, typename... Others, typename TFunc>
+		void ParallelEach(JobSystem& jobs, size_t grainSize, TFunc&& func)
+		{
+			ComponentPool<T>& pool = GetPool<T>();
+			std::tuple<ComponentPool<Others>*...> others{ &GetPool<Others>()... };
+			jobs.ParallelFor(0, pool.Size(), grainSize, [&](size_t begin, size_t end)
+				{
+					_EachRange<T, Others...>(pool, others, begin, end, func);
+				});
+		}
+
+	protected:
+		template<typename T, typename... Others, typename TFunc>
+		static void _EachRange(ComponentPool<T>& pool, std::tuple<ComponentPool<Others>*...>& others, size_t begin, size_t end, TFunc& func)
+		{
+			std::vector<T>& components = pool.GetComponents();
+			const std::vector<EntityId>& entities = pool.GetEntities();
+			for (size_t i = begin; i < end; ++i)
+			{
+				const EntityId entity = entities[i];
+				if constexpr (sizeof...(Others) == 0)
+				{
+					func(entity, components[i]);
+				}
+				else
+				{
+					if ((std::get<ComponentPool<Others>*>(others)->Has(entity) && ...))
+						func(entity, components[i], std::get<ComponentPool<Others>*>(others)->Get(entity)...);
+				}
+			}
+		}
+
+	protected:
+		template<typename T>
+		const ComponentPool<T>* FindPool() const
+		{
+			const uint32_t typeId = GetTypeId<T>();
+			return typeId < mPools_.size() ? static_cast<const ComponentPool<T>*>(mPools_[typeId].get()) : nullptr;
+		}
+
+		static uint32_t NextTypeId()
+		{
+			static uint32_t counter = 0;
+			return counter++;
+		}
+
+		template<typename T>
+		static uint32_t GetTypeId()
+		{
+			static const uint32_t id = NextTypeId();
+			return id;
+		}
+
+	protected:
+		std::vector<uint32_t> mGenerations_;
+		std::vector<uint32_t> mFreeIndices_;
+		std::vector<std::unique_ptr<IComponentPool>> mPools_;
+		size_t mAliveCount_{ 0 };
+	};
+}
\ No newline at end of file
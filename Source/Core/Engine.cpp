@@ -1,9 +1,11 @@
 #include "Engine.h"
 #include "Graphics/Vulkan/VulkanBase.h"
 #include "ClientScene.h"
+#include "JobSystem.h"
 #include "Graphics/Common/Renderer.h"
 #include "InputSystem.h"
 #include "Graphics/Imgui/imgui_impl_win32.h"
+#include "Common/Setting.h"
 
 
 namespace zyh
@@ -12,18 +14,18 @@ namespace zyh
 
 	Engine::Engine()
 	{
-		Scene = new ClientScene();
 	}
 
 	Engine::~Engine()
 	{
 		delete Scene;
+		delete Jobs;
 	}
 
 	void Engine::Run()
 	{
 		Initialize();
-		while (true)
+		while (!mScheduler_.IsExitRequested())
 		{
 			Tick();
 		}
@@ -32,33 +34,62 @@ namespace zyh
 
 	void Engine::Initialize()
 	{
-		mCurrFrameTime_ = mLastFrameTime_ = std::chrono::high_resolution_clock::now();
+		mScheduler_.SetFixedTimestep(Setting::FixedTimestep);
+		mScheduler_.SetMaxFrameRate(Setting::MaxFrameRate);
 
-		InitializeWindow();
+		// not in the constructor, which runs during static initialization of GEngine.
+		// one external slot for the render thread
+		Jobs = new JobSystem(0, 1);
+		Scene = new ClientScene(*Jobs);
+
+#if defined(_WIN32)
+		if (!Setting::IsHeadless)
+			InitializeWindow();
+#endif
 		Scene->Initialize();
 	}
 
 	void Engine::Tick()
 	{
-		// Update Timer First
-		mCurrFrameTime_ = std::chrono::high_resolution_clock::now();
-		mDeltaTime_ = std::chrono::duration<float, std::chrono::seconds::period>(mCurrFrameTime_ - mLastFrameTime_).count();
-		mLastFrameTime_ = mCurrFrameTime_;
+		// waits for the frame cap, then decides the simulation steps of this frame
+		mScheduler_.BeginFrame();
+		mDeltaTime_ = mScheduler_.GetStepDeltaTime();
 
 		// Tick Logic Scene
 		Scene->Tick();
 
 		mCurrFrame_ += 1;
+		if (Setting::FrameCount && mCurrFrame_ >= Setting::FrameCount)
+			RequestExit();
 	}
 
 	void Engine::CleanUp()
 	{
 		Scene->CleanUp();
+		if (Setting::IsHeadless)
+		{
+			const FrameTimeStats stats = mScheduler_.GetFrameTimeStats();
+			printf("frames %llu, frame time ms: avg %.3f p50 %.3f p95 %.3f p99 %.3f max %.3f\n",
+				(unsigned long long)mCurrFrame_, stats.Average, stats.P50, stats.P95, stats.P99, stats.Max);
+			fflush(stdout);
+		}
+#if defined(_WIN32)
+		if (mWindow_)
+			DestroyWindow(mWindow_);
+		mWindow_ = nullptr;
+#endif
 	}
 	
 #if defined(_WIN32)
 	LRESULT Engine::WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 	{
+		// the window is destroyed in CleanUp() once the render thread stopped using its surface
+		if (uMsg == WM_CLOSE)
+		{
+			GEngine->RequestExit();
+			return 0;
+		}
+
 		if (ImGui::GetCurrentContext())
 		{
 			ImGuiIO& io = ImGui::GetIO();
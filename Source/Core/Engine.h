@@ -1,10 +1,12 @@
 #pragma once
 #include "Common/Config.h"
+#include "Core/FrameScheduler.h"
 
 
 namespace zyh
 {
 	class ClientScene;
+	class JobSystem;
 
 	class Engine
 	{
@@ -14,7 +16,11 @@ namespace zyh
 
 	public:
 		void Run();
+		// delta time of the current simulation step
 		inline const float GetDeltaTime() const { return mDeltaTime_; }
+		// Run() returns through CleanUp() at the end of the current frame
+		void RequestExit() { mScheduler_.RequestExit(); }
+		FrameScheduler& GetScheduler() { return mScheduler_; }
 
 	private:
 		void Initialize();
@@ -22,12 +28,12 @@ namespace zyh
 		void CleanUp();
 		
 	public:
-		ClientScene* Scene;
+		// created in Initialize()
+		JobSystem* Jobs{ nullptr };
+		ClientScene* Scene{ nullptr };
 
 	private:
-		typedef std::chrono::steady_clock::time_point TimeType;
-		TimeType mCurrFrameTime_;
-		TimeType mLastFrameTime_;
+		FrameScheduler mScheduler_;
 		float mDeltaTime_{ 0.033f };
 		uint64_t mCurrFrame_{ 0 };
 
@@ -40,8 +46,8 @@ namespace zyh
 		static LRESULT CALLBACK WndProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
 		HWND InitializeWindow();
 	public:
-		HWND mWindow_;
-		HINSTANCE mWindowInstance_;
+		HWND mWindow_{ nullptr };
+		HINSTANCE mWindowInstance_{ nullptr };
 #endif
 	};
 
@@ -0,0 +1,138 @@
+#include "FrameScheduler.h"
+#include <algorithm>
+#include <thread>
+#include "Math/MathUtil.h"
+
+#if defined(_WIN32) && !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+
+
+namespace zyh
+{
+	FrameScheduler::FrameScheduler()
+	{
+#if defined(_WIN32)
+		// Sleep() granularity is the 15.6ms system tick, the high resolution timer (Win10 1803+) is ~0.5ms
+		mTimer_ = CreateWaitableTimerExW(NULL, NULL, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+#endif
+	}
+
+	FrameScheduler::~FrameScheduler()
+	{
+#if defined(_WIN32)
+		if (mTimer_)
+			CloseHandle(mTimer_);
+#endif
+	}
+
+	void FrameScheduler::SetFixedTimestep(float stepSeconds)
+	{
+		mFixedStep_ = Max(stepSeconds, 0.f);
+		mAccumulator_ = 0.f;
+	}
+
+	void FrameScheduler::SetMaxFrameRate(float framesPerSecond)
+	{
+		mFramePeriod_ = framesPerSecond > 0.f
+			? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / framesPerSecond))
+			: Clock::duration(0);
+	}
+
+	void FrameScheduler::BeginFrame()
+	{
+		const bool capped = mFramePeriod_.count() > 0;
+		if (capped && !mFirstFrame_)
+			_WaitUntil(mNextFrame_);
+
+		const Clock::time_point now = Clock::now();
+		if (mFirstFrame_)
+		{
+			mFirstFrame_ = false;
+			mNextFrame_ = now;
+			mFrameDelta_ = mFixedStep_;
+		}
+		else
+		{
+			const float frameTime = std::chrono::duration<float>(now - mLastFrame_).count();
+			mFrameTimes_[mFrameTimeCount_ % FRAME_HISTORY] = frameTime * 1000.f;
+			++mFrameTimeCount_;
+			mFrameDelta_ = Min(frameTime, MAX_FRAME_DELTA);
+		}
+		mLastFrame_ = now;
+
+		if (capped)
+		{
+			// keep the cadence, but don't try to catch up frames that were missed
+			mNextFrame_ += mFramePeriod_;
+			if (mNextFrame_ < now)
+				mNextFrame_ = now + mFramePeriod_;
+		}
+
+		if (IsFixedTimestep())
+		{
+			mAccumulator_ = Min(mAccumulator_ + mFrameDelta_, mFixedStep_ * MAX_STEPS_PER_FRAME);
+			mStepCount_ = uint32_t(mAccumulator_ / mFixedStep_);
+			mAccumulator_ -= mStepCount_ * mFixedStep_;
+			mAlpha_ = Clamp(mAccumulator_ / mFixedStep_, 0.f, 1.f);
+		}
+		else
+		{
+			mStepCount_ = 1;
+			mAlpha_ = 1.f;
+		}
+	}
+
+	FrameTimeStats FrameScheduler::GetFrameTimeStats() const
+	{
+		FrameTimeStats stats;
+		const size_t count = Min(mFrameTimeCount_, FRAME_HISTORY);
+		if (count == 0)
+			return stats;
+
+		std::vector<float> sorted(mFrameTimes_, mFrameTimes_ + count);
+		std::sort(sorted.begin(), sorted.end());
+		auto percentile = [&sorted](float p) { return sorted[Min(size_t(p * (sorted.size() - 1) + 0.5f), sorted.size() - 1)]; };
+
+		float sum = 0.f;
+		for (float frameTime : sorted)
+		{
+			sum += frameTime;
+		}
+		stats.Count = uint32_t(count);
+		stats.Min = sorted.front();
+		stats.Max = sorted.back();
+		stats.Average = sum / count;
+		stats.P50 = percentile(0.5f);
+		stats.P95 = percentile(0.95f);
+		stats.P99 = percentile(0.99f);
+		return stats;
+	}
+
+	void FrameScheduler::_WaitUntil(Clock::time_point target)
+	{
+		const Clock::time_point sleepUntil = target - SPIN_MARGIN;
+		if (Clock::now() < sleepUntil)
+		{
+#if defined(_WIN32)
+			if (mTimer_)
+			{
+				// relative due time in 100ns units
+				LARGE_INTEGER dueTime;
+				dueTime.QuadPart = -std::chrono::duration_cast<std::chrono::duration<int64_t, std::ratio<1, 10000000>>>(sleepUntil - Clock::now()).count();
+				if (dueTime.QuadPart < 0 && SetWaitableTimerEx(mTimer_, &dueTime, 0, NULL, NULL, NULL, 0))
+					WaitForSingleObject(mTimer_, INFINITE);
+			}
+			else
+#endif
+			{
+				std::this_thread::sleep_until(sleepUntil);
+			}
+		}
+
+		while (Clock::now() < target)
+		{
+			std::this_thread::yield();
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include "Common/Config.h"
+
+
+namespace zyh
+{
+	// frame times in milliseconds
+	struct FrameTimeStats
+	{
+		uint32_t Count{ 0 };
+		float Min{ 0.f };
+		float Max{ 0.f };
+		float Average{ 0.f };
+		float P50{ 0.f };
+		float P95{ 0.f };
+		float P99{ 0.f };
+	};
+
+	// Paces Engine::Run. BeginFrame() sleeps off the rest of the frame budget when a frame rate cap is set,
+	// measures the frame time and decides how many simulation steps run this frame. With a fixed timestep the
+	// time left in the accumulator is exposed as an interpolation alpha between the last two steps.
+	class FrameScheduler
+	{
+	public:
+		FrameScheduler();
+		~FrameScheduler();
+
+		FrameScheduler(const FrameScheduler&) = delete;
+		FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+	public:
+		// 0 runs one step per frame with the measured frame time
+		void SetFixedTimestep(float stepSeconds);
+		// 0 is uncapped
+		void SetMaxFrameRate(float framesPerSecond);
+
+		void BeginFrame();
+
+		uint32_t GetStepCount() const { return mStepCount_; }
+		// delta time of every simulation step this frame
+		float GetStepDeltaTime() const { return IsFixedTimestep() ? mFixedStep_ : mFrameDelta_; }
+		// measured time since the last frame, clamped to MAX_FRAME_DELTA
+		float GetFrameDeltaTime() const { return mFrameDelta_; }
+		// [0, 1) between the previous and the last step, 1 without a fixed timestep
+		float GetInterpolationAlpha() const { return mAlpha_; }
+		bool IsFixedTimestep() const { return mFixedStep_ > 0.f; }
+		// over the last FRAME_HISTORY frames
+		FrameTimeStats GetFrameTimeStats() const;
+
+		void RequestExit() { mExitRequested_.store(true); }
+		bool IsExitRequested() const { return mExitRequested_.load(); }
+
+	protected:
+		using Clock = std::chrono::steady_clock;
+
+		// coarse OS sleep up to SPIN_MARGIN before target, then spin
+		void _WaitUntil(Clock::time_point target);
+
+	protected:
+		static constexpr size_t FRAME_HISTORY = 256;
+		// a hitch (debugger, loading) must not turn into a burst of catch up steps
+		static constexpr float MAX_FRAME_DELTA = 0.25f;
+		static constexpr uint32_t MAX_STEPS_PER_FRAME = 8;
+		static constexpr std::chrono::microseconds SPIN_MARGIN{ 1000 };
+
+		float mFixedStep_{ 0.f };
+		Clock::duration mFramePeriod_{ 0 };
+
+		bool mFirstFrame_{ true };
+		Clock::time_point mLastFrame_;
+		Clock::time_point mNextFrame_;
+		float mFrameDelta_{ 0.f };
+		float mAccumulator_{ 0.f };
+		uint32_t mStepCount_{ 1 };
+		float mAlpha_{ 1.f };
+
+		float mFrameTimes_[FRAME_HISTORY]{};
+		size_t mFrameTimeCount_{ 0 };
+
+		std::atomic<bool> mExitRequested_{ false };
+#if defined(_WIN32)
+		HANDLE mTimer_{ nullptr };
+#endif
+	};
+}
\ No newline at end of file
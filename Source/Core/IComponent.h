@@ -12,11 +12,13 @@ namespace zyh
 	{
 	public:
 		IComponent(IEntity* Parent) :mParent_(Parent) {}
+		virtual ~IComponent() {}
 		virtual void Tick() {}
 		virtual bool IsTickable() { return mTickable_; }
 
 		IEntity* GetParent() { return mParent_; }
-		virtual void UpdateTransform(Matrix4x3& mat) {}
+		// called with the owner's world matrix after the transform hierarchy recomputed it
+		virtual void UpdateTransform(const Matrix4x3& mat) {}
 
 		virtual void Serialize(Archive* ar) override;
 
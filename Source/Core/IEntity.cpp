@@ -1,9 +1,28 @@
 #include "IEntity.h"
 #include "IComponent.h"
+#include "ClientScene.h"
+#include "ECS/Components.h"
 #include "File/FileSystem.h"
 
 namespace zyh
 {
+	IEntity::IEntity()
+	{
+		mTransformHandle_ = GEngine->Scene->GetTransforms().Create();
+		mId_ = GEngine->Scene->GetRegistry().Create();
+		GEngine->Scene->GetRegistry().Add<TransformComponent>(mId_, TransformComponent{ mTransformHandle_ });
+	}
+
+	IEntity::~IEntity()
+	{
+		for (IComponent* comp : mComponents_)
+		{
+			SafeDestroy(comp);
+		}
+		GEngine->Scene->GetRegistry().Destroy(mId_);
+		GEngine->Scene->GetTransforms().Destroy(mTransformHandle_);
+	}
+
 	void IEntity::Tick()
 	{
 		for (IComponent* comp : mComponents_)
@@ -14,12 +33,31 @@ namespace zyh
 		}
 	}
 
-	void IEntity::SetTransform(Matrix4x3& mat)
+	void IEntity::SetTransform(const Matrix4x3& mat)
 	{
 		mTransform_ = mat;
+		TransformComponent& transform = GEngine->Scene->GetRegistry().Get<TransformComponent>(mId_);
+		transform.Local = mat;
+		transform.Dirty = true;
+	}
+
+	const Matrix4x3& IEntity::GetWorldTransform() const
+	{
+		return GEngine->Scene->GetTransforms().GetWorld(mTransformHandle_);
+	}
+
+	void IEntity::SetParent(IEntity* parent)
+	{
+		HYBRID_CHECK(!GEngine->Scene->IsUpdating());
+		GEngine->Scene->GetTransforms().SetParent(mTransformHandle_, parent ? parent->GetTransformHandle() : TransformHierarchy::INVALID_HANDLE);
+	}
+
+	void IEntity::OnWorldTransformChanged()
+	{
+		const Matrix4x3& world = GetWorldTransform();
 		for (IComponent* comp : mUpdateTransformList_)
 		{
-			comp->UpdateTransform(mat);
+			comp->UpdateTransform(world);
 		}
 	}
 
@@ -2,6 +2,8 @@
 #include "Common/Config.h"
 #include "IObject.h"
 #include "Math/Matrix4x3.h"
+#include "TransformHierarchy.h"
+#include "ECS/EntityRegistry.h"
 
 namespace zyh
 {
@@ -9,9 +11,26 @@ namespace zyh
 
 	class IEntity : virtual IObject
 	{
+		friend class ClientScene;
 	public:
+		IEntity();
+		virtual ~IEntity();
+
+		// may run on any job thread, only this entity's own state may be written,
+		// structural changes go through ClientScene::GetCommands()
 		void Tick();
-		void SetTransform(Matrix4x3& mat);
+		// local transform, relative to the parent entity if there is one. safe to call from Tick(),
+		// only writes this entity's TransformComponent, which the commit phase pushes into the hierarchy
+		void SetTransform(const Matrix4x3& mat);
+		const Matrix4x3& GetTransform() const { return mTransform_; }
+		const Matrix4x3& GetWorldTransform() const;
+		// structural, not allowed while the scene updates
+		void SetParent(IEntity* parent);
+		TransformHierarchy::Handle GetTransformHandle() const { return mTransformHandle_; }
+		// id in ClientScene's EntityRegistry, data components of this entity live there
+		EntityId GetId() const { return mId_; }
+		// called by ClientScene after the hierarchy update recomputed this entity's world matrix
+		void OnWorldTransformChanged();
 		
 		template<typename T, typename... ArgsType>
 		T* AddComponent(ArgsType&&... args) 
@@ -23,7 +42,12 @@ namespace zyh
 
 		template<typename T>
 		T* GetComponent() { 
-			return static_cast<T*>(mComponents_[0]); 
+			for (IComponent* comp : mComponents_)
+			{
+				if (T* typed = dynamic_cast<T*>(comp))
+					return typed;
+			}
+			return nullptr;
 		}
 
 		const std::vector<IComponent*>& GetComponents() { return mComponents_; }
@@ -40,5 +64,8 @@ namespace zyh
 		std::vector<IComponent*> mComponents_;
 		std::vector<IComponent*> mUpdateTransformList_;
 		Matrix4x3 mTransform_;
+		TransformHierarchy::Handle mTransformHandle_{ TransformHierarchy::INVALID_HANDLE };
+		EntityId mId_;
+		SlotHandle mSceneHandle_;
 	};
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #include "IPrimitivesComponent.h"
+#include "IEntity.h"
 #include "File/FileSystem.h"
 #include "Graphics/Vulkan/VulkanModel.h"
+#include "Graphics/Common/Renderer.h"
 
 namespace zyh
 {
@@ -9,6 +11,8 @@ namespace zyh
 		mName_ = "IPrimitivesComponent";
 		GEngine->Scene->AddPrimitive(this);
 		mModel_ = new VulkanModel();
+		mModel_->BindTransform(&GEngine->Scene->GetTransforms(), Parent->GetTransformHandle());
+		mModel_->ElementsChanging.Bind([this]() { GEngine->Scene->RefreshPrimitive(this); });
 	}
 
 	IPrimitivesComponent::IPrimitivesComponent(IEntity* Parent, EPrimitiveType meshType, const std::string& meshFileName) : IPrimitivesComponent(Parent)
@@ -30,7 +34,10 @@ namespace zyh
 	IPrimitivesComponent::~IPrimitivesComponent()
 	{
 		GEngine->Scene->DelPrimitive(this);
-		SafeDestroy(mModel_);
+		// frames already handed to the render thread, or still in flight on the device, may draw the model's elements
+		VulkanModel* model = mModel_;
+		mModel_ = nullptr;
+		GEngine->Scene->GetRenderer()->EnqueueRelease([model]() { delete model; });
 	}
 
 	void IPrimitivesComponent::EmitRenderElements(RenderSet renderSet, IRenderScene& renderScene)
@@ -38,9 +45,46 @@ namespace zyh
 		mModel_->EmitRenderElements(renderSet, renderScene);
 	}
 
-	void IPrimitivesComponent::UpdateTransform(Matrix4x3& mat)
+	void IPrimitivesComponent::WithdrawRenderElements(RenderSet renderSet, IRenderScene& renderScene)
 	{
-		mModel_->UpdateTransform(mat);
+		mModel_->WithdrawRenderElements(renderSet, renderScene);
+	}
+
+	void IPrimitivesComponent::UpdateTransform(const Matrix4x3& mat)
+	{
+		mTransform_ = mat;
+		UpdateBoundingBox();
+	}
+
+	void IPrimitivesComponent::UpdateBoundingBox()
+	{
+		if (mLocalBoundingBoxDirty_)
+		{
+			mLocalBoundingBox_ = Box::GetEmpty();
+			for (IPrimitive* prim : mModel_->GetPrimitives())
+			{
+				mLocalBoundingBox_.Merge(prim->GetBoundingBox());
+			}
+
+			// sphere shares the box center, see BoundsStream
+			Vector3 center = mLocalBoundingBox_.GetCenter();
+			float radius = -1.f;
+			for (IPrimitive* prim : mModel_->GetPrimitives())
+			{
+				const Sphere& sphere = prim->GetBoundingSphere();
+				if (sphere.IsValid())
+					radius = Max(radius, (sphere.GetCenter() - center).GetLength() + sphere.GetRadius());
+			}
+			mLocalBoundingSphere_ = Sphere(center, radius);
+			mLocalBoundingBoxDirty_ = false;
+		}
+
+		// keep the default(infinite) box if there is nothing to bound, so it is never culled
+		if (!mLocalBoundingBox_.IsValid())
+			return;
+		mBoundingBox_ = mLocalBoundingBox_.Transform(mTransform_);
+		mBoundingSphere_ = mLocalBoundingSphere_.Transform(mTransform_);
+		GEngine->Scene->UpdatePrimitive(this);
 	}
 
 	void IPrimitivesComponent::Serialize(Archive* ar)
@@ -15,6 +15,7 @@ namespace zyh
 	class IPrimitivesComponent : public IComponent
 	{
 		using Super = IComponent;
+		friend class ClientScene;
 	public:
 		IPrimitivesComponent(IEntity* Parent);
 		IPrimitivesComponent(IEntity* Parent, EPrimitiveType meshType, const std::string& meshFileName);
@@ -22,14 +23,40 @@ namespace zyh
 
 	public:
 		virtual void EmitRenderElements(RenderSet renderSet, IRenderScene& renderScene);
+		virtual void WithdrawRenderElements(RenderSet renderSet, IRenderScene& renderScene);
 		virtual bool Culling() { return true; }
-		virtual void UpdateTransform(Matrix4x3& mat) override;
+		virtual void UpdateTransform(const Matrix4x3& mat) override;
 		virtual void Serialize(Archive* ar);
 
+	public:
+		// world space, used by ClientScene's primitive tree
+		const Box& GetBoundingBox() const { return mBoundingBox_; }
+		const Sphere& GetBoundingSphere() const { return mBoundingSphere_; }
+		void MarkBoundingBoxDirty() { mLocalBoundingBoxDirty_ = true; }
+
+	protected:
+		void UpdateBoundingBox();
+
 	protected:
 		VulkanModel* mModel_;
+		Matrix4x3 mTransform_;
+		Box mLocalBoundingBox_;
+		Sphere mLocalBoundingSphere_;
+		Box mBoundingBox_;
+		Sphere mBoundingSphere_;
+		bool mLocalBoundingBoxDirty_{ true };
 
 		EPrimitiveType mMeshType_{ EPrimitiveType::MESH };
 		std::string mMeshFileName_;
+
+		SlotHandle mSceneHandle_;
+
+		// visible set membership, maintained by ClientScene::UpdateVisibleSet
+		bool mIsVisible_{ false };
+		uint32_t mVisibleStamp_{ 0 };
+		// slots in ClientScene's visible / refresh lists, so removal is a swap with the last entry
+		static constexpr uint32_t INVALID_LIST_INDEX = ~0u;
+		uint32_t mVisibleIndex_{ INVALID_LIST_INDEX };
+		uint32_t mRefreshIndex_{ INVALID_LIST_INDEX };
 	};
 }
\ No newline at end of file
@@ -10,6 +10,7 @@ namespace zyh
 {
 	InputSystem* GInputSystem = new InputSystem();
 
+#if defined(_WIN32)
 	void InputSystem::HandleMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 	{
 		switch (uMsg)
@@ -38,6 +39,7 @@ namespace zyh
 			break;
 		}
 	}
+#endif
 }
 
 #undef BOARDCAST_EVENT
\ No newline at end of file
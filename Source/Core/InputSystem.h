@@ -34,8 +34,10 @@ namespace zyh
 		DEFINE_OP_EVENT(MouseWheel, KEY_TYPE /* Wheel Offset */);
 		DEFINE_OP_EVENT(MouseMove, KEY_TYPE/* XPosition */, KEY_TYPE/* YPosition */);
 
+#if defined(_WIN32)
 	public:
 		void HandleMessage(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
+#endif
 	};
 
 	extern InputSystem* GInputSystem;
@@ -0,0 +1,204 @@
+#include "JobSystem.h"
+#include <stdexcept>
+
+
+namespace zyh
+{
+	namespace
+	{
+		// set for worker and registered threads, identifies the owning system so nested systems don't mix up indices
+		thread_local const JobSystem* tJobSystem = nullptr;
+		thread_local uint32_t tThreadIndex = 0;
+	}
+
+	JobSystem::JobSystem(uint32_t threadCount, uint32_t externalThreads)
+	{
+		if (threadCount == 0)
+			threadCount = Max(std::thread::hardware_concurrency(), 1u);
+
+		// external slots follow the workers, the owner keeps slot 0
+		mExternalUsed_.resize(externalThreads, false);
+		for (uint32_t i = 0; i < threadCount + externalThreads; ++i)
+		{
+			mQueues_.push_back(std::make_unique<WorkQueue>());
+		}
+		for (uint32_t i = 1; i < threadCount; ++i)
+		{
+			mThreads_.emplace_back(&JobSystem::_WorkerLoop, this, i);
+		}
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mSleepLock_);
+			mStop_.store(true);
+		}
+		mWakeUp_.notify_all();
+		for (std::thread& thread : mThreads_)
+		{
+			thread.join();
+		}
+	}
+
+	uint32_t JobSystem::GetThreadIndex() const
+	{
+		return tJobSystem == this ? tThreadIndex : 0;
+	}
+
+	uint32_t JobSystem::RegisterThread()
+	{
+		HYBRID_CHECK(tJobSystem != this, "thread is already registered");
+		std::lock_guard<std::mutex> lock(mExternalLock_);
+		for (uint32_t i = 0; i < mExternalUsed_.size(); ++i)
+		{
+			if (mExternalUsed_[i])
+				continue;
+			mExternalUsed_[i] = true;
+			tJobSystem = this;
+			tThreadIndex = GetThreadCount() + i;
+			return tThreadIndex;
+		}
+		throw std::runtime_error("no free external job thread slot!");
+	}
+
+	void JobSystem::UnregisterThread()
+	{
+		HYBRID_CHECK(tJobSystem == this && tThreadIndex >= GetThreadCount(), "thread is not registered");
+		std::lock_guard<std::mutex> lock(mExternalLock_);
+		// jobs left in the slot's deque are still stolen by the others
+		mExternalUsed_[tThreadIndex - GetThreadCount()] = false;
+		tJobSystem = nullptr;
+		tThreadIndex = 0;
+	}
+
+	void JobSystem::Run(std::function<void()> job, JobCounter* counter)
+	{
+		if (counter)
+			counter->mPending_.fetch_add(1, std::memory_order_relaxed);
+		_Push(Job{ std::move(job), counter });
+	}
+
+	void JobSystem::RunAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter)
+	{
+		if (counter)
+			counter->mPending_.fetch_add(1, std::memory_order_relaxed);
+		{
+			// _Finish swaps the continuations out under the same lock, so either it sees this one or the count is already zero
+			std::lock_guard<std::mutex> lock(dependency.mLock_);
+			if (!dependency.IsDone())
+			{
+				dependency.mContinuations_.emplace_back(std::move(job), counter);
+				return;
+			}
+		}
+		_Push(Job{ std::move(job), counter });
+	}
+
+	void JobSystem::Wait(JobCounter& counter)
+	{
+		const uint32_t threadIndex = GetThreadIndex();
+		while (!counter.IsDone())
+		{
+			if (!_TryRunOne(threadIndex))
+				std::this_thread::yield();
+		}
+		// the last _Finish may still hold the lock, the caller is free to destroy counter after this
+		std::lock_guard<std::mutex> lock(counter.mLock_);
+	}
+
+	void JobSystem::_Push(Job&& job)
+	{
+		WorkQueue& queue = *mQueues_[GetThreadIndex()];
+		{
+			std::lock_guard<std::mutex> lock(queue.Lock);
+			queue.Jobs.push_back(std::move(job));
+		}
+		mQueuedJobs_.fetch_add(1, std::memory_order_release);
+		if (!mThreads_.empty())
+		{
+			// empty critical section orders the push against a worker going to sleep
+			{ std::lock_guard<std::mutex> lock(mSleepLock_); }
+			mWakeUp_.notify_one();
+		}
+	}
+
+	bool JobSystem::_Pop(uint32_t threadIndex, Job& outJob)
+	{
+		WorkQueue& queue = *mQueues_[threadIndex];
+		std::lock_guard<std::mutex> lock(queue.Lock);
+		if (queue.Jobs.empty())
+			return false;
+		outJob = std::move(queue.Jobs.back());
+		queue.Jobs.pop_back();
+		return true;
+	}
+
+	bool JobSystem::_Steal(uint32_t threadIndex, Job& outJob)
+	{
+		const uint32_t count = GetSlotCount();
+		for (uint32_t offset = 1; offset < count; ++offset)
+		{
+			WorkQueue& queue = *mQueues_[(threadIndex + offset) % count];
+			std::unique_lock<std::mutex> lock(queue.Lock, std::try_to_lock);
+			if (!lock.owns_lock() || queue.Jobs.empty())
+				continue;
+			outJob = std::move(queue.Jobs.front());
+			queue.Jobs.pop_front();
+			return true;
+		}
+		return false;
+	}
+
+	bool JobSystem::_TryRunOne(uint32_t threadIndex)
+	{
+		if (mQueuedJobs_.load(std::memory_order_acquire) == 0)
+			return false;
+		Job job;
+		if (!_Pop(threadIndex, job) && !_Steal(threadIndex, job))
+			return false;
+		mQueuedJobs_.fetch_sub(1, std::memory_order_relaxed);
+		_Execute(job);
+		return true;
+	}
+
+	void JobSystem::_Execute(Job& job)
+	{
+		job.Func();
+		_Finish(job.Counter);
+	}
+
+	void JobSystem::_Finish(JobCounter* counter)
+	{
+		if (!counter)
+			return;
+		std::vector<std::pair<std::function<void()>, JobCounter*>> continuations;
+		{
+			std::lock_guard<std::mutex> lock(counter->mLock_);
+			if (counter->mPending_.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+			continuations.swap(counter->mContinuations_);
+		}
+		// the counter may be destroyed by a waiter from here on
+		for (auto& continuation : continuations)
+		{
+			_Push(Job{ std::move(continuation.first), continuation.second });
+		}
+	}
+
+	void JobSystem::_WorkerLoop(uint32_t threadIndex)
+	{
+		tJobSystem = this;
+		tThreadIndex = threadIndex;
+		while (true)
+		{
+			if (_TryRunOne(threadIndex))
+				continue;
+
+			std::unique_lock<std::mutex> lock(mSleepLock_);
+			mWakeUp_.wait(lock, [this]() { return mStop_.load() || mQueuedJobs_.load(std::memory_order_acquire) != 0; });
+			if (mStop_.load())
+				return;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <memory>
+#include "Common/Config.h"
+#include "Math/MathUtil.h"
+
+
+namespace zyh
+{
+	class JobSystem;
+
+	// Counts unfinished jobs. Jobs attached with JobSystem::RunAfter are scheduled once it drops to zero,
+	// which is how dependencies are expressed.
+	class JobCounter
+	{
+		friend class JobSystem;
+	public:
+		bool IsDone() const { return mPending_.load(std::memory_order_acquire) == 0; }
+
+	protected:
+		std::atomic<uint32_t> mPending_{ 0 };
+		std::mutex mLock_;
+		std::vector<std::pair<std::function<void()>, JobCounter*>> mContinuations_;
+	};
+
+	// Work stealing scheduler: every thread owns a deque, pushes / pops at the back and steals from the front
+	// of other deques when its own is empty. The thread that created the system takes part as worker 0 while
+	// it is in Wait(), so GetThreadCount() workers run jobs in total. Other threads submitting work (e.g. the
+	// render thread) claim one of the externalThreads slots with RegisterThread(), so they never share a deque.
+	class JobSystem
+	{
+	public:
+		// threadCount 0 means one per hardware thread
+		explicit JobSystem(uint32_t threadCount = 0, uint32_t externalThreads = 0);
+		~JobSystem();
+
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+
+	public:
+		// counter (optional) is incremented now and decremented when job finished
+		void Run(std::function<void()> job, JobCounter* counter = nullptr);
+		// schedules job once dependency is done
+		void RunAfter(JobCounter& dependency, std::function<void()> job, JobCounter* counter = nullptr);
+		// runs other jobs on the calling thread until counter is done
+		void Wait(JobCounter& counter);
+
+		// func(begin, end) over chunks of at most grainSize, returns when all chunks finished
+		template<typename TFunc>
+		void ParallelFor(size_t begin, size_t end, size_t grainSize, TFunc&& func)
+		{
+			if (begin >= end)
+				return;
+			grainSize = Max(grainSize, size_t(1));
+			if (end - begin <= grainSize || mThreads_.empty())
+			{
+				func(begin, end);
+				return;
+			}
+			JobCounter counter;
+			for (size_t chunk = begin; chunk < end; chunk += grainSize)
+			{
+				const size_t chunkEnd = Min(chunk + grainSize, end);
+				Run([&func, chunk, chunkEnd]() { func(chunk, chunkEnd); }, &counter);
+			}
+			Wait(counter);
+		}
+
+		// threads running jobs: the owner and the workers
+		uint32_t GetThreadCount() const { return uint32_t(mThreads_.size()) + 1; }
+		// every index GetThreadIndex() can return, external slots included
+		uint32_t GetSlotCount() const { return uint32_t(mQueues_.size()); }
+		// index of the calling thread inside this system, 0 for the owner and any unregistered thread
+		uint32_t GetThreadIndex() const;
+
+		// gives the calling thread an external slot until UnregisterThread(), throws when all are taken
+		uint32_t RegisterThread();
+		void UnregisterThread();
+
+	protected:
+		struct Job
+		{
+			std::function<void()> Func;
+			JobCounter* Counter{ nullptr };
+		};
+
+		struct alignas(64) WorkQueue
+		{
+			std::mutex Lock;
+			std::deque<Job> Jobs;
+		};
+
+		void _Push(Job&& job);
+		bool _Pop(uint32_t threadIndex, Job& outJob);
+		bool _Steal(uint32_t threadIndex, Job& outJob);
+		bool _TryRunOne(uint32_t threadIndex);
+		void _Execute(Job& job);
+		void _Finish(JobCounter* counter);
+		void _WorkerLoop(uint32_t threadIndex);
+
+	protected:
+		std::vector<std::unique_ptr<WorkQueue>> mQueues_;
+		std::vector<std::thread> mThreads_;
+		std::mutex mExternalLock_;
+		std::vector<bool> mExternalUsed_;
+
+		std::atomic<uint32_t> mQueuedJobs_{ 0 };
+		std::atomic<bool> mStop_{ false };
+		std::mutex mSleepLock_;
+		std::condition_variable mWakeUp_;
+	};
+}
\ No newline at end of file
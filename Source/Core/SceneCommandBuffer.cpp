@@ -0,0 +1,121 @@
+#include "SceneCommandBuffer.h"
+#include "ClientScene.h"
+#include "IEntity.h"
+#include "JobSystem.h"
+#include <algorithm>
+#include <unordered_set>
+
+
+namespace zyh
+{
+	namespace
+	{
+		thread_local uint64_t tSource = SceneCommandBuffer::NO_SOURCE;
+	}
+
+	SceneCommandBuffer::SceneCommandBuffer(const JobSystem& jobs) : mJobs_(jobs)
+	{
+		for (uint32_t i = 0; i < jobs.GetSlotCount(); ++i)
+		{
+			mThreadCommands_.push_back(std::make_unique<ThreadCommands>());
+		}
+	}
+
+	void SceneCommandBuffer::SpawnEntity(std::function<IEntity*()> factory)
+	{
+		_Record(Command{ ECommandType::SPAWN_ENTITY, NO_SOURCE, nullptr, nullptr, std::move(factory) });
+	}
+
+	void SceneCommandBuffer::DelEntity(IEntity* entity)
+	{
+		_Record(Command{ ECommandType::DEL_ENTITY, NO_SOURCE, entity });
+	}
+
+	void SceneCommandBuffer::DestroyEntity(IEntity* entity)
+	{
+		_Record(Command{ ECommandType::DESTROY_ENTITY, NO_SOURCE, entity });
+	}
+
+	void SceneCommandBuffer::SetParent(IEntity* entity, IEntity* parent)
+	{
+		_Record(Command{ ECommandType::SET_PARENT, NO_SOURCE, entity, parent });
+	}
+
+	void SceneCommandBuffer::Call(std::function<void(ClientScene&)> func)
+	{
+		_Record(Command{ ECommandType::CALL, NO_SOURCE, nullptr, nullptr, nullptr, std::move(func) });
+	}
+
+	void SceneCommandBuffer::Flush(ClientScene& scene)
+	{
+		// commands may record new commands (e.g. a Call spawning entities), those run in the next flush
+		for (auto& threadCommands : mThreadCommands_)
+		{
+			std::lock_guard<std::mutex> lock(threadCommands->Lock);
+			for (Command& command : threadCommands->Commands)
+			{
+				mFlushing_.push_back(std::move(command));
+			}
+			threadCommands->Commands.clear();
+		}
+
+		// which thread recorded a command depends on scheduling, the source doesn't
+		std::stable_sort(mFlushing_.begin(), mFlushing_.end(), [](const Command& a, const Command& b) { return a.Source < b.Source; });
+
+		std::unordered_set<IEntity*> destroyed;
+		for (Command& command : mFlushing_)
+		{
+			switch (command.Type)
+			{
+			case ECommandType::SPAWN_ENTITY:
+				scene.AddEntity(command.Factory());
+				break;
+			case ECommandType::DEL_ENTITY:
+				scene.DelEntity(command.Entity);
+				break;
+			case ECommandType::DESTROY_ENTITY:
+				if (destroyed.insert(command.Entity).second)
+					mDestroying_.push_back(command.Entity);
+				break;
+			case ECommandType::SET_PARENT:
+				command.Entity->SetParent(command.Parent);
+				break;
+			case ECommandType::CALL:
+				command.Func(scene);
+				break;
+			}
+		}
+		mFlushing_.clear();
+
+		for (IEntity* entity : mDestroying_)
+		{
+			scene.DelEntity(entity);
+			delete entity;
+		}
+		mDestroying_.clear();
+	}
+
+	bool SceneCommandBuffer::Empty() const
+	{
+		for (const auto& threadCommands : mThreadCommands_)
+		{
+			std::lock_guard<std::mutex> lock(threadCommands->Lock);
+			if (!threadCommands->Commands.empty())
+				return false;
+		}
+		return true;
+	}
+
+	void SceneCommandBuffer::SetSource(uint64_t source)
+	{
+		tSource = source;
+	}
+
+	void SceneCommandBuffer::_Record(Command&& command)
+	{
+		command.Source = tSource;
+		ThreadCommands& threadCommands = *mThreadCommands_[mJobs_.GetThreadIndex()];
+		std::lock_guard<std::mutex> lock(threadCommands.Lock);
+		threadCommands.Commands.push_back(std::move(command));
+	}
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+#include <memory>
+#include <mutex>
+#include "Common/Config.h"
+
+
+namespace zyh
+{
+	class ClientScene;
+	class IEntity;
+	class JobSystem;
+
+	// Structural scene changes recorded while entities tick in parallel, applied by ClientScene at the sync point
+	// after the update phase. Each job thread records into its own list so recording never contends.
+	class SceneCommandBuffer
+	{
+	public:
+		explicit SceneCommandBuffer(const JobSystem& jobs);
+
+		// entity construction touches shared scene state (transforms, registry, primitives), so spawning
+		// takes a factory that runs at the sync point, the result is added to the scene
+		void SpawnEntity(std::function<IEntity*()> factory);
+		// removes the entity from the scene, the caller keeps ownership
+		void DelEntity(IEntity* entity);
+		// removes and deletes the entity together with its components
+		void DestroyEntity(IEntity* entity);
+		void SetParent(IEntity* entity, IEntity* parent);
+		// anything else that touches shared scene state
+		void Call(std::function<void(ClientScene&)> func);
+
+		// applies the commands ordered by source, then by thread, commands of one thread keep their recording
+		// order. destroys run last, once per entity, so no other command of the flush sees a deleted entity
+		void Flush(ClientScene& scene);
+		bool Empty() const;
+
+		// calling thread: commands recorded from now on are ordered by source instead of by the thread that
+		// happened to record them, parallel loops set it to the index of the item being processed
+		static void SetSource(uint64_t source);
+		static void ClearSource() { SetSource(NO_SOURCE); }
+
+		static constexpr uint64_t NO_SOURCE = UINT64_MAX;
+
+	protected:
+		enum class ECommandType : uint8_t
+		{
+			SPAWN_ENTITY,
+			DEL_ENTITY,
+			DESTROY_ENTITY,
+			SET_PARENT,
+			CALL,
+		};
+
+		struct Command
+		{
+			ECommandType Type;
+			uint64_t Source{ NO_SOURCE };
+			IEntity* Entity{ nullptr };
+			IEntity* Parent{ nullptr };
+			std::function<IEntity*()> Factory;
+			std::function<void(ClientScene&)> Func;
+		};
+
+		// foreign threads share slot 0 with the main thread, hence the lock
+		struct alignas(64) ThreadCommands
+		{
+			mutable std::mutex Lock;
+			std::vector<Command> Commands;
+		};
+
+		void _Record(Command&& command);
+
+	protected:
+		const JobSystem& mJobs_;
+		std::vector<std::unique_ptr<ThreadCommands>> mThreadCommands_;
+		std::vector<Command> mFlushing_;
+		std::vector<IEntity*> mDestroying_;
+	};
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "Math/MathUtil.h"
 #include "Graphics/Vulkan/VulkanRenderElement.h"
 #include "Graphics/Vulkan/VulkanModel.h"
+#include "Graphics/Common/Renderer.h"
 
 #include <time.h>
 
@@ -60,10 +61,24 @@ namespace zyh
 	{
 		std::vector<VulkanRenderElement*> Elements;
 		mModel_->getAllRenderElements(Elements);
-		for (VulkanRenderElement* element : Elements)
-		{
-			element->updateData(prim);
-		}
+
+		// buffers are uploaded on the render thread, the height map keeps changing meanwhile so copy the data
+		void* vertexData{ nullptr }; size_t vertexSize;
+		void* indexData{ nullptr }; size_t indexSize;
+		prim->GetVerticesData(&vertexData, vertexSize);
+		prim->GetIndicesData(&indexData, indexSize);
+		std::vector<uint8_t> vertices(static_cast<uint8_t*>(vertexData), static_cast<uint8_t*>(vertexData) + vertexSize);
+		std::vector<uint8_t> indices(static_cast<uint8_t*>(indexData), static_cast<uint8_t*>(indexData) + indexSize);
+		GEngine->Scene->GetRenderer()->EnqueueCommand([Elements, vertices = std::move(vertices), indices = std::move(indices)]() mutable
+			{
+				for (VulkanRenderElement* element : Elements)
+				{
+					element->updateData(vertices.data(), vertices.size(), indices.data(), indices.size());
+				}
+			});
+
+		MarkBoundingBoxDirty();
+		UpdateBoundingBox();
 	}
 
 }
\ No newline at end of file
@@ -155,6 +155,8 @@ namespace zyh
 				}
 			}
 		
+			UpdateBoundingVolume();
+
 			// [DEBUG]
 			HeightMapManipulator::getInstance()->SetTargetHeightMap(heightMap);
 		}
@@ -172,6 +174,7 @@ namespace zyh
 			mVertices_[index].pos.g = mHeightMap_->mHeightMapData_[index];
 			mVertices_[index].normal.r = (fx0 - fx1) / 2 * mHeightMap_->mTileAcc_;
 			mVertices_[index].normal.b = (fy0 - fy1) / 2 * mHeightMap_->mTileAcc_;
+			UpdateBoundingVolume();
 
 			DataChanged.BoardCast(this);
 		}
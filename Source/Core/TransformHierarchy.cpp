@@ -0,0 +1,271 @@
+#include "TransformHierarchy.h"
+#include "Math/VectorStream.h"
+
+
+namespace zyh
+{
+	TransformHierarchy::Handle TransformHierarchy::Create(Handle parent, const Matrix4x3& local)
+	{
+		HYBRID_CHECK(parent == INVALID_HANDLE || IsValid(parent));
+		Handle handle;
+		if (!mFreeHandles_.empty())
+		{
+			handle = mFreeHandles_.back();
+			mFreeHandles_.pop_back();
+		}
+		else
+		{
+			handle = Handle(mHandleToIndex_.size());
+			mHandleToIndex_.push_back(INVALID_HANDLE);
+			mParentHandle_.push_back(INVALID_HANDLE);
+			mFirstChild_.push_back(INVALID_HANDLE);
+			mNextSibling_.push_back(INVALID_HANDLE);
+			mPrevSibling_.push_back(INVALID_HANDLE);
+		}
+
+		// appended unsorted, _Rebuild() moves it to its level
+		uint32_t index = uint32_t(mLocal_.size());
+		mHandleToIndex_[handle] = index;
+		_LinkChild(handle, parent);
+		mLocal_.push_back(local);
+		mWorld_.push_back(local);
+		mPreviousWorld_.push_back(local);
+		mParentIndex_.push_back(parent == INVALID_HANDLE ? INVALID_HANDLE : mHandleToIndex_[parent]);
+		mDirty_.push_back(1);
+		mIndexToHandle_.push_back(handle);
+		mCreatedHandles_.push_back(handle);
+		mStructureDirty_ = true;
+		mHasDirty_ = true;
+		return handle;
+	}
+
+	void TransformHierarchy::Destroy(Handle handle)
+	{
+		HYBRID_CHECK(IsValid(handle));
+		Handle parent = mParentHandle_[handle];
+		while (mFirstChild_[handle] != INVALID_HANDLE)
+		{
+			SetParent(mFirstChild_[handle], parent);
+		}
+		_UnlinkChild(handle);
+
+		uint32_t index = _GetIndex(handle);
+		// swap with the last entry, order is restored by _Rebuild()
+		uint32_t last = uint32_t(mLocal_.size() - 1);
+		if (index != last)
+		{
+			mLocal_[index] = mLocal_[last];
+			mWorld_[index] = mWorld_[last];
+			mPreviousWorld_[index] = mPreviousWorld_[last];
+			mDirty_[index] = mDirty_[last];
+			mIndexToHandle_[index] = mIndexToHandle_[last];
+			mHandleToIndex_[mIndexToHandle_[index]] = index;
+		}
+		mLocal_.pop_back();
+		mWorld_.pop_back();
+		mPreviousWorld_.pop_back();
+		mParentIndex_.pop_back();
+		mDirty_.pop_back();
+		mIndexToHandle_.pop_back();
+
+		mHandleToIndex_[handle] = INVALID_HANDLE;
+		mFreeHandles_.push_back(handle);
+		mStructureDirty_ = true;
+	}
+
+	void TransformHierarchy::SetParent(Handle handle, Handle parent)
+	{
+		HYBRID_CHECK(IsValid(handle));
+		HYBRID_CHECK(parent == INVALID_HANDLE || IsValid(parent));
+		// no cycles
+		for (Handle ancestor = parent; ancestor != INVALID_HANDLE; ancestor = mParentHandle_[ancestor])
+		{
+			HYBRID_CHECK(ancestor != handle);
+		}
+		_UnlinkChild(handle);
+		_LinkChild(handle, parent);
+		mDirty_[_GetIndex(handle)] = 1;
+		mStructureDirty_ = true;
+		mHasDirty_ = true;
+	}
+
+	TransformHierarchy::Handle TransformHierarchy::GetParent(Handle handle) const
+	{
+		HYBRID_CHECK(IsValid(handle));
+		return mParentHandle_[handle];
+	}
+
+	void TransformHierarchy::SetLocal(Handle handle, const Matrix4x3& local)
+	{
+		uint32_t index = _GetIndex(handle);
+		mLocal_[index] = local;
+		mDirty_[index] = 1;
+		mHasDirty_ = true;
+	}
+
+	Matrix4x3 TransformHierarchy::GetInterpolatedWorld(Handle handle, float alpha) const
+	{
+		const uint32_t index = _GetIndex(handle);
+		const Matrix4x3& previous = mPreviousWorld_[index];
+		const Matrix4x3& current = mWorld_[index];
+		if (alpha >= 1.f || previous == current)
+			return current;
+
+		Matrix4x3 result;
+		for (uint32 row = 0; row < Matrix4x3::ROW; ++row)
+		{
+			for (uint32 col = 0; col < Matrix4x3::COL; ++col)
+			{
+				result(row, col) = Lerp(previous(row, col), current(row, col), alpha);
+			}
+		}
+		return result;
+	}
+
+	void TransformHierarchy::Update()
+	{
+		if (mStructureDirty_)
+			_Rebuild();
+
+		// only the nodes changed by the last update differ from their previous world matrix
+		for (Handle handle : mChangedHandles_)
+		{
+			if (IsValid(handle))
+				mPreviousWorld_[mHandleToIndex_[handle]] = mWorld_[mHandleToIndex_[handle]];
+		}
+		mChangedHandles_.clear();
+		if (!mHasDirty_ || mLocal_.empty())
+			return;
+		mHasDirty_ = false;
+
+		// parents are sorted before their children, so one forward pass marks whole subtrees
+		for (uint32_t i = mLevelBegin_[1]; i < mLocal_.size(); ++i)
+		{
+			mDirty_[i] |= mDirty_[mParentIndex_[i]];
+		}
+
+		for (uint32_t i = mLevelBegin_[0]; i < mLevelBegin_[1]; ++i)
+		{
+			if (!mDirty_[i])
+				continue;
+			mWorld_[i] = mLocal_[i];
+			mDirty_[i] = 0;
+			mChangedHandles_.push_back(mIndexToHandle_[i]);
+		}
+
+		// every level only reads the level above, which is complete at this point
+		for (size_t level = 1; level + 1 < mLevelBegin_.size(); ++level)
+		{
+			mDirtyIndices_.clear();
+			mDirtyParentIndices_.clear();
+			for (uint32_t i = mLevelBegin_[level]; i < mLevelBegin_[level + 1]; ++i)
+			{
+				if (!mDirty_[i])
+					continue;
+				mDirtyIndices_.push_back(i);
+				mDirtyParentIndices_.push_back(mParentIndex_[i]);
+				mDirty_[i] = 0;
+				mChangedHandles_.push_back(mIndexToHandle_[i]);
+			}
+			VectorStream::MultiplyAffineIndexed(mLocal_.data(), mWorld_.data(), mWorld_.data(),
+				mDirtyIndices_.data(), mDirtyParentIndices_.data(), mDirtyIndices_.size());
+		}
+
+		for (Handle handle : mCreatedHandles_)
+		{
+			if (IsValid(handle))
+				mPreviousWorld_[mHandleToIndex_[handle]] = mWorld_[mHandleToIndex_[handle]];
+		}
+		mCreatedHandles_.clear();
+	}
+
+	uint32_t TransformHierarchy::_GetDepth(Handle handle, std::vector<uint32_t>& depths) const
+	{
+		if (depths[handle] != INVALID_HANDLE)
+			return depths[handle];
+		Handle parent = mParentHandle_[handle];
+		depths[handle] = parent == INVALID_HANDLE ? 0 : _GetDepth(parent, depths) + 1;
+		return depths[handle];
+	}
+
+	void TransformHierarchy::_LinkChild(Handle handle, Handle parent)
+	{
+		mParentHandle_[handle] = parent;
+		mPrevSibling_[handle] = INVALID_HANDLE;
+		mNextSibling_[handle] = INVALID_HANDLE;
+		if (parent == INVALID_HANDLE)
+			return;
+		const Handle next = mFirstChild_[parent];
+		mNextSibling_[handle] = next;
+		if (next != INVALID_HANDLE)
+			mPrevSibling_[next] = handle;
+		mFirstChild_[parent] = handle;
+	}
+
+	void TransformHierarchy::_UnlinkChild(Handle handle)
+	{
+		const Handle parent = mParentHandle_[handle];
+		const Handle prev = mPrevSibling_[handle];
+		const Handle next = mNextSibling_[handle];
+		if (prev != INVALID_HANDLE)
+			mNextSibling_[prev] = next;
+		else if (parent != INVALID_HANDLE)
+			mFirstChild_[parent] = next;
+		if (next != INVALID_HANDLE)
+			mPrevSibling_[next] = prev;
+		mParentHandle_[handle] = INVALID_HANDLE;
+		mPrevSibling_[handle] = INVALID_HANDLE;
+		mNextSibling_[handle] = INVALID_HANDLE;
+	}
+
+	void TransformHierarchy::_Rebuild()
+	{
+		const uint32_t count = uint32_t(mLocal_.size());
+		std::vector<uint32_t> depths(mHandleToIndex_.size(), INVALID_HANDLE);
+		uint32_t maxDepth = 0;
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			maxDepth = Max(maxDepth, _GetDepth(mIndexToHandle_[i], depths));
+		}
+
+		// counting sort by depth, stable so siblings keep their relative order
+		mLevelBegin_.assign(maxDepth + 2, 0);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			++mLevelBegin_[depths[mIndexToHandle_[i]] + 1];
+		}
+		for (size_t level = 1; level < mLevelBegin_.size(); ++level)
+		{
+			mLevelBegin_[level] += mLevelBegin_[level - 1];
+		}
+
+		std::vector<uint32_t> cursor(mLevelBegin_.begin(), mLevelBegin_.end() - 1);
+		std::vector<Matrix4x3> local(count), world(count), previousWorld(count);
+		std::vector<uint8_t> dirty(count);
+		std::vector<Handle> indexToHandle(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Handle handle = mIndexToHandle_[i];
+			uint32_t target = cursor[depths[handle]]++;
+			local[target] = mLocal_[i];
+			world[target] = mWorld_[i];
+			previousWorld[target] = mPreviousWorld_[i];
+			dirty[target] = mDirty_[i];
+			indexToHandle[target] = handle;
+			mHandleToIndex_[handle] = target;
+		}
+		mLocal_.swap(local);
+		mWorld_.swap(world);
+		mPreviousWorld_.swap(previousWorld);
+		mDirty_.swap(dirty);
+		mIndexToHandle_.swap(indexToHandle);
+
+		mParentIndex_.resize(count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			Handle parent = mParentHandle_[mIndexToHandle_[i]];
+			mParentIndex_[i] = parent == INVALID_HANDLE ? INVALID_HANDLE : mHandleToIndex_[parent];
+		}
+		mStructureDirty_ = false;
+	}
+}
\ No newline at end of file
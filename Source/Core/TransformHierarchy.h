@@ -0,0 +1,83 @@
+#pragma once
+#include "Common/Config.h"
+#include "Math/Matrix4x3.h"
+
+
+namespace zyh
+{
+	// Scene graph transforms kept in flat arrays sorted by depth, so a parent always comes before its children.
+	// Handles stay valid across re-sorting, Update() only recomputes the world matrices of dirty subtrees.
+	class TransformHierarchy
+	{
+	public:
+		using Handle = uint32_t;
+		static constexpr Handle INVALID_HANDLE = ~0u;
+
+	public:
+		Handle Create(Handle parent = INVALID_HANDLE, const Matrix4x3& local = Matrix4x3());
+		// children are attached to the parent of the destroyed node
+		void Destroy(Handle handle);
+
+		void SetParent(Handle handle, Handle parent);
+		Handle GetParent(Handle handle) const;
+
+		void SetLocal(Handle handle, const Matrix4x3& local);
+		const Matrix4x3& GetLocal(Handle handle) const { return mLocal_[_GetIndex(handle)]; }
+		// valid after Update()
+		const Matrix4x3& GetWorld(Handle handle) const { return mWorld_[_GetIndex(handle)]; }
+		// world matrix before the last Update()
+		const Matrix4x3& GetPreviousWorld(Handle handle) const { return mPreviousWorld_[_GetIndex(handle)]; }
+		// component wise blend from the previous to the current world matrix (alpha 0 -> 1),
+		// good enough for the small change of one simulation step
+		Matrix4x3 GetInterpolatedWorld(Handle handle, float alpha) const;
+
+		bool IsValid(Handle handle) const { return handle < mHandleToIndex_.size() && mHandleToIndex_[handle] != INVALID_HANDLE; }
+		size_t Size() const { return mLocal_.size(); }
+
+		// re-sorts if nodes were added / removed / re-parented, then propagates dirty flags and recomputes world matrices level by level
+		void Update();
+		// handles whose world matrix was recomputed by the last Update()
+		const std::vector<Handle>& GetChangedHandles() const { return mChangedHandles_; }
+
+	protected:
+		uint32_t _GetIndex(Handle handle) const
+		{
+			HYBRID_CHECK(IsValid(handle));
+			return mHandleToIndex_[handle];
+		}
+		void _Rebuild();
+		uint32_t _GetDepth(Handle handle, std::vector<uint32_t>& depths) const;
+		// child lists, so reparenting and destroying only touch the node and its direct children
+		void _LinkChild(Handle handle, Handle parent);
+		void _UnlinkChild(Handle handle);
+
+	protected:
+		// indexed by position, sorted by depth
+		std::vector<Matrix4x3> mLocal_;
+		std::vector<Matrix4x3> mWorld_;
+		std::vector<Matrix4x3> mPreviousWorld_;
+		std::vector<uint32_t> mParentIndex_;
+		std::vector<uint8_t> mDirty_;
+		std::vector<Handle> mIndexToHandle_;
+		// first position of every depth, plus the end
+		std::vector<uint32_t> mLevelBegin_;
+
+		// indexed by handle
+		std::vector<uint32_t> mHandleToIndex_;
+		std::vector<Handle> mParentHandle_;
+		std::vector<Handle> mFirstChild_;
+		std::vector<Handle> mNextSibling_;
+		std::vector<Handle> mPrevSibling_;
+		std::vector<Handle> mFreeHandles_;
+
+		bool mStructureDirty_{ false };
+		bool mHasDirty_{ false };
+
+		// Update() scratch
+		std::vector<uint32_t> mDirtyIndices_;
+		std::vector<uint32_t> mDirtyParentIndices_;
+		std::vector<Handle> mChangedHandles_;
+		// created since the last Update(), they start without history
+		std::vector<Handle> mCreatedHandles_;
+	};
+}
\ No newline at end of file
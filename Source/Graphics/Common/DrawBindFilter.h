@@ -0,0 +1,78 @@
+#pragma once
+#include "DrawSortKey.h"
+
+
+namespace zyh
+{
+	// what one draw binds, handles are the API's (value initialized is the null handle)
+	template<typename TPipeline, typename TLayout, typename TSet, typename TBuffer>
+	struct DrawBindings
+	{
+		TPipeline Pipeline{};
+		TLayout PipelineLayout{};
+		// null draws without a set
+		TSet DescriptorSet{};
+		// per object uniforms at dynamic offsets, such a set is rebound every draw
+		bool HasDynamicOffsets{ false };
+		TBuffer VertexBuffer{};
+		TBuffer IndexBuffer{};
+	};
+
+	// what the command buffer has bound so far in a pass
+	template<typename TPipeline, typename TLayout, typename TSet, typename TBuffer>
+	struct DrawBindState
+	{
+		TPipeline Pipeline{};
+		TLayout PipelineLayout{};
+		TSet DescriptorSet{};
+		TBuffer VertexBuffer{};
+		TBuffer IndexBuffer{};
+		bool HasDynamicState{ false };
+		DrawStats Stats;
+	};
+
+	// Issues only the binds of draw that differ from state through recorder, which provides SetDynamicState(),
+	// BindPipeline(pipeline), BindDescriptorSet(layout, set), BindVertexBuffer(buffer) and BindIndexBuffer(buffer).
+	// Kept apart from the command buffer so the filtering can run without a device.
+	template<typename TPipeline, typename TLayout, typename TSet, typename TBuffer, typename TRecorder>
+	inline void FilterDrawBinds(const DrawBindings<TPipeline, TLayout, TSet, TBuffer>& draw, DrawBindState<TPipeline, TLayout, TSet, TBuffer>& state, TRecorder& recorder)
+	{
+		// viewport and scissor are dynamic and the same for the whole pass
+		if (!state.HasDynamicState)
+		{
+			recorder.SetDynamicState();
+			state.HasDynamicState = true;
+			state.Stats.DynamicStateSets += 2;
+		}
+
+		if (draw.Pipeline != state.Pipeline)
+		{
+			recorder.BindPipeline(draw.Pipeline);
+			state.Pipeline = draw.Pipeline;
+			++state.Stats.PipelineBinds;
+		}
+
+		// a different layout may disturb the bound set, so it is rebound then
+		if (draw.DescriptorSet != TSet{} && (draw.HasDynamicOffsets || draw.DescriptorSet != state.DescriptorSet || draw.PipelineLayout != state.PipelineLayout))
+		{
+			recorder.BindDescriptorSet(draw.PipelineLayout, draw.DescriptorSet);
+			state.DescriptorSet = draw.DescriptorSet;
+			state.PipelineLayout = draw.PipelineLayout;
+			++state.Stats.DescriptorSetBinds;
+		}
+
+		if (draw.VertexBuffer != state.VertexBuffer)
+		{
+			recorder.BindVertexBuffer(draw.VertexBuffer);
+			state.VertexBuffer = draw.VertexBuffer;
+			++state.Stats.VertexBufferBinds;
+		}
+
+		if (draw.IndexBuffer != state.IndexBuffer)
+		{
+			recorder.BindIndexBuffer(draw.IndexBuffer);
+			state.IndexBuffer = draw.IndexBuffer;
+			++state.Stats.IndexBufferBinds;
+		}
+	}
+}
\ No newline at end of file
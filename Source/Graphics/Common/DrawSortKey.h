@@ -0,0 +1,155 @@
+#pragma once
+#include "Common/Config.h"
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+
+namespace zyh
+{
+	// 64 bit draw key, most significant first: set(4) | pipeline(16) | material(16) | depth(16) | descriptor set(12).
+	// draws sorted by it are grouped by state, so only what differs from the previous draw is bound. depth sits above
+	// the descriptor set since those are mostly per draw, it would never order anything below them
+	struct DrawSortKey
+	{
+		static constexpr uint32_t SET_BITS = 4;
+		static constexpr uint32_t PIPELINE_BITS = 16;
+		static constexpr uint32_t MATERIAL_BITS = 16;
+		static constexpr uint32_t DEPTH_BITS = 16;
+		static constexpr uint32_t DESCRIPTOR_BITS = 12;
+		static_assert(SET_BITS + PIPELINE_BITS + MATERIAL_BITS + DEPTH_BITS + DESCRIPTOR_BITS == 64);
+
+		// ids wider than their field wrap, which only costs grouping, never correctness
+		static constexpr uint64_t Make(uint32_t set, uint32_t pipeline, uint32_t material, uint32_t descriptor, uint32_t depth)
+		{
+			uint64_t key = _Field(set, SET_BITS);
+			key = (key << PIPELINE_BITS) | _Field(pipeline, PIPELINE_BITS);
+			key = (key << MATERIAL_BITS) | _Field(material, MATERIAL_BITS);
+			key = (key << DEPTH_BITS) | _Field(depth, DEPTH_BITS);
+			key = (key << DESCRIPTOR_BITS) | _Field(descriptor, DESCRIPTOR_BITS);
+			return key;
+		}
+
+		// positive floats order like their bit patterns, the top bits are kept. nearest first
+		static uint32_t QuantizeDepth(float depth)
+		{
+			if (!(depth > 0.f))
+				return 0;
+			uint32_t bits;
+			memcpy(&bits, &depth, sizeof(bits));
+			return bits >> (32 - DEPTH_BITS);
+		}
+
+	private:
+		static constexpr uint64_t _Field(uint32_t value, uint32_t bits)
+		{
+			return uint64_t(value) & ((uint64_t(1) << bits) - 1);
+		}
+	};
+
+	// dense per frame ids for the handles packed into a DrawSortKey, in first seen order
+	template<typename T>
+	class DrawKeyIds
+	{
+	public:
+		void Clear() { mIds_.clear(); }
+
+		uint32_t Get(T handle)
+		{
+			auto result = mIds_.try_emplace(handle, uint32_t(mIds_.size()));
+			return result.first->second;
+		}
+
+	private:
+		std::unordered_map<T, uint32_t> mIds_;
+	};
+
+	struct DrawSortItem
+	{
+		uint64_t Key;
+		uint32_t Index;
+	};
+
+	// stable LSD radix sort on Key, 8 bits a pass. digits shared by every key (unused fields) are skipped,
+	// scratch is only resized so callers can keep it across frames. short lists go to std::stable_sort
+	inline void RadixSortDrawItems(std::vector<DrawSortItem>& items, std::vector<DrawSortItem>& scratch)
+	{
+		constexpr uint32_t RADIX_BITS = 8;
+		constexpr uint32_t RADIX = 1 << RADIX_BITS;
+		constexpr uint32_t PASS_COUNT = 64 / RADIX_BITS;
+		constexpr size_t RADIX_SORT_MIN_COUNT = 2048;
+
+		const size_t count = items.size();
+		if (count < 2)
+			return;
+		if (count < RADIX_SORT_MIN_COUNT)
+		{
+			std::stable_sort(items.begin(), items.end(), [](const DrawSortItem& a, const DrawSortItem& b) { return a.Key < b.Key; });
+			return;
+		}
+		scratch.resize(count);
+
+		uint32_t histograms[PASS_COUNT][RADIX] = {};
+		for (const DrawSortItem& item : items)
+		{
+			for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+			{
+				++histograms[pass][(item.Key >> (pass * RADIX_BITS)) & (RADIX - 1)];
+			}
+		}
+
+		DrawSortItem* src = items.data();
+		DrawSortItem* dst = scratch.data();
+		for (uint32_t pass = 0; pass < PASS_COUNT; ++pass)
+		{
+			const uint32_t shift = pass * RADIX_BITS;
+			uint32_t* histogram = histograms[pass];
+			if (histogram[(src[0].Key >> shift) & (RADIX - 1)] == count)
+				continue;
+
+			uint32_t offset = 0;
+			for (uint32_t digit = 0; digit < RADIX; ++digit)
+			{
+				const uint32_t digitCount = histogram[digit];
+				histogram[digit] = offset;
+				offset += digitCount;
+			}
+			for (size_t i = 0; i < count; ++i)
+			{
+				dst[histogram[(src[i].Key >> shift) & (RADIX - 1)]++] = src[i];
+			}
+			std::swap(src, dst);
+		}
+		if (src != items.data())
+			items.swap(scratch);
+	}
+
+	// binds and draws recorded by one pass in one frame
+	struct DrawStats
+	{
+		uint32_t Draws{ 0 };
+		uint32_t PipelineBinds{ 0 };
+		uint32_t DescriptorSetBinds{ 0 };
+		uint32_t VertexBufferBinds{ 0 };
+		uint32_t IndexBufferBinds{ 0 };
+		uint32_t DynamicStateSets{ 0 };
+		// instanced draws are counted in Draws too
+		uint32_t InstancedDraws{ 0 };
+		uint32_t Instances{ 0 };
+
+		uint32_t GetBinds() const { return PipelineBinds + DescriptorSetBinds + VertexBufferBinds + IndexBufferBinds + DynamicStateSets; }
+
+		DrawStats& operator+=(const DrawStats& rhs)
+		{
+			Draws += rhs.Draws;
+			PipelineBinds += rhs.PipelineBinds;
+			DescriptorSetBinds += rhs.DescriptorSetBinds;
+			VertexBufferBinds += rhs.VertexBufferBinds;
+			IndexBufferBinds += rhs.IndexBufferBinds;
+			DynamicStateSets += rhs.DynamicStateSets;
+			InstancedDraws += rhs.InstancedDraws;
+			Instances += rhs.Instances;
+			return *this;
+		}
+	};
+}
\ No newline at end of file
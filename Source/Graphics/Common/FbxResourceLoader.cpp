@@ -1,3 +1,4 @@
+#include <stdexcept>
 #include "FbxResourceLoader.h"
 #include "Common/Config.h"
 
@@ -6,13 +7,16 @@ namespace zyh
 {
 	namespace FbxResourceLoader
 	{
+#if defined(CUTE_WITH_FBX)
 		static bool isInit = false;
 
 		void InitModule()
 		{
 			if (isInit)
 				return;
+#if defined(_WIN32)
 			HINSTANCE fbxsdk = LoadLibraryW(L"Libraries/FBX/Lib/libfbxsdk.dll");
+#endif
 
 			isInit = true;
 		}
@@ -86,5 +90,11 @@ namespace zyh
 
 			lSdkManager->Destroy();
 		}
+#else
+		void loadModel(const std::string& modelPath, std::vector<Vertex>& outVertexs, std::vector<uint32_t>& outIndices)
+		{
+			throw std::runtime_error("FBX SDK is not available in this build, can't load " + modelPath + "!");
+		}
+#endif
 	}
 }
\ No newline at end of file
@@ -1,7 +1,9 @@
 #pragma once
 #include <string>
 #include <vector>
+#if defined(CUTE_WITH_FBX)
 #include <fbxsdk.h>
+#endif
 
 #include "Common/Config.h"
 #include "Geometry.h"
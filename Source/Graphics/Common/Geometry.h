@@ -39,6 +39,28 @@ struct Vertex {
 	}
 };
 
+// Per instance stream of an instanced draw, bound after the primitive's vertex binding(s)
+struct InstanceData {
+	glm::mat4 model;
+
+	static constexpr uint32_t BINDING = 1;
+	static constexpr uint32_t FIRST_LOCATION = 4;
+
+	// appended to the primitive's descriptions
+	static void GetBindingDescriptions(std::vector<VkVertexInputBindingDescription>& descriptions) {
+		descriptions.push_back(initInputBindingDesc(BINDING, sizeof(InstanceData), VK_VERTEX_INPUT_RATE_INSTANCE));
+	}
+
+	// a mat4 attribute takes four consecutive locations, one column each
+	static void GetAttributeDescriptions(std::vector<VkVertexInputAttributeDescription>& descriptions)
+	{
+		for (uint32_t column = 0; column < 4; ++column)
+		{
+			descriptions.push_back(initInputAttrDesc(BINDING, FIRST_LOCATION + column, VK_FORMAT_R32G32B32A32_SFLOAT, uint32_t(offsetof(InstanceData, model) + column * sizeof(glm::vec4))));
+		}
+	}
+};
+
 // Hash trait For Vertex
 namespace std {
 	template<> struct hash<Vertex> {
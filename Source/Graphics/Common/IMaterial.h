@@ -47,12 +47,36 @@ namespace zyh
 			return GShaderCreator->GetShader(mShaderPathMap_[renderSet][_Type]);
 		}
 
+		const std::string& GetShaderPath(EShaderType _Type, RenderSet renderSet = RenderSet::SCENE) const
+		{
+			static const std::string EMPTY_PATH;
+			auto setIter = mShaderPathMap_.find(renderSet);
+			if (setIter == mShaderPathMap_.end())
+				return EMPTY_PATH;
+			auto pathIter = setIter->second.find(_Type);
+			return pathIter != setIter->second.end() ? pathIter->second : EMPTY_PATH;
+		}
+
 	public:
 		IPipelineState& GetPipelineState() { return mPipelineState_; }
+		const IPipelineState& GetPipelineState() const { return mPipelineState_; }
+
+	public:
+		// samplers without an assigned texture fall back to DEFAULT_TEXTURE
+		static constexpr const char* DEFAULT_TEXTURE = "Resource/textures/viking_room.png";
+		void SetTexture(uint32_t binding, const std::string& textureFile) { mTextures_[binding] = textureFile; }
+		std::string GetTexturePath(uint32_t binding) const
+		{
+			auto iter = mTextures_.find(binding);
+			return iter != mTextures_.end() ? iter->second : DEFAULT_TEXTURE;
+		}
+		const std::map<uint32_t, std::string>& GetTextures() const { return mTextures_; }
+		void SetTextures(const std::map<uint32_t, std::string>& textures) { mTextures_ = textures; }
 
 	protected:
 		TRenderSets mRenderSets_{ SCENE };
 		IPipelineState mPipelineState_{};
+		std::map<uint32_t, std::string> mTextures_{};
 
 	protected:
 		std::unordered_map<RenderSet, std::map<EShaderType, std::string>> mShaderPathMap_{};
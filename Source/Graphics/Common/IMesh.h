@@ -93,20 +93,9 @@ namespace zyh
 			outMatrix = mPrimitivesTransform_[index];
 		}
 
-		void UpdateEntityTransform(Matrix4x3& mat) 
-		{ 
-			EntityTransform_ = mat;
-			for (size_t index =0; index < mPrimitives_.size(); ++index)
-			{
-				IPrimitive* prim = mPrimitives_[index];
-				prim->SetTransform(EntityTransform_); // *PrimitivesTransform_[index]);
-			}
-		}
-
 	public:
 		std::vector<IPrimitive*> mPrimitives_;
 		std::vector<Matrix4x3> mPrimitivesTransform_;
-		Matrix4x3 EntityTransform_;
 		std::string mName_;
 	};
 }
\ No newline at end of file
@@ -4,6 +4,9 @@
 #include "Math/Vector3.h"
 #include "IMaterial.h"
 #include "Math/Matrix4x4.h"
+#include "Math/Box.h"
+#include "Math/Sphere.h"
+#include "Math/SIMD.h"
 #include "Graphics/Common/IRenderElement.h"
 
 
@@ -57,6 +60,10 @@ namespace zyh
 
 		bool IsStatic() { return mIsStatic_; }
 
+		// primitives with the same key have identical vertices / indices and may share GPU buffers and be
+		// drawn instanced, empty for geometry of its own (terrain, edited meshes)
+		const std::string& GetGeometryKey() const { return mGeometryKey_; }
+
 		virtual void LoadResourceFile(const std::string& InFileName) = 0;
 
 		virtual void GetBindingDescriptions(std::vector<VkVertexInputBindingDescription>& descriptions) = 0;
@@ -68,6 +75,11 @@ namespace zyh
 		virtual uint32_t GetVerticeCount() = 0;
 		virtual uint32_t GetIndicesCount() = 0;
 
+		// local space bounding volumes, cached when vertices are loaded
+		const Box& GetBoundingBox() const { return mBoundingBox_; }
+		const Sphere& GetBoundingSphere() const { return mBoundingSphere_; }
+		virtual void UpdateBoundingVolume() = 0;
+
 		virtual void AddRenderElement(RenderSet renderSet, IRenderElement* element)
 		{
 			mRenderElements_[renderSet] = element;
@@ -103,6 +115,9 @@ namespace zyh
 		EPrimitiveType mType_ { EPrimitiveType::MESH };
 		Matrix4x3 mTransform_;
 		bool	mIsStatic_{ true };
+		Box		mBoundingBox_{ Box::GetEmpty() };
+		Sphere	mBoundingSphere_;
+		std::string mGeometryKey_;
 	};
 	
 	template<typename TVertexStruct = Vertex>
@@ -161,6 +176,29 @@ namespace zyh
 			return static_cast<uint32_t>(mIndices_.size());
 		}
 
+		virtual void UpdateBoundingVolume() override
+		{
+			// SIMD::ReduceMinMax reads 4 floats from every pos
+			static_assert(offsetof(TVertexStruct, pos) + 4 * sizeof(float) <= sizeof(TVertexStruct));
+			if (mVertices_.empty())
+			{
+				mBoundingBox_ = Box::GetEmpty();
+				mBoundingSphere_ = Sphere();
+				return;
+			}
+
+			const void* positions = &mVertices_[0].pos;
+			float bmin[3], bmax[3];
+			SIMD::ReduceMinMax(positions, mVertices_.size(), sizeof(TVertexStruct), bmin, bmax);
+			mBoundingBox_ = Box(Vector3(bmin[0], bmin[1], bmin[2]), Vector3(bmax[0], bmax[1], bmax[2]));
+
+			// centered on the box so both volumes can be tested together
+			Vector3 center = mBoundingBox_.GetCenter();
+			const float c[3] = { center.x, center.y, center.z };
+			float radiusSqr = SIMD::ReduceMaxDistanceSquared(positions, mVertices_.size(), sizeof(TVertexStruct), c);
+			mBoundingSphere_ = Sphere(center, Sqrt(radiusSqr));
+		}
+
 		virtual void GetBindingDescriptions(std::vector<VkVertexInputBindingDescription>& descriptions) override
 		{
 			TVertexStruct::GetBindingDescriptions(descriptions);
@@ -185,6 +223,8 @@ namespace zyh
 		virtual void LoadResourceFile(const std::string& InFileName)
 		{
 			ResourceLoader::loadModel(InFileName, mVertices_, mIndices_);
+			UpdateBoundingVolume();
+			mGeometryKey_ = "mesh:" + InFileName;
 		}
 	};
 
@@ -256,6 +296,8 @@ namespace zyh
 					AddIndex(index + 2);
 				}
 			}
+			UpdateBoundingVolume();
+			mGeometryKey_ = "sphere:" + std::to_string(division) + ":" + std::to_string(mRadius_);
 		}
 
 	protected:
@@ -1,24 +1,51 @@
 #pragma once
 #include "Common/Config.h"
 #include "Math/Matrix4x4.h"
+#include "Core/TransformHierarchy.h"
 
 
 namespace zyh
 {
 	class IRenderElement
 	{
+		friend class IRenderScene;
 	public:
+		static constexpr uint32_t INVALID_SCENE_INDEX = MAX_UINT;
+
 		IRenderElement()
 		{
-			mTransform_.SetIdentity();
 		}
 
-		void UpdateTransform(Matrix4x3& transform)
+		bool IsInRenderScene() const { return mSceneIndex_ != INVALID_SCENE_INDEX; }
+
+		// the world matrix is read from the hierarchy when ClientScene builds the render snapshot
+		void BindTransform(const TransformHierarchy* transforms, TransformHierarchy::Handle handle)
+		{
+			mTransforms_ = transforms;
+			mTransformHandle_ = handle;
+		}
+
+		const Matrix4x3& GetWorldTransform() const
 		{
-			mTransform_ = transform;
+			static const Matrix4x3 identity;
+			if (!mTransforms_ || mTransformHandle_ == TransformHierarchy::INVALID_HANDLE)
+				return identity;
+			return mTransforms_->GetWorld(mTransformHandle_);
+		}
+
+		Matrix4x3 GetWorldTransform(float alpha) const
+		{
+			if (!mTransforms_ || mTransformHandle_ == TransformHierarchy::INVALID_HANDLE)
+				return Matrix4x3();
+			return mTransforms_->GetInterpolatedWorld(mTransformHandle_, alpha);
 		}
 
 	protected:
-		Matrix4x3 mTransform_;
+		const TransformHierarchy* mTransforms_{ nullptr };
+		TransformHierarchy::Handle mTransformHandle_{ TransformHierarchy::INVALID_HANDLE };
+
+	private:
+		// slot in its IRenderScene set, lets the scene remove it in O(1)
+		uint32_t mSceneIndex_{ INVALID_SCENE_INDEX };
 	};
 }
@@ -7,7 +7,7 @@
 #include "Graphics/Vulkan/VulkanSurface.h"
 #include "Graphics/Vulkan/VulkanPhysicalDevice.h"
 #include "Graphics/Vulkan/VulkanLogicalDevice.h"
-#include "Graphics/Vulkan/VulkanSwapchain.h"
+#include "Graphics/Vulkan/VulkanSwapChain.h"
 #include "Graphics/Vulkan/VulkanCommandPool.h"
 #include "Graphics/Vulkan/VulkanImage.h"
 #include "Graphics/Vulkan/VulkanRenderPass.h"
@@ -17,6 +17,7 @@
 
 #include "Core/IPrimitivesComponent.h"
 #include "Graphics/Common/RenderResource.h"
+#include "Graphics/Common/RenderGraph.h"
 
 #include "Graphics/Imgui/imgui.h"
 #include "Graphics/Imgui/imgui_impl_vulkan.h"
@@ -40,6 +41,10 @@ namespace zyh
 		bool IsDepthStencil;
 		bool IsSwapChain{ false };
 		bool IsResolve{ false };
+		// set by RenderGraph when a later pass reads the target in a shader
+		bool IsSampled{ false };
+		// set by RenderGraph when the target only lives inside one pass
+		bool IsTransient{ false };
 	};
 
 	class RenderTargetResource : IRenderTarget
@@ -115,6 +120,8 @@ namespace zyh
 		}
 
 		virtual RenderTargetResource* CreateRenderTarget_Imp(RenderTargetWrapper targetDesc) = 0;
+		// after the targets of the compiled graph are created: gives them memory, may add barriers to graph
+		virtual void CommitRenderTargets(RenderGraph& graph) {}
 		std::vector<RenderTargetResource*> RenderTargets;
 	};
 	extern RenderDevice* GRenderDevice;
@@ -213,6 +220,10 @@ namespace zyh
 		uint32_t GetWidth() { return mWidth_; }
 		uint32_t GetHeight() { return mHeight_; }
 
+		const std::vector<uint32_t>& GetReadTargets() const { return ReadTargets; }
+		const std::vector<uint32_t>& GetWriteTargets() const { return WriteTargets; }
+		uint32_t GetDepthStencil() const { return DepthStencil; }
+
 	protected:
 		std::vector<uint32_t> ReadTargets;
 		std::vector<uint32_t> WriteTargets;
@@ -235,10 +246,16 @@ namespace zyh
 		{
 		}
 
+		const std::string& GetName() const { return mName_; }
+
 		const TRenderSets& GetRenderSets()
 		{
 			return mRenderSets_;
 		}
+
+		// load / store ops, layouts and barriers worked out by RenderGraph::Compile
+		void SetCompiled(const RenderGraphPass* compiled) { mCompiled_ = compiled; }
+		const RenderGraphPass* GetCompiled() const { return mCompiled_; }
 	
 		virtual std::vector<RenderTarget> GetWriteTargetsDesc() 
 		{ 
@@ -252,7 +269,12 @@ namespace zyh
 
 				RenderTarget& targetDesc = wrapper.RenderTargetDesc;
 				
-				if (std::find(CreateTargets.begin(), CreateTargets.end(), idx) != CreateTargets.end())
+				if (const RenderGraphAttachment* attachment = mCompiled_ ? mCompiled_->FindAttachment(idx) : nullptr)
+				{
+					targetDesc.LoadOp = attachment->LoadOp;
+					targetDesc.StoreOp = attachment->StoreOp;
+				}
+				else if (std::find(CreateTargets.begin(), CreateTargets.end(), idx) != CreateTargets.end())
 				{
 					targetDesc.LoadOp = RenderTarget::ELoadOp::DONT_CARE;
 					targetDesc.StoreOp = RenderTarget::EStoreOp::STORE;
@@ -292,7 +314,12 @@ namespace zyh
 			}
 
 			RenderTarget targetDesc = GRenderDevice->GetRenderTargetResource(DepthStencil).Desc.RenderTargetDesc;
-			if (std::find(CreateTargets.begin(), CreateTargets.end(), DepthStencil) != CreateTargets.end())
+			if (const RenderGraphAttachment* attachment = mCompiled_ ? mCompiled_->FindAttachment(DepthStencil) : nullptr)
+			{
+				targetDesc.LoadOp = attachment->LoadOp;
+				targetDesc.StoreOp = attachment->StoreOp;
+			}
+			else if (std::find(CreateTargets.begin(), CreateTargets.end(), DepthStencil) != CreateTargets.end())
 			{
 				targetDesc.LoadOp = RenderTarget::ELoadOp::DONT_CARE;
 				targetDesc.StoreOp = RenderTarget::EStoreOp::STORE;
@@ -310,6 +337,7 @@ namespace zyh
 	protected:
 		std::string mName_;
 		TRenderSets mRenderSets_;
+		const RenderGraphPass* mCompiled_{ nullptr };
 		
 	private:
 		VkFramebuffer mVKFramebuffer_;
@@ -1,11 +1,14 @@
 #pragma once
 #include "Common/Config.h"
+#include "Graphics/Common/IRenderElement.h"
 
 
 namespace zyh
 {
-	class IRenderElement;
-
+	// per set element lists indexed by RenderSet, Clear() keeps the capacity so a frame's
+	// collect / lookup does not allocate once the lists have grown.
+	// elements know their slot, so the visible set is maintained by Add / Remove of what changed,
+	// the generation of a set bumps on every change so consumers can skip rebuilding what depends on it
 	class IRenderScene
 	{
 	public: 
@@ -14,56 +17,72 @@ namespace zyh
 	public:
 		void Clear(RenderSet renderSet)
 		{
-			mRenderElements_[renderSet].clear();
-			mIsDirtys_.clear();
+			std::vector<IRenderElement*>& elements = _GetElements(renderSet);
+			if (elements.empty())
+				return;
+			for (IRenderElement* element : elements)
+			{
+				element->mSceneIndex_ = IRenderElement::INVALID_SCENE_INDEX;
+			}
+			elements.clear();
+			_MarkChanged(renderSet);
 		}
 
 		bool AddRenderElement(RenderSet renderSet, IRenderElement* element) 
 		{ 
-			if (mRenderElements_.find(renderSet) == mRenderElements_.end())
-			{
-				mRenderElements_[renderSet] = std::vector<IRenderElement*>();
-			}
-			mRenderElements_[renderSet].push_back(element);
-			mIsDirtys_[renderSet] = true;
+			if (element->IsInRenderScene())
+				return false;
+			std::vector<IRenderElement*>& elements = _GetElements(renderSet);
+			element->mSceneIndex_ = uint32_t(elements.size());
+			elements.push_back(element);
+			_MarkChanged(renderSet);
 			return true;
 		}
 
-		void GetRenderElements(RenderSet renderSet, std::vector<IRenderElement*>& elements)
+		// swaps the last element into the hole, so the order of a set is not stable
+		bool RemoveRenderElement(RenderSet renderSet, IRenderElement* element)
 		{
-			elements.clear();
-			if (mRenderElements_.find(renderSet) != mRenderElements_.end())
-			{
-				elements = mRenderElements_[renderSet];
-			}
+			if (!element->IsInRenderScene())
+				return false;
+			std::vector<IRenderElement*>& elements = _GetElements(renderSet);
+			const uint32_t index = element->mSceneIndex_;
+			HYBRID_CHECK(index < elements.size() && elements[index] == element, "element is in another render set");
+			IRenderElement* last = elements.back();
+			elements[index] = last;
+			last->mSceneIndex_ = index;
+			elements.pop_back();
+			element->mSceneIndex_ = IRenderElement::INVALID_SCENE_INDEX;
+			_MarkChanged(renderSet);
+			return true;
 		}
 
-		TRenderSets GetExistRenderSets()
+		// view into the scene's list, valid until the set is next changed
+		std::span<IRenderElement* const> GetRenderElements(RenderSet renderSet) const
 		{
-			TRenderSets RenderSets;
-			for (auto& pair : mRenderElements_)
-			{
-				RenderSets.push_back(pair.first);
-			}
-			return RenderSets;
+			HYBRID_CHECK(renderSet < RENDER_SET_COUNT);
+			return mRenderElements_[renderSet];
 		}
 
-		bool IsRenderElementDirty(RenderSet renderSet)
+		uint64_t GetGeneration(RenderSet renderSet) const
 		{
-			HYBRID_CHECK(mRenderElements_.find(renderSet) != mRenderElements_.end());
-			
-			return mIsDirtys_[renderSet];
+			HYBRID_CHECK(renderSet < RENDER_SET_COUNT);
+			return mGenerations_[renderSet];
 		}
 
-		void SetRenderElementDirty(RenderSet renderSet, bool IsDirty)
+	private:
+		void _MarkChanged(RenderSet renderSet)
 		{
-			HYBRID_CHECK(mRenderElements_.find(renderSet) != mRenderElements_.end());
+			++mGenerations_[renderSet];
+		}
 
-			mIsDirtys_[renderSet] = IsDirty;
+		std::vector<IRenderElement*>& _GetElements(RenderSet renderSet)
+		{
+			HYBRID_CHECK(renderSet < RENDER_SET_COUNT);
+			return mRenderElements_[renderSet];
 		}
 
 	private:
-		std::map<RenderSet, std::vector<IRenderElement*>> mRenderElements_;
-		std::map<RenderSet, bool> mIsDirtys_;
+		std::array<std::vector<IRenderElement*>, RENDER_SET_COUNT> mRenderElements_;
+		std::array<uint64_t, RENDER_SET_COUNT> mGenerations_{};
 	};
 }
\ No newline at end of file
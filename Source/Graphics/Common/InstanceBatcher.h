@@ -0,0 +1,136 @@
+#pragma once
+#include "Common/Config.h"
+#include "Math/GlmConvert.h"
+#include <unordered_map>
+
+
+namespace zyh
+{
+	// the entries of one instanced draw and their world matrices packed for the instance stream,
+	// TEntry has Item->WorldTransform and SetOrder, TInstance a glm::mat4 model
+	template<typename TEntry, typename TInstance>
+	class InstanceBatch
+	{
+	public:
+		void Reset() { mEntries_.clear(); }
+		void AddInstance(const TEntry& entry) { mEntries_.push_back(entry); }
+		const std::vector<TEntry>& GetEntries() const { return mEntries_; }
+		const std::vector<TInstance>& GetInstances() const { return mInstances_; }
+		uint32_t GetSetOrder() const { return mEntries_.empty() ? 0 : mEntries_.front().SetOrder; }
+		// frames in a row the batch was left without entries
+		uint32_t UpdateIdleFrames() { mIdleFrames_ = mEntries_.empty() ? mIdleFrames_ + 1 : 0; return mIdleFrames_; }
+
+		void PackInstances()
+		{
+			mInstances_.resize(mEntries_.size());
+			for (size_t i = 0; i < mEntries_.size(); ++i)
+			{
+				mInstances_[i].model = ToGlm(mEntries_[i].Item->WorldTransform);
+			}
+		}
+
+	protected:
+		std::vector<TEntry> mEntries_;
+		std::vector<TInstance> mInstances_;
+		uint32_t mIdleFrames_{ 0 };
+	};
+
+	// Groups the entries of a pass into batches of a shared mesh, TBatch derives from InstanceBatch and provides
+	// IsCompatible(key...). Batches are created by the caller's factory and handed back to its release callback,
+	// kept apart from the device so the grouping can run without one.
+	template<typename TMesh, typename TBatch>
+	class InstanceBatcher
+	{
+	public:
+		void Begin()
+		{
+			for (TBatch* batch : mActiveBatches_)
+				batch->Reset();
+			mActiveBatches_.clear();
+		}
+
+		template<typename TCreate, typename... TKey>
+		TBatch* GetBatch(TMesh mesh, TCreate&& create, const TKey&... key)
+		{
+			std::vector<TBatch*>& batches = mBatches_[mesh];
+			for (TBatch* batch : batches)
+			{
+				if (batch->IsCompatible(key...))
+					return batch;
+			}
+			batches.push_back(create());
+			return batches.back();
+		}
+
+		template<typename TEntry>
+		void Add(TBatch* batch, const TEntry& entry)
+		{
+			if (batch->GetEntries().empty())
+				mActiveBatches_.push_back(batch);
+			batch->AddInstance(entry);
+		}
+
+		// emit(batch) for each batch of at least minCount entries, the members of smaller ones go back to entries
+		template<typename TEntry, typename TEmit>
+		void End(size_t minCount, std::vector<TEntry>& entries, TEmit&& emit)
+		{
+			for (TBatch* batch : mActiveBatches_)
+			{
+				if (batch->GetEntries().size() < minCount)
+				{
+					entries.insert(entries.end(), batch->GetEntries().begin(), batch->GetEntries().end());
+					continue;
+				}
+				emit(batch);
+			}
+		}
+
+		// hands batches that stayed empty for more than idleFrames to release
+		template<typename TRelease>
+		void ReleaseIdle(uint32_t idleFrames, TRelease&& release)
+		{
+			for (auto iter = mBatches_.begin(); iter != mBatches_.end();)
+			{
+				std::vector<TBatch*>& batches = iter->second;
+				for (size_t i = 0; i < batches.size();)
+				{
+					TBatch* batch = batches[i];
+					if (batch->UpdateIdleFrames() <= idleFrames)
+					{
+						++i;
+						continue;
+					}
+					release(batch);
+					batches[i] = batches.back();
+					batches.pop_back();
+				}
+				iter = batches.empty() ? mBatches_.erase(iter) : std::next(iter);
+			}
+		}
+
+		template<typename TRelease>
+		void ReleaseAll(TRelease&& release)
+		{
+			for (auto& pair : mBatches_)
+			{
+				for (TBatch* batch : pair.second)
+					release(batch);
+			}
+			mBatches_.clear();
+			mActiveBatches_.clear();
+		}
+
+		size_t GetBatchCount() const
+		{
+			size_t count = 0;
+			for (auto& pair : mBatches_)
+				count += pair.second.size();
+			return count;
+		}
+
+	private:
+		std::unordered_map<TMesh, std::vector<TBatch*>> mBatches_;
+		// batches added to since Begin()
+		std::vector<TBatch*> mActiveBatches_;
+	};
+}
\ No newline at end of file
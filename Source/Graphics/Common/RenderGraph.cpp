@@ -0,0 +1,263 @@
+#include "RenderGraph.h"
+#include "IRenderPass.h"
+
+
+namespace zyh
+{
+	void RenderGraph::Compile(const std::vector<IRenderPass*>& passes, RenderDevice& device)
+	{
+		mPasses_.clear();
+		mCulledPasses_.clear();
+		mLifetimes_.assign(device.RenderTargets.size(), RenderGraphLifetime{});
+		mBarrierCount_ = 0;
+
+		std::vector<std::vector<TargetUse>> uses(passes.size());
+		for (size_t i = 0; i < passes.size(); ++i)
+			_CollectUses(passes[i], device, uses[i]);
+
+		std::vector<uint32_t> order;
+		_SortPasses(uses, device.RenderTargets.size(), order);
+		_CullPasses(passes, uses, device, order);
+
+		mPasses_.resize(order.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			mPasses_[i].Pass = passes[order[i]];
+		_DeriveAccess(uses, order, device);
+
+		for (uint32_t target = 0; target < mLifetimes_.size(); ++target)
+		{
+			RenderTargetWrapper& desc = device.GetRenderTargetResource(target).Desc;
+			desc.IsSampled = mLifetimes_[target].IsSampled;
+			desc.IsTransient = mLifetimes_[target] && mLifetimes_[target].IsTransient() && !desc.IsSwapChain;
+		}
+	}
+
+	void RenderGraph::AddAliasBarrier(uint32_t from, uint32_t to)
+	{
+		const RenderGraphLifetime& fromLifetime = mLifetimes_[from];
+		const RenderGraphLifetime& toLifetime = mLifetimes_[to];
+		HYBRID_CHECK(fromLifetime && toLifetime && fromLifetime.LastPass < toLifetime.FirstPass);
+
+		mPasses_[toLifetime.FirstPass].Incoming.Add(fromLifetime.LastUsage, toLifetime.FirstUsage);
+		mPasses_[fromLifetime.FirstPass].Incoming.Add(toLifetime.LastUsage, fromLifetime.FirstUsage);
+		mBarrierCount_ += 2;
+	}
+
+	void RenderGraph::_CollectUses(IRenderPass* pass, RenderDevice& device, std::vector<TargetUse>& outUses)
+	{
+		for (uint32_t target : pass->GetWriteTargets())
+		{
+			const bool isSwapChain = device.GetRenderTargetResource(target).Desc.IsSwapChain;
+			outUses.push_back({ target, isSwapChain ? ERenderTargetUsage::RESOLVE : ERenderTargetUsage::COLOR_ATTACHMENT });
+		}
+		// 0 means no depth stencil, see IRenderNode
+		if (pass->GetDepthStencil())
+			outUses.push_back({ pass->GetDepthStencil(), ERenderTargetUsage::DEPTH_STENCIL_ATTACHMENT });
+		for (uint32_t target : pass->GetReadTargets())
+		{
+			HYBRID_CHECK(std::find(pass->GetWriteTargets().begin(), pass->GetWriteTargets().end(), target) == pass->GetWriteTargets().end(), "a pass can not sample a target it writes");
+			outUses.push_back({ target, ERenderTargetUsage::SHADER_READ });
+		}
+	}
+
+	void RenderGraph::_SortPasses(const std::vector<std::vector<TargetUse>>& uses, size_t targetCount, std::vector<uint32_t>& outOrder) const
+	{
+		const uint32_t passCount = static_cast<uint32_t>(uses.size());
+		std::vector<std::vector<uint32_t>> successors(passCount);
+		std::vector<uint32_t> inDegree(passCount, 0);
+		auto addEdge = [&](uint32_t from, uint32_t to)
+		{
+			if (from == to)
+				return;
+			successors[from].push_back(to);
+			++inDegree[to];
+		};
+
+		// writers of a target follow each other in declaration order
+		std::vector<std::vector<uint32_t>> writers(targetCount);
+		for (uint32_t pass = 0; pass < passCount; ++pass)
+		{
+			for (const TargetUse& use : uses[pass])
+			{
+				if (!_IsWrite(use.Usage))
+					continue;
+				std::vector<uint32_t>& targetWriters = writers[use.Target];
+				if (!targetWriters.empty())
+					addEdge(targetWriters.back(), pass);
+				targetWriters.push_back(pass);
+			}
+		}
+		// and readers see what all of them wrote
+		for (uint32_t pass = 0; pass < passCount; ++pass)
+		{
+			for (const TargetUse& use : uses[pass])
+			{
+				if (_IsWrite(use.Usage))
+					continue;
+				for (uint32_t writer : writers[use.Target])
+					addEdge(writer, pass);
+			}
+		}
+
+		// Kahn, ties go to the earlier declared pass so independent passes keep their order
+		outOrder.clear();
+		std::vector<bool> isEmitted(passCount, false);
+		while (outOrder.size() < passCount)
+		{
+			uint32_t ready = MAX_UINT;
+			for (uint32_t pass = 0; pass < passCount; ++pass)
+			{
+				if (!isEmitted[pass] && inDegree[pass] == 0)
+				{
+					ready = pass;
+					break;
+				}
+			}
+			if (ready == MAX_UINT)
+			{
+				HYBRID_CHECK(false, "render graph has a cycle");
+				for (uint32_t pass = 0; pass < passCount; ++pass)
+				{
+					if (!isEmitted[pass])
+						outOrder.push_back(pass);
+				}
+				break;
+			}
+			isEmitted[ready] = true;
+			outOrder.push_back(ready);
+			for (uint32_t successor : successors[ready])
+				--inDegree[successor];
+		}
+	}
+
+	void RenderGraph::_CullPasses(const std::vector<IRenderPass*>& passes, const std::vector<std::vector<TargetUse>>& uses, RenderDevice& device, std::vector<uint32_t>& inOutOrder)
+	{
+		// walk back from the passes writing the swapchain, a pass lives if a live pass after it needs what it writes
+		std::vector<bool> isNeeded(device.RenderTargets.size(), false);
+		std::vector<bool> isLive(passes.size(), false);
+		for (auto it = inOutOrder.rbegin(); it != inOutOrder.rend(); ++it)
+		{
+			const uint32_t pass = *it;
+			for (const TargetUse& use : uses[pass])
+			{
+				if (_IsWrite(use.Usage) && (isNeeded[use.Target] || device.GetRenderTargetResource(use.Target).Desc.IsSwapChain))
+					isLive[pass] = true;
+			}
+			if (!isLive[pass])
+				continue;
+			// written targets are loaded, so their earlier writers are needed too
+			for (const TargetUse& use : uses[pass])
+				isNeeded[use.Target] = true;
+		}
+
+		size_t liveCount = 0;
+		for (uint32_t pass : inOutOrder)
+		{
+			if (isLive[pass])
+				inOutOrder[liveCount++] = pass;
+			else
+				mCulledPasses_.push_back(passes[pass]);
+		}
+		inOutOrder.resize(liveCount);
+	}
+
+	void RenderGraph::_DeriveAccess(const std::vector<std::vector<TargetUse>>& uses, const std::vector<uint32_t>& order, RenderDevice& device)
+	{
+		struct OrderedUse
+		{
+			uint32_t Pass;
+			ERenderTargetUsage Usage;
+			RenderGraphAttachment* Attachment;
+		};
+		std::vector<std::vector<OrderedUse>> targetUses(mLifetimes_.size());
+		for (uint32_t i = 0; i < order.size(); ++i)
+		{
+			RenderGraphPass& pass = mPasses_[i];
+			for (const TargetUse& use : uses[order[i]])
+			{
+				if (use.Usage != ERenderTargetUsage::SHADER_READ)
+					pass.Attachments.push_back(RenderGraphAttachment{ use.Target, use.Usage });
+
+				RenderGraphLifetime& lifetime = mLifetimes_[use.Target];
+				if (!lifetime)
+				{
+					lifetime.FirstPass = i;
+					lifetime.FirstUsage = use.Usage;
+				}
+				lifetime.LastPass = i;
+				lifetime.LastUsage = use.Usage;
+				lifetime.IsSampled |= use.Usage == ERenderTargetUsage::SHADER_READ;
+			}
+			// attachments no longer grow, pointers into them stay valid
+			for (RenderGraphAttachment& attachment : pass.Attachments)
+				targetUses[attachment.Target].push_back({ i, attachment.Usage, &attachment });
+			for (const TargetUse& use : uses[order[i]])
+			{
+				if (use.Usage == ERenderTargetUsage::SHADER_READ)
+					targetUses[use.Target].push_back({ i, use.Usage, nullptr });
+			}
+		}
+
+		for (uint32_t target = 0; target < targetUses.size(); ++target)
+		{
+			std::vector<OrderedUse>& sequence = targetUses[target];
+			if (sequence.empty())
+				continue;
+			std::sort(sequence.begin(), sequence.end(), [](const OrderedUse& lhs, const OrderedUse& rhs) { return lhs.Pass < rhs.Pass; });
+
+			// the first use of a frame follows the last one of the frame before
+			const bool isSwapChain = device.GetRenderTargetResource(target).Desc.IsSwapChain;
+			ERenderTargetUsage prevUsage = isSwapChain ? ERenderTargetUsage::PRESENT : sequence.back().Usage;
+			bool isPrevAttachment = false;
+			ERenderTargetUsage layout = ERenderTargetUsage::NONE;
+			for (size_t j = 0; j < sequence.size(); ++j)
+			{
+				const OrderedUse& use = sequence[j];
+				RenderGraphPass& pass = mPasses_[use.Pass];
+				const bool needsBarrier = _IsWrite(prevUsage) || _IsWrite(use.Usage);
+
+				if (!use.Attachment)
+				{
+					// the writer before moved it to the read layout on its way out
+					if (needsBarrier && !isPrevAttachment)
+					{
+						pass.Incoming.Add(prevUsage, use.Usage);
+						++mBarrierCount_;
+					}
+					prevUsage = use.Usage;
+					isPrevAttachment = false;
+					continue;
+				}
+
+				if (needsBarrier)
+				{
+					pass.Incoming.Add(prevUsage, use.Usage);
+					++mBarrierCount_;
+				}
+
+				const OrderedUse* nextUse = j + 1 < sequence.size() ? &sequence[j + 1] : nullptr;
+				RenderGraphAttachment& attachment = *use.Attachment;
+				// resolves overwrite every pixel, the first writer clears, later ones keep what is there
+				if (use.Usage == ERenderTargetUsage::RESOLVE)
+					attachment.LoadOp = RenderTarget::ELoadOp::DONT_CARE;
+				else
+					attachment.LoadOp = j == 0 ? RenderTarget::ELoadOp::CLEAR : RenderTarget::ELoadOp::LOAD;
+				attachment.StoreOp = nextUse || isSwapChain ? RenderTarget::EStoreOp::STORE : RenderTarget::EStoreOp::DONT_CARE;
+				attachment.InitialUsage = attachment.LoadOp == RenderTarget::ELoadOp::LOAD ? layout : ERenderTargetUsage::NONE;
+				if (nextUse)
+					attachment.FinalUsage = nextUse->Usage;
+				else
+					attachment.FinalUsage = isSwapChain ? ERenderTargetUsage::PRESENT : use.Usage;
+
+				if (attachment.FinalUsage == ERenderTargetUsage::SHADER_READ)
+				{
+					pass.Outgoing.Add(use.Usage, ERenderTargetUsage::SHADER_READ);
+					++mBarrierCount_;
+				}
+				layout = attachment.FinalUsage;
+				prevUsage = use.Usage;
+				isPrevAttachment = true;
+			}
+		}
+	}
+}
\ No newline at end of file
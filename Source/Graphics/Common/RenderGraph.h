@@ -0,0 +1,109 @@
+#pragma once
+#include "Common/Config.h"
+#include "Math/MathUtil.h"
+#include "Graphics/Common/RenderResource.h"
+
+
+namespace zyh
+{
+	class IRenderPass;
+	class RenderDevice;
+
+	// one render target as an attachment of a compiled pass
+	struct RenderGraphAttachment
+	{
+		uint32_t Target{ 0 };
+		ERenderTargetUsage Usage{ ERenderTargetUsage::NONE };
+		RenderTarget::ELoadOp LoadOp{ RenderTarget::ELoadOp::DONT_CARE };
+		RenderTarget::EStoreOp StoreOp{ RenderTarget::EStoreOp::DONT_CARE };
+		// layouts on entry and on exit, NONE on entry when the content is not loaded
+		ERenderTargetUsage InitialUsage{ ERenderTargetUsage::NONE };
+		ERenderTargetUsage FinalUsage{ ERenderTargetUsage::NONE };
+	};
+
+	// dependency between the usages before and after it, one bit per ERenderTargetUsage
+	struct RenderGraphBarrier
+	{
+		uint32_t SrcUsages{ 0 };
+		uint32_t DstUsages{ 0 };
+
+		void Add(ERenderTargetUsage src, ERenderTargetUsage dst)
+		{
+			SrcUsages |= 1u << uint32_t(src);
+			DstUsages |= 1u << uint32_t(dst);
+		}
+		explicit operator bool() const { return DstUsages != 0; }
+	};
+
+	struct RenderGraphPass
+	{
+		IRenderPass* Pass{ nullptr };
+		// write targets then the depth stencil, reads are sampled and not attachments
+		std::vector<RenderGraphAttachment> Attachments;
+		// before the pass, and after it for layout changes the pass makes on its way out
+		RenderGraphBarrier Incoming;
+		RenderGraphBarrier Outgoing;
+
+		const RenderGraphAttachment* FindAttachment(uint32_t target) const
+		{
+			for (const RenderGraphAttachment& attachment : Attachments)
+			{
+				if (attachment.Target == target)
+					return &attachment;
+			}
+			return nullptr;
+		}
+	};
+
+	// compiled pass indices of the first and last use of a target, FirstPass is MAX_UINT if unused
+	struct RenderGraphLifetime
+	{
+		uint32_t FirstPass{ MAX_UINT };
+		uint32_t LastPass{ 0 };
+		ERenderTargetUsage FirstUsage{ ERenderTargetUsage::NONE };
+		ERenderTargetUsage LastUsage{ ERenderTargetUsage::NONE };
+		bool IsSampled{ false };
+		// lives inside a single pass, its content is never loaded nor stored
+		bool IsTransient() const { return FirstPass == LastPass && !IsSampled; }
+
+		explicit operator bool() const { return FirstPass != MAX_UINT; }
+	};
+
+	// Orders the passes by the targets they declare, drops the ones nothing consumes and derives
+	// load / store ops, layouts and barriers from how every target is used from pass to pass.
+	// Writers of a target keep their declaration order, readers run after all of its writers.
+	// Passes writing the swapchain are the outputs, everything they do not depend on is culled.
+	class RenderGraph
+	{
+	public:
+		void Compile(const std::vector<IRenderPass*>& passes, RenderDevice& device);
+
+		// live passes in execution order
+		const std::vector<RenderGraphPass>& GetPasses() const { return mPasses_; }
+		const std::vector<IRenderPass*>& GetCulledPasses() const { return mCulledPasses_; }
+		const RenderGraphLifetime& GetLifetime(uint32_t target) const { return mLifetimes_[target]; }
+		uint32_t GetBarrierCount() const { return mBarrierCount_; }
+
+		// from and to share memory and from is used first: to waits for from inside the frame,
+		// and from waits for to of the frame before
+		void AddAliasBarrier(uint32_t from, uint32_t to);
+
+	protected:
+		struct TargetUse
+		{
+			uint32_t Target;
+			ERenderTargetUsage Usage;
+		};
+		static void _CollectUses(IRenderPass* pass, RenderDevice& device, std::vector<TargetUse>& outUses);
+		static bool _IsWrite(ERenderTargetUsage usage) { return usage != ERenderTargetUsage::SHADER_READ && usage != ERenderTargetUsage::NONE; }
+		void _SortPasses(const std::vector<std::vector<TargetUse>>& uses, size_t targetCount, std::vector<uint32_t>& outOrder) const;
+		void _CullPasses(const std::vector<IRenderPass*>& passes, const std::vector<std::vector<TargetUse>>& uses, RenderDevice& device, std::vector<uint32_t>& inOutOrder);
+		void _DeriveAccess(const std::vector<std::vector<TargetUse>>& uses, const std::vector<uint32_t>& order, RenderDevice& device);
+
+	protected:
+		std::vector<RenderGraphPass> mPasses_;
+		std::vector<IRenderPass*> mCulledPasses_;
+		std::vector<RenderGraphLifetime> mLifetimes_;
+		uint32_t mBarrierCount_{ 0 };
+	};
+}
\ No newline at end of file
@@ -91,4 +91,16 @@ namespace zyh
 		ELoadOp LoadOp{ ELoadOp::DONT_CARE };
 		EStoreOp StoreOp{ EStoreOp::DONT_CARE };
 	};
+
+	// how a pass uses a render target, decides the layout it is in and what has to be synchronized
+	enum class ERenderTargetUsage : uint8_t
+	{
+		NONE = 0,
+		COLOR_ATTACHMENT,
+		DEPTH_STENCIL_ATTACHMENT,
+		RESOLVE,
+		SHADER_READ,
+		// swapchain image owned by presentation, or headless readback
+		PRESENT,
+	};
 }
\ No newline at end of file
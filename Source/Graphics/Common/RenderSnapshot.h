@@ -0,0 +1,69 @@
+#pragma once
+#include "Common/Config.h"
+#include "Math/Matrix4x3.h"
+#include "Math/Matrix4x4.h"
+#include "Graphics/Light/LightBase.h"
+
+
+namespace zyh
+{
+	class IRenderElement;
+
+	struct RenderItem
+	{
+		IRenderElement* Element;
+		Matrix4x3 WorldTransform;
+	};
+
+	// terrain editing settings of HeightMapManipulator shown by the UI pass, edits go back through ClientScene::GetCommands()
+	struct TerrainEditSettings
+	{
+		bool Enable{ false };
+		float Offset{ 0.f };
+		float Range{ 1.f };
+
+		bool operator==(const TerrainEditSettings&) const = default;
+	};
+
+	// Everything the render thread needs for one frame, copied out of the game state by ClientScene.
+	// Written by the game thread before submit, read only by the render thread afterwards.
+	struct RenderSnapshot
+	{
+		uint64_t Frame{ 0 };
+		float DeltaTime{ 0.f };
+
+		Matrix4x3 ViewMatrix;
+		Matrix4x4 ProjMatrix;
+		float Fov{ 0.f };
+
+		DirectionLight DirectionalLight;
+		std::vector<PointLight> PointLights;
+		SpotLight Spot;
+		TerrainEditSettings TerrainEdit;
+
+		std::array<std::vector<RenderItem>, RENDER_SET_COUNT> Items;
+		// IRenderScene::GetGeneration of every set when Items was copied
+		std::array<uint64_t, RENDER_SET_COUNT> Generations{};
+		// bumped whenever an item's WorldTransform may differ from the previous snapshot
+		uint64_t TransformGeneration{ 0 };
+		// run on the render thread in recording order before the frame is drawn (GPU uploads, deferred releases)
+		std::vector<std::function<void()>> Commands;
+
+		std::span<const RenderItem> GetItems(RenderSet renderSet) const
+		{
+			HYBRID_CHECK(renderSet < RENDER_SET_COUNT);
+			return Items[renderSet];
+		}
+
+		// keeps the capacity of the item arrays
+		void Reset()
+		{
+			for (std::vector<RenderItem>& items : Items)
+			{
+				items.clear();
+			}
+			PointLights.clear();
+			Commands.clear();
+		}
+	};
+}
\ No newline at end of file
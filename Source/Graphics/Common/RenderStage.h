@@ -20,6 +20,8 @@ namespace zyh
 		};
 
 		ERasterizationCullMode CullMode{ ERasterizationCullMode::BACK };
+
+		bool operator==(const RasterizationState&) const = default;
 	};
 	using ERasterizationCullMode = RasterizationState::ERasterizationCullMode;
 	static RasterizationState DefaultRasterizationState{};
@@ -58,6 +60,8 @@ namespace zyh
 			EStencilOp DepthFailOp{ EStencilOp::KEEP }; // Depth Fail but Stencil Pass
 			ECompareOP CompareOp{ ECompareOP::EQUAL };
 			uint32_t Reference{ 1 };
+
+			bool operator==(const StencialState&) const = default;
 		};
 
 		bool DepthTestEnable{ true };
@@ -65,6 +69,8 @@ namespace zyh
 		bool StencilTestEnable{ false };
 		ECompareOP DepthCompareOp{ ECompareOP::LESS_OR_EQUAL };
 		StencialState StencilState{};
+
+		bool operator==(const DepthStencilState&) const = default;
 	};
 	static DepthStencilState DefaultDepthStencilState{};
 
@@ -106,6 +112,8 @@ namespace zyh
 		EBlendFactor SrcAlphaBlendFactor{ EBlendFactor::ONE_MINUS_SRC_ALPHA };
 		EBlendFactor DstAlphaBlendFactor{ EBlendFactor::ZERO };
 		EBlendOP AlphaBlendOp{ EBlendOP::ADD };
+
+		bool operator==(const ColorBlendState&) const = default;
 	};
 	static ColorBlendState DefaultColorBlendState{};
 
@@ -116,6 +124,8 @@ namespace zyh
 		RasterizationState Rasterization{ DefaultRasterizationState };
 		DepthStencilState DepthStencil{ DefaultDepthStencilState };
 		ColorBlendState ColorBlend{ DefaultColorBlendState };
+
+		bool operator==(const IPipelineState&) const = default;
 	};
 
 	static IPipelineState DefaultPipelineState{};
@@ -0,0 +1,87 @@
+#pragma once
+#include "Common/Config.h"
+#include <algorithm>
+#include <vector>
+
+
+namespace zyh
+{
+	// a render target asking for memory, alive from FirstPass to LastPass of the compiled graph
+	struct AliasRequest
+	{
+		uint64_t Size{ 0 };
+		uint64_t Alignment{ 1 };
+		uint32_t FirstPass{ 0 };
+		uint32_t LastPass{ 0 };
+		// only requests of the same heap (memory type) may share memory
+		uint32_t Heap{ 0 };
+	};
+
+	inline bool AliasLifetimesOverlap(const AliasRequest& lhs, const AliasRequest& rhs)
+	{
+		return lhs.Heap == rhs.Heap && lhs.FirstPass <= rhs.LastPass && rhs.FirstPass <= lhs.LastPass;
+	}
+
+	inline bool AliasRangesOverlap(uint64_t lhsOffset, uint64_t lhsSize, uint64_t rhsOffset, uint64_t rhsSize)
+	{
+		return lhsOffset < rhsOffset + rhsSize && rhsOffset < lhsOffset + lhsSize;
+	}
+
+	// Places every request in its heap so that requests alive at the same time never overlap in memory.
+	// Greedy, largest first, each at the lowest aligned offset that is free for its whole lifetime.
+	// outHeapSizes is indexed by AliasRequest::Heap.
+	inline void PlanRenderTargetAliasing(const std::vector<AliasRequest>& requests, std::vector<uint64_t>& outOffsets, std::vector<uint64_t>& outHeapSizes)
+	{
+		outOffsets.assign(requests.size(), 0);
+		outHeapSizes.clear();
+
+		std::vector<uint32_t> order(requests.size());
+		for (uint32_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+		std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs) { return requests[lhs].Size > requests[rhs].Size; });
+
+		std::vector<uint32_t> placed;
+		std::vector<uint64_t> candidates;
+		for (uint32_t index : order)
+		{
+			const AliasRequest& request = requests[index];
+			const uint64_t alignment = request.Alignment ? request.Alignment : 1;
+
+			// free spots start at 0 or right after a live neighbour
+			candidates.clear();
+			candidates.push_back(0);
+			for (uint32_t other : placed)
+			{
+				if (AliasLifetimesOverlap(request, requests[other]))
+				{
+					const uint64_t end = outOffsets[other] + requests[other].Size;
+					candidates.push_back((end + alignment - 1) / alignment * alignment);
+				}
+			}
+			std::sort(candidates.begin(), candidates.end());
+
+			for (uint64_t offset : candidates)
+			{
+				bool isFree = true;
+				for (uint32_t other : placed)
+				{
+					if (AliasLifetimesOverlap(request, requests[other]) && AliasRangesOverlap(offset, request.Size, outOffsets[other], requests[other].Size))
+					{
+						isFree = false;
+						break;
+					}
+				}
+				if (isFree)
+				{
+					outOffsets[index] = offset;
+					break;
+				}
+			}
+			placed.push_back(index);
+
+			if (outHeapSizes.size() <= request.Heap)
+				outHeapSizes.resize(request.Heap + 1, 0);
+			outHeapSizes[request.Heap] = std::max(outHeapSizes[request.Heap], outOffsets[index] + request.Size);
+		}
+	}
+}
\ No newline at end of file
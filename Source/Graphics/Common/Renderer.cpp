@@ -1,14 +1,21 @@
 #include "Renderer.h"
 #include "IRenderPass.h"
 #include "IRenderScene.h"
+#include "Core/Engine.h"
+#include "Core/JobSystem.h"
 
 #include "Graphics/Vulkan/VulkanBase.h"
 #include "Graphics/Vulkan/VulkanRenderElement.h"
 #include "Graphics/Vulkan/VulkanRenderPass.h"
 
+#include "Graphics/Vulkan/VulkanCommandPool.h"
 #include "Graphics/Vulkan/VulkanLogicalDevice.h"
 #include "Graphics/Vulkan/VulkanSurface.h"
-#include "Graphics/Vulkan/VulkanSwapchain.h"
+#include "Graphics/Vulkan/VulkanSwapChain.h"
+#include "Graphics/Vulkan/VulkanPipelineCache.h"
+#include "Graphics/Vulkan/VulkanDescriptor.h"
+#include "Graphics/Vulkan/VulkanUniformRing.h"
+#include "Graphics/Vulkan/VulkanStagingArena.h"
 #include "Graphics/Common/IRenderPass.h"
 
 
@@ -18,43 +25,177 @@ namespace zyh
 		: mRenderScene_(renderScene)
 	{
 		mPlatform_ = new VulkanBase();
+		for (RenderSnapshot& snapshot : mSnapshots_)
+		{
+			mFree_.TryPush(&snapshot);
+		}
 	}
 
 	Renderer::~Renderer()
 	{
-		
+		Stop();
 	}
 
 	void Renderer::Build()
 	{
+		mBuildTime_ = std::chrono::steady_clock::now();
 		mPlatform_->Initialize();
 		SetupPipeline();
 		Compile();
 	}
 
-	void Renderer::Draw()
+	void Renderer::Start()
+	{
+		HYBRID_CHECK(!mRenderThread_.joinable());
+		mRenderThread_ = std::thread(&Renderer::_RenderLoop, this);
+	}
+
+	void Renderer::Stop()
+	{
+		if (!mRenderThread_.joinable())
+			return;
+		mSubmitted_.Push(nullptr);
+		mRenderThread_.join();
+
+		for (auto& command : mPendingCommands_)
+		{
+			command();
+		}
+		mPendingCommands_.clear();
+		mPlatform_->FlushRetired();
+		GPipelineCache->Save();
+	}
+
+	RenderSnapshot& Renderer::BeginSnapshot()
+	{
+		HYBRID_CHECK(!mBuilding_);
+		mFree_.Pop(mBuilding_);
+		mBuilding_->Reset();
+		return *mBuilding_;
+	}
+
+	void Renderer::SubmitSnapshot()
+	{
+		HYBRID_CHECK(mBuilding_);
+		mBuilding_->Commands.swap(mPendingCommands_);
+		RenderSnapshot* snapshot = mBuilding_;
+		mBuilding_ = nullptr;
+
+		if (mRenderThread_.joinable())
+			mSubmitted_.Push(snapshot);
+		else
+			_RenderFrame(snapshot);
+	}
+
+	void Renderer::EnqueueCommand(std::function<void()> command)
+	{
+		mPendingCommands_.push_back(std::move(command));
+	}
+
+	void Renderer::EnqueueRelease(std::function<void()> release)
+	{
+		EnqueueCommand([this, release = std::move(release)]() mutable { mPlatform_->Retire(std::move(release)); });
+	}
+
+	bool Renderer::CaptureFrame(const std::string& path)
+	{
+		HYBRID_CHECK(!mRenderThread_.joinable());
+		return mPlatform_->CaptureFrame(path);
+	}
+
+	void Renderer::_RenderLoop()
+	{
+		GEngine->Jobs->RegisterThread();
+		while (true)
+		{
+			RenderSnapshot* snapshot = nullptr;
+			mSubmitted_.Pop(snapshot);
+			if (!snapshot)
+				break;
+			_RenderFrame(snapshot);
+		}
+		GEngine->Jobs->UnregisterThread();
+	}
+
+	void Renderer::_RenderFrame(RenderSnapshot* snapshot)
+	{
+		for (auto& command : snapshot->Commands)
+		{
+			command();
+		}
+		Draw(*snapshot);
+		mFree_.Push(snapshot);
+	}
+
+	void Renderer::Draw(const RenderSnapshot& snapshot)
 	{
 		mPlatform_->DrawFrameBegin(mCurrentImage_);
 		{
-			for (auto renderSet : mRenderScene_->GetExistRenderSets())
+			// new elements are set up first, their uniforms can only be pushed once their material has its offsets
+			for (VulkanRenderPass* pass : mVulkanRenderPasses_)
+			{
+				pass->Prepare(snapshot);
+			}
+
+			// every element owns its material and uniform buffers, so they can be filled in parallel
+			std::vector<const RenderItem*>& items = mUniformItems_;
+			items.clear();
+			for (const std::vector<RenderItem>& setItems : snapshot.Items)
 			{
-				std::vector<IRenderElement*> elements;
-				mRenderScene_->GetRenderElements(renderSet, elements);
-				for (auto& renderElement : elements)
+				for (const RenderItem& item : setItems)
 				{
-					VulkanRenderElement* element = static_cast<VulkanRenderElement*>(renderElement);
-					element->updateUniformBuffer(mCurrentImage_);
+					items.push_back(&item);
 				}
 			}
-
+			GEngine->Jobs->ParallelFor(0, items.size(), UNIFORM_UPDATE_BATCH_SIZE, [&](size_t begin, size_t end)
+				{
+					for (size_t i = begin; i < end; ++i)
+					{
+						VulkanRenderElement* element = static_cast<VulkanRenderElement*>(items[i]->Element);
+						element->updateUniformBuffer(mCurrentImage_, snapshot, items[i]->WorldTransform);
+					}
+				});
 
 			for (VulkanRenderPass* pass : mVulkanRenderPasses_)
 			{
-				pass->Prepare();
-				pass->Draw();
+				pass->Draw(snapshot);
 			}
 		}
 		mPlatform_->DrawFrameEnd();
+
+		// pipelines are compiled while the first frame is prepared, a warm cache shows here
+		if (!mFirstFrameDrawn_)
+		{
+			mFirstFrameDrawn_ = true;
+			const double startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mBuildTime_).count();
+			printf("startup: first frame %.1f ms after build, %s pipeline cache, %u pipelines built in %.1f ms\n",
+				startupMs, GPipelineCache->IsWarm() ? "warm" : "cold", GPipelineCache->GetBuiltCount(), GPipelineCache->GetBuildMs());
+			fflush(stdout);
+		}
+	}
+
+	void Renderer::PrintDrawStats() const
+	{
+		for (VulkanRenderPass* pass : mVulkanRenderPasses_)
+		{
+			const uint64_t frames = pass->GetDrawnFrames();
+			if (!frames)
+				continue;
+			const DrawStats& total = pass->GetTotalDrawStats();
+			const double scale = 1.0 / double(frames);
+			printf("pass %s per frame: draws %.1f (instanced %.1f of %.1f instances) binds %.1f (pipeline %.1f descriptor set %.1f vertex %.1f index %.1f dynamic %.1f)\n",
+				pass->GetRenderPass()->GetName().c_str(),
+				total.Draws * scale, total.InstancedDraws * scale, total.Instances * scale,
+				total.GetBinds() * scale, total.PipelineBinds * scale, total.DescriptorSetBinds * scale,
+				total.VertexBufferBinds * scale, total.IndexBufferBinds * scale, total.DynamicStateSets * scale);
+		}
+		printf("pipelines %zu, descriptor set layouts %zu, descriptor pools %zu (%s)\n",
+			GPipelineCache->GetPipelineCount(), GDescriptorAllocator->GetLayoutCount(), GDescriptorAllocator->GetPoolCount(),
+			GDescriptorAllocator->HasUpdateTemplates() ? "update templates" : "batched writes");
+		printf("uniform ring: peak %.1f KB per frame\n", GVulkanInstance->mUniformRing_->GetPeakFrameBytes() / 1024.0);
+		printf("staging arena: %.1f KB, %zu uploads, %zu grows\n",
+			GStagingArena->GetCapacity() / 1024.0, GStagingArena->GetUploadCount(), GStagingArena->GetGrowCount());
+		fflush(stdout);
 	}
 
 	void Renderer::Connect()
@@ -69,9 +210,21 @@ namespace zyh
 
 		mVulkanRenderPasses_.clear();
 
+		// execution order, culling and attachment access come from the graph
+		mRenderGraph_.Compile(mRenderPasses_, *GRenderDevice);
+		for (IRenderPass* pass : mRenderGraph_.GetCulledPasses())
+			pass->SetCompiled(nullptr);
+
+		// every live target exists before any gets memory, so the ones used at different times can share it
+		for (const RenderGraphPass& compiled : mRenderGraph_.GetPasses())
+			compiled.Pass->CreateRenderResource();
+		GRenderDevice->CommitRenderTargets(mRenderGraph_);
+
 		// Resolve RenderPass
-		for (IRenderPass* pass : mRenderPasses_)
+		for (const RenderGraphPass& compiled : mRenderGraph_.GetPasses())
 		{
+			IRenderPass* pass = compiled.Pass;
+			pass->SetCompiled(&compiled);
 			pass->PrepareData();
 			VulkanRenderPass* vulkanPass = new VulkanRenderPass(pass);
 			vulkanPass->InitailizeResource();
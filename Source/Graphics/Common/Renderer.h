@@ -1,5 +1,9 @@
 #pragma once
+#include <thread>
 #include "Common/Config.h"
+#include "Core/DataStructure/SPSCQueue.h"
+#include "Graphics/Common/RenderSnapshot.h"
+#include "Graphics/Common/RenderGraph.h"
 #include "Graphics/Imgui/imgui.h"
 #include "Graphics/Imgui/imgui_impl_vulkan.h"
 #include "Graphics/Imgui/imgui_impl_win32.h"
@@ -20,16 +24,62 @@ namespace zyh
 		virtual ~Renderer();
 
 		void Build();
-		void Draw();
 		void Connect();
 		void Compile();
 		void SetupPipeline();
 
+	public:
+		// starts the render thread, frames are only drawn there from now on
+		void Start();
+		// drains the submitted frames and joins the render thread, then runs the commands
+		// enqueued after the last frame and every pending release
+		void Stop();
+
+		// game thread: fill the returned snapshot and hand it over with SubmitSnapshot().
+		// blocks while the render thread is SNAPSHOT_COUNT - 1 frames behind.
+		// without a render thread the frame is drawn inline on submit
+		RenderSnapshot& BeginSnapshot();
+		void SubmitSnapshot();
+		// game thread: runs on the render thread before the next submitted frame
+		void EnqueueCommand(std::function<void()> command);
+		// game thread: runs release on the render thread once no frame in flight can still use what it frees
+		void EnqueueRelease(std::function<void()> release);
+		// headless, after Stop(): writes the last drawn frame to path
+		bool CaptureFrame(const std::string& path);
+		// after Stop(): average binds / draws per frame of every pass
+		void PrintDrawStats() const;
+
+	protected:
+		void Draw(const RenderSnapshot& snapshot);
+		void _RenderLoop();
+		void _RenderFrame(RenderSnapshot* snapshot);
+
 	protected:
 		VulkanBase* mPlatform_;
 		IRenderScene* mRenderScene_;
+		// declared by SetupPipeline, mVulkanRenderPasses_ follow the compiled graph
 		std::vector<IRenderPass*> mRenderPasses_;
+		RenderGraph mRenderGraph_;
 		std::vector<class VulkanRenderPass*> mVulkanRenderPasses_;
 		size_t mCurrentImage_ = 0;
+
+		static constexpr size_t UNIFORM_UPDATE_BATCH_SIZE = 64;
+		// render thread only, reused every frame
+		std::vector<const RenderItem*> mUniformItems_;
+
+		// double buffered: the game thread fills one snapshot while the render thread draws the other
+		static constexpr size_t SNAPSHOT_COUNT = 2;
+		RenderSnapshot mSnapshots_[SNAPSHOT_COUNT];
+		// game -> render, nullptr asks the render thread to quit
+		SPSCQueue<RenderSnapshot*, SNAPSHOT_COUNT * 2> mSubmitted_;
+		// render -> game
+		SPSCQueue<RenderSnapshot*, SNAPSHOT_COUNT * 2> mFree_;
+		RenderSnapshot* mBuilding_{ nullptr };
+		std::vector<std::function<void()>> mPendingCommands_;
+		std::thread mRenderThread_;
+
+		// startup time is Build() to the end of the first drawn frame
+		std::chrono::steady_clock::time_point mBuildTime_;
+		bool mFirstFrameDrawn_{ false };
 	};
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "Core/Engine.h"
 #include "Core/ClientScene.h"
+#include "Core/JobSystem.h"
 
 #include "VulkanBase.h"
 #include "VulkanTools.h"
@@ -7,12 +8,16 @@
 #include "VulkanSurface.h"
 #include "VulkanPhysicalDevice.h"
 #include "VulkanLogicalDevice.h"
-#include "VulkanSwapchain.h"
+#include "VulkanSwapChain.h"
 #include "VulkanCommandPool.h"
 #include "VulkanImage.h"
 #include "VulkanRenderPass.h"
 #include "VulkanGraphicsPipeline.h"
 #include "VulkanBuffer.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanDescriptor.h"
+#include "VulkanUniformRing.h"
+#include "VulkanStagingArena.h"
 
 #include "VulkanRenderElement.h"
 
@@ -41,18 +46,26 @@ namespace zyh
 		GVulkanInstance = this;
 
 		mInstance_ = new VulkanInstance();
-		mSurface_ = new VulkanSurface();
 		mPhysicalDevice_ = new VulkanPhysicalDevice();
 		mLogicalDevice_ = new VulkanLogicalDevice();
-		mSwapchain_ = new VulkanSwapchain();
 		mGraphicsCommandPool_ = new VulkanCommandPool(GRAPHICS);
+		mRecordingPools_ = new VulkanRecordingPools();
+		mUniformRing_ = new VulkanUniformRing();
+		if (!Setting::IsHeadless)
+		{
+			mSurface_ = new VulkanSurface();
+			mSwapchain_ = new VulkanSwapchain();
+			mSurface_->connect(mInstance_);
+		}
 
 		// connect
-		mSurface_->connect(mInstance_);
 		mPhysicalDevice_->connect(mInstance_, mSurface_);
 		mLogicalDevice_->connect(mInstance_, mPhysicalDevice_);
-		mSwapchain_->connect(mInstance_, mPhysicalDevice_, mLogicalDevice_, mSurface_);
+		if (mSwapchain_)
+			mSwapchain_->connect(mInstance_, mPhysicalDevice_, mLogicalDevice_, mSurface_);
 		mGraphicsCommandPool_->connect(mPhysicalDevice_, mLogicalDevice_, mSwapchain_);
+		mRecordingPools_->connect(mPhysicalDevice_, mLogicalDevice_);
+		mUniformRing_->connect(mPhysicalDevice_, mLogicalDevice_);
 	}
 
 	void VulkanBase::setupVulkan()
@@ -63,16 +76,26 @@ namespace zyh
 		mInstance_->setup();
 
 #if defined(VK_USE_PLATFORM_WIN32_KHR)		
-		mSurface_->setup(GEngine->mWindowInstance_, GEngine->mWindow_);
+		if (mSurface_)
+			mSurface_->setup(GEngine->mWindowInstance_, GEngine->mWindow_);
 #endif
 
 		mPhysicalDevice_->setup();
 		
 		mLogicalDevice_->setup();
-
-		mSwapchain_->setup(&mWidth_, &mHeight_);
+		GPipelineCache->setup(mPhysicalDevice_, mLogicalDevice_, Setting::PipelineCachePath);
+		GDescriptorAllocator->setup(mPhysicalDevice_, mLogicalDevice_);
+		GStagingArena->setup(mPhysicalDevice_, mLogicalDevice_);
+
+		if (mSwapchain_)
+			mSwapchain_->setup(&mWidth_, &mHeight_);
+		else
+			createOffscreenImages();
 		
 		mGraphicsCommandPool_->setup();
+		// one slot per job worker, so every chunk recorded at once gets its own pool
+		mRecordingPools_->setup(GEngine->Jobs->GetThreadCount());
+		mUniformRing_->setup(static_cast<uint32_t>(getImageCount()), UNIFORM_RING_SEGMENT_SIZE);
 	}
 
 	void VulkanBase::createSyncObjects()
@@ -80,7 +103,8 @@ namespace zyh
 		mImageAvailableSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
 		mRenderFinishedSemaphores_.resize(MAX_FRAMES_IN_FLIGHT);
 		mInFlightFences_.resize(MAX_FRAMES_IN_FLIGHT);
-		mImagesInFights_.resize(mSwapchain_->getImageCount(), VK_NULL_HANDLE);
+		mImagesInFights_.resize(getImageCount(), VK_NULL_HANDLE);
+		mRetired_.resize(getImageCount());
 
 		VkSemaphoreCreateInfo semaphoreInfo{};
 		semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
@@ -110,12 +134,113 @@ namespace zyh
 
 	size_t VulkanBase::getImageCount()
 	{
-		return mSwapchain_->getImageCount();
+		return mSwapchain_ ? mSwapchain_->getImageCount() : mOffscreenImages_.size();
 	}
 
 	std::vector<VulkanImage>& VulkanBase::getSwapChainImages()
 	{
-		return mSwapchain_->getImages();
+		return mSwapchain_ ? mSwapchain_->getImages() : mOffscreenImages_;
+	}
+
+	VkImageLayout VulkanBase::getOutputLayout()
+	{
+		return mSwapchain_ ? VK_IMAGE_LAYOUT_PRESENT_SRC_KHR : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	}
+
+	void VulkanBase::createOffscreenImages()
+	{
+		// same format the final pass resolves into (EPixelFormat::R8G8B8A8)
+		const VkFormat format = VK_FORMAT_B8G8R8A8_UNORM;
+		mOffscreenImages_.resize(MAX_FRAMES_IN_FLIGHT);
+		for (VulkanImage& image : mOffscreenImages_)
+		{
+			image.connect(mPhysicalDevice_, mLogicalDevice_);
+			image.setup(mWidth_, mHeight_, 1, VK_SAMPLE_COUNT_1_BIT, format, VK_IMAGE_TILING_OPTIMAL,
+				VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+				VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_IMAGE_ASPECT_COLOR_BIT
+			);
+		}
+
+		*GInstance->mImageCount_ = static_cast<uint32_t>(mOffscreenImages_.size());
+		GInstance->mImageCount_.IsValid(true);
+
+		*GInstance->mColorFormat_ = format;
+		GInstance->mColorFormat_.IsValid(true);
+
+		*GInstance->mExtend_ = VkExtent2D{ mWidth_, mHeight_ };
+		GInstance->mExtend_.IsValid(true);
+	}
+
+	void VulkanBase::destroyOffscreenImages()
+	{
+		for (VulkanImage& image : mOffscreenImages_)
+		{
+			image.cleanup();
+		}
+		mOffscreenImages_.clear();
+	}
+
+	bool VulkanBase::CaptureFrame(const std::string& path)
+	{
+		HYBRID_CHECK(!mSwapchain_, "only offscreen images can be read back");
+		vkDeviceWaitIdle(mLogicalDevice_->Get());
+
+		// nothing drawn yet, the image has no defined content / layout
+		if (mOffscreenImages_.empty() || mImagesInFights_[mCurrentImage_] == VK_NULL_HANDLE)
+			return false;
+
+		const VkDeviceSize size = VkDeviceSize(mWidth_) * mHeight_ * 4;
+		VulkanBuffer readback;
+		readback.connect(mPhysicalDevice_, mLogicalDevice_);
+		readback.setup(size, VK_BUFFER_USAGE_TRANSFER_DST_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+		VkImage image = mOffscreenImages_[mCurrentImage_].Get().image;
+		mGraphicsCommandPool_->generateSingleTimeCommand([&](VulkanCommand& command)
+			{
+				VkBufferImageCopy region{};
+				region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+				region.imageSubresource.layerCount = 1;
+				region.imageExtent = { mWidth_, mHeight_, 1 };
+				vkCmdCopyImageToBuffer(command.Get(), image, getOutputLayout(), readback.Get().buffer, 1, &region);
+			});
+
+		FILE* file = fopen(path.c_str(), "wb");
+		if (!file)
+			return false;
+
+		// host visible buffers are mapped at setup
+		const uint8_t* bgra = readback.GetMapped();
+		std::vector<uint8_t> rgb(size_t(mWidth_) * mHeight_ * 3);
+		for (size_t i = 0, count = size_t(mWidth_) * mHeight_; i < count; ++i)
+		{
+			rgb[i * 3 + 0] = bgra[i * 4 + 2];
+			rgb[i * 3 + 1] = bgra[i * 4 + 1];
+			rgb[i * 3 + 2] = bgra[i * 4 + 0];
+		}
+
+		fprintf(file, "P6\n%u %u\n255\n", mWidth_, mHeight_);
+		fwrite(rgb.data(), 1, rgb.size(), file);
+		fclose(file);
+		return true;
+	}
+
+	void VulkanBase::Retire(std::function<void()> release)
+	{
+		mRetiring_.push_back(std::move(release));
+	}
+
+	void VulkanBase::FlushRetired()
+	{
+		vkDeviceWaitIdle(mLogicalDevice_->Get());
+		for (auto& retired : mRetired_)
+		{
+			for (auto& release : retired)
+				release();
+			retired.clear();
+		}
+		for (auto& release : mRetiring_)
+			release();
+		mRetiring_.clear();
 	}
 
 	/// impl
@@ -125,8 +250,8 @@ namespace zyh
 		createCommandBuffers();
 		createSyncObjects();
 
-		GEngine->Scene->GetCamera()->mScreenHeight_ = static_cast<float>(mSwapchain_->getExtend().height);
-		GEngine->Scene->GetCamera()->mScreenWidth_ = static_cast<float>(mSwapchain_->getExtend().width);
+		GEngine->Scene->GetCamera()->mScreenHeight_ = static_cast<float>(GInstance->mExtend_->height);
+		GEngine->Scene->GetCamera()->mScreenWidth_ = static_cast<float>(GInstance->mExtend_->width);
 		GEngine->Scene->GetCamera()->updateProjMatrix();
 	}
 
@@ -148,6 +273,12 @@ namespace zyh
 			vkDestroyFence(mLogicalDevice_->Get(), mInFlightFences_[i], nullptr);
 		}
 		SafeDestroy(mSwapchain_);
+		destroyOffscreenImages();
+		GPipelineCache->cleanup();
+		GDescriptorAllocator->cleanup();
+		GStagingArena->cleanup();
+		mUniformRing_->cleanup();
+		SafeDestroy(mUniformRing_);
 		SafeDestroy(mLogicalDevice_);
 		SafeDestroy(mPhysicalDevice_);
 		SafeDestroy(mSurface_);
@@ -156,6 +287,9 @@ namespace zyh
 
 	void VulkanBase::windowResize(uint32_t width, uint32_t height)
 	{
+		// offscreen targets keep the size they were created with
+		if (!mSwapchain_)
+			return;
 		mWidth_ = width;
 		mHeight_ = height;
 		recreateSwapchain();
@@ -163,7 +297,7 @@ namespace zyh
 
 	void VulkanBase::createCommandBuffers()
 	{
-		mCommandBuffers_.resize(mSwapchain_->getImageCount());
+		mCommandBuffers_.resize(getImageCount());
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.commandPool = mGraphicsCommandPool_->Get();
@@ -222,20 +356,37 @@ namespace zyh
 		submitInfo.commandBufferCount = static_cast<uint32_t>(commandList.size());
 		submitInfo.pCommandBuffers = commandList.data();
 
+		// headless: nothing is acquired or presented, the in flight fence is the only synchronization
+		const bool present = mSwapchain_ != nullptr;
 		VkSemaphore waitSemaphores[] = { mImageAvailableSemaphores_[mCurrentFrame_] };
 		VkPipelineStageFlags waitStages[] = { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-		submitInfo.waitSemaphoreCount = 1;
+		submitInfo.waitSemaphoreCount = present ? 1 : 0;
 		submitInfo.pWaitSemaphores = waitSemaphores;
 		submitInfo.pWaitDstStageMask = waitStages;
 		
 		VkSemaphore signalSemaphores[] = { mRenderFinishedSemaphores_[mCurrentFrame_] };
-		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.signalSemaphoreCount = present ? 1 : 0;
 		submitInfo.pSignalSemaphores = signalSemaphores;
 
 		vkResetFences(mLogicalDevice_->Get(), 1, &mInFlightFences_[mCurrentFrame_]);
-		VK_CHECK_RESULT(vkQueueSubmit(mLogicalDevice_->graphicsQueue(), 1, &submitInfo, mInFlightFences_[mCurrentFrame_]), "failed to submit draw command buffer!");
+		{
+			// the game thread submits uploads to the same queue
+			std::lock_guard<std::recursive_mutex> lock(mGraphicsCommandPool_->GetSubmitLock());
+			VK_CHECK_RESULT(vkQueueSubmit(mLogicalDevice_->graphicsQueue(), 1, &submitInfo, mInFlightFences_[mCurrentFrame_]), "failed to submit draw command buffer!");
+		}
 
 		mImagesInFights_[mCurrentImage_] = mInFlightFences_[mCurrentFrame_];
+		// the queue finishes frames in submission order, so once this fence signals nothing retired before it is in use
+		std::vector<std::function<void()>>& retired = mRetired_[mCurrentImage_];
+		for (auto& release : mRetiring_)
+			retired.push_back(std::move(release));
+		mRetiring_.clear();
+
+		if (!present)
+		{
+			mCurrentFrame_ = (mCurrentFrame_ + 1) % MAX_FRAMES_IN_FLIGHT;
+			return;
+		}
 
 		// Presentation
 		VkPresentInfoKHR presentInfo{};
@@ -250,7 +401,11 @@ namespace zyh
 		presentInfo.pImageIndices = &imageIndex;
 		presentInfo.pResults = nullptr;
 
-		result = vkQueuePresentKHR(mLogicalDevice_->presentQueue(), &presentInfo);
+		{
+			// the present queue is usually the graphics one
+			std::lock_guard<std::recursive_mutex> lock(mGraphicsCommandPool_->GetSubmitLock());
+			result = vkQueuePresentKHR(mLogicalDevice_->presentQueue(), &presentInfo);
+		}
 
 		if (result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || mFrameBufferResized_) {
 			mFrameBufferResized_ = false;
@@ -266,7 +421,10 @@ namespace zyh
 	void VulkanBase::recreateSwapchain()
 	{
 		// Ensure all operations on the device have been finished before destroying resources
-		vkDeviceWaitIdle(mLogicalDevice_->Get());
+		{
+			std::lock_guard<std::recursive_mutex> lock(mGraphicsCommandPool_->GetSubmitLock());
+			vkDeviceWaitIdle(mLogicalDevice_->Get());
+		}
 		_cleanupSwapchain();
 
 		// Recreate swap chain
@@ -307,17 +465,26 @@ namespace zyh
 		{
 			uint32_t imageIndex;
 
-			// acquire next image we want to use
-			mSwapchain_->acquireNextImage(mImageAvailableSemaphores_[mCurrentFrame_], &imageIndex);
+			// acquire next image we want to use, headless simply cycles through the offscreen images
+			if (mSwapchain_)
+				mSwapchain_->acquireNextImage(mImageAvailableSemaphores_[mCurrentFrame_], &imageIndex);
+			else
+				imageIndex = static_cast<uint32_t>(mCurrentFrame_ % mOffscreenImages_.size());
 
 			// Check if a previous frame is using this image (if true, wait for it)
 			if (mImagesInFights_[imageIndex] != VK_NULL_HANDLE) {
 				vkWaitForFences(mLogicalDevice_->Get(), 1, &mImagesInFights_[imageIndex], VK_TRUE, UINT64_MAX);
 			}
 			mCurrentImage_ = imageIndex;
+
+			for (auto& release : mRetired_[imageIndex])
+				release();
+			mRetired_[imageIndex].clear();
 		}
 
 		mFreeCommandBufferIdx_ = 0;
+		mRecordingPools_->BeginFrame(mCurrentImage_);
+		mUniformRing_->BeginFrame(mCurrentImage_);
 		OutCurrentImage = mCurrentImage_;
 	}
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include "VulkanHeader.h"
 #include "VulkanTools.h"
+#include "VulkanImage.h"
 #include "Common/Setting.h"
 #include "Common/KeyCodes.h"
 
@@ -13,6 +14,8 @@ namespace zyh
 	class VulkanLogicalDevice;
 	class VulkanSwapchain;
 	class VulkanCommandPool;
+	class VulkanRecordingPools;
+	class VulkanUniformRing;
 	class VulkanCommand;
 	class VulkanImage;
 	class VulkanTextureImage;
@@ -63,24 +66,47 @@ namespace zyh
 		/** @brief Encapsulated logical device */
 		VulkanLogicalDevice* mLogicalDevice_{ nullptr };
 
-		/** @brief Encapsulated swapchain*/
+		/** @brief Encapsulated swapchain, nullptr when headless*/
 		VulkanSwapchain* mSwapchain_{ nullptr };
 
+		/** @brief Headless color targets standing in for the swapchain images*/
+		std::vector<VulkanImage> mOffscreenImages_;
+
 		/** @brief Encapsulated command pool*/
 		VulkanCommandPool* mGraphicsCommandPool_{ nullptr };
 
+		/** @brief Per image and recording slot pools for secondary command buffers*/
+		VulkanRecordingPools* mRecordingPools_{ nullptr };
+
+		/** @brief Persistently mapped per image segments the per object uniforms are streamed into*/
+		VulkanUniformRing* mUniformRing_{ nullptr };
+		static constexpr VkDeviceSize UNIFORM_RING_SEGMENT_SIZE = 8 * 1024 * 1024;
+
 		/** @brief Synchronization Objects*/
 		const int MAX_FRAMES_IN_FLIGHT = 2;
 		std::vector<VkSemaphore> mImageAvailableSemaphores_;
 		std::vector<VkSemaphore> mRenderFinishedSemaphores_;
 		std::vector<VkFence> mInFlightFences_;
 		std::vector<VkFence> mImagesInFights_;
+		// retired since the last submit, then parked on the image of the next submitted frame
+		// until its fence is waited on again
+		std::vector<std::function<void()>> mRetiring_;
+		std::vector<std::vector<std::function<void()>>> mRetired_;
 
 	public:
 		virtual VkSampleCountFlagBits getMsaaSamples();
 		virtual VkFormat getDepthFormat();
 		size_t getImageCount();
+		// swapchain images, or the offscreen images when headless
 		std::vector<VulkanImage>& getSwapChainImages();
+		// layout the final pass leaves its output in: presentable, or ready for readback when headless
+		VkImageLayout getOutputLayout();
+		// headless: reads back the last drawn image and writes it to path as binary ppm
+		bool CaptureFrame(const std::string& path);
+		// render thread: runs release once the frames submitted so far have finished on the device
+		void Retire(std::function<void()> release);
+		// waits for the device and runs every retired release
+		void FlushRetired();
 
 	protected:
 		bool mIsPaused_{ false };
@@ -103,6 +129,8 @@ namespace zyh
 	private:
 		// TODO: Encapsulated or insert to any class
 		void createSyncObjects();
+		void createOffscreenImages();
+		void destroyOffscreenImages();
 
 	// impl
 	private:
@@ -59,19 +59,64 @@ namespace zyh
 	{
 		cleanup();
 		_createBuffer(size, usage, properties);
+		if (!(properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT))
+			return;
+
+		mIsCoherent_ = properties & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		if (!mIsCoherent_)
+		{
+			VkPhysicalDeviceProperties deviceProperties;
+			vkGetPhysicalDeviceProperties(mVulkanPhysicalDevice_->Get(), &deviceProperties);
+			mNonCoherentAtomSize_ = Max(deviceProperties.limits.nonCoherentAtomSize, VkDeviceSize(1));
+		}
+
+		void* mapped = nullptr;
+		if (vkMapMemory(mVulkanLogicalDevice_->Get(), mVkImpl_.mem, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS)
+			throw std::runtime_error("failed to map buffer memory!");
+		mMapped_ = static_cast<uint8_t*>(mapped);
 	}
 
-	void VulkanBuffer::setupData(void* data, VkDeviceSize size, size_t offset)
+	void VulkanBuffer::setupData(const void* data, VkDeviceSize size, size_t offset)
 	{
-		void* memData;
-		vkMapMemory(mVulkanLogicalDevice_->Get(), mVkImpl_.mem, 0, GetBufferSize(), 0, &memData);
-		void* memDataStart = (void*)((char*)memData + offset);
-		memcpy(memDataStart, data, static_cast<size_t>(size));
-		vkUnmapMemory(mVulkanLogicalDevice_->Get(), mVkImpl_.mem);
+		Write(offset, std::span<const uint8_t>(static_cast<const uint8_t*>(data), static_cast<size_t>(size)));
+	}
+
+	void VulkanBuffer::Write(VkDeviceSize offset, std::span<const uint8_t> data)
+	{
+		HYBRID_CHECK(mMapped_, "buffer is not host visible!");
+		HYBRID_CHECK(offset + data.size() <= mBufferSize_);
+		memcpy(mMapped_ + offset, data.data(), data.size());
+		Flush(offset, data.size());
+	}
+
+	void VulkanBuffer::Flush(VkDeviceSize offset, VkDeviceSize size)
+	{
+		if (mIsCoherent_ || !mMapped_ || size == 0)
+			return;
+
+		// flushed ranges must start and end on nonCoherentAtomSize, or run to the end of the allocation
+		VkMappedMemoryRange range{};
+		range.sType = VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE;
+		range.memory = mVkImpl_.mem;
+		range.offset = offset / mNonCoherentAtomSize_ * mNonCoherentAtomSize_;
+		range.size = VK_WHOLE_SIZE;
+		if (size != VK_WHOLE_SIZE)
+		{
+			const VkDeviceSize end = (offset + size + mNonCoherentAtomSize_ - 1) / mNonCoherentAtomSize_ * mNonCoherentAtomSize_;
+			if (end <= mBufferSize_)
+				range.size = end - range.offset;
+		}
+		vkFlushMappedMemoryRanges(mVulkanLogicalDevice_->Get(), 1, &range);
 	}
 
 	void VulkanBuffer::cleanup()
 	{
+		if (mMapped_)
+		{
+			vkUnmapMemory(mVulkanLogicalDevice_->Get(), mVkImpl_.mem);
+			mMapped_ = nullptr;
+		}
+
 		if (mVkImpl_.buffer)
 		{
 			vkDestroyBuffer(mVulkanLogicalDevice_->Get(), mVkImpl_.buffer, nullptr);
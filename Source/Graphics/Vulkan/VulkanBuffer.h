@@ -1,6 +1,7 @@
 #pragma once
 #include "VulkanObject.h"
 #include "Math/MathUtil.h"
+#include <span>
 
 namespace zyh
 {
@@ -29,10 +30,18 @@ namespace zyh
 
 		void connect(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice);
 		void setup(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
-		void setupData(void* data, VkDeviceSize size, size_t offset=0);
+		void setupData(const void* data, VkDeviceSize size, size_t offset=0);
 		void cleanup();
 
+		// copies into the persistent mapping and flushes the written range on non coherent memory
+		void Write(VkDeviceSize offset, std::span<const uint8_t> data);
+		// makes host writes in [offset, offset + size) visible to the device, no-op on coherent memory
+		void Flush(VkDeviceSize offset = 0, VkDeviceSize size = VK_WHOLE_SIZE);
+
 		VkDeviceSize GetBufferSize() { return mBufferSize_; }
+		// host visible buffers stay mapped from setup until cleanup
+		uint8_t* GetMapped() { return mMapped_; }
+		bool IsCoherent() const { return mIsCoherent_; }
 
 	protected:
 		void _createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties);
@@ -43,6 +52,9 @@ namespace zyh
 	private:
 		VulkanPhysicalDevice* mVulkanPhysicalDevice_;
 		VulkanLogicalDevice* mVulkanLogicalDevice_;
+		uint8_t* mMapped_{ nullptr };
+		bool mIsCoherent_{ true };
+		VkDeviceSize mNonCoherentAtomSize_{ 1 };
 	};
 
 	namespace UniformType
@@ -57,30 +69,6 @@ namespace zyh
 		};
 	}
 	using EUniformType = UniformType::EUniformType;
-	class VulkanUniformBuffer : public VulkanBuffer
-	{
-	public:
-		VulkanUniformBuffer(EUniformType type, VkShaderStageFlagBits usageState)
-			: VulkanBuffer()
-			, mType_(type)
-			, mUseState_(usageState)
-		{
-		}
-
-	public:
-		EUniformType GetType() { return mType_; }
-		VkShaderStageFlags GetState() { return mUseState_; }
-		void AddState(VkShaderStageFlagBits bit) { mUseState_ = mUseState_ | bit; }
-		void setupData(EUniformType dataType, void* data, VkDeviceSize size)
-		{
-			if (dataType == mType_)
-				VulkanBuffer::setupData(data, size);
-		}
-
-	protected:
-		EUniformType mType_;
-		VkShaderStageFlags mUseState_; // TODO: support multi-state
-	};
 
 	class VulkanImageBuffer : public VulkanBuffer
 	{
@@ -1,7 +1,8 @@
 #include "VulkanCommandPool.h"
 #include "VulkanPhysicalDevice.h"
 #include "VulkanLogicalDevice.h"
-#include "VulkanSwapchain.h"
+#include "VulkanInstance.h"
+#include "VulkanSwapChain.h"
 
 namespace zyh
 {
@@ -10,6 +11,7 @@ namespace zyh
 		mVkImpl_ = rhs.mVkImpl_;
 		mVulkanCommandPool_ = rhs.mVulkanCommandPool_;
 		mVulkanLogicalDevice_ = rhs.mVulkanLogicalDevice_;
+		mVkCommandPool_ = rhs.mVkCommandPool_;
 	}
 
 	VulkanCommand::VulkanCommand(VulkanCommand&& rhs) noexcept
@@ -17,6 +19,7 @@ namespace zyh
 		mVkImpl_ = rhs.mVkImpl_;
 		mVulkanCommandPool_ = rhs.mVulkanCommandPool_;
 		mVulkanLogicalDevice_ = rhs.mVulkanLogicalDevice_;
+		mVkCommandPool_ = rhs.mVkCommandPool_;
 
 		rhs.mVkImpl_ = VK_NULL_HANDLE;
 	}
@@ -39,12 +42,13 @@ namespace zyh
 
 	void VulkanCommand::setup(VkCommandBufferAllocateInfo allocInfo)
 	{
+		mVkCommandPool_ = allocInfo.commandPool;
 		vkAllocateCommandBuffers(mVulkanLogicalDevice_->Get(), &allocInfo, &mVkImpl_);
 	}
 
 	void VulkanCommand::cleanup()
 	{
-		vkFreeCommandBuffers(mVulkanLogicalDevice_->Get(), mVulkanCommandPool_->Get(), 1, &mVkImpl_);
+		vkFreeCommandBuffers(mVulkanLogicalDevice_->Get(), mVkCommandPool_, 1, &mVkImpl_);
 		mVkImpl_ = VK_NULL_HANDLE;
 	}
 
@@ -73,6 +77,7 @@ namespace zyh
 
 	void VulkanCommandPool::cleanup()
 	{
+		vkDestroyCommandPool(mVulkanLogicalDevice_->Get(), mTransientPool_, nullptr);
 		vkDestroyCommandPool(mVulkanLogicalDevice_->Get(), mVkImpl_, nullptr);
 	}
 
@@ -84,11 +89,15 @@ namespace zyh
 		poolInfo.queueFamilyIndex = indices->getIndexByQueueFamily(mQueueFamily_);
 		poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 		VK_CHECK_RESULT(vkCreateCommandPool(mVulkanLogicalDevice_->Get(), &poolInfo, nullptr/* Allocator*/, &mVkImpl_), "failed to create command pool!");
+
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+		VK_CHECK_RESULT(vkCreateCommandPool(mVulkanLogicalDevice_->Get(), &poolInfo, nullptr/* Allocator*/, &mTransientPool_), "failed to create transient command pool!");
 	}
 
 	void VulkanCommandPool::_setupCommandBuffers()
 	{
-		mCommandBuffers_.resize(mVulkanSwapchain_->getImageCount());
+		// set by the swapchain or, headless, by the offscreen targets
+		mCommandBuffers_.resize(*GInstance->mImageCount_);
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -100,12 +109,13 @@ namespace zyh
 
 	void VulkanCommandPool::generateSingleTimeCommand(SingleTimeExecFunc execFunc)
 	{
+		std::lock_guard<std::mutex> lock(mTransientLock_);
 		VkQueue queue = mVulkanLogicalDevice_->graphicsQueue();
 
 		VkCommandBufferAllocateInfo allocInfo{};
 		allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
 		allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-		allocInfo.commandPool = mVkImpl_;
+		allocInfo.commandPool = mTransientPool_;
 		allocInfo.commandBufferCount = 1;
 
 		VulkanCommand commandBuffer;
@@ -125,8 +135,82 @@ namespace zyh
 		submitInfo.commandBufferCount = 1;
 		submitInfo.pCommandBuffers = &commandBuffer.Get();
 
-		vkQueueSubmit(queue, 1, &submitInfo, VK_NULL_HANDLE);
-		vkQueueWaitIdle(queue); 
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkFence fence;
+		vkCreateFence(mVulkanLogicalDevice_->Get(), &fenceInfo, nullptr, &fence);
+		{
+			std::lock_guard<std::recursive_mutex> submitLock(mSubmitLock_);
+			vkQueueSubmit(queue, 1, &submitInfo, fence);
+		}
+		// waits for this submit only, not for the frames the render thread has in flight
+		vkWaitForFences(mVulkanLogicalDevice_->Get(), 1, &fence, VK_TRUE, UINT64_MAX);
+		vkDestroyFence(mVulkanLogicalDevice_->Get(), fence, nullptr);
+	}
+
+	void VulkanRecordingPools::connect(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice)
+	{
+		mVulkanPhysicalDevice_ = physicalDevice;
+		mVulkanLogicalDevice_ = logicalDevice;
+	}
+
+	void VulkanRecordingPools::setup(uint32_t slotCount)
+	{
+		mSlotCount_ = slotCount > 0 ? slotCount : 1;
+		QueueFamilyIndices indices = mVulkanPhysicalDevice_->findQueueFamilies();
+		VkCommandPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+		poolInfo.queueFamilyIndex = indices->getIndexByQueueFamily(GRAPHICS);
+		// buffers are re-recorded every frame and reset with their pool
+		poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+
+		mPools_.resize(*GInstance->mImageCount_);
+		for (auto& slots : mPools_)
+		{
+			slots.resize(mSlotCount_);
+			for (SlotPool& slot : slots)
+				VK_CHECK_RESULT(vkCreateCommandPool(mVulkanLogicalDevice_->Get(), &poolInfo, nullptr, &slot.Pool), "failed to create command pool!");
+		}
+	}
+
+	void VulkanRecordingPools::cleanup()
+	{
+		for (auto& slots : mPools_)
+		{
+			for (SlotPool& slot : slots)
+				vkDestroyCommandPool(mVulkanLogicalDevice_->Get(), slot.Pool, nullptr);
+		}
+		mPools_.clear();
+	}
+
+	void VulkanRecordingPools::BeginFrame(size_t image)
+	{
+		HYBRID_CHECK(image < mPools_.size());
+		for (SlotPool& slot : mPools_[image])
+		{
+			if (slot.Used == 0)
+				continue;
+			vkResetCommandPool(mVulkanLogicalDevice_->Get(), slot.Pool, 0);
+			slot.Used = 0;
+		}
+	}
+
+	VkCommandBuffer VulkanRecordingPools::Allocate(size_t image, uint32_t slot)
+	{
+		HYBRID_CHECK(image < mPools_.size() && slot < mSlotCount_);
+		SlotPool& pool = mPools_[image][slot];
+		if (pool.Used == pool.Buffers.size())
+		{
+			VkCommandBufferAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+			allocInfo.commandPool = pool.Pool;
+			allocInfo.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+			allocInfo.commandBufferCount = 1;
+			VkCommandBuffer buffer = VK_NULL_HANDLE;
+			VK_CHECK_RESULT(vkAllocateCommandBuffers(mVulkanLogicalDevice_->Get(), &allocInfo, &buffer), "failed to allocate command buffers!");
+			pool.Buffers.push_back(buffer);
+		}
+		return pool.Buffers[pool.Used++];
 	}
 }
 
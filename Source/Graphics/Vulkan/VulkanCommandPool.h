@@ -1,4 +1,5 @@
 #pragma once
+#include <mutex>
 #include "VulkanObject.h"
 
 namespace zyh
@@ -25,6 +26,8 @@ namespace zyh
 	private:
 		VulkanLogicalDevice* mVulkanLogicalDevice_{ nullptr };
 		VulkanCommandPool* mVulkanCommandPool_{ nullptr };
+		// the pool it was allocated from, single time commands come from the transient one
+		VkCommandPool mVkCommandPool_{ VK_NULL_HANDLE };
 
 	public:
 		void begin(VkCommandBufferBeginInfo* beginInfo);
@@ -52,10 +55,46 @@ namespace zyh
 		void _setupCommandBuffers();
 
 	public:
+		// records from the transient pool and blocks until the queue ran it, callable from any thread
 		void generateSingleTimeCommand(SingleTimeExecFunc execFunc);
 		void generateCommand();
+		// guards the queue between the game and the render thread, held around submits / presents only
+		std::recursive_mutex& GetSubmitLock() { return mSubmitLock_; }
 
 	private:
 		std::vector<VkCommandBuffer> mCommandBuffers_;
+		std::recursive_mutex mSubmitLock_;
+		// single time commands never touch the render thread's pool, uploads don't wait for frame recording
+		VkCommandPool mTransientPool_{ VK_NULL_HANDLE };
+		std::mutex mTransientLock_;
+	};
+
+	// secondary command buffers for parallel recording, one pool per [image][slot] so
+	// recorders running at the same time never share a pool
+	class VulkanRecordingPools
+	{
+	public:
+		void connect(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice);
+		void setup(uint32_t slotCount);
+		void cleanup();
+
+		uint32_t GetSlotCount() const { return mSlotCount_; }
+		// render thread, once the previous frame using image has finished
+		void BeginFrame(size_t image);
+		// any thread, as long as no other thread records into the same slot
+		VkCommandBuffer Allocate(size_t image, uint32_t slot);
+
+	private:
+		struct SlotPool
+		{
+			VkCommandPool Pool{ VK_NULL_HANDLE };
+			std::vector<VkCommandBuffer> Buffers;
+			uint32_t Used{ 0 };
+		};
+
+		VulkanPhysicalDevice* mVulkanPhysicalDevice_{ nullptr };
+		VulkanLogicalDevice* mVulkanLogicalDevice_{ nullptr };
+		uint32_t mSlotCount_{ 0 };
+		std::vector<std::vector<SlotPool>> mPools_;
 	};
 }
\ No newline at end of file
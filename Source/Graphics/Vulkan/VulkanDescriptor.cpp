@@ -2,10 +2,14 @@
 #include "VulkanLogicalDevice.h"
 #include "VulkanMaterial.h"
 #include "VulkanBuffer.h"
+#include "VulkanPhysicalDevice.h"
+#include <algorithm>
 
 
 namespace zyh
 {
+	VulkanDescriptorAllocator* GDescriptorAllocator = new VulkanDescriptorAllocator();
+
 	void VulkanDescriptorLayout::connect(VulkanLogicalDevice* logicalDevice)
 	{
 		mVulkanLogicalDevice = logicalDevice;
@@ -14,15 +18,15 @@ namespace zyh
 	void VulkanDescriptorLayout::setup()
 	{
 		std::vector<VkDescriptorSetLayoutBinding> layoutBinding;
-		layoutBinding.resize(mOwner_->mUniformBuffers_.size() + mOwner_->mTextureImages_.size());
+		layoutBinding.resize(mOwner_->mUniformBindings_.size() + mOwner_->mTextureImages_.size());
 
-		for (auto& uniformPair : mOwner_->mUniformBuffers_)
+		for (auto& uniformPair : mOwner_->mUniformBindings_)
 		{
 			VkDescriptorSetLayoutBinding& uboLayoutBinding = layoutBinding[uniformPair.first];
 			uboLayoutBinding.binding = uniformPair.first;
-			uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			uboLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
 			uboLayoutBinding.descriptorCount = 1;
-			uboLayoutBinding.stageFlags = uniformPair.second[0]->GetState();
+			uboLayoutBinding.stageFlags = uniformPair.second.Stages;
 			uboLayoutBinding.pImmutableSamplers = nullptr; // Optional
 		}
 
@@ -36,20 +40,241 @@ namespace zyh
 			samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 		}
 
+		mVkImpl_ = GDescriptorAllocator->AcquireLayout(layoutBinding);
+	}
+
+	void VulkanDescriptorLayout::cleanup()
+	{
+		// the allocator destroys the shared handle
+		mVkImpl_ = VK_NULL_HANDLE;
+	}
+
+	VulkanDescriptorAllocator::~VulkanDescriptorAllocator()
+	{
+		cleanup();
+	}
+
+	void VulkanDescriptorAllocator::setup(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice)
+	{
+		mLogicalDevice_ = logicalDevice;
+		if (!physicalDevice->isExtensionEnabled(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME))
+			return;
+		VkDevice device = mLogicalDevice_->Get();
+		mCreateUpdateTemplate_ = reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplateKHR>(vkGetDeviceProcAddr(device, "vkCreateDescriptorUpdateTemplateKHR"));
+		mDestroyUpdateTemplate_ = reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplateKHR>(vkGetDeviceProcAddr(device, "vkDestroyDescriptorUpdateTemplateKHR"));
+		mUpdateWithTemplate_ = reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplateKHR>(vkGetDeviceProcAddr(device, "vkUpdateDescriptorSetWithTemplateKHR"));
+		if (!mCreateUpdateTemplate_ || !mDestroyUpdateTemplate_ || !mUpdateWithTemplate_)
+		{
+			mCreateUpdateTemplate_ = nullptr;
+			mDestroyUpdateTemplate_ = nullptr;
+			mUpdateWithTemplate_ = nullptr;
+		}
+	}
+
+	void VulkanDescriptorAllocator::cleanup()
+	{
+		std::lock_guard<std::mutex> lock(mMutex_);
+		for (auto& pair : mLayouts_)
+		{
+			Layout& layout = pair.second;
+			for (VkDescriptorPool pool : layout.Pools)
+				vkDestroyDescriptorPool(mLogicalDevice_->Get(), pool, nullptr);
+			if (layout.UpdateTemplate != VK_NULL_HANDLE)
+				mDestroyUpdateTemplate_(mLogicalDevice_->Get(), layout.UpdateTemplate, nullptr);
+			vkDestroyDescriptorSetLayout(mLogicalDevice_->Get(), layout.Handle, nullptr);
+		}
+		mLayouts_.clear();
+		mLayoutsByHandle_.clear();
+		mPoolCount_ = 0;
+	}
+
+	VkDescriptorSetLayout VulkanDescriptorAllocator::AcquireLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings)
+	{
+		std::vector<VkDescriptorSetLayoutBinding> sorted = bindings;
+		std::sort(sorted.begin(), sorted.end(), [](const VkDescriptorSetLayoutBinding& a, const VkDescriptorSetLayoutBinding& b) { return a.binding < b.binding; });
+
+		std::string key;
+		for (const VkDescriptorSetLayoutBinding& binding : sorted)
+		{
+			HYBRID_CHECK(!binding.pImmutableSamplers, "immutable samplers are not part of the signature");
+			const uint32_t signature[] = { binding.binding, uint32_t(binding.descriptorType), binding.descriptorCount, uint32_t(binding.stageFlags) };
+			key.append(reinterpret_cast<const char*>(signature), sizeof(signature));
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex_);
+		Layout& layout = mLayouts_[key];
+		if (layout.Handle != VK_NULL_HANDLE)
+			return layout.Handle;
+
 		VkDescriptorSetLayoutCreateInfo layoutInfo{};
 		layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-		layoutInfo.bindingCount = static_cast<uint32_t>(layoutBinding.size());
-		layoutInfo.pBindings = layoutBinding.data();
+		layoutInfo.bindingCount = static_cast<uint32_t>(sorted.size());
+		layoutInfo.pBindings = sorted.data();
+		if (vkCreateDescriptorSetLayout(mLogicalDevice_->Get(), &layoutInfo, nullptr, &layout.Handle) != VK_SUCCESS)
+		{
+			mLayouts_.erase(key);
+			throw std::runtime_error("failed to create descriptor set layout!");
+		}
 
-		VK_CHECK_RESULT(
-			vkCreateDescriptorSetLayout(mVulkanLogicalDevice->Get(), &layoutInfo, nullptr, &mVkImpl_),
-			"failed to create descriptor set layout!"
-		);
+		for (const VkDescriptorSetLayoutBinding& binding : sorted)
+		{
+			layout.DescriptorCount += binding.descriptorCount;
+			auto sizeIter = std::find_if(layout.SetPoolSizes.begin(), layout.SetPoolSizes.end(),
+				[&](const VkDescriptorPoolSize& size) { return size.type == binding.descriptorType; });
+			if (sizeIter != layout.SetPoolSizes.end())
+				sizeIter->descriptorCount += binding.descriptorCount;
+			else
+				layout.SetPoolSizes.push_back(VkDescriptorPoolSize{ binding.descriptorType, binding.descriptorCount });
+		}
+		layout.Bindings = std::move(sorted);
+		layout.NextPoolSets = FIRST_POOL_SETS;
+		mLayoutsByHandle_[layout.Handle] = &layout;
+		return layout.Handle;
 	}
 
-	void VulkanDescriptorLayout::cleanup()
+	void VulkanDescriptorAllocator::Allocate(VkDescriptorSetLayout handle, uint32_t count, VkDescriptorSet* outSets)
+	{
+		std::lock_guard<std::mutex> lock(mMutex_);
+		Layout& layout = _GetLayout(handle);
+		HYBRID_CHECK(layout.DescriptorCount > 0, "a layout without bindings needs no sets");
+
+		uint32_t allocated = 0;
+		while (allocated < count && !layout.FreeList.empty())
+		{
+			outSets[allocated++] = layout.FreeList.back();
+			layout.FreeList.pop_back();
+		}
+		while (allocated < count)
+		{
+			if (!layout.FreeSets)
+				_AddPool(layout);
+			const uint32_t batch = std::min(count - allocated, layout.FreeSets);
+			std::vector<VkDescriptorSetLayout> layouts(batch, layout.Handle);
+
+			VkDescriptorSetAllocateInfo allocInfo{};
+			allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+			allocInfo.descriptorPool = layout.Pools.back();
+			allocInfo.descriptorSetCount = batch;
+			allocInfo.pSetLayouts = layouts.data();
+			if (vkAllocateDescriptorSets(mLogicalDevice_->Get(), &allocInfo, outSets + allocated) != VK_SUCCESS)
+				throw std::runtime_error("failed to allocate descriptor sets!");
+
+			layout.FreeSets -= batch;
+			allocated += batch;
+		}
+	}
+
+	void VulkanDescriptorAllocator::Free(VkDescriptorSetLayout handle, uint32_t count, const VkDescriptorSet* sets)
+	{
+		std::lock_guard<std::mutex> lock(mMutex_);
+		Layout& layout = _GetLayout(handle);
+		layout.FreeList.insert(layout.FreeList.end(), sets, sets + count);
+	}
+
+	void VulkanDescriptorAllocator::Write(VkDescriptorSetLayout handle, const VkDescriptorSet* sets, uint32_t count, const std::vector<VulkanDescriptorInfo>& infos)
+	{
+		std::unique_lock<std::mutex> lock(mMutex_);
+		Layout& layout = _GetLayout(handle);
+		HYBRID_CHECK(infos.size() == size_t(layout.DescriptorCount) * count);
+
+		if (mCreateUpdateTemplate_ && layout.UpdateTemplate == VK_NULL_HANDLE)
+		{
+			std::vector<VkDescriptorUpdateTemplateEntryKHR> entries;
+			size_t offset = 0;
+			for (const VkDescriptorSetLayoutBinding& binding : layout.Bindings)
+			{
+				VkDescriptorUpdateTemplateEntryKHR entry{};
+				entry.dstBinding = binding.binding;
+				entry.dstArrayElement = 0;
+				entry.descriptorCount = binding.descriptorCount;
+				entry.descriptorType = binding.descriptorType;
+				entry.offset = offset;
+				entry.stride = sizeof(VulkanDescriptorInfo);
+				entries.push_back(entry);
+				offset += sizeof(VulkanDescriptorInfo) * binding.descriptorCount;
+			}
+
+			VkDescriptorUpdateTemplateCreateInfoKHR templateInfo{};
+			templateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+			templateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+			templateInfo.pDescriptorUpdateEntries = entries.data();
+			templateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+			templateInfo.descriptorSetLayout = layout.Handle;
+			if (mCreateUpdateTemplate_(mLogicalDevice_->Get(), &templateInfo, nullptr, &layout.UpdateTemplate) != VK_SUCCESS)
+				layout.UpdateTemplate = VK_NULL_HANDLE;
+		}
+		const VkDescriptorUpdateTemplateKHR updateTemplate = layout.UpdateTemplate;
+		const std::vector<VkDescriptorSetLayoutBinding> bindings = layout.Bindings;
+		const uint32_t descriptorCount = layout.DescriptorCount;
+		lock.unlock();
+
+		if (updateTemplate != VK_NULL_HANDLE)
+		{
+			for (uint32_t i = 0; i < count; ++i)
+				mUpdateWithTemplate_(mLogicalDevice_->Get(), sets[i], updateTemplate, &infos[size_t(i) * descriptorCount]);
+			return;
+		}
+
+		// no template: still a single call for every binding of every set. arrays of descriptors point straight
+		// into infos, which only works because both info types fill the union exactly
+		static_assert(sizeof(VulkanDescriptorInfo) == sizeof(VkDescriptorBufferInfo) && sizeof(VulkanDescriptorInfo) == sizeof(VkDescriptorImageInfo));
+		std::vector<VkWriteDescriptorSet> writes;
+		writes.reserve(bindings.size() * count);
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			size_t infoIndex = size_t(i) * descriptorCount;
+			for (const VkDescriptorSetLayoutBinding& binding : bindings)
+			{
+				VkWriteDescriptorSet write{};
+				write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				write.dstSet = sets[i];
+				write.dstBinding = binding.binding;
+				write.dstArrayElement = 0;
+				write.descriptorCount = binding.descriptorCount;
+				write.descriptorType = binding.descriptorType;
+				if (binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER || binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER
+					|| binding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC || binding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC)
+				{
+					write.pBufferInfo = &infos[infoIndex].Buffer;
+				}
+				else
+				{
+					write.pImageInfo = &infos[infoIndex].Image;
+				}
+				writes.push_back(write);
+				infoIndex += binding.descriptorCount;
+			}
+		}
+		vkUpdateDescriptorSets(mLogicalDevice_->Get(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+	}
+
+	void VulkanDescriptorAllocator::_AddPool(Layout& layout)
+	{
+		std::vector<VkDescriptorPoolSize> poolSizes = layout.SetPoolSizes;
+		for (VkDescriptorPoolSize& size : poolSizes)
+			size.descriptorCount *= layout.NextPoolSets;
+
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+		poolInfo.pPoolSizes = poolSizes.data();
+		poolInfo.maxSets = layout.NextPoolSets;
+
+		VkDescriptorPool pool = VK_NULL_HANDLE;
+		if (vkCreateDescriptorPool(mLogicalDevice_->Get(), &poolInfo, nullptr, &pool) != VK_SUCCESS)
+			throw std::runtime_error("failed to create descriptor pool!");
+
+		layout.Pools.push_back(pool);
+		layout.FreeSets = layout.NextPoolSets;
+		layout.NextPoolSets = std::min(layout.NextPoolSets * 2, MAX_POOL_SETS);
+		++mPoolCount_;
+	}
+
+	VulkanDescriptorAllocator::Layout& VulkanDescriptorAllocator::_GetLayout(VkDescriptorSetLayout handle)
 	{
-		vkDestroyDescriptorSetLayout(mVulkanLogicalDevice->Get(), mVkImpl_, nullptr);
+		auto iter = mLayoutsByHandle_.find(handle);
+		HYBRID_CHECK(iter != mLayoutsByHandle_.end(), "layout was not made by the allocator");
+		return *iter->second;
 	}
 
 }
@@ -1,12 +1,17 @@
+#pragma once
 #include "Common/Config.h"
 #include "VulkanObject.h"
+#include <mutex>
+#include <unordered_map>
 
 
 namespace zyh
 {
 	class VulkanMaterial;
+	class VulkanPhysicalDevice;
 	class VulkanLogicalDevice;
 
+	// handle is owned by GDescriptorAllocator and shared with every layout of the same bindings
 	class VulkanDescriptorLayout : public TVulkanObject<VkDescriptorSetLayout>
 	{
 	public:
@@ -24,4 +29,77 @@ namespace zyh
 	protected:
 		VulkanMaterial* mOwner_;
 	};
+
+
+	// one descriptor of a write, VkDescriptorBufferInfo and VkDescriptorImageInfo share the slot so
+	// an update template walks the array with a single stride
+	union VulkanDescriptorInfo
+	{
+		VkDescriptorBufferInfo Buffer;
+		VkDescriptorImageInfo Image;
+	};
+
+	// set layouts deduplicated by binding signature, and sets allocated from pools shared by every user of a layout.
+	// a layout's pools are sized to its bindings and grow geometrically, so the pool count stays flat with the set count
+	class VulkanDescriptorAllocator
+	{
+	public:
+		~VulkanDescriptorAllocator();
+
+		void setup(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice);
+		// after the pipelines using the layouts are gone
+		void cleanup();
+
+		// the same bindings in any order give the same handle, owned by the allocator
+		VkDescriptorSetLayout AcquireLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings);
+		// freed sets of the layout are handed out again before new ones are allocated
+		void Allocate(VkDescriptorSetLayout layout, uint32_t count, VkDescriptorSet* outSets);
+		// returns sets to the layout's free list, no frame in flight may still use them
+		void Free(VkDescriptorSetLayout layout, uint32_t count, const VkDescriptorSet* sets);
+		// writes every descriptor of count sets in one call. infos has one entry per descriptor of a set,
+		// ordered by binding, for each set in turn
+		void Write(VkDescriptorSetLayout layout, const VkDescriptorSet* sets, uint32_t count, const std::vector<VulkanDescriptorInfo>& infos);
+
+		size_t GetLayoutCount() const { return mLayouts_.size(); }
+		size_t GetPoolCount() const { return mPoolCount_; }
+		bool HasUpdateTemplates() const { return mCreateUpdateTemplate_ != nullptr; }
+
+	private:
+		struct Layout
+		{
+			VkDescriptorSetLayout Handle{ VK_NULL_HANDLE };
+			// sorted by binding
+			std::vector<VkDescriptorSetLayoutBinding> Bindings;
+			uint32_t DescriptorCount{ 0 };
+			// descriptors of one set, by type
+			std::vector<VkDescriptorPoolSize> SetPoolSizes;
+			std::vector<VkDescriptorPool> Pools;
+			uint32_t FreeSets{ 0 };
+			// freed by their users, reused as is since the pools are not created with FREE_DESCRIPTOR_SET_BIT
+			std::vector<VkDescriptorSet> FreeList;
+			uint32_t NextPoolSets{ 0 };
+			VkDescriptorUpdateTemplateKHR UpdateTemplate{ VK_NULL_HANDLE };
+		};
+
+		static constexpr uint32_t FIRST_POOL_SETS = 64;
+		static constexpr uint32_t MAX_POOL_SETS = 4096;
+
+		void _AddPool(Layout& layout);
+		Layout& _GetLayout(VkDescriptorSetLayout handle);
+
+	private:
+		VulkanLogicalDevice* mLogicalDevice_{ nullptr };
+		std::mutex mMutex_;
+		// keyed by the binding signature
+		std::unordered_map<std::string, Layout> mLayouts_;
+		std::unordered_map<VkDescriptorSetLayout, Layout*> mLayoutsByHandle_;
+		size_t mPoolCount_{ 0 };
+
+		// VK_KHR_descriptor_update_template, null when the device lacks it
+		PFN_vkCreateDescriptorUpdateTemplateKHR mCreateUpdateTemplate_{ nullptr };
+		PFN_vkDestroyDescriptorUpdateTemplateKHR mDestroyUpdateTemplate_{ nullptr };
+		PFN_vkUpdateDescriptorSetWithTemplateKHR mUpdateWithTemplate_{ nullptr };
+	};
+
+	extern VulkanDescriptorAllocator* GDescriptorAllocator;
 }
\ No newline at end of file
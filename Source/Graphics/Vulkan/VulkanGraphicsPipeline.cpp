@@ -11,22 +11,34 @@
 
 namespace zyh
 {
-	void VulkanGraphicsPipelineBase::connect(VulkanLogicalDevice* logicalDevice)
+	void VulkanGraphicsPipelineBase::connect(VulkanLogicalDevice* logicalDevice, VkPipelineCache pipelineCache)
 	{
 		mVulkanLogicalDevice = logicalDevice;
+		mVkPipelineCache_ = pipelineCache;
 	}
 
 	void VulkanGraphicsPipelineBase::setup()
 	{
 		// only create pipeline cache, concrete setup will be done at child object
+		if (mVkPipelineCache_ != VK_NULL_HANDLE)
+			return;
+		mOwnsPipelineCache_ = true;
 		VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
 		pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
 		VK_CHECK_RESULT(vkCreatePipelineCache(mVulkanLogicalDevice->Get(), &pipelineCacheCreateInfo, nullptr, &mVkPipelineCache_));
 	}
 
-	void VulkanGraphicsPipeline::connect(VulkanLogicalDevice* logicalDevice)
+	void VulkanGraphicsPipelineBase::cleanup()
 	{
-		VulkanGraphicsPipelineBase::connect(logicalDevice);
+		if (mOwnsPipelineCache_)
+			vkDestroyPipelineCache(mVulkanLogicalDevice->Get(), mVkPipelineCache_, nullptr);
+		mVkPipelineCache_ = VK_NULL_HANDLE;
+		mOwnsPipelineCache_ = false;
+	}
+
+	void VulkanGraphicsPipeline::connect(VulkanLogicalDevice* logicalDevice, VkPipelineCache pipelineCache)
+	{
+		VulkanGraphicsPipelineBase::connect(logicalDevice, pipelineCache);
 	}
 
 	void VulkanGraphicsPipeline::setup()
@@ -39,6 +51,7 @@ namespace zyh
 	{
 		vkDestroyPipeline(mVulkanLogicalDevice->Get(), mVkImpl_, nullptr);
 		vkDestroyPipelineLayout(mVulkanLogicalDevice->Get(), mVkPipelineLayout_, nullptr);
+		VulkanGraphicsPipelineBase::cleanup();
 	}
 
 	void VulkanGraphicsPipeline::_setupGraphicsPipeline()
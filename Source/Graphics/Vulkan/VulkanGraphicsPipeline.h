@@ -10,14 +10,17 @@ namespace zyh
 	class VulkanGraphicsPipelineBase : public TVulkanObject<VkPipeline>
 	{
 	public:
-		virtual void connect(VulkanLogicalDevice* logicalDevice);
+		// a shared pipelineCache is used as is, otherwise the pipeline makes its own
+		virtual void connect(VulkanLogicalDevice* logicalDevice, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
 		virtual void setup();
+		virtual void cleanup() override;
 
 	protected:
 		VulkanLogicalDevice* mVulkanLogicalDevice;
 
 	protected:
-		VkPipelineCache mVkPipelineCache_;
+		VkPipelineCache mVkPipelineCache_{ VK_NULL_HANDLE };
+		bool mOwnsPipelineCache_{ false };
 	};
 
 
@@ -29,7 +32,7 @@ namespace zyh
 		}
 
 	public:
-		virtual void connect(VulkanLogicalDevice* logicalDevice);
+		virtual void connect(VulkanLogicalDevice* logicalDevice, VkPipelineCache pipelineCache = VK_NULL_HANDLE);
 		virtual void setup();
 		virtual void cleanup() override;
 
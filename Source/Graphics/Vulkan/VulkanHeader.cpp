@@ -24,7 +24,7 @@ namespace zyh
 {
 	namespace Convert
 	{
-		VkSampleCountFlagBits Convert::Quality2SamplerCount(const ESamplerQuality quality)
+		VkSampleCountFlagBits Quality2SamplerCount(const ESamplerQuality quality)
 		{
 			switch (quality)
 			{
@@ -71,7 +71,7 @@ namespace zyh
 			case RenderTarget::ELoadOp::LOAD:
 				return VK_ATTACHMENT_LOAD_OP_LOAD;
 			case RenderTarget::ELoadOp::CLEAR:
-				return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+				return VK_ATTACHMENT_LOAD_OP_CLEAR;
 			case RenderTarget::ELoadOp::DONT_CARE:
 				return VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 			default:
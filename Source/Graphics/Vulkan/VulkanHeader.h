@@ -15,11 +15,15 @@
 #include <fstream>
 #include <chrono>
 
+#if defined(_WIN32)
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif
 #include <vulkan/vulkan.h>
 
 #define GLFW_INCLUDE_VULKAN
+#if defined(_MSC_VER)
 #pragma warning (disable : 4005)
+#endif
 #include <GLFW/glfw3.h>
 
 #define GLM_FORCE_RADIANS
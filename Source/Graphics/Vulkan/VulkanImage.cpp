@@ -32,7 +32,8 @@ namespace zyh
 	{
 		vkDestroyImageView(mVulkanLogicalDevice_->Get(), mVkImpl_.view, nullptr);
 		vkDestroyImage(mVulkanLogicalDevice_->Get(), mVkImpl_.image, nullptr);
-		vkFreeMemory(mVulkanLogicalDevice_->Get(), mVkImpl_.mem, nullptr);
+		if (mOwnsMemory_)
+			vkFreeMemory(mVulkanLogicalDevice_->Get(), mVkImpl_.mem, nullptr);
 		
 		mVkImpl_.view = VK_NULL_HANDLE;
 		mVkImpl_.image = VK_NULL_HANDLE;
@@ -47,10 +48,34 @@ namespace zyh
 		_setupImageView(aspectFlags);
 	}
 
-	void VulkanImage::_setupImage(
+	void VulkanImage::setupUnbound(
 		uint32_t width, uint32_t height, uint32_t mipLevels,
 		VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling,
-		VkImageUsageFlags usage, VkMemoryPropertyFlags properties
+		VkImageUsageFlags usage
+	)
+	{
+		_createImage(width, height, mipLevels, numSamples, format, tiling, usage);
+	}
+
+	VkMemoryRequirements VulkanImage::getMemoryRequirements()
+	{
+		VkMemoryRequirements memRequirements;
+		vkGetImageMemoryRequirements(mVulkanLogicalDevice_->Get(), mVkImpl_.image, &memRequirements);
+		return memRequirements;
+	}
+
+	void VulkanImage::bindMemory(VkDeviceMemory memory, VkDeviceSize offset, VkImageAspectFlags aspectFlags)
+	{
+		mVkImpl_.mem = memory;
+		mOwnsMemory_ = false;
+		VK_CHECK_RESULT(vkBindImageMemory(mVulkanLogicalDevice_->Get(), mVkImpl_.image, memory, offset), "failed to bind image memory!");
+		_setupImageView(aspectFlags);
+	}
+
+	void VulkanImage::_createImage(
+		uint32_t width, uint32_t height, uint32_t mipLevels,
+		VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling,
+		VkImageUsageFlags usage
 	)
 	{
 		// save properties
@@ -78,6 +103,15 @@ namespace zyh
 		if (vkCreateImage(mVulkanLogicalDevice_->Get(), &imageInfo, nullptr, &mVkImpl_.image) != VK_SUCCESS) {
 			throw std::runtime_error("failed to create image!");
 		}
+	}
+
+	void VulkanImage::_setupImage(
+		uint32_t width, uint32_t height, uint32_t mipLevels,
+		VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling,
+		VkImageUsageFlags usage, VkMemoryPropertyFlags properties
+	)
+	{
+		_createImage(width, height, mipLevels, numSamples, format, tiling, usage);
 
 		VkMemoryRequirements memRequirements;
 		vkGetImageMemoryRequirements(mVulkanLogicalDevice_->Get(), mVkImpl_.image, &memRequirements);
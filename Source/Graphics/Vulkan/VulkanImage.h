@@ -29,6 +29,15 @@ namespace zyh
 		);
 		virtual void cleanup() override;
 
+		// image without memory: bindMemory() later places it in memory owned by someone else
+		void setupUnbound(
+			uint32_t width, uint32_t height, uint32_t mipLevels,
+			VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling,
+			VkImageUsageFlags usage
+		);
+		VkMemoryRequirements getMemoryRequirements();
+		void bindMemory(VkDeviceMemory memory, VkDeviceSize offset, VkImageAspectFlags aspectFlags);
+
 	public:
 		void createImageView(VkImage& image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
 		
@@ -47,8 +56,15 @@ namespace zyh
 		uint32_t mTexHeight_{ 0 };
 		uint32_t mMipLevels_{ 0 };
 		VkFormat mFormat_;
+		// false when bound to shared memory, which is freed by its owner
+		bool mOwnsMemory_{ true };
 
 	protected:
+		void _createImage(
+			uint32_t width, uint32_t height, uint32_t mipLevels,
+			VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling,
+			VkImageUsageFlags usage
+		);
 		virtual void _setupImage(
 			uint32_t width, uint32_t height, uint32_t mipLevels,
 			VkSampleCountFlagBits numSamples, VkFormat format, VkImageTiling tiling,
@@ -49,10 +49,15 @@ namespace zyh
 
 	const std::vector<const char*> VulkanInstance::_getRequiredExtensions()
 	{
-		std::vector<const char*> extensions = { VK_KHR_SURFACE_EXTENSION_NAME };
+		std::vector<const char*> extensions;
+		// headless needs no surface, so it also runs on drivers without a WSI (e.g. lavapipe on a server)
+		if (!Setting::IsHeadless)
+		{
+			extensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
 #if defined(_WIN32)
-		extensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
+			extensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
 #endif
+		}
 
 		if (mEnableValidationLayers_) {
 			extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
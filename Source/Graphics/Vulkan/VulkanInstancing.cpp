@@ -0,0 +1,142 @@
+#include "VulkanInstancing.h"
+#include <filesystem>
+
+
+namespace zyh
+{
+	VulkanInstancedRenderElement::VulkanInstancedRenderElement(IMaterial* material, VulkanMaterial* vulkanMaterial, VulkanMeshCache::Mesh* mesh)
+		: VulkanRenderElement(vulkanMaterial)
+		, mInstancedMaterial_(material)
+	{
+		mSharedMesh_ = mesh;
+		mInstanceBuffers_.resize(*GInstance->mImageCount_, nullptr);
+	}
+
+	VulkanInstancedRenderElement::~VulkanInstancedRenderElement()
+	{
+		for (VulkanBuffer* buffer : mInstanceBuffers_)
+			SafeDestroy(buffer);
+		mInstanceBuffers_.clear();
+		cleanup();
+		SafeDestroy(mInstancedMaterial_);
+	}
+
+	void VulkanInstancedRenderElement::SetSource(const IMaterial* material, RenderSet renderSet)
+	{
+		mSourceVertexShader_ = material->GetShaderPath(EShaderType::VS, renderSet);
+		mSourceFragmentShader_ = material->GetShaderPath(EShaderType::PS, renderSet);
+		mSourcePipelineState_ = material->GetPipelineState();
+		mSourceTextures_ = material->GetTextures();
+	}
+
+	bool VulkanInstancedRenderElement::IsCompatible(const IMaterial* material, RenderSet renderSet) const
+	{
+		return mMaterial_->getRenderSet() == renderSet
+			&& material->GetShaderPath(EShaderType::VS, renderSet) == mSourceVertexShader_
+			&& material->GetShaderPath(EShaderType::PS, renderSet) == mSourceFragmentShader_
+			&& material->GetPipelineState() == mSourcePipelineState_
+			&& material->GetTextures() == mSourceTextures_;
+	}
+
+	void VulkanInstancedRenderElement::prepare(size_t currentImage, const RenderSnapshot& snapshot)
+	{
+		PackInstances();
+
+		const VkDeviceSize size = mInstances_.size() * sizeof(InstanceData);
+		VulkanBuffer*& buffer = mInstanceBuffers_[currentImage];
+		if (!buffer || buffer->GetBufferSize() < size)
+		{
+			const VkDeviceSize capacity = buffer ? Max(size, buffer->GetBufferSize() * 2) : size;
+			SafeDestroy(buffer);
+			buffer = new VulkanBuffer();
+			buffer->connect(mVulkanPhysicalDevice_, mVulkanLogicalDevice_);
+			buffer->setup(capacity, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		}
+		buffer->setupData(mInstances_.data(), size);
+
+		// the instanced shader takes the model matrix from the instance stream
+		updateUniformBuffer(currentImage, snapshot, Matrix4x3());
+	}
+
+	void VulkanInstancedRenderElement::draw(VkCommandBuffer commandBuffer, size_t currImage, VulkanDrawState& state)
+	{
+		_bindState(commandBuffer, currImage, state);
+
+		VkBuffer instanceBuffer = mInstanceBuffers_[currImage]->Get().buffer;
+		VkDeviceSize offsets[] = { 0 };
+		vkCmdBindVertexBuffers(commandBuffer, InstanceData::BINDING, 1, &instanceBuffer, offsets);
+		++state.Stats.VertexBufferBinds;
+
+		const uint32_t instanceCount = static_cast<uint32_t>(mInstances_.size());
+		vkCmdDrawIndexed(commandBuffer, mSharedMesh_->IndexCount, instanceCount, 0, 0, 0);
+		++state.Stats.Draws;
+		++state.Stats.InstancedDraws;
+		state.Stats.Instances += instanceCount;
+	}
+
+	VulkanInstancer::VulkanInstancer(VulkanRenderPass* renderPass)
+		: mRenderPass_(renderPass)
+	{
+		// the instanced shader is built by Resource/shaders/compile.bat, without it every element draws on its own
+		mIsSupported_ = std::filesystem::exists(INSTANCED_VERTEX_SHADER);
+	}
+
+	VulkanInstancer::~VulkanInstancer()
+	{
+		mBatcher_.ReleaseAll([](VulkanInstancedRenderElement* batch) { SafeDestroy(batch); });
+	}
+
+	void VulkanInstancer::Begin()
+	{
+		mBatcher_.Begin();
+	}
+
+	bool VulkanInstancer::Add(const VulkanDrawEntry& entry)
+	{
+		if (!mIsSupported_)
+			return false;
+		VulkanInstancedRenderElement* batch = _GetBatch(entry.Element);
+		if (!batch)
+			return false;
+		mBatcher_.Add(batch, entry);
+		return true;
+	}
+
+	void VulkanInstancer::End(size_t currentImage, const RenderSnapshot& snapshot, std::vector<VulkanDrawEntry>& entries)
+	{
+		mBatcher_.End(INSTANCING_MIN_COUNT, entries, [&](VulkanInstancedRenderElement* batch)
+			{
+				batch->prepare(currentImage, snapshot);
+				entries.push_back(VulkanDrawEntry{ batch, nullptr, batch->GetSetOrder() });
+			});
+		// its instance buffers and descriptor sets may still be read by frames in flight
+		mBatcher_.ReleaseIdle(BATCH_RELEASE_FRAMES, [](VulkanInstancedRenderElement* batch)
+			{
+				GVulkanInstance->Retire([batch]() mutable { SafeDestroy(batch); });
+			});
+	}
+
+	VulkanInstancedRenderElement* VulkanInstancer::_GetBatch(VulkanRenderElement* element)
+	{
+		VulkanMeshCache::Mesh* mesh = element->getSharedMesh();
+		VulkanMaterial* material = element->mMaterial_;
+		if (!mesh || !material->mPrim_)
+			return nullptr;
+		const IMaterial* source = material->getMaterial();
+		const RenderSet renderSet = material->getRenderSet();
+		if (source->GetShaderPath(EShaderType::VS, renderSet) != DEFAULT_VERTEX_SHADER)
+			return nullptr;
+
+		return mBatcher_.GetBatch(mesh, [&]()
+			{
+				IMaterial* instancedMaterial = new IMaterial(INSTANCED_VERTEX_SHADER, source->GetShaderPath(EShaderType::PS, renderSet), renderSet);
+				instancedMaterial->GetPipelineState() = source->GetPipelineState();
+				instancedMaterial->SetTextures(source->GetTextures());
+				VulkanMaterial* vulkanMaterial = new VulkanInstancedMaterial(instancedMaterial, renderSet, material->mPrim_);
+				VulkanInstancedRenderElement* batch = new VulkanInstancedRenderElement(instancedMaterial, vulkanMaterial, GMeshCache->Acquire(material->mPrim_));
+				batch->SetSource(source, renderSet);
+				batch->setupState(mRenderPass_);
+				return batch;
+			}, source, renderSet);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+#include "VulkanRenderElement.h"
+#include "VulkanRenderPass.h"
+#include "Graphics/Common/InstanceBatcher.h"
+
+
+namespace zyh
+{
+	// one instanced draw for the visible elements of a shared mesh / material combination,
+	// their world matrices are packed into a per image instance buffer every frame
+	class VulkanInstancedRenderElement : public VulkanRenderElement, public InstanceBatch<VulkanDrawEntry, InstanceData>
+	{
+	public:
+		VulkanInstancedRenderElement(IMaterial* material, VulkanMaterial* vulkanMaterial, VulkanMeshCache::Mesh* mesh);
+		virtual ~VulkanInstancedRenderElement();
+
+	public:
+		// elements whose material matches the source one (shaders, pipeline state and textures) are drawn by this batch
+		void SetSource(const IMaterial* material, RenderSet renderSet);
+		bool IsCompatible(const IMaterial* material, RenderSet renderSet) const;
+
+		// camera / lights into the uniforms and the world matrices into this image's instance buffer
+		void prepare(size_t currentImage, const RenderSnapshot& snapshot);
+		virtual void draw(VkCommandBuffer commandBuffer, size_t currImage, VulkanDrawState& state) override;
+
+	private:
+		IMaterial* mInstancedMaterial_;
+		std::string mSourceVertexShader_;
+		std::string mSourceFragmentShader_;
+		IPipelineState mSourcePipelineState_;
+		std::map<uint32_t, std::string> mSourceTextures_;
+
+		// per image, grown to the largest instance count seen
+		std::vector<VulkanBuffer*> mInstanceBuffers_;
+	};
+
+	// groups the items of a pass that share mesh and material into instanced batches, owned by VulkanRenderPass.
+	// batches are created on first use and released once they stay empty for BATCH_RELEASE_FRAMES
+	class VulkanInstancer
+	{
+	public:
+		static constexpr size_t INSTANCING_MIN_COUNT = 2;
+		static constexpr uint32_t BATCH_RELEASE_FRAMES = 120;
+		// only primitives drawn by the default shader are instanced, with its instanced variant
+		static constexpr const char* DEFAULT_VERTEX_SHADER = "Resource/shaders/vert.spv";
+		static constexpr const char* INSTANCED_VERTEX_SHADER = "Resource/shaders/instanced.vert.spv";
+
+	public:
+		explicit VulkanInstancer(VulkanRenderPass* renderPass);
+		~VulkanInstancer();
+
+		void Begin();
+		// false if the entry has to be drawn on its own
+		bool Add(const VulkanDrawEntry& entry);
+		// appends a draw entry per batch of at least INSTANCING_MIN_COUNT, the members of smaller ones are drawn on their own
+		void End(size_t currentImage, const RenderSnapshot& snapshot, std::vector<VulkanDrawEntry>& entries);
+
+	private:
+		VulkanInstancedRenderElement* _GetBatch(VulkanRenderElement* element);
+
+	private:
+		VulkanRenderPass* mRenderPass_;
+		bool mIsSupported_;
+		InstanceBatcher<VulkanMeshCache::Mesh*, VulkanInstancedRenderElement> mBatcher_;
+	};
+}
\ No newline at end of file
@@ -13,7 +13,8 @@
 #include "VulkanDescriptor.h"
 #include "Math/Matrix4x4.h"
 #include "VulkanRenderPass.h"
-#include "VulkanSwapchain.h"
+#include "VulkanSwapChain.h"
+#include "VulkanUniformRing.h"
 
 #include "Graphics/Imgui/imgui.h"
 #include "Graphics/Imgui/imgui_impl_vulkan.h"
@@ -26,8 +27,6 @@ namespace zyh
 	{
 		mMaterial_ = material;
 		mRenderSet_ = renderSet;
-		mGraphicsPipeline_ = new VulkanGraphicsPipeline(this);
-		mDescriptorLayout_ = new VulkanDescriptorLayout(this);
 	}
 
 	VulkanMaterial::VulkanMaterial(IPrimitive* prim, RenderSet renderSet)
@@ -36,35 +35,49 @@ namespace zyh
 		mPrim_ = prim;
 	}
 
+	VulkanMaterial::~VulkanMaterial()
+	{
+		// the layout handle belongs to the allocator and outlives the pipeline state
+		if (!mDescriptorSets_.empty())
+			GDescriptorAllocator->Free(mDescriptorLayout_->Get(), static_cast<uint32_t>(mDescriptorSets_.size()), mDescriptorSets_.data());
+		mDescriptorSets_.clear();
+		GPipelineCache->Release(mPipelineState_);
+		mPipelineState_ = nullptr;
+	}
+
 	void VulkanMaterial::connect(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice, uint32_t layoutCount)
 	{
 		mPhysicalDevice_ = physicalDevice;
 		mLogicalDevice_ = logicalDevice;
 		mLayoutCount_ = layoutCount;
-		mGraphicsPipeline_->connect(mLogicalDevice_);
-		mDescriptorLayout_->connect(mLogicalDevice_);
 	}
 
 	void VulkanMaterial::setup()
 	{
-		createDescriptorSetData();
-		createDescriptorLayout();
+		if (mPipelineState_ && mPipelineRenderPass_ == mRenderPass_)
+			return;
+
+		const bool firstSetup = !mPipelineState_;
+		if (firstSetup)
+			createDescriptorSetData();
 		createGraphicsPipeline();
-		if (mUniformBuffers_.size() + mTextureImages_.size() > 0)
+		// layouts with the same bindings are compatible, the sets outlive a render pass change
+		if (firstSetup && mUniformBindings_.size() + mTextureImages_.size() > 0)
 		{
-			createDesciptorPool();
+			mDynamicOffsets_.assign(mLayoutCount_, std::vector<uint32_t>(mUniformBindings_.size(), 0));
 			createDescriptorSets();
 		}
 	}
 
 	void VulkanMaterial::createGraphicsPipeline()
 	{
-		mGraphicsPipeline_->setup();
-	}
-
-	void VulkanMaterial::createDescriptorLayout()
-	{
-		mDescriptorLayout_->setup();
+		// acquired before the old one is released, a pipeline still shared by both isn't rebuilt
+		VulkanPipelineCache::PipelineState* state = GPipelineCache->Acquire(this);
+		GPipelineCache->Release(mPipelineState_);
+		mPipelineState_ = state;
+		mGraphicsPipeline_ = state->Pipeline;
+		mDescriptorLayout_ = state->DescriptorLayout;
+		mPipelineRenderPass_ = mRenderPass_;
 	}
 
 	void VulkanMaterial::createDescriptorSetData()
@@ -113,28 +126,17 @@ namespace zyh
 					if (type == EUniformType::NONE)
 						continue;
 
-					if (mUniformBuffers_.find(binding) != mUniformBuffers_.end())
-					{
-						HYBRID_CHECK(mUniformBuffers_.at(binding)[0]->GetBufferSize() == desc.Block.Uniform.Size);
-						for (size_t i = 0; i < mLayoutCount_; ++i)
-						{
-							mUniformBuffers_.at(binding)[i]->AddState(stateBit);
-						}
-					}
-					std::vector<VulkanUniformBuffer*> uniformBuffers;
-					uniformBuffers.resize(mLayoutCount_);
-					for (auto& uniformBuffer : uniformBuffers)
-					{
-						uniformBuffer = new VulkanUniformBuffer(type, stateBit);
-						uniformBuffer->connect(mPhysicalDevice_, mLogicalDevice_);
-						uniformBuffer->setup(desc.Block.Uniform.Size, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-					}
-					mUniformBuffers_[binding] = std::move(uniformBuffers);
+					// a block both stages use is one binding visible to both
+					VulkanUniformBinding& uniform = mUniformBindings_[binding];
+					HYBRID_CHECK(!uniform.Size || uniform.Size == desc.Block.Uniform.Size);
+					uniform.Type = type;
+					uniform.Size = desc.Block.Uniform.Size;
+					uniform.Stages |= stateBit;
 				}
 
 				if (desc.Type == EDescriptorType::SAMPLER)
 				{
-					VulkanTextureImage* baseTextureImage_ = new VulkanTextureImage("Resource/textures/viking_room.png");
+					VulkanTextureImage* baseTextureImage_ = new VulkanTextureImage(mMaterial_->GetTexturePath(binding));
 					baseTextureImage_->connect(mPhysicalDevice_, mLogicalDevice_, GVulkanInstance->mGraphicsCommandPool_);
 					baseTextureImage_->setup(VK_SAMPLE_COUNT_1_BIT, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_TILING_OPTIMAL,
 						VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
@@ -147,96 +149,41 @@ namespace zyh
 		}
 	}
 
-	void VulkanMaterial::createDesciptorPool()
-	{
-		std::vector<VkDescriptorPoolSize> poolSizes;
-		poolSizes.resize(mUniformBuffers_.size() + mTextureImages_.size());
-
-		for (auto& uniformPair : mUniformBuffers_)
-		{
-			VkDescriptorPoolSize& poolSize = poolSizes[uniformPair.first];
-			poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-			poolSize.descriptorCount = static_cast<uint32_t>(mLayoutCount_);
-		}
-
-		for (auto& texturePair : mTextureImages_)
-		{
-			VkDescriptorPoolSize& poolSize = poolSizes[texturePair.first];
-			poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-			poolSize.descriptorCount = static_cast<uint32_t>(mLayoutCount_);
-		}
-
-		VkDescriptorPoolCreateInfo poolInfo{};
-		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-		poolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
-		poolInfo.pPoolSizes = poolSizes.data();
-		poolInfo.maxSets = static_cast<uint32_t>(mLayoutCount_);
-
-		VK_CHECK_RESULT(vkCreateDescriptorPool(mLogicalDevice_->Get(), &poolInfo, nullptr, &mDescriptorPool_), "failed to create descriptor pool!");
-	}
-
 	void VulkanMaterial::createDescriptorSets()
 	{
-		std::vector<VkDescriptorSetLayout> layouts(mLayoutCount_, mDescriptorLayout_->Get());
-
-		VkDescriptorSetAllocateInfo allocInfo{};
-		allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-		allocInfo.descriptorPool = mDescriptorPool_;
-		allocInfo.descriptorSetCount = mLayoutCount_;
-		allocInfo.pSetLayouts = layouts.data();
-
 		mDescriptorSets_.resize(mLayoutCount_);
-		VK_CHECK_RESULT(vkAllocateDescriptorSets(mLogicalDevice_->Get(), &allocInfo, mDescriptorSets_.data()), "failed to allocate descriptor sets!");
-
-		for (size_t i = 0; i < mDescriptorSets_.size(); i++) {
-			DEBUG_RUN(std::set<uint32_t> debugBindingSet;)
-			std::vector<VkWriteDescriptorSet> descriptorWrites;
-			descriptorWrites.resize(mUniformBuffers_.size() + mTextureImages_.size());
-			VkWriteDescriptorSet writeInfo{};
-			for (auto& uniformPair : mUniformBuffers_)
+		GDescriptorAllocator->Allocate(mDescriptorLayout_->Get(), mLayoutCount_, mDescriptorSets_.data());
+
+		// ordered by binding like the layout, one image after another
+		std::vector<VulkanDescriptorInfo> infos;
+		infos.reserve((mUniformBindings_.size() + mTextureImages_.size()) * mDescriptorSets_.size());
+		for (size_t i = 0; i < mDescriptorSets_.size(); i++)
+		{
+			std::map<uint32_t, VulkanDescriptorInfo> bindingInfos;
+			// each image reads its own ring segment, the dynamic offset picks the object inside
+			VulkanUniformRing* uniformRing = GVulkanInstance->mUniformRing_;
+			for (auto& uniformPair : mUniformBindings_)
 			{
-				uint32_t binding = uniformPair.first;
-				VulkanBuffer* vulkanBuffer = uniformPair.second[i];
-				DEBUG_RUN(HYBRID_CHECK(debugBindingSet.find(binding) == debugBindingSet.end());)
-
-				VkDescriptorBufferInfo bufferInfo{};
-				bufferInfo.buffer = vulkanBuffer->Get().buffer;
-				bufferInfo.offset = 0;
-				bufferInfo.range = vulkanBuffer->GetBufferSize();
-
-				writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				writeInfo.dstSet = mDescriptorSets_[i];
-				writeInfo.dstBinding = binding;
-				writeInfo.dstArrayElement = 0;
-				writeInfo.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-				writeInfo.descriptorCount = 1;
-				writeInfo.pBufferInfo = &bufferInfo;
-				vkUpdateDescriptorSets(mLogicalDevice_->Get(), 1, &writeInfo, 0, nullptr);
-				DEBUG_RUN(debugBindingSet.insert(binding);)
+				VulkanDescriptorInfo& info = bindingInfos[uniformPair.first];
+				info.Buffer.buffer = uniformRing->GetBuffer();
+				info.Buffer.offset = uniformRing->GetSegmentOffset(i);
+				info.Buffer.range = uniformPair.second.Size;
 			}
 
 			for (auto& texturePair : mTextureImages_)
 			{
-				uint32_t binding = texturePair.first;
 				VulkanTextureImage* image = static_cast<VulkanTextureImage*>(texturePair.second);
-				DEBUG_RUN(HYBRID_CHECK(debugBindingSet.find(binding) == debugBindingSet.end());)
-
-				VkDescriptorImageInfo imageInfo{};
-				imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-				imageInfo.imageView = image->Get().view;
-				imageInfo.sampler = image->getTextureSampler();
-
-				writeInfo.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-				writeInfo.dstSet = mDescriptorSets_[i];
-				writeInfo.dstBinding = binding;
-				writeInfo.dstArrayElement = 0;
-				writeInfo.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-				writeInfo.descriptorCount = 1;
-				writeInfo.pImageInfo = &imageInfo;
-				vkUpdateDescriptorSets(mLogicalDevice_->Get(), 1, &writeInfo, 0, nullptr);
-				DEBUG_RUN(debugBindingSet.insert(binding);)
+				HYBRID_CHECK(bindingInfos.find(texturePair.first) == bindingInfos.end());
+				VulkanDescriptorInfo& info = bindingInfos[texturePair.first];
+				info.Image.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+				info.Image.imageView = image->Get().view;
+				info.Image.sampler = image->getTextureSampler();
 			}
+
+			for (auto& bindingPair : bindingInfos)
+				infos.push_back(bindingPair.second);
 		}
+		GDescriptorAllocator->Write(mDescriptorLayout_->Get(), mDescriptorSets_.data(), static_cast<uint32_t>(mDescriptorSets_.size()), infos);
 	}
 
 	void VulkanMaterial::cleanup()
@@ -250,10 +197,20 @@ namespace zyh
 
 	void VulkanMaterial::endUpdateUniformBuffer(UniformBufferObject& ubo, UniformLightingBufferObject& ulbo)
 	{
-		for (auto& uniformPair : mUniformBuffers_)
+		// only elements a pass draws on their own are set up, by VulkanRenderPass::Prepare before this
+		if (mDynamicOffsets_.empty())
+			return;
+
+		VulkanUniformRing* uniformRing = GVulkanInstance->mUniformRing_;
+		std::vector<uint32_t>& offsets = mDynamicOffsets_[mCurrentUpdateImage_];
+		size_t index = 0;
+		for (auto& uniformPair : mUniformBindings_)
 		{
-			uniformPair.second[mCurrentUpdateImage_]->setupData(EUniformType::BATCH, &ubo, sizeof(ubo));
-			uniformPair.second[mCurrentUpdateImage_]->setupData(EUniformType::LIGHT, &ulbo, sizeof(ulbo));
+			const VulkanUniformBinding& uniform = uniformPair.second;
+			const bool isBatch = uniform.Type == EUniformType::BATCH;
+			const void* data = isBatch ? static_cast<const void*>(&ubo) : static_cast<const void*>(&ulbo);
+			const VkDeviceSize size = isBatch ? sizeof(ubo) : sizeof(ulbo);
+			offsets[index++] = uniformRing->Push(data, Min(size, VkDeviceSize(uniform.Size)), uniform.Size);
 		}
 	}
 
@@ -271,8 +228,8 @@ namespace zyh
 	{
 		ImGui::CreateContext();
 		ImGuiIO& io = ImGui::GetIO();
-		io.DisplaySize.x = (float)GVulkanInstance->mSwapchain_->getExtend().width;
-		io.DisplaySize.y = (float)GVulkanInstance->mSwapchain_->getExtend().height;
+		io.DisplaySize.x = (float)GInstance->mExtend_->width;
+		io.DisplaySize.y = (float)GInstance->mExtend_->height;
 
 		int width, height, channel;
 		unsigned char* pixels = NULL;
@@ -8,6 +8,8 @@
 #include "Graphics/Common/Geometry.h"
 #include "Graphics/Common/RenderStage.h"
 #include "Graphics/Common/IPrimitive.h"
+#include "VulkanPipelineCache.h"
+#include "VulkanBuffer.h"
 
 
 namespace zyh
@@ -15,7 +17,6 @@ namespace zyh
 	class VulkanLogicalDevice;
 	class VulkanPhysicalDevice;
 	class VulkanGraphicsPipeline;
-	class VulkanUniformBuffer;
 	class VulkanTextureImage;
 	class VulkanDescriptorLayout;
 
@@ -34,11 +35,21 @@ namespace zyh
 		SpotLight spotLight;
 	};
 
+	// a uniform block of the material's shaders, the data is streamed into GVulkanInstance->mUniformRing_ every frame
+	struct VulkanUniformBinding
+	{
+		EUniformType Type{ EUniformType::NONE };
+		uint32_t Size{ 0 };
+		VkShaderStageFlags Stages{ 0 };
+	};
+
 	class VulkanMaterial : public IVulkanObject
 	{
 		friend class VulkanGraphicsPipeline;
+		friend class VulkanPipelineCache;
 	public:
 		VulkanMaterial(IMaterial* material, RenderSet renderSet);
+		virtual ~VulkanMaterial();
 		
 		// Temp: Clean after VertexFactory Implementation
 		VulkanMaterial(IPrimitive* prim, RenderSet renderSet);
@@ -46,6 +57,7 @@ namespace zyh
 
 		virtual void connect(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice, uint32_t layoutCount);
 
+		// descriptor data is made once, the pipeline again only when mRenderPass_ changes
 		virtual void setup() override;
 
 		virtual void cleanup() override;
@@ -55,9 +67,17 @@ namespace zyh
 		virtual void updateUniformBuffer(UniformBufferObject& ubo, UniformLightingBufferObject& ulbo);
 		void endUpdateUniformBuffer(UniformBufferObject& ubo, UniformLightingBufferObject& ulbo);
 		VkDescriptorSet getDescriptorSet(size_t currentImage) { return mDescriptorSets_[currentImage]; }
-		bool needUpdateDesciptorSet() { return mUniformBuffers_.size() + mTextureImages_.size() > 0; }
+		// in binding order, as vkCmdBindDescriptorSets expects them
+		const std::vector<uint32_t>& getDynamicOffsets(size_t currentImage)
+		{
+			static const std::vector<uint32_t> NO_OFFSETS;
+			return mDynamicOffsets_.empty() ? NO_OFFSETS : mDynamicOffsets_[currentImage];
+		}
+		bool needUpdateDesciptorSet() { return mUniformBindings_.size() + mTextureImages_.size() > 0; }
 		VkPipelineLayout getPipelineLayout();
 		VkPipeline getPipeline();
+		const IMaterial* getMaterial() const { return mMaterial_; }
+		RenderSet getRenderSet() const { return mRenderSet_; }
 
 		// TODO
 		virtual void getBindingDescriptions(std::vector<VkVertexInputBindingDescription>& descriptions) 
@@ -90,19 +110,21 @@ namespace zyh
 		RenderSet			mRenderSet_;
 
 	public:
-		VulkanGraphicsPipeline* mGraphicsPipeline_;
+		// both shared through GPipelineCache
+		VulkanGraphicsPipeline* mGraphicsPipeline_{ nullptr };
+		VulkanDescriptorLayout* mDescriptorLayout_{ nullptr };
+		VulkanPipelineCache::PipelineState* mPipelineState_{ nullptr };
+		const VulkanRenderPass* mPipelineRenderPass_{ nullptr };
 		virtual void createGraphicsPipeline();
 
-		VulkanDescriptorLayout* mDescriptorLayout_;
-		virtual void createDescriptorLayout();
-
-		VkDescriptorPool mDescriptorPool_;
-		virtual void createDesciptorPool();
-
+		// allocated from GDescriptorAllocator, one per image
 		std::vector<VkDescriptorSet> mDescriptorSets_;
 		virtual void createDescriptorSets();
 
-		std::unordered_map<uint32_t, std::vector<VulkanUniformBuffer*>> mUniformBuffers_;
+		// ordered, dynamic offsets follow the binding order
+		std::map<uint32_t, VulkanUniformBinding> mUniformBindings_;
+		// per image, offsets into the ring of the last update
+		std::vector<std::vector<uint32_t>> mDynamicOffsets_;
 		virtual void createDescriptorSetData();
 
 		std::unordered_map<uint32_t, class VulkanTexture*> mTextureImages_;
@@ -113,6 +135,29 @@ namespace zyh
 	};
 
 
+	// material of an instanced draw: the primitive's vertex layout followed by the per instance InstanceData stream.
+	// the layout is copied, so the material outlives the primitive it was made from
+	class VulkanInstancedMaterial : public VulkanMaterial
+	{
+	public:
+		VulkanInstancedMaterial(IMaterial* material, RenderSet renderSet, IPrimitive* prim) : VulkanMaterial(material, renderSet)
+		{
+			prim->GetBindingDescriptions(mBindingDescriptions_);
+			prim->GetAttributeDescriptions(mAttributeDescriptions_);
+			InstanceData::GetBindingDescriptions(mBindingDescriptions_);
+			InstanceData::GetAttributeDescriptions(mAttributeDescriptions_);
+		}
+
+	public:
+		virtual void getBindingDescriptions(std::vector<VkVertexInputBindingDescription>& descriptions) override { descriptions = mBindingDescriptions_; }
+		virtual void getAttributeDescriptions(std::vector<VkVertexInputAttributeDescription>& descriptions) override { descriptions = mAttributeDescriptions_; }
+
+	private:
+		std::vector<VkVertexInputBindingDescription> mBindingDescriptions_;
+		std::vector<VkVertexInputAttributeDescription> mAttributeDescriptions_;
+	};
+
+
 	class ImGuiMaterial : public VulkanMaterial
 	{
 		struct PushConstBlock {
@@ -0,0 +1,74 @@
+#include "VulkanMeshCache.h"
+#include "VulkanBase.h"
+#include "VulkanBuffer.h"
+#include "VulkanStagingArena.h"
+#include "Graphics/Common/IPrimitive.h"
+
+
+namespace zyh
+{
+	VulkanMeshCache* GMeshCache = new VulkanMeshCache();
+
+	VulkanMeshCache::~VulkanMeshCache()
+	{
+		for (auto& pair : mMeshes_)
+		{
+			SafeDestroy(pair.second.VertexBuffer);
+			SafeDestroy(pair.second.IndexBuffer);
+		}
+		mMeshes_.clear();
+	}
+
+	VulkanMeshCache::Mesh* VulkanMeshCache::Acquire(IPrimitive* prim)
+	{
+		const std::string& key = prim->GetGeometryKey();
+		HYBRID_CHECK(!key.empty());
+
+		std::lock_guard<std::mutex> lock(mMutex_);
+		Mesh& mesh = mMeshes_[key];
+		if (!mesh.RefCount)
+		{
+			mesh.Key = key;
+			_Upload(mesh, prim);
+		}
+		++mesh.RefCount;
+		return &mesh;
+	}
+
+	void VulkanMeshCache::Release(Mesh* mesh)
+	{
+		if (!mesh)
+			return;
+		std::lock_guard<std::mutex> lock(mMutex_);
+		HYBRID_CHECK(mesh->RefCount > 0);
+		if (--mesh->RefCount)
+			return;
+		SafeDestroy(mesh->VertexBuffer);
+		SafeDestroy(mesh->IndexBuffer);
+		mMeshes_.erase(mesh->Key);
+	}
+
+	void VulkanMeshCache::_Upload(Mesh& mesh, IPrimitive* prim)
+	{
+		void* vertexData{ nullptr }; size_t vertexSize;
+		void* indexData{ nullptr }; size_t indexSize;
+		prim->GetVerticesData(&vertexData, vertexSize);
+		prim->GetIndicesData(&indexData, indexSize);
+		mesh.IndexCount = static_cast<uint32_t>(indexSize / sizeof(uint32_t));
+
+		VulkanPhysicalDevice* physicalDevice = GVulkanInstance->mPhysicalDevice_;
+		VulkanLogicalDevice* logicalDevice = GVulkanInstance->mLogicalDevice_;
+		mesh.VertexBuffer = new VulkanBuffer();
+		mesh.VertexBuffer->connect(physicalDevice, logicalDevice);
+		mesh.VertexBuffer->setup(vertexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		mesh.IndexBuffer = new VulkanBuffer();
+		mesh.IndexBuffer->connect(physicalDevice, logicalDevice);
+		mesh.IndexBuffer->setup(indexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+		const VulkanStagingCopy copies[] = {
+			{ mesh.VertexBuffer->Get().buffer, 0, vertexData, vertexSize },
+			{ mesh.IndexBuffer->Get().buffer, 0, indexData, indexSize },
+		};
+		GStagingArena->Upload(GVulkanInstance->mGraphicsCommandPool_, copies);
+	}
+}
\ No newline at end of file
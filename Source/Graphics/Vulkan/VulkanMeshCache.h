@@ -0,0 +1,43 @@
+#pragma once
+#include "Common/Config.h"
+#include <mutex>
+#include <unordered_map>
+
+
+namespace zyh
+{
+	class IPrimitive;
+	class VulkanBuffer;
+
+	// device local vertex / index buffers shared by the primitives of one IPrimitive::GetGeometryKey(),
+	// uploaded by the first user and destroyed with the last one
+	class VulkanMeshCache
+	{
+	public:
+		struct Mesh
+		{
+			std::string Key;
+			VulkanBuffer* VertexBuffer{ nullptr };
+			VulkanBuffer* IndexBuffer{ nullptr };
+			uint32_t IndexCount{ 0 };
+			uint32_t RefCount{ 0 };
+		};
+
+	public:
+		~VulkanMeshCache();
+
+		// prim must have a geometry key
+		Mesh* Acquire(IPrimitive* prim);
+		void Release(Mesh* mesh);
+
+	private:
+		void _Upload(Mesh& mesh, IPrimitive* prim);
+
+	private:
+		// elements are created on the game thread and released on the render thread
+		std::mutex mMutex_;
+		std::unordered_map<std::string, Mesh> mMeshes_;
+	};
+
+	extern VulkanMeshCache* GMeshCache;
+}
\ No newline at end of file
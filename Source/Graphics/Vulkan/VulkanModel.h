@@ -3,6 +3,7 @@
 #include "Graphics/Common/IRenderScene.h"
 #include "Graphics/Common/IMaterial.h"
 #include "IVulkanObject.h"
+#include "Core/EventHelper.h"
 #include "VulkanRenderElement.h"
 
 namespace zyh
@@ -17,6 +18,7 @@ namespace zyh
 	public: // override
 		virtual size_t AddPrimitive(IPrimitive* prim, Matrix4x3* localTransform = nullptr) override
 		{
+			ElementsChanging.BoardCast();
 			size_t index = IModel::AddPrimitive(prim, localTransform);
 			if (prim->IsStatic())
 			{
@@ -27,6 +29,7 @@ namespace zyh
 
 		virtual size_t AddPrimitive(EPrimitiveType primType, Matrix4x3* localTransform = nullptr) override
 		{
+			ElementsChanging.BoardCast();
 			size_t index = IModel::AddPrimitive(primType, localTransform);
 			IPrimitive* prim = mMesh_->GetPrimitive(index);
 			if (prim->IsStatic())
@@ -37,18 +40,23 @@ namespace zyh
 		}
 		
 		
-		virtual void UpdateTransform(Matrix4x3& mat) 
-		{ 
-			IModel::UpdateTransform(mat);
+		// render elements of this model read their world matrix from here
+		void BindTransform(const TransformHierarchy* transforms, TransformHierarchy::Handle handle)
+		{
+			mTransforms_ = transforms;
+			mTransformHandle_ = handle;
 			std::vector<VulkanRenderElement*> allElements;
 			getAllRenderElements(allElements);
 			for (VulkanRenderElement* element : allElements)
 			{
-				element->UpdateTransform(mat);
+				element->BindTransform(transforms, handle);
 			}
 		}
 
 
+		// fired before the element lists change, owners withdraw the current elements from the render scene
+		Event<void> ElementsChanging;
+
 	public:
 		void EmitRenderElements(RenderSet renderSet, IRenderScene& renderScene)
 		{
@@ -62,6 +70,18 @@ namespace zyh
 				}
 			}
 		}
+
+		void WithdrawRenderElements(RenderSet renderSet, IRenderScene& renderScene)
+		{
+			auto iter = mRenderElements_.find(renderSet);
+			if (iter != mRenderElements_.end())
+			{
+				for (auto element : iter->second)
+				{
+					renderScene.RemoveRenderElement(renderSet, element);
+				}
+			}
+		}
 		
 	protected:
 		void GenerateRenderElement(IPrimitive* prim)
@@ -69,17 +89,17 @@ namespace zyh
 			const IMaterial* material = prim->GetMaterial();
 			for (RenderSet renderSet : material->GetSupportRenderSet())
 			{
-				if (mRenderElements_.find(renderSet) == mRenderElements_.end())
-				{
-					mRenderElements_[renderSet] = *(new std::vector<IRenderElement*>());
-				}
 				IRenderElement* element = new VulkanRenderElement(prim, renderSet);
+				element->BindTransform(mTransforms_, mTransformHandle_);
 				prim->AddRenderElement(renderSet, element);
+				mRenderElements_[renderSet].push_back(element);
 			}
 		}
 
 		void GenerateRenderElements()
 		{
+			ElementsChanging.BoardCast();
+			mRenderElements_.clear();
 			auto& prims = GetPrimitives();
 			for (auto& prim : prims)
 			{
@@ -150,5 +170,7 @@ namespace zyh
 	protected:
 		IModel* mModel_;
 		std::map<RenderSet, std::vector<IRenderElement*>> mRenderElements_;
+		const TransformHierarchy* mTransforms_{ nullptr };
+		TransformHierarchy::Handle mTransformHandle_{ TransformHierarchy::INVALID_HANDLE };
 	};
 }
\ No newline at end of file
@@ -8,6 +8,9 @@ namespace zyh
 	{
 		mVulkanInstance_ = instance;
 		mVulkanSurface_ = surface;
+		// offscreen only, no presentation
+		if (!surface)
+			mDeviceExtensions_.clear();
 	}
 
 	void VulkanPhysicalDevice::setup()
@@ -21,6 +24,22 @@ namespace zyh
 		mVkImpl_ = _chooseSuitablePhysicsDevice(devices);
 		HYBRID_CHECK(mVkImpl_, "failed to find a suitable GPU!");
 
+		uint32_t extensionCount;
+		vkEnumerateDeviceExtensionProperties(mVkImpl_, nullptr, &extensionCount, nullptr);
+		std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+		vkEnumerateDeviceExtensionProperties(mVkImpl_, nullptr, &extensionCount, availableExtensions.data());
+		for (const char* extensionName : mOptionalDeviceExtensions_)
+		{
+			for (const auto& extension : availableExtensions)
+			{
+				if (strcmp(extension.extensionName, extensionName) == 0)
+				{
+					mDeviceExtensions_.push_back(extensionName);
+					break;
+				}
+			}
+		}
+
 		*GInstance->mMsaaSamples_ = getMaxUsableSampleCount();
 		GInstance->mMsaaSamples_.IsValid(true);
 
@@ -39,7 +58,7 @@ namespace zyh
 		{
 			if (!mQueueFamilyCache_.IsValid())
 			{
-				mQueueFamilyCache_ = _findQueueFamilies(mVkImpl_, mVulkanSurface_->Get());
+				mQueueFamilyCache_ = _findQueueFamilies(mVkImpl_, mVulkanSurface_ ? mVulkanSurface_->Get() : VK_NULL_HANDLE);
 			}
 			return mQueueFamilyCache_;
 		}
@@ -78,6 +97,14 @@ namespace zyh
 	}
 
 	uint32_t VulkanPhysicalDevice::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties)
+	{
+		uint32_t index = 0;
+		if (!tryFindMemoryType(typeFilter, properties, index))
+			tools::exitFatal("failed to find suitable memory type!");
+		return index;
+	}
+
+	bool VulkanPhysicalDevice::tryFindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t& outIndex)
 	{
 		HYBRID_CHECK(mVkImpl_);
 
@@ -85,11 +112,11 @@ namespace zyh
 		vkGetPhysicalDeviceMemoryProperties(mVkImpl_, &memProperties);
 		for (uint32_t i = 0; i < memProperties.memoryTypeCount; ++i) {
 			if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & properties) == properties) {
-				return i;
+				outIndex = i;
+				return true;
 			}
 		}
-		tools::exitFatal("failed to find suitable memory type!");
-		return 0;
+		return false;
 	}
 
 	VkSampleCountFlagBits VulkanPhysicalDevice::getMaxUsableSampleCount()
@@ -178,8 +205,9 @@ namespace zyh
 		std::vector<VkQueueFamilyProperties> queueFamilyProperties(queueFamilyCount);
 		vkGetPhysicalDeviceQueueFamilyProperties(device, &queueFamilyCount, queueFamilyProperties.data());
 
-		int i = 0;
-		for (const auto& queueFamilyPropertie : queueFamilyProperties) {
+		// indexed loop: the early continues below must not skip the index increment
+		for (uint32_t i = 0; i < queueFamilyCount; ++i) {
+			const VkQueueFamilyProperties& queueFamilyPropertie = queueFamilyProperties[i];
 			// Try to find a queue family index that supports compute but not graphics
 			if ((queueFamilyPropertie.queueFlags & VK_QUEUE_COMPUTE_BIT) && ((queueFamilyPropertie.queueFlags & VK_QUEUE_GRAPHICS_BIT) == 0))
 			{
@@ -199,21 +227,33 @@ namespace zyh
 			}
 
 			VkBool32 presentSupport = false;
-			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+			if (surface)
+				vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
 			if (presentSupport)
 				indices->presentFamily = i;
+			// without a surface nothing is presented, the graphics queue stands in
+			else if (!surface && indices->graphicsFamily && !indices->presentFamily)
+				indices->presentFamily = indices->graphicsFamily;
 
 			if (indices->isComplete()) {
 				break;
 			}
-
-			++i;
 		}
 
 		indices.IsValid(true);
 		return indices;
 	}
 
+	bool VulkanPhysicalDevice::isExtensionEnabled(const char* extensionName) const
+	{
+		for (const char* enabled : mDeviceExtensions_)
+		{
+			if (strcmp(enabled, extensionName) == 0)
+				return true;
+		}
+		return false;
+	}
+
 	bool VulkanPhysicalDevice::_checkDeviceExtensionSupport(VkPhysicalDevice device)
 	{
 		uint32_t extensionCount;
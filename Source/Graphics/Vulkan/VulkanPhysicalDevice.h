@@ -77,7 +77,11 @@ namespace zyh
 		const VkPhysicalDeviceFeatures& getDeviceFeatures();
 		const VkFormat findSupportedFormat(const std::vector<VkFormat>& candidates, VkImageTiling tiling, VkFormatFeatureFlags features);
 		virtual const std::vector<const char*>& getDeviceExtensions() { return mDeviceExtensions_; }
+		// after setup: an extension of mOptionalDeviceExtensions_ the chosen device supports, so it is enabled too
+		bool isExtensionEnabled(const char* extensionName) const;
 		uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties);
+		// false instead of a fatal exit when no type matches, for optional properties like lazy allocation
+		bool tryFindMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags properties, uint32_t& outIndex);
 		VkSampleCountFlagBits getMaxUsableSampleCount();
 
 	protected:
@@ -95,10 +99,15 @@ namespace zyh
 		TCache<VkPhysicalDeviceFeatures> mDeviceFeatures_{};
 		QueueFamilyIndices mQueueFamilyCache_;
 
-		const std::vector<const char*> mDeviceExtensions_ = {
+		std::vector<const char*> mDeviceExtensions_ = {
 			VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 		};
 
+		// used when present, never a reason to reject a device
+		std::vector<const char*> mOptionalDeviceExtensions_ = {
+			VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME,
+		};
+
 
 	};
 }
\ No newline at end of file
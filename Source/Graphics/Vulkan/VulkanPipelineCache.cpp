@@ -0,0 +1,265 @@
+#include "VulkanPipelineCache.h"
+#include "VulkanBase.h"
+#include "VulkanInstance.h"
+#include "VulkanLogicalDevice.h"
+#include "VulkanMaterial.h"
+#include "VulkanGraphicsPipeline.h"
+#include "VulkanDescriptor.h"
+#include "VulkanShader.h"
+#include "VulkanBuffer.h"
+#include "VulkanPhysicalDevice.h"
+#include <cstdio>
+#include <fstream>
+#include <type_traits>
+
+
+namespace zyh
+{
+	VulkanPipelineCache* GPipelineCache = new VulkanPipelineCache();
+
+	namespace
+	{
+		template<typename T>
+		void AppendKey(std::string& key, const T& value)
+		{
+			static_assert(std::is_trivially_copyable_v<T>);
+			key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+		}
+
+		template<typename T>
+		void AppendKey(std::string& key, const std::vector<T>& values)
+		{
+			AppendKey(key, values.size());
+			for (const T& value : values)
+				AppendKey(key, value);
+		}
+	}
+
+	VulkanPipelineCache::~VulkanPipelineCache()
+	{
+		cleanup();
+	}
+
+	void VulkanPipelineCache::setup(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice, const std::string& path)
+	{
+		HYBRID_CHECK(mVkPipelineCache_ == VK_NULL_HANDLE);
+		mPhysicalDevice_ = physicalDevice;
+		mLogicalDevice_ = logicalDevice;
+		mPath_ = path;
+
+		std::vector<char> data;
+		if (!mPath_.empty())
+		{
+			std::ifstream file(mPath_, std::ios::ate | std::ios::binary);
+			if (file.is_open())
+			{
+				data.resize(static_cast<size_t>(file.tellg()));
+				file.seekg(0);
+				file.read(data.data(), data.size());
+				if (!file || !_IsCompatible(data))
+				{
+					printf("pipeline cache: %s is stale or from another device, starting cold\n", mPath_.c_str());
+					data.clear();
+				}
+			}
+		}
+
+		VkPipelineCacheCreateInfo pipelineCacheCreateInfo = {};
+		pipelineCacheCreateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+		pipelineCacheCreateInfo.initialDataSize = data.size();
+		pipelineCacheCreateInfo.pInitialData = data.empty() ? nullptr : data.data();
+		mIsWarm_ = !data.empty() && vkCreatePipelineCache(mLogicalDevice_->Get(), &pipelineCacheCreateInfo, nullptr, &mVkPipelineCache_) == VK_SUCCESS;
+		if (!mIsWarm_)
+		{
+			// the driver may still refuse data that passed the header check
+			pipelineCacheCreateInfo.initialDataSize = 0;
+			pipelineCacheCreateInfo.pInitialData = nullptr;
+			if (vkCreatePipelineCache(mLogicalDevice_->Get(), &pipelineCacheCreateInfo, nullptr, &mVkPipelineCache_) != VK_SUCCESS)
+				throw std::runtime_error("failed to create pipeline cache!");
+		}
+	}
+
+	void VulkanPipelineCache::cleanup()
+	{
+		std::lock_guard<std::mutex> lock(mMutex_);
+		for (auto& pair : mStates_)
+			_Destroy(pair.second);
+		mStates_.clear();
+		if (mVkPipelineCache_ != VK_NULL_HANDLE)
+			vkDestroyPipelineCache(mLogicalDevice_->Get(), mVkPipelineCache_, nullptr);
+		mVkPipelineCache_ = VK_NULL_HANDLE;
+	}
+
+	bool VulkanPipelineCache::Save()
+	{
+		if (mPath_.empty() || mVkPipelineCache_ == VK_NULL_HANDLE)
+			return false;
+
+		size_t size = 0;
+		std::vector<char> data;
+		{
+			std::lock_guard<std::mutex> lock(mMutex_);
+			if (vkGetPipelineCacheData(mLogicalDevice_->Get(), mVkPipelineCache_, &size, nullptr) != VK_SUCCESS)
+				return false;
+			data.resize(size);
+			if (vkGetPipelineCacheData(mLogicalDevice_->Get(), mVkPipelineCache_, &size, data.data()) != VK_SUCCESS)
+				return false;
+			data.resize(size);
+		}
+
+		// written aside first, a crash mid write must not leave a truncated cache behind
+		const std::string tempPath = mPath_ + ".tmp";
+		{
+			std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+			if (!file.is_open())
+				return false;
+			file.write(data.data(), data.size());
+			if (!file)
+				return false;
+		}
+		std::remove(mPath_.c_str());
+		if (std::rename(tempPath.c_str(), mPath_.c_str()) != 0)
+			return false;
+
+		printf("pipeline cache: saved %zu bytes to %s (%s start, %u pipelines built in %.1f ms)\n",
+			data.size(), mPath_.c_str(), mIsWarm_ ? "warm" : "cold", mBuiltCount_, mBuildMs_);
+		fflush(stdout);
+		return true;
+	}
+
+	bool VulkanPipelineCache::_IsCompatible(const std::vector<char>& data) const
+	{
+		VkPipelineCacheHeaderVersionOne header{};
+		if (data.size() < sizeof(header))
+			return false;
+		memcpy(&header, data.data(), sizeof(header));
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(mPhysicalDevice_->Get(), &properties);
+		return header.headerSize >= sizeof(header)
+			&& header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE
+			&& header.vendorID == properties.vendorID
+			&& header.deviceID == properties.deviceID
+			&& memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+	}
+
+	VulkanPipelineCache::PipelineState* VulkanPipelineCache::Acquire(VulkanMaterial* material)
+	{
+		HYBRID_CHECK(material->GetRenderPass());
+		std::string key = _MakeKey(material);
+
+		std::lock_guard<std::mutex> lock(mMutex_);
+		PipelineState& state = mStates_[key];
+		if (!state.RefCount)
+		{
+			state.Key = std::move(key);
+			_Build(state, material);
+		}
+		++state.RefCount;
+		return &state;
+	}
+
+	void VulkanPipelineCache::Release(PipelineState* state)
+	{
+		if (!state)
+			return;
+		std::lock_guard<std::mutex> lock(mMutex_);
+		HYBRID_CHECK(state->RefCount > 0);
+		if (--state->RefCount)
+			return;
+		_Destroy(*state);
+		mStates_.erase(state->Key);
+	}
+
+	void VulkanPipelineCache::_Build(PipelineState& state, VulkanMaterial* material)
+	{
+		HYBRID_CHECK(mVkPipelineCache_ != VK_NULL_HANDLE, "GPipelineCache used before setup");
+		VulkanLogicalDevice* logicalDevice = material->mLogicalDevice_;
+		const auto start = std::chrono::steady_clock::now();
+
+		// the owner is only read while the objects are set up, later users never touch it
+		state.DescriptorLayout = new VulkanDescriptorLayout(material);
+		state.DescriptorLayout->connect(logicalDevice);
+		state.DescriptorLayout->setup();
+		material->mDescriptorLayout_ = state.DescriptorLayout;
+
+		state.Pipeline = new VulkanGraphicsPipeline(material);
+		state.Pipeline->connect(logicalDevice, mVkPipelineCache_);
+		state.Pipeline->setup();
+
+		++mBuiltCount_;
+		mBuildMs_ += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	void VulkanPipelineCache::_Destroy(PipelineState& state)
+	{
+		if (state.Pipeline)
+			state.Pipeline->cleanup();
+		SafeDestroy(state.Pipeline);
+		if (state.DescriptorLayout)
+			state.DescriptorLayout->cleanup();
+		SafeDestroy(state.DescriptorLayout);
+	}
+
+	std::string VulkanPipelineCache::_MakeKey(VulkanMaterial* material)
+	{
+		std::string key;
+
+		// shader modules are unique per path in GShaderCreator
+		AppendKey(key, static_cast<VulkanShader*>(material->mMaterial_->GetShader(EShaderType::VS, material->mRenderSet_))->GetShaderModule());
+		AppendKey(key, static_cast<VulkanShader*>(material->mMaterial_->GetShader(EShaderType::PS, material->mRenderSet_))->GetShaderModule());
+
+		std::vector<VkVertexInputBindingDescription> bindingDescriptions;
+		std::vector<VkVertexInputAttributeDescription> attributeDescriptions;
+		std::vector<VkPushConstantRange> pushConstantRanges;
+		material->getBindingDescriptions(bindingDescriptions);
+		material->getAttributeDescriptions(attributeDescriptions);
+		material->getPushConstantRange(pushConstantRanges);
+		AppendKey(key, bindingDescriptions);
+		AppendKey(key, attributeDescriptions);
+		AppendKey(key, pushConstantRanges);
+
+		// same bindings VulkanDescriptorLayout::setup makes, the maps aren't ordered
+		std::map<uint32_t, std::pair<VkDescriptorType, VkShaderStageFlags>> descriptorBindings;
+		for (auto& uniformPair : material->mUniformBindings_)
+			descriptorBindings[uniformPair.first] = { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, uniformPair.second.Stages };
+		for (auto& texturePair : material->mTextureImages_)
+			descriptorBindings[texturePair.first] = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT };
+		AppendKey(key, descriptorBindings.size());
+		for (auto& bindingPair : descriptorBindings)
+		{
+			AppendKey(key, bindingPair.first);
+			AppendKey(key, bindingPair.second.first);
+			AppendKey(key, bindingPair.second.second);
+		}
+
+		// field by field, padding bytes must not reach the key
+		const RasterizationState& rasterization = material->GetRasterizationState();
+		AppendKey(key, rasterization.CullMode);
+
+		const DepthStencilState& depthStencil = material->GetDepthStencilState();
+		AppendKey(key, depthStencil.DepthTestEnable);
+		AppendKey(key, depthStencil.DepthWriteEnable);
+		AppendKey(key, depthStencil.StencilTestEnable);
+		AppendKey(key, depthStencil.DepthCompareOp);
+		AppendKey(key, depthStencil.StencilState.FailOp);
+		AppendKey(key, depthStencil.StencilState.PassOp);
+		AppendKey(key, depthStencil.StencilState.DepthFailOp);
+		AppendKey(key, depthStencil.StencilState.CompareOp);
+		AppendKey(key, depthStencil.StencilState.Reference);
+
+		const ColorBlendState& colorBlend = material->GetColorBlendState();
+		AppendKey(key, colorBlend.BlendEnable);
+		AppendKey(key, colorBlend.SrcColorBlendFactor);
+		AppendKey(key, colorBlend.DstColorBlendFactor);
+		AppendKey(key, colorBlend.ColorBlendOp);
+		AppendKey(key, colorBlend.SrcAlphaBlendFactor);
+		AppendKey(key, colorBlend.DstAlphaBlendFactor);
+		AppendKey(key, colorBlend.AlphaBlendOp);
+
+		// a pipeline is only used with the render pass it was made for
+		AppendKey(key, material->GetRenderPass()->Get());
+		AppendKey(key, *(GInstance->mMsaaSamples_));
+		return key;
+	}
+}
\ No newline at end of file
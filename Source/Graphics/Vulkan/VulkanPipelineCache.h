@@ -0,0 +1,73 @@
+#pragma once
+#include "Common/Config.h"
+#include "VulkanHeader.h"
+#include <mutex>
+#include <unordered_map>
+
+
+namespace zyh
+{
+	class VulkanMaterial;
+	class VulkanGraphicsPipeline;
+	class VulkanDescriptorLayout;
+	class VulkanPhysicalDevice;
+	class VulkanLogicalDevice;
+
+	// pipelines and their layouts shared by every material with the same shaders, vertex layout,
+	// descriptor bindings, IPipelineState and render pass, built by the first user and destroyed with the last one.
+	// all of them are compiled through one device wide VkPipelineCache that is kept on disk between runs
+	class VulkanPipelineCache
+	{
+	public:
+		struct PipelineState
+		{
+			std::string Key;
+			VulkanGraphicsPipeline* Pipeline{ nullptr };
+			VulkanDescriptorLayout* DescriptorLayout{ nullptr };
+			uint32_t RefCount{ 0 };
+		};
+
+	public:
+		~VulkanPipelineCache();
+
+		// after the logical device: creates the VkPipelineCache, seeded from path when that file was written
+		// by the same driver and device. an empty path neither loads nor saves
+		void setup(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice, const std::string& path);
+		// before the logical device goes away: destroys the pipelines and the VkPipelineCache
+		void cleanup();
+		// writes the VkPipelineCache back to the setup path
+		bool Save();
+
+		// material must have its descriptor set data and render pass
+		PipelineState* Acquire(VulkanMaterial* material);
+		void Release(PipelineState* state);
+
+		size_t GetPipelineCount() const { return mStates_.size(); }
+		// whether setup found a usable file, and the time spent compiling pipelines since
+		bool IsWarm() const { return mIsWarm_; }
+		uint32_t GetBuiltCount() const { return mBuiltCount_; }
+		double GetBuildMs() const { return mBuildMs_; }
+
+	private:
+		void _Build(PipelineState& state, VulkanMaterial* material);
+		void _Destroy(PipelineState& state);
+		bool _IsCompatible(const std::vector<char>& data) const;
+		static std::string _MakeKey(VulkanMaterial* material);
+
+	private:
+		std::mutex mMutex_;
+		// keyed by the raw state bytes, the map hashes them and compares in full on a hit
+		std::unordered_map<std::string, PipelineState> mStates_;
+		// one driver cache for every pipeline built
+		VkPipelineCache mVkPipelineCache_{ VK_NULL_HANDLE };
+		VulkanPhysicalDevice* mPhysicalDevice_{ nullptr };
+		VulkanLogicalDevice* mLogicalDevice_{ nullptr };
+		std::string mPath_;
+
+		bool mIsWarm_{ false };
+		uint32_t mBuiltCount_{ 0 };
+		double mBuildMs_{ 0.0 };
+	};
+
+	extern VulkanPipelineCache* GPipelineCache;
+}
\ No newline at end of file
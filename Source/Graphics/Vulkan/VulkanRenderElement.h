@@ -6,10 +6,15 @@
 #include "VulkanGraphicsPipeline.h"
 #include "VulkanInstance.h"
 #include "VulkanBase.h"
+#include "VulkanMeshCache.h"
+#include "VulkanStagingArena.h"
 #include "Math/Matrix4x4.h"
+#include "Math/GlmConvert.h"
 #include "Core/Engine.h"
 #include "Core/ClientScene.h"
-#include "Camera/Camera.h"
+#include "Graphics/Common/RenderSnapshot.h"
+#include "Graphics/Common/DrawSortKey.h"
+#include "Graphics/Common/DrawBindFilter.h"
 
 
 namespace zyh
@@ -18,6 +23,11 @@ namespace zyh
 	class VulkanLogicalDevice;
 	class VulkanCommandPool;
 
+	// what the command buffer has bound so far in a pass, draws only bind what differs
+	struct VulkanDrawState : DrawBindState<VkPipeline, VkPipelineLayout, VkDescriptorSet, VkBuffer>
+	{
+	};
+
 	class VulkanRenderElement : public IRenderElement, public IVulkanObject
 	{
 	public:
@@ -77,6 +87,8 @@ namespace zyh
 			for (auto buffer : mIndexBuffers_)
 				SafeDestroy(buffer);
 			mIndexBuffers_.clear();
+			GMeshCache->Release(mSharedMesh_);
+			mSharedMesh_ = nullptr;
 			SafeDestroy(mMaterial_);
 		}
 
@@ -87,105 +99,116 @@ namespace zyh
 			mMaterial_->setup();
 		}
 
-		void updateUniformBuffer(size_t currentImage)
+		// everything comes from the frame snapshot, nothing is read from the live scene
+		void updateUniformBuffer(size_t currentImage, const RenderSnapshot& snapshot, const Matrix4x3& worldTransform)
 		{
 			UniformBufferObject ubo{};
 			UniformLightingBufferObject ulbo{};
 
-			auto convertToGlmMat = [](const Matrix4x4& mat) -> glm::mat4x4
-			{
-				return glm::mat4x4
-				{
-					mat.m00, mat.m01, mat.m02, mat.m03,
-					mat.m10, mat.m11, mat.m12, mat.m13,
-					mat.m20, mat.m21, mat.m22, mat.m23,
-					mat.m30, mat.m31, mat.m32, mat.m33,
-				};
-			};
-			
-			Matrix4x3 modelMat = mTransform_;
-			Matrix4x3 viewMat = GEngine->Scene->GetCamera()->getViewMatrix();
-			Matrix4x4 projMat = GEngine->Scene->GetCamera()->getProjMatrix();
-
-			ubo.model = convertToGlmMat(modelMat);
-			ubo.view = convertToGlmMat(viewMat);
-			ubo.proj = convertToGlmMat(projMat);
+			ubo.model = ToGlm(worldTransform);
+			ubo.view = ToGlm(snapshot.ViewMatrix);
+			ubo.proj = ToGlm(snapshot.ProjMatrix);
 			ubo.proj[1][1] *= -1;
 
-			ulbo.directionalLight = DirectionLight
-			(
-				Vector3(0.5f, 0.5f, 1.0f),
-				Vector3(0.1f, 0.1f, 0.1f),
-				Vector3(0.5f, 0.5f, 0.5f),
-				Vector3(0.2f, 0.2f, 0.2f)
-			);
-			ulbo.numOfPointLights = 1;
-			ulbo.pointLights[0] = PointLight
-			(
-				Vector3(-0.5f, -0.5f, 1.0f),
-				Vector3(0.1f, 0.1f, 0.1f),
-				Vector3(0.3f, 0.3f, 0.3f),
-				Vector3(0.3f, 0.3f, 0.3f)
-			);
-			ulbo.spotLight = SpotLight
-			(
-				Vector3(0.5f, 0.5f, 1.0f),
-				Vector3(-0.5f, -0.5f, -1.0f),
-				Vector3(0.3f, 0.3f, 0.3f),
-				Vector3(0.5f, 0.5f, 0.5f),
-				Vector3(0.3f, 0.3f, 0.3f)
-			);
+			ulbo.directionalLight = snapshot.DirectionalLight;
+			ulbo.numOfPointLights = int32_t(Min(snapshot.PointLights.size(), size_t(N_MAX_POINT_LIGHT)));
+			for (int32_t i = 0; i < ulbo.numOfPointLights; ++i)
+			{
+				ulbo.pointLights[i] = snapshot.PointLights[i];
+			}
+			ulbo.spotLight = snapshot.Spot;
 
 			mMaterial_->beginUpdateUniformBuffer(currentImage);
 			mMaterial_->updateUniformBuffer(ubo, ulbo);
 			mMaterial_->endUpdateUniformBuffer(ubo, ulbo);
 		}
 
-		virtual void draw(VkCommandBuffer commandBuffer, size_t currImage)
+		// state the draw binds, valid after setupState()
+		VkPipeline getPipeline() { return mMaterial_->getPipeline(); }
+		VkDescriptorSet getDescriptorSet(size_t currImage)
 		{
-			HYBRID_CHECK(GetActiveVertexBuffer());
-			HYBRID_CHECK(GetActiveIndexBuffer());
+			return mMaterial_->needUpdateDesciptorSet() ? mMaterial_->getDescriptorSet(currImage) : VK_NULL_HANDLE;
+		}
 
-			size_t width = GVulkanInstance->GetScreenWidth();
-			size_t height = GVulkanInstance->GetScreenHeigth();
-			
-			VkViewport viewport{};
-			viewport.x = 0.0f;
-			viewport.y = 0.0f;
-			viewport.width = (float)GInstance->mExtend_->width;
-			viewport.height = (float)GInstance->mExtend_->height;
-			viewport.minDepth = 0.0f;
-			viewport.maxDepth = 1.0f;
-			vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-
-			VkRect2D scissor{};
-			scissor.offset = { 0, 0 };
-			scissor.extent = *(GInstance->mExtend_);
-			vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-
-			vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mMaterial_->mGraphicsPipeline_->Get());
-			if (mMaterial_->needUpdateDesciptorSet())
+		virtual void draw(VkCommandBuffer commandBuffer, size_t currImage, VulkanDrawState& state)
+		{
+			_bindState(commandBuffer, currImage, state);
+			uint32_t indexSize = static_cast<uint32_t>(GetActiveIndexBuffer()->GetBufferSize() / sizeof(uint32_t));
+			vkCmdDrawIndexed(commandBuffer, indexSize, 1, 0, 0, 0);
+			++state.Stats.Draws;
+		}
+
+		// shared geometry, the element can then be drawn instanced with others of the same mesh
+		VulkanMeshCache::Mesh* getSharedMesh() const { return mSharedMesh_; }
+
+	protected:
+		// turns what FilterDrawBinds decided into commands
+		struct CommandRecorder
+		{
+			VkCommandBuffer CommandBuffer;
+			const std::vector<uint32_t>& DynamicOffsets;
+
+			void SetDynamicState()
 			{
-				VkDescriptorSet set = mMaterial_->getDescriptorSet(currImage);
-				vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, mMaterial_->getPipelineLayout(), 0, 1, &set, 0, nullptr);
+				VkViewport viewport{};
+				viewport.x = 0.0f;
+				viewport.y = 0.0f;
+				viewport.width = (float)GInstance->mExtend_->width;
+				viewport.height = (float)GInstance->mExtend_->height;
+				viewport.minDepth = 0.0f;
+				viewport.maxDepth = 1.0f;
+				vkCmdSetViewport(CommandBuffer, 0, 1, &viewport);
+
+				VkRect2D scissor{};
+				scissor.offset = { 0, 0 };
+				scissor.extent = *(GInstance->mExtend_);
+				vkCmdSetScissor(CommandBuffer, 0, 1, &scissor);
 			}
+			void BindPipeline(VkPipeline pipeline)
+			{
+				vkCmdBindPipeline(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+			}
+			void BindDescriptorSet(VkPipelineLayout layout, VkDescriptorSet set)
+			{
+				vkCmdBindDescriptorSets(CommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &set,
+					static_cast<uint32_t>(DynamicOffsets.size()), DynamicOffsets.data());
+			}
+			void BindVertexBuffer(VkBuffer buffer)
+			{
+				VkDeviceSize offsets[] = { 0 };
+				vkCmdBindVertexBuffers(CommandBuffer, 0, 1, &buffer, offsets);
+			}
+			void BindIndexBuffer(VkBuffer buffer)
+			{
+				vkCmdBindIndexBuffer(CommandBuffer, buffer, 0, VK_INDEX_TYPE_UINT32);
+			}
+		};
 
-			uint32_t indexSize = static_cast<uint32_t>(GetActiveIndexBuffer()->GetBufferSize() / sizeof(uint32_t));
-			VkBuffer vertexBuffers[] = { GetActiveVertexBuffer()->Get().buffer };
-			VkDeviceSize offsets[] = { 0 };
-			vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
-			vkCmdBindIndexBuffer(commandBuffer, GetActiveIndexBuffer()->Get().buffer, 0, VK_INDEX_TYPE_UINT32);
-			vkCmdDrawIndexed(commandBuffer, indexSize, 1, 0, 0, 0);
+		void _bindState(VkCommandBuffer commandBuffer, size_t currImage, VulkanDrawState& state)
+		{
+			HYBRID_CHECK(GetActiveVertexBuffer());
+			HYBRID_CHECK(GetActiveIndexBuffer());
+
+			const std::vector<uint32_t>& dynamicOffsets = mMaterial_->getDynamicOffsets(currImage);
+			DrawBindings<VkPipeline, VkPipelineLayout, VkDescriptorSet, VkBuffer> draw;
+			draw.Pipeline = getPipeline();
+			draw.PipelineLayout = mMaterial_->getPipelineLayout();
+			draw.DescriptorSet = getDescriptorSet(currImage);
+			draw.HasDynamicOffsets = !dynamicOffsets.empty();
+			draw.VertexBuffer = GetActiveVertexBuffer()->Get().buffer;
+			draw.IndexBuffer = GetActiveIndexBuffer()->Get().buffer;
+
+			CommandRecorder recorder{ commandBuffer, dynamicOffsets };
+			FilterDrawBinds(draw, state, recorder);
 		}
 
+	public:
+
 		void updateData(
 			void* vertexData, size_t vertexSize,
 			void* indexData, size_t indexSize
 		)
 		{
-			VulkanBuffer stagingBuffer;
-			stagingBuffer.connect(mVulkanPhysicalDevice_, mVulkanLogicalDevice_);
-
 			uint32_t maxBufferSize = *GInstance->mImageCount_;
 			bool needCreateInitBuffer = mActiveVertexBufferIndex_ < 0;
 			mActiveVertexBufferIndex_ = (mActiveVertexBufferIndex_ + 1) % maxBufferSize;
@@ -199,9 +222,6 @@ namespace zyh
 				GetActiveVertexBuffer()->setup(vertexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 			}
 
-			stagingBuffer.setup(vertexSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-			stagingBuffer.setupData(vertexData, vertexSize);
-			VulkanBuffer::copyBuffer(mVulkanCommandPool_, stagingBuffer.Get().buffer, GetActiveVertexBuffer()->Get().buffer, vertexSize);
 
 			needCreateInitBuffer = mActiveIndexBufferIndex_ < 0;
 			mActiveIndexBufferIndex_ = (mActiveIndexBufferIndex_ + 1) % maxBufferSize;
@@ -213,15 +233,24 @@ namespace zyh
 				GetActiveIndexBuffer()->connect(mVulkanPhysicalDevice_, mVulkanLogicalDevice_);
 				GetActiveIndexBuffer()->setup(indexSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 			}
-			stagingBuffer.setup(indexSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-			stagingBuffer.setupData(indexData, indexSize);
-			VulkanBuffer::copyBuffer(mVulkanCommandPool_, stagingBuffer.Get().buffer, GetActiveIndexBuffer()->Get().buffer, indexSize);
+
+			const VulkanStagingCopy copies[] = {
+				{ GetActiveVertexBuffer()->Get().buffer, 0, vertexData, vertexSize },
+				{ GetActiveIndexBuffer()->Get().buffer, 0, indexData, indexSize },
+			};
+			GStagingArena->Upload(mVulkanCommandPool_, copies);
 		}
 
 		void updateData(IPrimitive* InPrimtives)
 		{
 			if (!InPrimtives)
 				return;
+			if (!InPrimtives->GetGeometryKey().empty())
+			{
+				if (!mSharedMesh_)
+					mSharedMesh_ = GMeshCache->Acquire(InPrimtives);
+				return;
+			}
 			void* vertexData{ nullptr }; size_t vertexSize;
 			void* indexData{ nullptr };	size_t indexSize;
 			InPrimtives->GetVerticesData(&vertexData, vertexSize);
@@ -235,15 +264,20 @@ namespace zyh
 
 		int mActiveVertexBufferIndex_{ -1 };
 		int mActiveIndexBufferIndex_{ -1 };
+		VulkanMeshCache::Mesh* mSharedMesh_{ nullptr };
 			
 		VulkanBuffer* GetActiveVertexBuffer()
 		{
+			if (mSharedMesh_)
+				return mSharedMesh_->VertexBuffer;
 			HYBRID_CHECK(mActiveVertexBufferIndex_ < mVertexBuffers_.size());
 			return mVertexBuffers_[mActiveVertexBufferIndex_];
 		}
 
 		VulkanBuffer* GetActiveIndexBuffer()
 		{
+			if (mSharedMesh_)
+				return mSharedMesh_->IndexBuffer;
 			HYBRID_CHECK(mActiveIndexBufferIndex_ < mIndexBuffers_.size());
 			return mIndexBuffers_[mActiveIndexBufferIndex_];
 		}
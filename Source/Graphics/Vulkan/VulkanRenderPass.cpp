@@ -1,9 +1,14 @@
 #include "VulkanRenderPass.h"
 #include "VulkanLogicalDevice.h"
+#include "VulkanPhysicalDevice.h"
 #include "VulkanRenderElement.h"
+#include "VulkanInstancing.h"
 #include "VulkanMaterial.h"
+#include "VulkanCommandPool.h"
+#include "VulkanStagingArena.h"
 
 #include "Core/TerrainComponent.h"
+#include "Core/JobSystem.h"
 
 #include "Graphics/Imgui/imgui.h"
 #include "Graphics/Imgui/imgui_impl_vulkan.h"
@@ -12,6 +17,7 @@
 
 #include "Graphics/Vulkan/VulkanImage.h"
 #include "Graphics/Common/IRenderScene.h"
+#include "Graphics/Common/RenderTargetAliasing.h"
 
 
 namespace zyh
@@ -25,17 +31,119 @@ namespace zyh
 		mImage_->connect(GVulkanInstance->mPhysicalDevice_, GVulkanInstance->mLogicalDevice_);
 
 		bool isDepthStencil = Desc.IsDepthStencil;
-		VkImageUsageFlags usage = isDepthStencil ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
-		VkImageAspectFlags aspectFlag = isDepthStencil ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
-
-		mImage_->setup(target.Width, target.Height, target.Mips,
+		VkImageUsageFlags usage = isDepthStencil ? VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT : VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+		// only content that never leaves its pass may live in lazily allocated memory
+		if (Desc.IsTransient)
+			usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+		if (Desc.IsSampled)
+			usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
+		mAspectFlags_ = isDepthStencil ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+
+		mImage_->setupUnbound(target.Width, target.Height, target.Mips,
 			Convert::Quality2SamplerCount(target.Quality), Convert::Format(target.Format),
 			VK_IMAGE_TILING_OPTIMAL,
-			usage,
-			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, aspectFlag
+			usage
 		);
 	}
 
+	void VulkanRenderTargetResource::BindMemory(VkDeviceMemory memory, VkDeviceSize offset)
+	{
+		HYBRID_CHECK(!mIsBound_);
+		mImage_->bindMemory(memory, offset, mAspectFlags_);
+		mIsBound_ = true;
+	}
+
+	void VulkanRenderDevice::CommitRenderTargets(RenderGraph& graph)
+	{
+		VulkanPhysicalDevice* physicalDevice = GVulkanInstance->mPhysicalDevice_;
+
+		std::vector<uint32_t> targetIndices;
+		std::vector<AliasRequest> requests;
+		// memory type of every alias heap
+		std::vector<uint32_t> heapTypes;
+		VkDeviceSize dedicatedSize = 0;
+		VkDeviceSize lazySize = 0;
+		for (uint32_t index = 0; index < RenderTargets.size(); ++index)
+		{
+			RenderTargetResource* resource = RenderTargets[index];
+			if (resource->Desc.IsSwapChain || resource->State != RenderTargetResource::ResourceState::EResourceState_Created)
+				continue;
+			VulkanRenderTargetResource* target = static_cast<VulkanRenderTargetResource*>(resource);
+			if (target->IsBound())
+				continue;
+
+			const RenderGraphLifetime& lifetime = graph.GetLifetime(index);
+			HYBRID_CHECK(lifetime, "render targets are only created for live passes");
+			const VkMemoryRequirements requirements = target->GetImage()->getMemoryRequirements();
+			dedicatedSize += requirements.size;
+
+			// on tilers a single pass target never leaves on-chip memory, so its pages are never committed
+			uint32_t memoryType = 0;
+			if (resource->Desc.IsTransient && physicalDevice->tryFindMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT | VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, memoryType))
+			{
+				target->BindMemory(_AllocateTargetMemory(requirements.size, memoryType), 0);
+				lazySize += requirements.size;
+				continue;
+			}
+
+			memoryType = physicalDevice->findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+			auto heap = std::find(heapTypes.begin(), heapTypes.end(), memoryType);
+			if (heap == heapTypes.end())
+				heap = heapTypes.insert(heapTypes.end(), memoryType);
+			requests.push_back(AliasRequest{ requirements.size, requirements.alignment, lifetime.FirstPass, lifetime.LastPass, static_cast<uint32_t>(heap - heapTypes.begin()) });
+			targetIndices.push_back(index);
+		}
+
+		std::vector<uint64_t> offsets;
+		std::vector<uint64_t> heapSizes;
+		PlanRenderTargetAliasing(requests, offsets, heapSizes);
+
+		VkDeviceSize aliasedSize = 0;
+		std::vector<VkDeviceMemory> heaps(heapSizes.size());
+		for (size_t heap = 0; heap < heaps.size(); ++heap)
+		{
+			heaps[heap] = _AllocateTargetMemory(heapSizes[heap], heapTypes[heap]);
+			aliasedSize += heapSizes[heap];
+		}
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			static_cast<VulkanRenderTargetResource*>(RenderTargets[targetIndices[i]])->BindMemory(heaps[requests[i].Heap], offsets[i]);
+		}
+
+		// the later of two targets sharing memory starts from undefined content, it only has to wait for the earlier one
+		for (size_t i = 0; i < requests.size(); ++i)
+		{
+			for (size_t j = i + 1; j < requests.size(); ++j)
+			{
+				if (requests[i].Heap != requests[j].Heap || !AliasRangesOverlap(offsets[i], requests[i].Size, offsets[j], requests[j].Size))
+					continue;
+				HYBRID_CHECK(!AliasLifetimesOverlap(requests[i], requests[j]));
+				if (requests[i].FirstPass < requests[j].FirstPass)
+					graph.AddAliasBarrier(targetIndices[i], targetIndices[j]);
+				else
+					graph.AddAliasBarrier(targetIndices[j], targetIndices[i]);
+			}
+		}
+
+		const double bytesToMB = 1.0 / (1024.0 * 1024.0);
+		printf("render targets: %.1f MB with dedicated memory, %.1f MB aliased in %zu heaps + %.1f MB lazily allocated\n",
+			dedicatedSize * bytesToMB, aliasedSize * bytesToMB, heaps.size(), lazySize * bytesToMB);
+		fflush(stdout);
+	}
+
+	VkDeviceMemory VulkanRenderDevice::_AllocateTargetMemory(VkDeviceSize size, uint32_t memoryType)
+	{
+		VkMemoryAllocateInfo allocInfo{};
+		allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+		allocInfo.allocationSize = size;
+		allocInfo.memoryTypeIndex = memoryType;
+
+		VkDeviceMemory memory = VK_NULL_HANDLE;
+		VK_CHECK_RESULT(vkAllocateMemory(GVulkanInstance->mLogicalDevice_->Get(), &allocInfo, nullptr, &memory), "failed to allocate image memory!");
+		mTargetMemory_.push_back(memory);
+		return memory;
+	}
+
 	void VulkanSwapchainResource::Create_Imp()
 	{
 
@@ -56,8 +164,65 @@ namespace zyh
 		mVulkanLogicalDevice_ = logicalDevice;
 	}
 
+	namespace
+	{
+		VkImageLayout UsageLayout(ERenderTargetUsage usage)
+		{
+			switch (usage)
+			{
+			case ERenderTargetUsage::COLOR_ATTACHMENT:
+			case ERenderTargetUsage::RESOLVE:
+				return VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			case ERenderTargetUsage::DEPTH_STENCIL_ATTACHMENT:
+				return VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			case ERenderTargetUsage::SHADER_READ:
+				return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+			case ERenderTargetUsage::PRESENT:
+				return GVulkanInstance->getOutputLayout();
+			default:
+				return VK_IMAGE_LAYOUT_UNDEFINED;
+			}
+		}
+
+		// usages is a mask of ERenderTargetUsage bits, see RenderGraphBarrier
+		VkPipelineStageFlags UsageStages(uint32_t usages)
+		{
+			VkPipelineStageFlags stages = 0;
+			auto has = [usages](ERenderTargetUsage usage) { return (usages & (1u << uint32_t(usage))) != 0; };
+			if (has(ERenderTargetUsage::NONE))
+				stages |= VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			// presentation hands the image over through the acquire semaphore, waited on at color output
+			if (has(ERenderTargetUsage::COLOR_ATTACHMENT) || has(ERenderTargetUsage::RESOLVE) || has(ERenderTargetUsage::PRESENT))
+				stages |= VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+			if (has(ERenderTargetUsage::DEPTH_STENCIL_ATTACHMENT))
+				stages |= VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+			if (has(ERenderTargetUsage::SHADER_READ))
+				stages |= VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+			return stages;
+		}
+
+		// writes have to be made available on the source side, reads only wait on the destination side
+		VkAccessFlags UsageAccess(uint32_t usages, bool isSource)
+		{
+			VkAccessFlags access = 0;
+			auto has = [usages](ERenderTargetUsage usage) { return (usages & (1u << uint32_t(usage))) != 0; };
+			if (has(ERenderTargetUsage::COLOR_ATTACHMENT))
+				access |= isSource ? VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			if (has(ERenderTargetUsage::RESOLVE))
+				access |= VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+			if (has(ERenderTargetUsage::DEPTH_STENCIL_ATTACHMENT))
+				access |= isSource ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+			if (has(ERenderTargetUsage::SHADER_READ) && !isSource)
+				access |= VK_ACCESS_SHADER_READ_BIT;
+			return access;
+		}
+	}
+
 	void VulkanRenderPass::setup()
 	{
+		const RenderGraphPass* compiled = mRenderPass_->GetCompiled();
+		HYBRID_CHECK(compiled, "render passes are set up from the compiled render graph");
+
 		std::vector<RenderTarget> RenderTargets = mRenderPass_->GetWriteTargetsDesc();
 		std::vector<RenderTarget> ResolveRenderTargets = mRenderPass_->GetResolveTargetsDesc();
 		size_t attachmentSize = RenderTargets.size() + ResolveRenderTargets.size();
@@ -65,10 +230,23 @@ namespace zyh
 		if (DepthStencil)
 			attachmentSize += 1;
 
+		// graph attachments in the same order as RenderTargets, then the swapchain it resolves into
+		std::vector<const RenderGraphAttachment*> colorAttachments;
+		const RenderGraphAttachment* resolveAttachment = nullptr;
+		for (const RenderGraphAttachment& attachment : compiled->Attachments)
+		{
+			if (attachment.Usage == ERenderTargetUsage::COLOR_ATTACHMENT)
+				colorAttachments.push_back(&attachment);
+			else if (attachment.Usage == ERenderTargetUsage::RESOLVE)
+				resolveAttachment = &attachment;
+		}
+		HYBRID_CHECK(colorAttachments.size() == RenderTargets.size());
+
 		std::vector<VkAttachmentDescription> attachments;
 		std::vector<VkAttachmentReference> references;
 		attachments.resize(attachmentSize);
 		references.resize(attachmentSize);
+		mClearValues_.assign(attachmentSize, VkClearValue{});
 
 		size_t index = 0;
 		// Color Attachment
@@ -80,37 +258,39 @@ namespace zyh
 			attachments[index].loadOp = Convert::LoadOp(target.LoadOp);
 			attachments[index].storeOp = Convert::StoreOp(target.StoreOp);
 
-			attachments[index].initialLayout = target.LoadOp == RenderTarget::ELoadOp::LOAD ?
-				VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+			attachments[index].initialLayout = UsageLayout(colorAttachments[index]->InitialUsage);
 
 			attachments[index].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 			attachments[index].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			attachments[index].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			attachments[index].finalLayout = UsageLayout(colorAttachments[index]->FinalUsage);
 
 			references[index].attachment = static_cast<uint32_t>(index);
 			references[index].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			mClearValues_[index].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
 		}
 
 		// Depth Attachment
 		int depthStencilIndex = -1;
 		if (DepthStencil)
 		{
+			const RenderGraphAttachment* depthAttachment = compiled->FindAttachment(mRenderPass_->GetDepthStencil());
+			HYBRID_CHECK(depthAttachment);
+
 			depthStencilIndex = static_cast<int>(index);
 			const RenderTarget& target = DepthStencil;
 			attachments[index].format = Convert::Format(target.Format);
 			attachments[index].samples = Convert::Quality2SamplerCount(target.Quality);
+			attachments[index].loadOp = Convert::LoadOp(target.LoadOp);
+			attachments[index].storeOp = Convert::StoreOp(target.StoreOp);
 			attachments[index].stencilLoadOp = Convert::LoadOp(target.LoadOp);
 			attachments[index].stencilStoreOp = Convert::StoreOp(target.StoreOp);
 
-			attachments[index].initialLayout = target.LoadOp == RenderTarget::ELoadOp::LOAD ?
-				VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
-
-			attachments[index].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-			attachments[index].storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-			attachments[index].finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			attachments[index].initialLayout = UsageLayout(depthAttachment->InitialUsage);
+			attachments[index].finalLayout = UsageLayout(depthAttachment->FinalUsage);
 
 			references[index].attachment = static_cast<uint32_t>(index);
 			references[index].layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+			mClearValues_[index].depthStencil = { 1.0f, 0 };
 
 			++index;
 		}
@@ -119,18 +299,19 @@ namespace zyh
 		int resolveIndex = -1;
 		if (!ResolveRenderTargets.empty())
 		{
+			HYBRID_CHECK(resolveAttachment);
 			size_t lastSize = index;
 			for (;index < lastSize + ResolveRenderTargets.size(); ++index)
 			{
 				resolveIndex = static_cast<int>(index);
 				attachments[index].format = Convert::Format(RenderTargets[index - lastSize].Format);
 				attachments[index].samples = VK_SAMPLE_COUNT_1_BIT;
-				attachments[index].loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-				attachments[index].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+				attachments[index].loadOp = Convert::LoadOp(resolveAttachment->LoadOp);
+				attachments[index].storeOp = Convert::StoreOp(resolveAttachment->StoreOp);
 				attachments[index].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 				attachments[index].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-				attachments[index].initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-				attachments[index].finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+				attachments[index].initialLayout = UsageLayout(resolveAttachment->InitialUsage);
+				attachments[index].finalLayout = UsageLayout(resolveAttachment->FinalUsage);
 
 				references[index].attachment = static_cast<uint32_t>(index);
 				references[index].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
@@ -148,15 +329,28 @@ namespace zyh
 		subpassDescription.preserveAttachmentCount = 0;
 		subpassDescription.pPreserveAttachments = nullptr;
 
-		VkSubpassDependency dependency{};
-		dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-		dependency.dstSubpass = 0;
-
-		dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.srcAccessMask = 0;
-
-		dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-		dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+		// only the hazards the graph found, a pass without any gets no dependency at all
+		std::vector<VkSubpassDependency> dependencies;
+		if (compiled->Incoming)
+		{
+			VkSubpassDependency& dependency = dependencies.emplace_back();
+			dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+			dependency.dstSubpass = 0;
+			dependency.srcStageMask = UsageStages(compiled->Incoming.SrcUsages);
+			dependency.srcAccessMask = UsageAccess(compiled->Incoming.SrcUsages, true);
+			dependency.dstStageMask = UsageStages(compiled->Incoming.DstUsages);
+			dependency.dstAccessMask = UsageAccess(compiled->Incoming.DstUsages, false);
+		}
+		if (compiled->Outgoing)
+		{
+			VkSubpassDependency& dependency = dependencies.emplace_back();
+			dependency.srcSubpass = 0;
+			dependency.dstSubpass = VK_SUBPASS_EXTERNAL;
+			dependency.srcStageMask = UsageStages(compiled->Outgoing.SrcUsages);
+			dependency.srcAccessMask = UsageAccess(compiled->Outgoing.SrcUsages, true);
+			dependency.dstStageMask = UsageStages(compiled->Outgoing.DstUsages);
+			dependency.dstAccessMask = UsageAccess(compiled->Outgoing.DstUsages, false);
+		}
 
 		VkRenderPassCreateInfo renderPassInfo = {};
 		renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
@@ -164,23 +358,27 @@ namespace zyh
 		renderPassInfo.pAttachments = attachments.data();
 		renderPassInfo.subpassCount = 1;
 		renderPassInfo.pSubpasses = &subpassDescription;
-		renderPassInfo.dependencyCount = 1;
-		renderPassInfo.pDependencies = &dependency;
+		renderPassInfo.dependencyCount = static_cast<uint32_t>(dependencies.size());
+		renderPassInfo.pDependencies = dependencies.data();
 
 		VK_CHECK_RESULT(vkCreateRenderPass(mVulkanLogicalDevice_->Get(), &renderPassInfo, nullptr, &mVkImpl_));
 	}
 
 	void VulkanRenderPass::cleanup()
 	{
+		SafeDestroy(mInstancer_);
 		vkDestroyRenderPass(mVulkanLogicalDevice_->Get(), mVkImpl_, nullptr);
 	}
 
-	void VulkanRenderPass::Prepare()
+	void VulkanRenderPass::Prepare(const RenderSnapshot& snapshot)
 	{
+		mSnapshot_ = &snapshot;
+		_PrepareElements();
 	}
 
-	void VulkanRenderPass::Draw()
+	void VulkanRenderPass::Draw(const RenderSnapshot& snapshot)
 	{
+		HYBRID_CHECK(mSnapshot_ == &snapshot);
 		mVKBufferBeginInfo_.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 		mVKBufferBeginInfo_.flags = 0;
 		mVKBufferBeginInfo_.pInheritanceInfo = nullptr;
@@ -190,52 +388,164 @@ namespace zyh
 		mRenderPassInfo_.framebuffer = mFrameBuffers_[GVulkanInstance->GetCurrentImage()]->Get();
 		mRenderPassInfo_.renderArea.offset = { 0, 0 };
 		mRenderPassInfo_.renderArea.extent = *(GInstance->mExtend_);
-		{
-			// set Clear Values
-			const std::vector<RenderTarget>& RenderTargets = mRenderPass_->GetWriteTargetsDesc();
-			size_t attachmentSize = RenderTargets.size();
-			const RenderTarget DepthStencil = mRenderPass_->GetDepthStencilTargetDesc();
-			if (DepthStencil)
-				attachmentSize += 1;
-			std::vector<VkClearValue> clearValues;
-			clearValues.resize(attachmentSize, {});
-			size_t index = 0;
-			for (index = 0; index < RenderTargets.size(); ++index)
-			{
-				clearValues[index].color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-				clearValues[index].depthStencil = { 1.0f, 0 };
-			}
-			++index;
-			mRenderPassInfo_.clearValueCount = static_cast<uint32_t>(clearValues.size());
-			mRenderPassInfo_.pClearValues = clearValues.data();
-		}
+		// one per attachment, used by the ones the graph clears
+		mRenderPassInfo_.clearValueCount = static_cast<uint32_t>(mClearValues_.size());
+		mRenderPassInfo_.pClearValues = mClearValues_.data();
+		// a pass is either fully inline or fully made of secondary command buffers
+		const bool recordParallel = mSortItems_.size() >= PARALLEL_RECORD_MIN_DRAWS && GVulkanInstance->mRecordingPools_->GetSlotCount() > 1;
+
 		VulkanCommand* command = GVulkanInstance->GetCommandBuffer();
 		command->begin(&mVKBufferBeginInfo_);
 		{
 			VkCommandBuffer vkCommandBuffer = command->Get();
-			vkCmdBeginRenderPass(vkCommandBuffer, &mRenderPassInfo_, VK_SUBPASS_CONTENTS_INLINE);
-			_DrawElements(vkCommandBuffer);
+			if (recordParallel)
+			{
+				vkCmdBeginRenderPass(vkCommandBuffer, &mRenderPassInfo_, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+				_RecordSecondaryElements(vkCommandBuffer);
+			}
+			else
+			{
+				vkCmdBeginRenderPass(vkCommandBuffer, &mRenderPassInfo_, VK_SUBPASS_CONTENTS_INLINE);
+				_DrawElements(vkCommandBuffer);
+			}
 			vkCmdEndRenderPass(vkCommandBuffer);
 		}
 		command->end();
 	}
 
-	void VulkanRenderPass::_DrawElements(VkCommandBuffer vkCommandBuffer)
+	void VulkanRenderPass::_PrepareElements()
 	{
+		const size_t currentImage = GVulkanInstance->GetCurrentImage();
+		mDrawEntries_.clear();
+
+		// items sharing mesh and material go to the instancer, the rest draw on their own
+		if (!mInstancer_)
+			mInstancer_ = new VulkanInstancer(this);
+		mInstancer_->Begin();
 		auto& renderSets = mRenderPass_->GetRenderSets();
+		uint32_t setOrder = 0;
 		for (const RenderSet& renderSet : renderSets)
 		{
-			std::vector<IRenderElement*> elements;
-			GEngine->Scene->GetRenderElements(renderSet, elements);
-			for (auto renderElement : elements)
+			for (const RenderItem& item : mSnapshot_->GetItems(renderSet))
 			{
-				VulkanRenderElement* element = static_cast<VulkanRenderElement*>(renderElement);
+				const VulkanDrawEntry entry{ static_cast<VulkanRenderElement*>(item.Element), &item, setOrder };
+				if (!mInstancer_->Add(entry))
+					mDrawEntries_.push_back(entry);
+			}
+			++setOrder;
+		}
+		mInstancer_->End(currentImage, *mSnapshot_, mDrawEntries_);
+
+		// entries come out in the same order while the sets are unchanged, and the keys only depend on
+		// them, the transforms and the view. descriptor set ids follow first use, so they match across images
+		bool reuseOrder = mIsSortValid_ && mSortItems_.size() == mDrawEntries_.size()
+			&& mSortedTransformGeneration_ == mSnapshot_->TransformGeneration && mSortedView_ == mSnapshot_->ViewMatrix;
+		for (const RenderSet& renderSet : renderSets)
+		{
+			reuseOrder = reuseOrder && mSortedGenerations_[renderSet] == mSnapshot_->Generations[renderSet];
+		}
+		if (reuseOrder)
+			return;
+		mSortedGenerations_ = mSnapshot_->Generations;
+		mSortedTransformGeneration_ = mSnapshot_->TransformGeneration;
+		mSortedView_ = mSnapshot_->ViewMatrix;
+		mIsSortValid_ = true;
+
+		mSortItems_.clear();
+		mPipelineIds_.Clear();
+		mMaterialIds_.Clear();
+		mDescriptorSetIds_.Clear();
+
+		// sets keep the pass order, inside a set draws are grouped by pipeline and material then front to back
+		for (uint32_t i = 0; i < mDrawEntries_.size(); ++i)
+		{
+			const VulkanDrawEntry& entry = mDrawEntries_[i];
+			VulkanRenderElement* element = entry.Element;
+			float depth = 0.f;
+			if (entry.Item)
+			{
+				// batches are set up once by the instancer
 				element->setupState(this);
-				element->draw(vkCommandBuffer, GVulkanInstance->GetCurrentImage());
+				depth = mSnapshot_->ViewMatrix.TransformPoint(entry.Item->WorldTransform.GetTranslation()).GetLength();
 			}
+			const uint64_t key = DrawSortKey::Make(
+				entry.SetOrder,
+				mPipelineIds_.Get(element->getPipeline()),
+				mMaterialIds_.Get(element->mMaterial_->getMaterial()),
+				mDescriptorSetIds_.Get(element->getDescriptorSet(currentImage)),
+				DrawSortKey::QuantizeDepth(depth)
+			);
+			mSortItems_.push_back(DrawSortItem{ key, i });
+		}
+		RadixSortDrawItems(mSortItems_, mSortScratch_);
+	}
+
+	void VulkanRenderPass::_DrawElements(VkCommandBuffer vkCommandBuffer)
+	{
+		VulkanDrawState state;
+		_RecordElements(vkCommandBuffer, 0, mSortItems_.size(), state);
+		mDrawStats_ = state.Stats;
+		mTotalDrawStats_ += state.Stats;
+		++mDrawnFrames_;
+	}
+
+	void VulkanRenderPass::_RecordElements(VkCommandBuffer vkCommandBuffer, size_t begin, size_t end, VulkanDrawState& state)
+	{
+		const size_t currentImage = GVulkanInstance->GetCurrentImage();
+		for (size_t i = begin; i < end; ++i)
+		{
+			mDrawEntries_[mSortItems_[i].Index].Element->draw(vkCommandBuffer, currentImage, state);
 		}
 	}
 
+	void VulkanRenderPass::_RecordSecondaryElements(VkCommandBuffer vkCommandBuffer)
+	{
+		VulkanRecordingPools* pools = GVulkanInstance->mRecordingPools_;
+		const size_t currentImage = GVulkanInstance->GetCurrentImage();
+		const size_t drawCount = mSortItems_.size();
+		// chunk i records with slot i, so no two chunks share a pool
+		size_t chunkCount = (drawCount + PARALLEL_RECORD_MIN_CHUNK - 1) / PARALLEL_RECORD_MIN_CHUNK;
+		chunkCount = Min(chunkCount, size_t(pools->GetSlotCount()));
+		const size_t chunkSize = (drawCount + chunkCount - 1) / chunkCount;
+		mSecondaryBuffers_.assign(chunkCount, VK_NULL_HANDLE);
+		mChunkStats_.assign(chunkCount, DrawStats{});
+
+		VkCommandBufferInheritanceInfo inheritanceInfo{};
+		inheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+		inheritanceInfo.renderPass = mVkImpl_;
+		inheritanceInfo.subpass = 0;
+		inheritanceInfo.framebuffer = mRenderPassInfo_.framebuffer;
+
+		VkCommandBufferBeginInfo beginInfo{};
+		beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+		beginInfo.flags = VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT | VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+		beginInfo.pInheritanceInfo = &inheritanceInfo;
+
+		GEngine->Jobs->ParallelFor(0, chunkCount, 1, [&](size_t first, size_t last)
+			{
+				for (size_t chunk = first; chunk < last; ++chunk)
+				{
+					VkCommandBuffer secondary = pools->Allocate(currentImage, static_cast<uint32_t>(chunk));
+					VK_CHECK_RESULT(vkBeginCommandBuffer(secondary, &beginInfo), "failed to begin recording command buffer!");
+					// nothing is inherited from the primary, every chunk binds its own state
+					VulkanDrawState state;
+					const size_t begin = chunk * chunkSize;
+					_RecordElements(secondary, begin, Min(begin + chunkSize, drawCount), state);
+					VK_CHECK_RESULT(vkEndCommandBuffer(secondary), "failed to record command buffer!");
+					mSecondaryBuffers_[chunk] = secondary;
+					mChunkStats_[chunk] = state.Stats;
+				}
+			});
+		vkCmdExecuteCommands(vkCommandBuffer, static_cast<uint32_t>(mSecondaryBuffers_.size()), mSecondaryBuffers_.data());
+
+		DrawStats stats;
+		for (const DrawStats& chunkStats : mChunkStats_)
+			stats += chunkStats;
+		mDrawStats_ = stats;
+		mTotalDrawStats_ += stats;
+		++mDrawnFrames_;
+	}
+
 	void VulkanRenderPass::InitailizeResource()
 	{
 		// create VkImage & VkImageView
@@ -245,7 +555,6 @@ namespace zyh
 		connect(GVulkanInstance->mLogicalDevice_);
 		setup();
 
-		// create FrameBuffer; TODO: optimized by FrameGraph
 		CreateFrameBuffer();
 	}
 
@@ -289,7 +598,8 @@ namespace zyh
 		{
 			VulkanRenderElement::setupState(renderPass);
 			
-			uiSettings.frameTimes[GEngine->GetCurrFrame() % uiSettings.frameTimes.size()] = GEngine->GetDeltaTime() * 1000 * (uiSettings.frameTimeMax - uiSettings.frameTimeMin) / 10.f;
+			const RenderSnapshot& snapshot = renderPass->GetSnapshot();
+			uiSettings.frameTimes[snapshot.Frame % uiSettings.frameTimes.size()] = snapshot.DeltaTime * 1000 * (uiSettings.frameTimeMax - uiSettings.frameTimeMin) / 10.f;
 
 			ImGuiIO& io = ImGui::GetIO();
 			float constantScale[2] = { 2.0f / io.DisplaySize.x, 2.0f / io.DisplaySize.y };
@@ -298,12 +608,12 @@ namespace zyh
 			mMaterial_->PushConstant("scale", &constantScale);
 			mMaterial_->PushConstant("translate", &constantTranslate);
 
-			NewFrame();
+			NewFrame(snapshot);
 			UpdateBuffers();
 		}
 
 	protected:
-		void NewFrame()
+		void NewFrame(const RenderSnapshot& snapshot)
 		{
 			ImGui_ImplVulkan_NewFrame();
 			ImGui::NewFrame();
@@ -315,10 +625,10 @@ namespace zyh
 			ImGui::PlotLines("Frame Times", &uiSettings.frameTimes[0], 50, 0, "", uiSettings.frameTimeMin, uiSettings.frameTimeMax, ImVec2(0, 80));
 			ImGui::Text("Camera");
 
-			Matrix4x3 viewMatrix = GEngine->Scene->GetCamera()->getViewMatrix();
+			const Matrix4x3& viewMatrix = snapshot.ViewMatrix;
 			float trans[3]{ viewMatrix.GetTranslation().x, viewMatrix.GetTranslation().y, viewMatrix.GetTranslation().z };
 			float rot[3]{ viewMatrix.GetPitch(), viewMatrix.GetYaw(), viewMatrix.GetRoll() };
-			float fov = GEngine->Scene->GetCamera()->getFov();
+			float fov = snapshot.Fov;
 
 			ImGui::InputFloat3("position", trans);
 			ImGui::InputFloat3("rotation", rot);
@@ -329,12 +639,23 @@ namespace zyh
 			ImGui::SetNextWindowSize(ImVec2(200, 200), ImGuiCond_FirstUseEver);
 
 			ImGui::Begin("Example settings");
-			HeightMapManipulator* heightMapManipulator = HeightMapManipulator::getInstance();
-			ImGui::Checkbox("Modify terrain", &heightMapManipulator->mEnable_);
-			if (heightMapManipulator->mEnable_)
+			// the manipulator belongs to the game thread, edits are applied there at its next sync point
+			TerrainEditSettings terrainEdit = snapshot.TerrainEdit;
+			ImGui::Checkbox("Modify terrain", &terrainEdit.Enable);
+			if (terrainEdit.Enable)
 			{
-				ImGui::SliderFloat("Modify Offset", &heightMapManipulator->modifyTerrainOffset, -10.f, 100.f);
-				ImGui::SliderFloat("Modify Range", &heightMapManipulator->modifyTerrainRange, 1.f, 100.f);
+				ImGui::SliderFloat("Modify Offset", &terrainEdit.Offset, -10.f, 100.f);
+				ImGui::SliderFloat("Modify Range", &terrainEdit.Range, 1.f, 100.f);
+			}
+			if (terrainEdit != snapshot.TerrainEdit)
+			{
+				GEngine->Scene->GetCommands().Call([terrainEdit](ClientScene&)
+					{
+						HeightMapManipulator* heightMapManipulator = HeightMapManipulator::getInstance();
+						heightMapManipulator->mEnable_ = terrainEdit.Enable;
+						heightMapManipulator->modifyTerrainOffset = terrainEdit.Offset;
+						heightMapManipulator->modifyTerrainRange = terrainEdit.Range;
+					});
 			}
 			ImGui::Checkbox("Display logos", &uiSettings.displayLogos);
 			ImGui::Checkbox("Display background", &uiSettings.displayBackground);
@@ -378,26 +699,22 @@ namespace zyh
 				mIndexBuffer_->setup(indexBufferSize, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 			}
 
-			VulkanBuffer stagingBuffer1, stagingBuffer2;
-			stagingBuffer1.connect(GVulkanInstance->mPhysicalDevice_, GVulkanInstance->mLogicalDevice_);
-			stagingBuffer1.setup(mVertexBuffer_->GetBufferSize(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-			stagingBuffer2.connect(GVulkanInstance->mPhysicalDevice_, GVulkanInstance->mLogicalDevice_);
-			stagingBuffer2.setup(mIndexBuffer_->GetBufferSize(), VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-
-			size_t vtxOffset = 0;
-			size_t idxOffset = 0;
-			for (size_t i = 0; i < imDrawData->CmdListsCount; ++i)
+			// one region per draw list, all packed into a single staging upload
+			std::vector<VulkanStagingCopy> copies;
+			copies.reserve(imDrawData->CmdListsCount * 2);
+			VkDeviceSize vtxOffset = 0;
+			VkDeviceSize idxOffset = 0;
+			for (int i = 0; i < imDrawData->CmdListsCount; ++i)
 			{
 				const ImDrawList* cmdList = imDrawData->CmdLists[i];
-				stagingBuffer1.setupData(cmdList->VtxBuffer.Data, cmdList->VtxBuffer.Size * sizeof(ImDrawVert), vtxOffset);
-				stagingBuffer2.setupData(cmdList->IdxBuffer.Data, cmdList->IdxBuffer.Size * sizeof(ImDrawIdx), idxOffset);
-				vtxOffset += cmdList->VtxBuffer.Size * sizeof(ImDrawVert);
-				idxOffset += cmdList->IdxBuffer.Size * sizeof(ImDrawIdx);
+				const VkDeviceSize vtxSize = cmdList->VtxBuffer.Size * sizeof(ImDrawVert);
+				const VkDeviceSize idxSize = cmdList->IdxBuffer.Size * sizeof(ImDrawIdx);
+				copies.push_back({ mVertexBuffer_->Get().buffer, vtxOffset, cmdList->VtxBuffer.Data, vtxSize });
+				copies.push_back({ mIndexBuffer_->Get().buffer, idxOffset, cmdList->IdxBuffer.Data, idxSize });
+				vtxOffset += vtxSize;
+				idxOffset += idxSize;
 			}
-
-			VulkanBuffer::copyBuffer(GVulkanInstance->mGraphicsCommandPool_, stagingBuffer1.Get().buffer, mVertexBuffer_->Get().buffer, mVertexBuffer_->GetBufferSize());
-			VulkanBuffer::copyBuffer(GVulkanInstance->mGraphicsCommandPool_, stagingBuffer2.Get().buffer, mIndexBuffer_->Get().buffer, mIndexBuffer_->GetBufferSize());
+			GStagingArena->Upload(GVulkanInstance->mGraphicsCommandPool_, copies);
 		}
 
 		VulkanBuffer* mVertexBuffer_{ nullptr };
@@ -415,10 +732,20 @@ namespace zyh
 		
 		mMaterial_ = new ImGuiMaterial(material);
 		mMaterial_->connect(GVulkanInstance->mPhysicalDevice_, GVulkanInstance->mLogicalDevice_, *GInstance->mImageCount_);;
+		mMaterial_->mRenderPass_ = this;
 		mMaterial_->setup();
 
 		mRenderElement_ = new ImGuiRenderElement(mMaterial_);
 
+		// the backend only wants a pool of its own, the material's sets come from GDescriptorAllocator
+		VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, *GInstance->mImageCount_ };
+		VkDescriptorPoolCreateInfo poolInfo{};
+		poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+		poolInfo.poolSizeCount = 1;
+		poolInfo.pPoolSizes = &poolSize;
+		poolInfo.maxSets = *GInstance->mImageCount_;
+		VK_CHECK_RESULT(vkCreateDescriptorPool(GVulkanInstance->mLogicalDevice_->Get(), &poolInfo, nullptr, &mDescriptorPool_), "failed to create descriptor pool!");
+
 		ImGui_ImplVulkan_InitInfo initInfo
 		{
 			GVulkanInstance->mInstance_->Get(), // VkInstance Instance;
@@ -427,7 +754,7 @@ namespace zyh
 			GVulkanInstance->mLogicalDevice_->mFamilyIndices_->getIndexByQueueFamily(GRAPHICS), //uint32_t QueueFamily;
 			GVulkanInstance->mLogicalDevice_->graphicsQueue(), //VkQueue  Queue;
 			VK_NULL_HANDLE, //VkPipelineCache PipelineCache;
-			mMaterial_->mDescriptorPool_, //VkDescriptorPool DescriptorPool;
+			mDescriptorPool_, //VkDescriptorPool DescriptorPool;
 			0, //uint32_t Subpass;
 			*GInstance->mImageCount_, // uint32_t MinImageCount;          // >= 2
 			*GInstance->mImageCount_, //Setting:: uint32_t ImageCount;             // >= MinImageCount
@@ -2,6 +2,8 @@
 #include "VulkanObject.h"
 #include "Graphics/Common/RenderResource.h"
 #include "Graphics/Common/IRenderPass.h"
+#include "Graphics/Common/RenderSnapshot.h"
+#include "Graphics/Common/DrawSortKey.h"
 
 
 namespace zyh
@@ -9,6 +11,18 @@ namespace zyh
 	class VulkanLogicalDevice;
 	class VulkanImage;
 	class VulkanFrameBuffer;
+	class IMaterial;
+	class VulkanRenderElement;
+	class VulkanInstancer;
+	struct VulkanDrawState;
+
+	// one draw of a pass, Item is null for an instanced batch drawing several items
+	struct VulkanDrawEntry
+	{
+		VulkanRenderElement* Element;
+		const RenderItem* Item;
+		uint32_t SetOrder;
+	};
 
 	class VulkanRenderTargetResource : public RenderTargetResource
 	{
@@ -22,9 +36,15 @@ namespace zyh
 
 	public:
 		virtual VkImageView GetImageView();
+		VulkanImage* GetImage() { return mImage_; }
+		// created without memory, VulkanRenderDevice::CommitRenderTargets places it
+		bool IsBound() const { return mIsBound_; }
+		void BindMemory(VkDeviceMemory memory, VkDeviceSize offset);
 
 	protected:
 		VulkanImage* mImage_;
+		VkImageAspectFlags mAspectFlags_{ 0 };
+		bool mIsBound_{ false };
 	};
 
 	class VulkanSwapchainResource : public VulkanRenderTargetResource
@@ -51,6 +71,15 @@ namespace zyh
 				return new VulkanSwapchainResource(targetDesc);
 			return new VulkanRenderTargetResource(targetDesc);
 		}
+
+		// targets whose lifetimes do not overlap share memory, single pass ones prefer lazily allocated memory
+		virtual void CommitRenderTargets(RenderGraph& graph) override;
+
+	protected:
+		VkDeviceMemory _AllocateTargetMemory(VkDeviceSize size, uint32_t memoryType);
+
+	protected:
+		std::vector<VkDeviceMemory> mTargetMemory_;
 	};
 
 	class VulkanRenderPass : public TVulkanObject<VkRenderPass>
@@ -70,11 +99,28 @@ namespace zyh
 		virtual void setup();
 		virtual void cleanup() override;
 
-		virtual void Prepare();
-		virtual void Draw();
+		// sets up and orders the elements, before the uniforms of the frame are written
+		virtual void Prepare(const RenderSnapshot& snapshot);
+		virtual void Draw(const RenderSnapshot& snapshot);
+		// frame being recorded, only valid from Prepare() to the end of Draw()
+		const RenderSnapshot& GetSnapshot() const { return *mSnapshot_; }
+		// binds / draws of the last frame, and summed over mDrawnFrames_ frames
+		const DrawStats& GetDrawStats() const { return mDrawStats_; }
+		const DrawStats& GetTotalDrawStats() const { return mTotalDrawStats_; }
+		uint64_t GetDrawnFrames() const { return mDrawnFrames_; }
+
+		// passes with at least this many draws record them in parallel into secondary command buffers
+		static constexpr size_t PARALLEL_RECORD_MIN_DRAWS = 256;
+		// smallest chunk worth a secondary command buffer of its own
+		static constexpr size_t PARALLEL_RECORD_MIN_CHUNK = 64;
 
 	protected:
+		// builds the sorted draw list of the frame in mSortItems_
+		virtual void _PrepareElements();
 		virtual void _DrawElements(VkCommandBuffer vkCommandBuffer);
+		void _RecordElements(VkCommandBuffer vkCommandBuffer, size_t begin, size_t end, VulkanDrawState& state);
+		// splits mSortItems_ into chunks recorded by the job system, executed in sort order
+		void _RecordSecondaryElements(VkCommandBuffer vkCommandBuffer);
 
 	protected:
 		VulkanLogicalDevice* mVulkanLogicalDevice_;
@@ -91,6 +137,29 @@ namespace zyh
 		std::vector<VulkanFrameBuffer*> mFrameBuffers_;
 		VkCommandBufferBeginInfo mVKBufferBeginInfo_{};
 		VkRenderPassBeginInfo mRenderPassInfo_{};
+		std::vector<VkClearValue> mClearValues_;
+		const RenderSnapshot* mSnapshot_{ nullptr };
+
+		// draw order of a frame, rebuilt by _DrawElements with reused storage
+		std::vector<VulkanDrawEntry> mDrawEntries_;
+		VulkanInstancer* mInstancer_{ nullptr };
+		std::vector<DrawSortItem> mSortItems_;
+		std::vector<DrawSortItem> mSortScratch_;
+		DrawKeyIds<VkPipeline> mPipelineIds_;
+		DrawKeyIds<const IMaterial*> mMaterialIds_;
+		DrawKeyIds<VkDescriptorSet> mDescriptorSetIds_;
+		// what mSortItems_ was built from, the order is reused while none of it changed
+		std::array<uint64_t, RENDER_SET_COUNT> mSortedGenerations_{};
+		uint64_t mSortedTransformGeneration_{ 0 };
+		Matrix4x3 mSortedView_;
+		bool mIsSortValid_{ false };
+
+		std::vector<VkCommandBuffer> mSecondaryBuffers_;
+		std::vector<DrawStats> mChunkStats_;
+
+		DrawStats mDrawStats_;
+		DrawStats mTotalDrawStats_;
+		uint64_t mDrawnFrames_{ 0 };
 	};
 
 	class VulkanImGuiRenderPass : public VulkanRenderPass
@@ -100,6 +169,7 @@ namespace zyh
 		virtual void InitailizeResource() override;
 
 	protected:
+		virtual void _PrepareElements() override {}
 		virtual void _DrawElements(VkCommandBuffer vkCommandBuffer) override;
 
 	private:
@@ -107,5 +177,6 @@ namespace zyh
 		class VulkanBuffer* mVertexBuffer_{ nullptr };
 		class VulkanBuffer* mIndexBuffer_{ nullptr };
 		class ImGuiRenderElement* mRenderElement_;
+		VkDescriptorPool mDescriptorPool_{ VK_NULL_HANDLE };
 	};
 }
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "VulkanStagingArena.h"
+#include "VulkanPhysicalDevice.h"
+#include "VulkanLogicalDevice.h"
+#include "VulkanCommandPool.h"
+
+
+namespace zyh
+{
+	VulkanStagingArena* GStagingArena = new VulkanStagingArena();
+
+	void VulkanStagingArena::setup(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice)
+	{
+		cleanup();
+		mPhysicalDevice_ = physicalDevice;
+		mLogicalDevice_ = logicalDevice;
+	}
+
+	void VulkanStagingArena::cleanup()
+	{
+		std::lock_guard<std::mutex> lock(mMutex_);
+		SafeDestroy(mBuffer_);
+		mCapacity_ = 0;
+	}
+
+	void VulkanStagingArena::Upload(VulkanCommandPool* commandPool, std::span<const VulkanStagingCopy> copies)
+	{
+		VkDeviceSize total = 0;
+		for (const VulkanStagingCopy& copy : copies)
+			total += (copy.Size + COPY_ALIGNMENT - 1) / COPY_ALIGNMENT * COPY_ALIGNMENT;
+		if (total == 0)
+			return;
+
+		// the arena is reused as soon as the copy returns, so uploads are serialized
+		std::lock_guard<std::mutex> lock(mMutex_);
+		_Reserve(total);
+
+		std::vector<VkBufferCopy> regions(copies.size());
+		VkDeviceSize offset = 0;
+		uint8_t* mapped = mBuffer_->GetMapped();
+		for (size_t i = 0; i < copies.size(); ++i)
+		{
+			const VulkanStagingCopy& copy = copies[i];
+			memcpy(mapped + offset, copy.Data, static_cast<size_t>(copy.Size));
+			regions[i].srcOffset = offset;
+			regions[i].dstOffset = copy.DstOffset;
+			regions[i].size = copy.Size;
+			offset += (copy.Size + COPY_ALIGNMENT - 1) / COPY_ALIGNMENT * COPY_ALIGNMENT;
+		}
+		mBuffer_->Flush(0, offset);
+
+		VkBuffer src = mBuffer_->Get().buffer;
+		SingleTimeExecFunc func = [&](VulkanCommand& commandBuffer)
+		{
+			for (size_t i = 0; i < copies.size(); ++i)
+			{
+				if (regions[i].size > 0)
+					vkCmdCopyBuffer(commandBuffer.Get(), src, copies[i].Dst, 1, &regions[i]);
+			}
+		};
+		commandPool->generateSingleTimeCommand(func);
+		++mUploadCount_;
+	}
+
+	void VulkanStagingArena::_Reserve(VkDeviceSize size)
+	{
+		if (mBuffer_ && size <= mCapacity_)
+			return;
+
+		VkDeviceSize capacity = Max(mCapacity_, MIN_CAPACITY);
+		while (capacity < size)
+			capacity *= 2;
+
+		SafeDestroy(mBuffer_);
+		mBuffer_ = new VulkanBuffer();
+		mBuffer_->connect(mPhysicalDevice_, mLogicalDevice_);
+		mBuffer_->setup(capacity, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		mCapacity_ = capacity;
+		++mGrowCount_;
+	}
+}
\ No newline at end of file
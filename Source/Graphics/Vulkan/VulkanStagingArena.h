@@ -0,0 +1,55 @@
+#pragma once
+#include "Common/Config.h"
+#include "VulkanBuffer.h"
+#include <mutex>
+
+
+namespace zyh
+{
+	class VulkanPhysicalDevice;
+	class VulkanLogicalDevice;
+	class VulkanCommandPool;
+
+	struct VulkanStagingCopy
+	{
+		VkBuffer Dst{ VK_NULL_HANDLE };
+		VkDeviceSize DstOffset{ 0 };
+		const void* Data{ nullptr };
+		VkDeviceSize Size{ 0 };
+	};
+
+	// one persistently mapped staging buffer reused by every device local upload. it only grows,
+	// so uploads cost a memcpy and a single copy submission instead of a buffer create / map / destroy
+	class VulkanStagingArena
+	{
+	public:
+		void setup(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice);
+		void cleanup();
+
+		// any thread: packs every copy into the arena and records them in one command buffer,
+		// returns once the copies have finished
+		void Upload(VulkanCommandPool* commandPool, std::span<const VulkanStagingCopy> copies);
+		void Upload(VulkanCommandPool* commandPool, const VulkanStagingCopy& copy) { Upload(commandPool, std::span<const VulkanStagingCopy>(&copy, 1)); }
+
+		VkDeviceSize GetCapacity() const { return mCapacity_; }
+		size_t GetUploadCount() const { return mUploadCount_; }
+		size_t GetGrowCount() const { return mGrowCount_; }
+
+	private:
+		void _Reserve(VkDeviceSize size);
+
+	private:
+		static constexpr VkDeviceSize MIN_CAPACITY = 1 << 20;
+		static constexpr VkDeviceSize COPY_ALIGNMENT = 16;
+
+		VulkanPhysicalDevice* mPhysicalDevice_{ nullptr };
+		VulkanLogicalDevice* mLogicalDevice_{ nullptr };
+		std::mutex mMutex_;
+		VulkanBuffer* mBuffer_{ nullptr };
+		VkDeviceSize mCapacity_{ 0 };
+		size_t mUploadCount_{ 0 };
+		size_t mGrowCount_{ 0 };
+	};
+
+	extern VulkanStagingArena* GStagingArena;
+}
\ No newline at end of file
@@ -10,9 +10,7 @@ namespace zyh
 	public:
 		void connect(VulkanInstance* instance);
 
-#if defined(VK_USE_PLATFORM_WIN32_KHR)
 		void setup(void* platformHandle, void* platformWindow);
-#endif
 		void cleanup() override;
 
 	private:
@@ -1,4 +1,4 @@
-#include "VulkanSwapchain.h"
+#include "VulkanSwapChain.h"
 #include "VulkanInstance.h"
 #include "VulkanPhysicalDevice.h"
 #include "VulkanLogicalDevice.h"
@@ -16,7 +16,6 @@ namespace zyh
 		mVulkanSurface_ = surface;
 	}
 
-#if defined(VK_USE_PLATFORM_WIN32_KHR)
 	void VulkanSwapchain::setup(uint32_t* width, uint32_t* height, bool vsync)
 	{
 		auto vkInstance = mVulkanInstance_->Get();
@@ -55,7 +54,6 @@ namespace zyh
 		*GInstance->mExtend_ = mExtend2D_;
 		GInstance->mExtend_.IsValid(true);
 	}
-#endif 
 
 	void VulkanSwapchain::cleanup()
 	{
@@ -28,9 +28,7 @@ namespace zyh
 	{
 	public:
 		void connect(VulkanInstance* instance, VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice, VulkanSurface* surface);
-#if defined(VK_USE_PLATFORM_WIN32_KHR)
 		void setup(uint32_t* width, uint32_t* height, bool vsync = false);
-#endif
 		void cleanup();
 		void setupFrameBuffer(VulkanRenderPass& renderPass);
 
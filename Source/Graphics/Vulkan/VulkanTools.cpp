@@ -11,6 +11,7 @@ namespace zyh
 	{
 		bool errorModeSilent = false;
 
+#if defined(_WIN32)
 		LPCWSTR stringToLPCWSTR(const std::string& orig)
 		{
 			size_t origsize = orig.length() + 1;
@@ -21,6 +22,7 @@ namespace zyh
 
 			return wcstring;
 		}
+#endif
 
 		void exitFatal(int32_t exitCode)
 		{
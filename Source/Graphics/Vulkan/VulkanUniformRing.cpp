@@ -0,0 +1,55 @@
+#include "VulkanUniformRing.h"
+#include "VulkanPhysicalDevice.h"
+#include "VulkanLogicalDevice.h"
+
+
+namespace zyh
+{
+	void VulkanUniformRing::connect(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice)
+	{
+		mPhysicalDevice_ = physicalDevice;
+		mLogicalDevice_ = logicalDevice;
+		mBuffer_.connect(physicalDevice, logicalDevice);
+	}
+
+	void VulkanUniformRing::setup(uint32_t segmentCount, VkDeviceSize segmentSize)
+	{
+		cleanup();
+
+		VkPhysicalDeviceProperties properties;
+		vkGetPhysicalDeviceProperties(mPhysicalDevice_->Get(), &properties);
+		mAlignment_ = Max(properties.limits.minUniformBufferOffsetAlignment, VkDeviceSize(1));
+		// segments start aligned too, their base goes into the descriptor's offset
+		mSegmentSize_ = (segmentSize + mAlignment_ - 1) / mAlignment_ * mAlignment_;
+
+		mBuffer_.setup(mSegmentSize_ * segmentCount, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		mMapped_ = mBuffer_.GetMapped();
+		mSegmentOffset_ = 0;
+		mHead_ = 0;
+	}
+
+	void VulkanUniformRing::cleanup()
+	{
+		mMapped_ = nullptr;
+		mBuffer_.cleanup();
+	}
+
+	void VulkanUniformRing::BeginFrame(size_t image)
+	{
+		mPeakFrameBytes_ = Max(mPeakFrameBytes_, mHead_.load());
+		mSegmentOffset_ = GetSegmentOffset(image);
+		mHead_ = 0;
+	}
+
+	uint32_t VulkanUniformRing::Push(const void* data, VkDeviceSize size, VkDeviceSize reserveSize)
+	{
+		HYBRID_CHECK(mMapped_);
+		HYBRID_CHECK(size <= reserveSize);
+		const VkDeviceSize blockSize = (reserveSize + mAlignment_ - 1) / mAlignment_ * mAlignment_;
+		const VkDeviceSize offset = mHead_.fetch_add(blockSize, std::memory_order_relaxed);
+		if (offset + blockSize > mSegmentSize_)
+			throw std::runtime_error("uniform ring segment exhausted, raise UNIFORM_RING_SEGMENT_SIZE!");
+		memcpy(mMapped_ + mSegmentOffset_ + offset, data, static_cast<size_t>(size));
+		return static_cast<uint32_t>(offset);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+#include "Common/Config.h"
+#include "VulkanBuffer.h"
+#include <atomic>
+
+
+namespace zyh
+{
+	class VulkanPhysicalDevice;
+	class VulkanLogicalDevice;
+
+	// one persistently mapped, host visible uniform buffer with a segment per swapchain image.
+	// per object uniforms are sub-allocated linearly from the segment of the frame being built and
+	// bound with dynamic offsets, so a frame's uniform upload is a stream of memcpys without driver calls
+	class VulkanUniformRing
+	{
+	public:
+		void connect(VulkanPhysicalDevice* physicalDevice, VulkanLogicalDevice* logicalDevice);
+		void setup(uint32_t segmentCount, VkDeviceSize segmentSize);
+		void cleanup();
+
+		// render thread, once the previous frame using image has finished
+		void BeginFrame(size_t image);
+		// any thread: copies size bytes into a fresh block of reserveSize in the current segment
+		// and returns its offset inside the segment, the dynamic offset to bind it with
+		uint32_t Push(const void* data, VkDeviceSize size, VkDeviceSize reserveSize);
+
+		VkBuffer GetBuffer() { return mBuffer_.Get().buffer; }
+		// descriptor offset of an image's segment, dynamic offsets are relative to it
+		VkDeviceSize GetSegmentOffset(size_t image) const { return mSegmentSize_ * image; }
+		// most bytes a single frame has used so far
+		VkDeviceSize GetPeakFrameBytes() const { return mPeakFrameBytes_; }
+
+	private:
+		VulkanPhysicalDevice* mPhysicalDevice_{ nullptr };
+		VulkanLogicalDevice* mLogicalDevice_{ nullptr };
+		VulkanBuffer mBuffer_;
+		uint8_t* mMapped_{ nullptr };
+
+		VkDeviceSize mSegmentSize_{ 0 };
+		VkDeviceSize mAlignment_{ 1 };
+		VkDeviceSize mSegmentOffset_{ 0 };
+		std::atomic<VkDeviceSize> mHead_{ 0 };
+		VkDeviceSize mPeakFrameBytes_{ 0 };
+	};
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 #include "Common/Config.h"
 #include "Vector3.h"
+#include "Matrix4x3.h"
 #include "MathUtil.h"
 
 
@@ -12,9 +13,65 @@ namespace zyh
 		Box() {}
 		Box(const Vector3& BMin, const Vector3& BMax) : mBMin_(BMin), mBMax_(BMax){}
 
+		// inverted box, use Merge to grow it
+		static Box GetEmpty() { return Box(Vector3(MAX_NUM), Vector3(-MAX_NUM)); }
+
 	public:
-		const Vector3& GetMin() { return mBMin_; }
-		const Vector3& GetMax() { return mBMax_; }
+		const Vector3& GetMin() const { return mBMin_; }
+		const Vector3& GetMax() const { return mBMax_; }
+		Vector3 GetCenter() const { return (mBMin_ + mBMax_) * 0.5f; }
+		Vector3 GetExtent() const { return (mBMax_ - mBMin_) * 0.5f; }
+		bool IsValid() const { return mBMin_.x <= mBMax_.x && mBMin_.y <= mBMax_.y && mBMin_.z <= mBMax_.z; }
+
+		bool Contains(const Vector3& p) const
+		{
+			return p.x >= mBMin_.x && p.x <= mBMax_.x
+				&& p.y >= mBMin_.y && p.y <= mBMax_.y
+				&& p.z >= mBMin_.z && p.z <= mBMax_.z;
+		}
+
+		bool Contains(const Box& rhs) const
+		{
+			return rhs.mBMin_.x >= mBMin_.x && rhs.mBMax_.x <= mBMax_.x
+				&& rhs.mBMin_.y >= mBMin_.y && rhs.mBMax_.y <= mBMax_.y
+				&& rhs.mBMin_.z >= mBMin_.z && rhs.mBMax_.z <= mBMax_.z;
+		}
+
+		bool Intersect(const Box& rhs) const
+		{
+			return rhs.mBMin_.x <= mBMax_.x && rhs.mBMax_.x >= mBMin_.x
+				&& rhs.mBMin_.y <= mBMax_.y && rhs.mBMax_.y >= mBMin_.y
+				&& rhs.mBMin_.z <= mBMax_.z && rhs.mBMax_.z >= mBMin_.z;
+		}
+
+		void Merge(const Vector3& p)
+		{
+			mBMin_ = Vector3(Min(mBMin_.x, p.x), Min(mBMin_.y, p.y), Min(mBMin_.z, p.z));
+			mBMax_ = Vector3(Max(mBMax_.x, p.x), Max(mBMax_.y, p.y), Max(mBMax_.z, p.z));
+		}
+
+		void Merge(const Box& rhs)
+		{
+			if (!rhs.IsValid())
+				return;
+			Merge(rhs.mBMin_);
+			Merge(rhs.mBMax_);
+		}
+
+		// reference: Arvo, "Transforming Axis-Aligned Bounding Boxes", Graphics Gems 1990
+		Box Transform(const Matrix4x3& mat) const
+		{
+			if (!IsValid())
+				return *this;
+			Vector3 center = mat.TransformPoint(GetCenter());
+			Vector3 extent = GetExtent();
+			Vector3 newExtent(
+				Fabs(mat.m00) * extent.x + Fabs(mat.m10) * extent.y + Fabs(mat.m20) * extent.z,
+				Fabs(mat.m01) * extent.x + Fabs(mat.m11) * extent.y + Fabs(mat.m21) * extent.z,
+				Fabs(mat.m02) * extent.x + Fabs(mat.m12) * extent.y + Fabs(mat.m22) * extent.z
+			);
+			return Box(center - newExtent, center + newExtent);
+		}
 
 	protected:
 		Vector3 mBMin_ { MIN_NUM };
@@ -0,0 +1,92 @@
+#include "Frustum.h"
+#include "SIMD.h"
+
+
+namespace zyh
+{
+	void Frustum::TestBounds(const BoundsStream& bounds, uint8_t* outVisible) const
+	{
+		TestBounds(bounds, 0, bounds.Size(), outVisible);
+	}
+
+	void Frustum::TestBounds(const BoundsStream& bounds, size_t begin, size_t end, uint8_t* outVisible) const
+	{
+		HYBRID_CHECK(begin <= end && end <= bounds.Size());
+		const size_t count = end;
+		const float* cx = bounds.CenterX.data();
+		const float* cy = bounds.CenterY.data();
+		const float* cz = bounds.CenterZ.data();
+		const float* ex = bounds.ExtentX.data();
+		const float* ey = bounds.ExtentY.data();
+		const float* ez = bounds.ExtentZ.data();
+		const float* radius = bounds.Radius.data();
+		size_t i = begin;
+
+#if defined(ZYH_SIMD_AVX)
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 vcx = _mm256_loadu_ps(cx + i), vcy = _mm256_loadu_ps(cy + i), vcz = _mm256_loadu_ps(cz + i);
+			__m256 vex = _mm256_loadu_ps(ex + i), vey = _mm256_loadu_ps(ey + i), vez = _mm256_loadu_ps(ez + i);
+			__m256 vr = _mm256_loadu_ps(radius + i);
+			__m256 outside = _mm256_setzero_ps();
+			for (const Plane& plane : mPlanes_)
+			{
+				__m256 nx = _mm256_set1_ps(plane.Normal.x), ny = _mm256_set1_ps(plane.Normal.y), nz = _mm256_set1_ps(plane.Normal.z);
+				__m256 d = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(nx, vcx), _mm256_mul_ps(ny, vcy)),
+					_mm256_add_ps(_mm256_mul_ps(nz, vcz), _mm256_set1_ps(plane.D)));
+				__m256 r = _mm256_add_ps(
+					_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(Fabs(plane.Normal.x)), vex), _mm256_mul_ps(_mm256_set1_ps(Fabs(plane.Normal.y)), vey)),
+					_mm256_mul_ps(_mm256_set1_ps(Fabs(plane.Normal.z)), vez));
+				r = _mm256_min_ps(r, vr);
+				outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(d, r), _mm256_setzero_ps(), _CMP_LT_OQ));
+			}
+			int mask = _mm256_movemask_ps(outside);
+			for (int k = 0; k < 8; ++k)
+				outVisible[i + k] = ((mask >> k) & 1) ? 0 : 1;
+		}
+#endif
+
+#if defined(ZYH_SIMD_SSE)
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 vcx = _mm_loadu_ps(cx + i), vcy = _mm_loadu_ps(cy + i), vcz = _mm_loadu_ps(cz + i);
+			__m128 vex = _mm_loadu_ps(ex + i), vey = _mm_loadu_ps(ey + i), vez = _mm_loadu_ps(ez + i);
+			__m128 vr = _mm_loadu_ps(radius + i);
+			__m128 outside = _mm_setzero_ps();
+			for (const Plane& plane : mPlanes_)
+			{
+				__m128 nx = _mm_set1_ps(plane.Normal.x), ny = _mm_set1_ps(plane.Normal.y), nz = _mm_set1_ps(plane.Normal.z);
+				__m128 d = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(nx, vcx), _mm_mul_ps(ny, vcy)),
+					_mm_add_ps(_mm_mul_ps(nz, vcz), _mm_set1_ps(plane.D)));
+				__m128 r = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_set1_ps(Fabs(plane.Normal.x)), vex), _mm_mul_ps(_mm_set1_ps(Fabs(plane.Normal.y)), vey)),
+					_mm_mul_ps(_mm_set1_ps(Fabs(plane.Normal.z)), vez));
+				r = _mm_min_ps(r, vr);
+				outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(d, r), _mm_setzero_ps()));
+			}
+			int mask = _mm_movemask_ps(outside);
+			for (int k = 0; k < 4; ++k)
+				outVisible[i + k] = ((mask >> k) & 1) ? 0 : 1;
+		}
+#endif
+
+		for (; i < count; ++i)
+		{
+			uint8_t visible = 1;
+			for (const Plane& plane : mPlanes_)
+			{
+				float d = plane.Normal.x * cx[i] + plane.Normal.y * cy[i] + plane.Normal.z * cz[i] + plane.D;
+				float r = Fabs(plane.Normal.x) * ex[i] + Fabs(plane.Normal.y) * ey[i] + Fabs(plane.Normal.z) * ez[i];
+				r = Min(r, radius[i]);
+				if (d + r < 0.f)
+				{
+					visible = 0;
+					break;
+				}
+			}
+			outVisible[i] = visible;
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,168 @@
+#pragma once
+#include "Common/Config.h"
+#include "Vector3.h"
+#include "Matrix4x3.h"
+#include "Matrix4x4.h"
+#include "Box.h"
+#include "Sphere.h"
+
+
+namespace zyh
+{
+	enum class EFrustumTest : uint8_t
+	{
+		OUTSIDE = 0,
+		INTERSECT = 1,
+		INSIDE = 2
+	};
+
+	// point p is on the positive side when Normal * p + D >= 0
+	struct Plane
+	{
+		Vector3 Normal;
+		float D{ 0.f };
+
+		Plane() = default;
+		Plane(float a, float b, float c, float d)
+		{
+			float len = Vector3(a, b, c).GetLength();
+			float invLen = IsZero(len) ? 0.f : 1.f / len;
+			Normal = Vector3(a, b, c) * invLen;
+			D = d * invLen;
+		}
+
+		float Distance(const Vector3& p) const { return Normal * p + D; }
+	};
+
+	// structure of arrays of world space bounds, laid out for batched frustum tests
+	struct BoundsStream
+	{
+		std::vector<float> CenterX, CenterY, CenterZ;
+		std::vector<float> ExtentX, ExtentY, ExtentZ;
+		std::vector<float> Radius;
+
+		size_t Size() const { return CenterX.size(); }
+
+		void Resize(size_t count)
+		{
+			CenterX.resize(count); CenterY.resize(count); CenterZ.resize(count);
+			ExtentX.resize(count); ExtentY.resize(count); ExtentZ.resize(count);
+			Radius.resize(count);
+		}
+
+		void Clear()
+		{
+			CenterX.clear(); CenterY.clear(); CenterZ.clear();
+			ExtentX.clear(); ExtentY.clear(); ExtentZ.clear();
+			Radius.clear();
+		}
+
+		// the sphere has to share the box center, an invalid one never tightens the box
+		void Add(const Box& box, const Sphere& sphere = Sphere())
+		{
+			Vector3 center = box.GetCenter();
+			Vector3 extent = box.GetExtent();
+			CenterX.push_back(center.x); CenterY.push_back(center.y); CenterZ.push_back(center.z);
+			ExtentX.push_back(extent.x); ExtentY.push_back(extent.y); ExtentZ.push_back(extent.z);
+			Radius.push_back(sphere.IsValid() ? sphere.GetRadius() : MAX_NUM);
+		}
+	};
+
+	class Frustum
+	{
+	public:
+		enum EPlane : uint8_t
+		{
+			FP_LEFT = 0,
+			FP_RIGHT = 1,
+			FP_BOTTOM = 2,
+			FP_TOP = 3,
+			FP_NEAR = 4,
+			FP_FAR = 5,
+			FP_NUM = 6
+		};
+
+	public:
+		Frustum() = default;
+
+		// row-vector convention: clip = p * view * proj, clip.z / clip.w in [0, 1]
+		Frustum(const Matrix4x3& view, const Matrix4x4& proj)
+		{
+			float m[4][4];
+			const float v[4][3] = {
+				{ view.m00, view.m01, view.m02 },
+				{ view.m10, view.m11, view.m12 },
+				{ view.m20, view.m21, view.m22 },
+				{ view.m30, view.m31, view.m32 },
+			};
+			const float p[4][4] = {
+				{ proj.m00, proj.m01, proj.m02, proj.m03 },
+				{ proj.m10, proj.m11, proj.m12, proj.m13 },
+				{ proj.m20, proj.m21, proj.m22, proj.m23 },
+				{ proj.m30, proj.m31, proj.m32, proj.m33 },
+			};
+			for (int r = 0; r < 4; ++r)
+			{
+				for (int c = 0; c < 4; ++c)
+				{
+					m[r][c] = v[r][0] * p[0][c] + v[r][1] * p[1][c] + v[r][2] * p[2][c] + (r == 3 ? p[3][c] : 0.f);
+				}
+			}
+
+			// Gribb & Hartmann: w +/- x, w +/- y, z, w - z
+			auto combine = [&m](int c, float s) {
+				return Plane(
+					m[0][3] + s * m[0][c], m[1][3] + s * m[1][c],
+					m[2][3] + s * m[2][c], m[3][3] + s * m[3][c]
+				);
+			};
+			mPlanes_[FP_LEFT] = combine(0, 1.f);
+			mPlanes_[FP_RIGHT] = combine(0, -1.f);
+			mPlanes_[FP_BOTTOM] = combine(1, 1.f);
+			mPlanes_[FP_TOP] = combine(1, -1.f);
+			mPlanes_[FP_NEAR] = Plane(m[0][2], m[1][2], m[2][2], m[3][2]);
+			mPlanes_[FP_FAR] = combine(2, -1.f);
+		}
+
+	public:
+		const Plane& GetPlane(EPlane plane) const { return mPlanes_[plane]; }
+
+		bool Contains(const Vector3& p) const
+		{
+			for (const Plane& plane : mPlanes_)
+			{
+				if (plane.Distance(p) < 0.f)
+					return false;
+			}
+			return true;
+		}
+
+		EFrustumTest Test(const Box& box) const
+		{
+			Vector3 center = box.GetCenter();
+			Vector3 extent = box.GetExtent();
+			EFrustumTest result = EFrustumTest::INSIDE;
+			for (const Plane& plane : mPlanes_)
+			{
+				float d = plane.Distance(center);
+				float r = Fabs(plane.Normal.x) * extent.x + Fabs(plane.Normal.y) * extent.y + Fabs(plane.Normal.z) * extent.z;
+				if (d + r < 0.f)
+					return EFrustumTest::OUTSIDE;
+				if (d - r < 0.f)
+					result = EFrustumTest::INTERSECT;
+			}
+			return result;
+		}
+
+		bool Intersect(const Box& box) const { return Test(box) != EFrustumTest::OUTSIDE; }
+
+		// writes 1 for every bounds not fully outside, 8(AVX) or 4(SSE) bounds per iteration.
+		// the projected radius on each plane is min(box, sphere) as both enclose the object
+		void TestBounds(const BoundsStream& bounds, uint8_t* outVisible) const;
+		// only [begin, end), outVisible is indexed the same as bounds so ranges can be tested in parallel
+		void TestBounds(const BoundsStream& bounds, size_t begin, size_t end, uint8_t* outVisible) const;
+
+	protected:
+		Plane mPlanes_[FP_NUM];
+	};
+}
\ No newline at end of file
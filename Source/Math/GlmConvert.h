@@ -0,0 +1,49 @@
+#pragma once
+#define GLM_FORCE_RADIANS
+#define GLM_FORCE_DEFAULT_ALIGNED_GENTYPES
+#define GLM_FORCE_DEPTH_ZERO_TO_ONE
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "Vector3.h"
+#include "Matrix4x3.h"
+#include "Matrix4x4.h"
+#include "Quaternion.h"
+
+
+// zyh matrices are row vector / row major, glm is column vector / column major,
+// so the memory layout is the same and the conversion is a straight copy.
+namespace zyh
+{
+	inline glm::vec3 ToGlm(const Vector3& v)
+	{
+		return glm::vec3(v.x, v.y, v.z);
+	}
+
+	inline glm::quat ToGlm(const Quaternion& q)
+	{
+		return glm::quat(q.w, q.x, q.y, q.z);
+	}
+
+	inline glm::mat4x4 ToGlm(const Matrix4x4& mat)
+	{
+		return glm::mat4x4
+		{
+			mat.m00, mat.m01, mat.m02, mat.m03,
+			mat.m10, mat.m11, mat.m12, mat.m13,
+			mat.m20, mat.m21, mat.m22, mat.m23,
+			mat.m30, mat.m31, mat.m32, mat.m33,
+		};
+	}
+
+	// avoids building the intermediate Matrix4x4
+	inline glm::mat4x4 ToGlm(const Matrix4x3& mat)
+	{
+		return glm::mat4x4
+		{
+			mat.m00, mat.m01, mat.m02, 0.f,
+			mat.m10, mat.m11, mat.m12, 0.f,
+			mat.m20, mat.m21, mat.m22, 0.f,
+			mat.m30, mat.m31, mat.m32, 1.f,
+		};
+	}
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <cmath>
 #include <tuple>
 #include <limits>
+#include <cstdint>
 
 
 namespace zyh
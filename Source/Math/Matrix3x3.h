@@ -1,5 +1,6 @@
 #pragma once
 #include "Common/Config.h"
+#include <cstring>
 #include "MathUtil.h"
 #include "Quaternion.h"
 
@@ -15,11 +16,11 @@ namespace zyh
 		{
 			float m3x3[3][3];
 		};
-		constexpr inline as_array& __array() noexcept
+		inline as_array& __array() noexcept
 		{
 			return *(as_array*)this;
 		}
-		constexpr inline const as_array& __array() const noexcept
+		inline const as_array& __array() const noexcept
 		{
 			return *(const as_array*)this;
 		}
@@ -264,7 +265,7 @@ namespace zyh
 				v.x* m02 + v.y * m12 + v.z * m22,
 			};
 		}
-		constexpr void OrthonormalizeFast() noexcept
+		void OrthonormalizeFast() noexcept
 		{
 			Vector3 x{ m00, m01, m02, };
 			Vector3 y{ m10, m11, m12, };
@@ -276,7 +277,7 @@ namespace zyh
 			m10 = y.x; m11 = y.y; m12 = y.z;
 			m20 = z.x; m21 = z.y; m22 = z.z;
 		}
-		constexpr inline Vector3 GetColumn3(int i) const noexcept
+		inline Vector3 GetColumn3(int i) const noexcept
 		{
 			HYBRID_CHECK(i < COL);
 			return Vector3{
@@ -285,7 +286,7 @@ namespace zyh
 				__array().m3x3[2][i],
 			};
 		}
-		constexpr inline const Vector3& GetRow3(int i) const noexcept
+		inline const Vector3& GetRow3(int i) const noexcept
 		{
 			HYBRID_CHECK(i < ROW);
 			return *(Vector3*)__array().m3x3[i];
@@ -294,7 +295,7 @@ namespace zyh
 		{
 			return 0 == (Fabs(1.f - m00) + Fabs(m01) + Fabs(m02) + Fabs(m10) + Fabs(1.f - m11) + Fabs(m12) + Fabs(m20) + Fabs(m21) + Fabs(1.f - m22));
 		}
-		constexpr inline int IsOrthonormal(float threshold = 0.001) const noexcept
+		inline int IsOrthonormal(float threshold = 0.001) const noexcept
 		{
 			float d0 = Fabs(GetColumn3(0) * GetColumn3(1));
 			if (d0 > threshold)
@@ -15,11 +15,11 @@ namespace zyh
 		{
 			float m4x3[4][3];
 		};
-		constexpr inline as_array& __array() noexcept
+		inline as_array& __array() noexcept
 		{
 			return *(as_array*)this;
 		}
-		constexpr inline const as_array& __array() const noexcept
+		inline const as_array& __array() const noexcept
 		{
 			return *(const as_array*)this;
 		}
@@ -34,12 +34,12 @@ namespace zyh
 		static constexpr int ROW = 4;
 		static constexpr int COL = 3;
 
-		constexpr inline const float& operator()(uint32 row, uint32 col) const noexcept
+		inline const float& operator()(uint32 row, uint32 col) const noexcept
 		{
 			HYBRID_CHECK(row < ROW&& col < COL);
 			return __array().m4x3[row][col];
 		}
-		constexpr inline float& operator()(uint32 row, uint32 col) noexcept
+		inline float& operator()(uint32 row, uint32 col) noexcept
 		{
 			HYBRID_CHECK(row < ROW&& col < COL);
 			return __array().m4x3[row][col];
@@ -84,19 +84,19 @@ namespace zyh
 			m31 = translation.y;
 			m32 = translation.z;
 		}
-		constexpr inline const Vector3& GetTranslation() const noexcept
+		inline const Vector3& GetTranslation() const noexcept
 		{
 			return *((Vector3*)(__array().m4x3[3]));
 		}
-		constexpr inline const Vector3 GetXAxis() const noexcept
+		inline const Vector3 GetXAxis() const noexcept
 		{
 			return *((Vector3*)(__array().m4x3[0]));
 		}
-		constexpr inline const Vector3 GetYAxis() const noexcept
+		inline const Vector3 GetYAxis() const noexcept
 		{
 			return *((Vector3*)(__array().m4x3[1]));
 		}
-		constexpr inline const Vector3 GetZAxis() const noexcept
+		inline const Vector3 GetZAxis() const noexcept
 		{
 			return *((Vector3*)(__array().m4x3[2]));
 		}
@@ -118,7 +118,7 @@ namespace zyh
 			m21 = v.y;
 			m22 = v.z;
 		}
-		constexpr inline Vector3 GetScale() const noexcept
+		inline Vector3 GetScale() const noexcept
 		{
 			return Vector3{
 				GetXAxis().GetLength(),
@@ -143,7 +143,7 @@ namespace zyh
 			Vector3 scale = GetScale();
 			return ATan2(m01 * scale.y, m11 * scale.x);
 		}
-		constexpr inline void SetScale(const Vector3& s) noexcept
+		inline void SetScale(const Vector3& s) noexcept
 		{
 			((Vector3*)(__array().m4x3[0]))->Normalize();
 			(*((Vector3*)(__array().m4x3[0]))) *= s.x;
@@ -239,6 +239,24 @@ namespace zyh
 			m.m30 *= idet; m.m31 *= idet; m.m32 *= idet;
 			return m;
 		}
+		// row vector convention, v * (a * b) == (v * a) * b
+		constexpr inline Matrix4x3 operator*(const Matrix4x3& rhs) const noexcept
+		{
+			return Matrix4x3{
+				m00 * rhs.m00 + m01 * rhs.m10 + m02 * rhs.m20,
+				m00 * rhs.m01 + m01 * rhs.m11 + m02 * rhs.m21,
+				m00 * rhs.m02 + m01 * rhs.m12 + m02 * rhs.m22,
+				m10 * rhs.m00 + m11 * rhs.m10 + m12 * rhs.m20,
+				m10 * rhs.m01 + m11 * rhs.m11 + m12 * rhs.m21,
+				m10 * rhs.m02 + m11 * rhs.m12 + m12 * rhs.m22,
+				m20 * rhs.m00 + m21 * rhs.m10 + m22 * rhs.m20,
+				m20 * rhs.m01 + m21 * rhs.m11 + m22 * rhs.m21,
+				m20 * rhs.m02 + m21 * rhs.m12 + m22 * rhs.m22,
+				m30 * rhs.m00 + m31 * rhs.m10 + m32 * rhs.m20 + rhs.m30,
+				m30 * rhs.m01 + m31 * rhs.m11 + m32 * rhs.m21 + rhs.m31,
+				m30 * rhs.m02 + m31 * rhs.m12 + m32 * rhs.m22 + rhs.m32
+			};
+		}
 		constexpr inline Vector4 TransformVector(const Vector4& v) const noexcept
 		{
 			return Vector4{
@@ -256,7 +274,7 @@ namespace zyh
 				v.x* m02 + v.y * m12 + v.z * m22 + m32,
 			};
 		}
-		constexpr inline void OrthonormalizeFast() noexcept
+		inline void OrthonormalizeFast() noexcept
 		{
 			Vector3 x{ m00, m01, m02, };
 			Vector3 y{ m10, m11, m12, };
@@ -268,7 +286,7 @@ namespace zyh
 			m10 = y.x; m11 = y.y; m12 = y.z;
 			m20 = z.x; m21 = z.y; m22 = z.z;
 		}
-		constexpr inline Vector3 GetColumn3(int i) const noexcept
+		inline Vector3 GetColumn3(int i) const noexcept
 		{
 			HYBRID_CHECK(i < COL);
 			return Vector3{
@@ -277,12 +295,12 @@ namespace zyh
 					__array().m4x3[2][i],
 			};
 		}
-		constexpr inline const Vector3& GetRow3(int i) const noexcept
+		inline const Vector3& GetRow3(int i) const noexcept
 		{
 			HYBRID_CHECK(i < ROW);
 			return *(Vector3*)__array().m4x3[i];
 		}
-		constexpr inline void SetRow3(int i, const Vector3& v) noexcept
+		inline void SetRow3(int i, const Vector3& v) noexcept
 		{
 			HYBRID_CHECK(i < ROW);
 
@@ -296,7 +314,7 @@ namespace zyh
 		{
 			return 0 == (Fabs(1.f - m00) + Fabs(m01) + Fabs(m02) + Fabs(m10) + Fabs(1.f - m11) + Fabs(m12) + Fabs(m20) + Fabs(m21) + Fabs(1.f - m22) + Fabs(m30) + Fabs(m31) + Fabs(m32));
 		}
-		constexpr inline int IsOrthonormal(float threshold = 0.001) const noexcept
+		inline int IsOrthonormal(float threshold = 0.001) const noexcept
 		{
 			float d0 = Fabs(GetColumn3(0) * GetColumn3(1));
 			if (d0 > threshold)
@@ -312,7 +330,7 @@ namespace zyh
 			int c = (Fabs(1 - (GetColumn3(2) * GetColumn3(2)))) < threshold;
 			return a & b & c;
 		}
-		constexpr inline int IsNormal(float threshold = 0.001) const noexcept
+		inline int IsNormal(float threshold = 0.001) const noexcept
 		{
 			int a = (Fabs(1 - (GetColumn3(0) * GetColumn3(0)))) < threshold;
 			int b = (Fabs(1 - (GetColumn3(1) * GetColumn3(1)))) < threshold;
@@ -45,5 +45,70 @@ namespace zyh
 			m20 = 0; m21 = 0; m22 = 1; m23 = 0;
 			m30 = 0; m31 = 0; m32 = 0; m33 = 1;
 		}
+		// row vector convention, v * (a * b) == (v * a) * b
+		Matrix4x4 operator*(const Matrix4x4& rhs) const noexcept
+		{
+			return Matrix4x4(
+				m00 * rhs.m00 + m01 * rhs.m10 + m02 * rhs.m20 + m03 * rhs.m30,
+				m00 * rhs.m01 + m01 * rhs.m11 + m02 * rhs.m21 + m03 * rhs.m31,
+				m00 * rhs.m02 + m01 * rhs.m12 + m02 * rhs.m22 + m03 * rhs.m32,
+				m00 * rhs.m03 + m01 * rhs.m13 + m02 * rhs.m23 + m03 * rhs.m33,
+				m10 * rhs.m00 + m11 * rhs.m10 + m12 * rhs.m20 + m13 * rhs.m30,
+				m10 * rhs.m01 + m11 * rhs.m11 + m12 * rhs.m21 + m13 * rhs.m31,
+				m10 * rhs.m02 + m11 * rhs.m12 + m12 * rhs.m22 + m13 * rhs.m32,
+				m10 * rhs.m03 + m11 * rhs.m13 + m12 * rhs.m23 + m13 * rhs.m33,
+				m20 * rhs.m00 + m21 * rhs.m10 + m22 * rhs.m20 + m23 * rhs.m30,
+				m20 * rhs.m01 + m21 * rhs.m11 + m22 * rhs.m21 + m23 * rhs.m31,
+				m20 * rhs.m02 + m21 * rhs.m12 + m22 * rhs.m22 + m23 * rhs.m32,
+				m20 * rhs.m03 + m21 * rhs.m13 + m22 * rhs.m23 + m23 * rhs.m33,
+				m30 * rhs.m00 + m31 * rhs.m10 + m32 * rhs.m20 + m33 * rhs.m30,
+				m30 * rhs.m01 + m31 * rhs.m11 + m32 * rhs.m21 + m33 * rhs.m31,
+				m30 * rhs.m02 + m31 * rhs.m12 + m32 * rhs.m22 + m33 * rhs.m32,
+				m30 * rhs.m03 + m31 * rhs.m13 + m32 * rhs.m23 + m33 * rhs.m33
+			);
+		}
+		// cofactor expansion through 2x2 sub determinants, identity if singular
+		Matrix4x4 GetInverse() const noexcept
+		{
+			const float s0 = m00 * m11 - m10 * m01;
+			const float s1 = m00 * m12 - m10 * m02;
+			const float s2 = m00 * m13 - m10 * m03;
+			const float s3 = m01 * m12 - m11 * m02;
+			const float s4 = m01 * m13 - m11 * m03;
+			const float s5 = m02 * m13 - m12 * m03;
+			const float c5 = m22 * m33 - m32 * m23;
+			const float c4 = m21 * m33 - m31 * m23;
+			const float c3 = m21 * m32 - m31 * m22;
+			const float c2 = m20 * m33 - m30 * m23;
+			const float c1 = m20 * m32 - m30 * m22;
+			const float c0 = m20 * m31 - m30 * m21;
+
+			const float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+			if (IsZero(det))
+			{
+				Matrix4x4 identity;
+				identity.SetIdentity();
+				return identity;
+			}
+			const float idet = 1.f / det;
+			return Matrix4x4(
+				(m11 * c5 - m12 * c4 + m13 * c3) * idet,
+				(-m01 * c5 + m02 * c4 - m03 * c3) * idet,
+				(m31 * s5 - m32 * s4 + m33 * s3) * idet,
+				(-m21 * s5 + m22 * s4 - m23 * s3) * idet,
+				(-m10 * c5 + m12 * c2 - m13 * c1) * idet,
+				(m00 * c5 - m02 * c2 + m03 * c1) * idet,
+				(-m30 * s5 + m32 * s2 - m33 * s1) * idet,
+				(m20 * s5 - m22 * s2 + m23 * s1) * idet,
+				(m10 * c4 - m11 * c2 + m13 * c0) * idet,
+				(-m00 * c4 + m01 * c2 - m03 * c0) * idet,
+				(m30 * s4 - m31 * s2 + m33 * s0) * idet,
+				(-m20 * s4 + m21 * s2 - m23 * s0) * idet,
+				(-m10 * c3 + m11 * c1 - m12 * c0) * idet,
+				(m00 * c3 - m01 * c1 + m02 * c0) * idet,
+				(-m30 * s3 + m31 * s1 - m32 * s0) * idet,
+				(m20 * s3 - m21 * s1 + m22 * s0) * idet
+			);
+		}
 	};
 }
\ No newline at end of file
@@ -48,7 +48,10 @@ namespace zyh
 			}
 
 			float k0, k1;
-			if (cosOmega > 0.99f)
+			// nearly parallel sinOmega loses precision, lerp instead. unnormalized it falls short of the arc by
+			// up to omega^2 / 8 (~1e-3 from cos 0.99), so the threshold is tight and the result is renormalized
+			const bool isLerp = cosOmega > 0.9995f;
+			if (isLerp)
 			{
 				k0 = 1.0f - t;
 				k1 = t;
@@ -62,7 +65,15 @@ namespace zyh
 				k1 = Sin(t * omega) * oneOverSinOmega;
 			}
 
-			return q0 * k0  + q1 * k1;
+			Quaternion result(
+				q0.x * k0 + q1x * k1,
+				q0.y * k0 + q1y * k1,
+				q0.z * k0 + q1z * k1,
+				q0.w * k0 + q1w * k1
+			);
+			if (isLerp)
+				result.Normalize();
+			return result;
 		}
 		static Quaternion Pow(const Quaternion& quat, float exponent)
 		{
@@ -91,15 +102,15 @@ namespace zyh
 
 	public: // operator
 		constexpr Quaternion operator-() { return Quaternion(-x, -y, -z, -w); }
-		constexpr Quaternion operator-(const Quaternion& quat) const { return Quaternion(x - quat.x, y - quat.y, z - quat.x, w - quat.w); }
-		constexpr Quaternion operator+(const Quaternion& quat) const { return Quaternion(x + quat.x, y + quat.y, z + quat.x, w + quat.w); }
+		constexpr Quaternion operator-(const Quaternion& quat) const { return Quaternion(x - quat.x, y - quat.y, z - quat.z, w - quat.w); }
+		constexpr Quaternion operator+(const Quaternion& quat) const { return Quaternion(x + quat.x, y + quat.y, z + quat.z, w + quat.w); }
 		constexpr Quaternion operator*(const Quaternion& quat) const // cross production
 		{ 
-			float w = w * quat.w - x * quat.x - y * quat.y - z * quat.z;
-			float x = w * quat.x + x * quat.w + y * quat.z - z * quat.y;
-			float y = w * quat.y + y * quat.w + z * quat.x - x * quat.z;
-			float z = w * quat.z + z * quat.w + x * quat.y - y * quat.x;
-			return Quaternion(x, y, z, w);
+			float nw = w * quat.w - x * quat.x - y * quat.y - z * quat.z;
+			float nx = w * quat.x + x * quat.w + y * quat.z - z * quat.y;
+			float ny = w * quat.y + y * quat.w + z * quat.x - x * quat.z;
+			float nz = w * quat.z + z * quat.w + x * quat.y - y * quat.x;
+			return Quaternion(nx, ny, nz, nw);
 		}
 		constexpr Quaternion operator*(const float scaler) const noexcept { return Quaternion(x * scaler, y * scaler, z * scaler, w * scaler); }
 		constexpr Quaternion operator/(const float scaler) const noexcept { return Quaternion(x / scaler, y / scaler, z / scaler, w / scaler); }
@@ -0,0 +1,137 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// compile time instruction set selection, falls back to scalar code
+#if defined(__AVX2__)
+	#define ZYH_SIMD_AVX2 1
+#endif
+
+#if defined(ZYH_SIMD_AVX2) || defined(__AVX__)
+	#define ZYH_SIMD_AVX 1
+#endif
+
+#if defined(__FMA__) || (defined(_MSC_VER) && defined(ZYH_SIMD_AVX2))
+	#define ZYH_SIMD_FMA 1
+#endif
+
+#if defined(ZYH_SIMD_AVX) || defined(__SSE4_1__)
+	#define ZYH_SIMD_SSE4 1
+#endif
+
+#if defined(ZYH_SIMD_AVX) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define ZYH_SIMD_SSE 1
+#endif
+
+#if defined(ZYH_SIMD_AVX)
+	#include <immintrin.h>
+#elif defined(ZYH_SIMD_SSE4)
+	#include <smmintrin.h>
+#elif defined(ZYH_SIMD_SSE)
+	#include <emmintrin.h>
+#endif
+
+#include "MathUtil.h"
+
+
+namespace zyh
+{
+	namespace SIMD
+	{
+		// min/max over xyz of positions laid out with a byte stride (e.g. pos member of a vertex struct),
+		// the SSE path reads 4 floats per position, so stride has to be at least 16 bytes
+		inline void ReduceMinMax(const void* positions, size_t count, size_t stride, float outMin[3], float outMax[3])
+		{
+			const uint8_t* data = static_cast<const uint8_t*>(positions);
+			outMin[0] = outMin[1] = outMin[2] = MAX_NUM;
+			outMax[0] = outMax[1] = outMax[2] = -MAX_NUM;
+			if (count == 0)
+				return;
+
+#if defined(ZYH_SIMD_SSE)
+			if (stride >= 4 * sizeof(float))
+			{
+				__m128 vmin = _mm_set1_ps(MAX_NUM);
+				__m128 vmax = _mm_set1_ps(-MAX_NUM);
+				size_t i = 0;
+				// two independent chains to hide latency
+				__m128 vmin1 = vmin, vmax1 = vmax;
+				for (; i + 1 < count; i += 2)
+				{
+					__m128 p0 = _mm_loadu_ps(reinterpret_cast<const float*>(data + i * stride));
+					__m128 p1 = _mm_loadu_ps(reinterpret_cast<const float*>(data + (i + 1) * stride));
+					vmin = _mm_min_ps(vmin, p0);
+					vmax = _mm_max_ps(vmax, p0);
+					vmin1 = _mm_min_ps(vmin1, p1);
+					vmax1 = _mm_max_ps(vmax1, p1);
+				}
+				if (i < count)
+				{
+					__m128 p = _mm_loadu_ps(reinterpret_cast<const float*>(data + i * stride));
+					vmin = _mm_min_ps(vmin, p);
+					vmax = _mm_max_ps(vmax, p);
+				}
+				vmin = _mm_min_ps(vmin, vmin1);
+				vmax = _mm_max_ps(vmax, vmax1);
+
+				alignas(16) float mn[4], mx[4];
+				_mm_store_ps(mn, vmin);
+				_mm_store_ps(mx, vmax);
+				for (int k = 0; k < 3; ++k)
+				{
+					outMin[k] = mn[k];
+					outMax[k] = mx[k];
+				}
+				return;
+			}
+#endif
+			for (size_t i = 0; i < count; ++i)
+			{
+				const float* p = reinterpret_cast<const float*>(data + i * stride);
+				for (int k = 0; k < 3; ++k)
+				{
+					outMin[k] = Min(outMin[k], p[k]);
+					outMax[k] = Max(outMax[k], p[k]);
+				}
+			}
+		}
+
+		// max squared distance from center over xyz of strided positions
+		inline float ReduceMaxDistanceSquared(const void* positions, size_t count, size_t stride, const float center[3])
+		{
+			const uint8_t* data = static_cast<const uint8_t*>(positions);
+			float result = 0.f;
+			size_t i = 0;
+
+#if defined(ZYH_SIMD_SSE)
+			// gather 4 positions into xxxx/yyyy/zzzz lanes
+			const __m128 cx = _mm_set1_ps(center[0]);
+			const __m128 cy = _mm_set1_ps(center[1]);
+			const __m128 cz = _mm_set1_ps(center[2]);
+			__m128 vmax = _mm_setzero_ps();
+			for (; i + 4 <= count; i += 4)
+			{
+				const float* p0 = reinterpret_cast<const float*>(data + (i + 0) * stride);
+				const float* p1 = reinterpret_cast<const float*>(data + (i + 1) * stride);
+				const float* p2 = reinterpret_cast<const float*>(data + (i + 2) * stride);
+				const float* p3 = reinterpret_cast<const float*>(data + (i + 3) * stride);
+				__m128 dx = _mm_sub_ps(_mm_setr_ps(p0[0], p1[0], p2[0], p3[0]), cx);
+				__m128 dy = _mm_sub_ps(_mm_setr_ps(p0[1], p1[1], p2[1], p3[1]), cy);
+				__m128 dz = _mm_sub_ps(_mm_setr_ps(p0[2], p1[2], p2[2], p3[2]), cz);
+				__m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+				vmax = _mm_max_ps(vmax, d2);
+			}
+			alignas(16) float mx[4];
+			_mm_store_ps(mx, vmax);
+			result = Max(mx[0], mx[1], mx[2], mx[3]);
+#endif
+			for (; i < count; ++i)
+			{
+				const float* p = reinterpret_cast<const float*>(data + i * stride);
+				float dx = p[0] - center[0], dy = p[1] - center[1], dz = p[2] - center[2];
+				result = Max(result, dx * dx + dy * dy + dz * dz);
+			}
+			return result;
+		}
+	}
+}
\ No newline at end of file
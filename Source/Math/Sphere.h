@@ -0,0 +1,34 @@
+#pragma once
+#include "Common/Config.h"
+#include "Vector3.h"
+#include "Matrix4x3.h"
+#include "MathUtil.h"
+
+
+namespace zyh
+{
+	class Sphere
+	{
+	public:
+		Sphere() {}
+		Sphere(const Vector3& center, float radius) : mCenter_(center), mRadius_(radius) {}
+
+	public:
+		const Vector3& GetCenter() const { return mCenter_; }
+		float GetRadius() const { return mRadius_; }
+		bool IsValid() const { return mRadius_ >= 0.f; }
+
+		// non-uniform scale takes the largest axis, so the result still bounds the transformed sphere
+		Sphere Transform(const Matrix4x3& mat) const
+		{
+			if (!IsValid())
+				return *this;
+			Vector3 scale = mat.GetScale();
+			return Sphere(mat.TransformPoint(mCenter_), mRadius_ * Max(scale.x, scale.y, scale.z));
+		}
+
+	protected:
+		Vector3 mCenter_;
+		float mRadius_{ -1.f };
+	};
+}
\ No newline at end of file
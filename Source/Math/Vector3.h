@@ -9,7 +9,7 @@ namespace zyh
 	public: // static method
 		static float dot(const Vector3& lhs, const Vector3& rhs) 
 		{
-			return lhs * rhs;
+			return lhs.x * rhs.x + lhs.y * rhs.y + lhs.z * rhs.z;
 		}
 		static Vector3 cross(const Vector3& lhs, const Vector3& rhs)
 		{
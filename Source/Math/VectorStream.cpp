@@ -0,0 +1,371 @@
+#include "VectorStream.h"
+#include "SIMD.h"
+
+
+namespace zyh
+{
+	namespace
+	{
+		// every kernel is written once against these wrappers and instantiated per instruction set
+		struct ScalarOps
+		{
+			using Type = float;
+			static constexpr size_t Width = 1;
+			static Type Load(const float* p) { return *p; }
+			static void Store(float* p, Type v) { *p = v; }
+			static Type Set1(float v) { return v; }
+			static Type Add(Type a, Type b) { return a + b; }
+			static Type Sub(Type a, Type b) { return a - b; }
+			static Type Mul(Type a, Type b) { return a * b; }
+			static Type MulAdd(Type a, Type b, Type c) { return a * b + c; }
+			static Type Div(Type a, Type b) { return a / b; }
+			static Type Sqrt(Type a) { return zyh::Sqrt(a); }
+			static Type Abs(Type a) { return Fabs(a); }
+			static Type Max(Type a, Type b) { return zyh::Max(a, b); }
+			// a > 0 ? b : c
+			static Type SelectPositive(Type a, Type b, Type c) { return a > 0.f ? b : c; }
+		};
+
+#if defined(ZYH_SIMD_SSE)
+		struct SSEOps
+		{
+			using Type = __m128;
+			static constexpr size_t Width = 4;
+			static Type Load(const float* p) { return _mm_loadu_ps(p); }
+			static void Store(float* p, Type v) { _mm_storeu_ps(p, v); }
+			static Type Set1(float v) { return _mm_set1_ps(v); }
+			static Type Add(Type a, Type b) { return _mm_add_ps(a, b); }
+			static Type Sub(Type a, Type b) { return _mm_sub_ps(a, b); }
+			static Type Mul(Type a, Type b) { return _mm_mul_ps(a, b); }
+			static Type MulAdd(Type a, Type b, Type c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+			static Type Div(Type a, Type b) { return _mm_div_ps(a, b); }
+			static Type Sqrt(Type a) { return _mm_sqrt_ps(a); }
+			static Type Abs(Type a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+			static Type Max(Type a, Type b) { return _mm_max_ps(a, b); }
+			static Type SelectPositive(Type a, Type b, Type c)
+			{
+				Type mask = _mm_cmpgt_ps(a, _mm_setzero_ps());
+#if defined(ZYH_SIMD_SSE4)
+				return _mm_blendv_ps(c, b, mask);
+#else
+				return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, c));
+#endif
+			}
+		};
+#endif
+
+#if defined(ZYH_SIMD_AVX)
+		struct AVXOps
+		{
+			using Type = __m256;
+			static constexpr size_t Width = 8;
+			static Type Load(const float* p) { return _mm256_loadu_ps(p); }
+			static void Store(float* p, Type v) { _mm256_storeu_ps(p, v); }
+			static Type Set1(float v) { return _mm256_set1_ps(v); }
+			static Type Add(Type a, Type b) { return _mm256_add_ps(a, b); }
+			static Type Sub(Type a, Type b) { return _mm256_sub_ps(a, b); }
+			static Type Mul(Type a, Type b) { return _mm256_mul_ps(a, b); }
+			static Type MulAdd(Type a, Type b, Type c)
+			{
+#if defined(ZYH_SIMD_FMA)
+				return _mm256_fmadd_ps(a, b, c);
+#else
+				return _mm256_add_ps(_mm256_mul_ps(a, b), c);
+#endif
+			}
+			static Type Div(Type a, Type b) { return _mm256_div_ps(a, b); }
+			static Type Sqrt(Type a) { return _mm256_sqrt_ps(a); }
+			static Type Abs(Type a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+			static Type Max(Type a, Type b) { return _mm256_max_ps(a, b); }
+			static Type SelectPositive(Type a, Type b, Type c)
+			{
+				return _mm256_blendv_ps(c, b, _mm256_cmp_ps(a, _mm256_setzero_ps(), _CMP_GT_OQ));
+			}
+		};
+#endif
+
+		// each kernel processes [begin, end) with end rounded down to the op width and returns end
+		template<typename Ops>
+		size_t TransformPointsImpl(const Matrix4x3& m, const float* x, const float* y, const float* z, float* ox, float* oy, float* oz, size_t begin, size_t count)
+		{
+			using T = typename Ops::Type;
+			const T m00 = Ops::Set1(m.m00), m01 = Ops::Set1(m.m01), m02 = Ops::Set1(m.m02);
+			const T m10 = Ops::Set1(m.m10), m11 = Ops::Set1(m.m11), m12 = Ops::Set1(m.m12);
+			const T m20 = Ops::Set1(m.m20), m21 = Ops::Set1(m.m21), m22 = Ops::Set1(m.m22);
+			const T m30 = Ops::Set1(m.m30), m31 = Ops::Set1(m.m31), m32 = Ops::Set1(m.m32);
+			size_t i = begin;
+			for (; i + Ops::Width <= count; i += Ops::Width)
+			{
+				T vx = Ops::Load(x + i), vy = Ops::Load(y + i), vz = Ops::Load(z + i);
+				T rx = Ops::MulAdd(vz, m20, Ops::MulAdd(vy, m10, Ops::MulAdd(vx, m00, m30)));
+				T ry = Ops::MulAdd(vz, m21, Ops::MulAdd(vy, m11, Ops::MulAdd(vx, m01, m31)));
+				T rz = Ops::MulAdd(vz, m22, Ops::MulAdd(vy, m12, Ops::MulAdd(vx, m02, m32)));
+				Ops::Store(ox + i, rx); Ops::Store(oy + i, ry); Ops::Store(oz + i, rz);
+			}
+			return i;
+		}
+
+		template<typename Ops>
+		size_t TransformVectorsImpl(const Matrix4x3& m, const float* x, const float* y, const float* z, float* ox, float* oy, float* oz, size_t begin, size_t count)
+		{
+			using T = typename Ops::Type;
+			const T m00 = Ops::Set1(m.m00), m01 = Ops::Set1(m.m01), m02 = Ops::Set1(m.m02);
+			const T m10 = Ops::Set1(m.m10), m11 = Ops::Set1(m.m11), m12 = Ops::Set1(m.m12);
+			const T m20 = Ops::Set1(m.m20), m21 = Ops::Set1(m.m21), m22 = Ops::Set1(m.m22);
+			size_t i = begin;
+			for (; i + Ops::Width <= count; i += Ops::Width)
+			{
+				T vx = Ops::Load(x + i), vy = Ops::Load(y + i), vz = Ops::Load(z + i);
+				T rx = Ops::MulAdd(vz, m20, Ops::MulAdd(vy, m10, Ops::Mul(vx, m00)));
+				T ry = Ops::MulAdd(vz, m21, Ops::MulAdd(vy, m11, Ops::Mul(vx, m01)));
+				T rz = Ops::MulAdd(vz, m22, Ops::MulAdd(vy, m12, Ops::Mul(vx, m02)));
+				Ops::Store(ox + i, rx); Ops::Store(oy + i, ry); Ops::Store(oz + i, rz);
+			}
+			return i;
+		}
+
+		template<typename Ops>
+		size_t DotImpl(const Vector3Stream& a, const Vector3Stream& b, float* out, size_t begin, size_t count)
+		{
+			using T = typename Ops::Type;
+			size_t i = begin;
+			for (; i + Ops::Width <= count; i += Ops::Width)
+			{
+				T d = Ops::Mul(Ops::Load(a.X() + i), Ops::Load(b.X() + i));
+				d = Ops::MulAdd(Ops::Load(a.Y() + i), Ops::Load(b.Y() + i), d);
+				d = Ops::MulAdd(Ops::Load(a.Z() + i), Ops::Load(b.Z() + i), d);
+				Ops::Store(out + i, d);
+			}
+			return i;
+		}
+
+		template<typename Ops>
+		size_t CrossImpl(const Vector3Stream& a, const Vector3Stream& b, Vector3Stream& out, size_t begin, size_t count)
+		{
+			using T = typename Ops::Type;
+			size_t i = begin;
+			for (; i + Ops::Width <= count; i += Ops::Width)
+			{
+				T ax = Ops::Load(a.X() + i), ay = Ops::Load(a.Y() + i), az = Ops::Load(a.Z() + i);
+				T bx = Ops::Load(b.X() + i), by = Ops::Load(b.Y() + i), bz = Ops::Load(b.Z() + i);
+				T rx = Ops::Sub(Ops::Mul(ay, bz), Ops::Mul(az, by));
+				T ry = Ops::Sub(Ops::Mul(az, bx), Ops::Mul(ax, bz));
+				T rz = Ops::Sub(Ops::Mul(ax, by), Ops::Mul(ay, bx));
+				Ops::Store(out.X() + i, rx); Ops::Store(out.Y() + i, ry); Ops::Store(out.Z() + i, rz);
+			}
+			return i;
+		}
+
+		template<typename Ops>
+		size_t NormalizeImpl(const Vector3Stream& v, Vector3Stream& out, size_t begin, size_t count)
+		{
+			using T = typename Ops::Type;
+			const T one = Ops::Set1(1.f);
+			size_t i = begin;
+			for (; i + Ops::Width <= count; i += Ops::Width)
+			{
+				T x = Ops::Load(v.X() + i), y = Ops::Load(v.Y() + i), z = Ops::Load(v.Z() + i);
+				T magSqr = Ops::Add(Ops::Add(Ops::Mul(x, x), Ops::Mul(y, y)), Ops::Mul(z, z));
+				T scale = Ops::SelectPositive(magSqr, Ops::Div(one, Ops::Sqrt(magSqr)), one);
+				Ops::Store(out.X() + i, Ops::Mul(x, scale));
+				Ops::Store(out.Y() + i, Ops::Mul(y, scale));
+				Ops::Store(out.Z() + i, Ops::Mul(z, scale));
+			}
+			return i;
+		}
+
+		template<typename Ops>
+		size_t TransformBoundsImpl(const Matrix4x3& m, float radiusScale, const BoundsStream& in, BoundsStream& out, size_t begin, size_t count)
+		{
+			using T = typename Ops::Type;
+			const T a00 = Ops::Set1(Fabs(m.m00)), a01 = Ops::Set1(Fabs(m.m01)), a02 = Ops::Set1(Fabs(m.m02));
+			const T a10 = Ops::Set1(Fabs(m.m10)), a11 = Ops::Set1(Fabs(m.m11)), a12 = Ops::Set1(Fabs(m.m12));
+			const T a20 = Ops::Set1(Fabs(m.m20)), a21 = Ops::Set1(Fabs(m.m21)), a22 = Ops::Set1(Fabs(m.m22));
+			const T scale = Ops::Set1(radiusScale);
+			size_t i = TransformPointsImpl<Ops>(m, in.CenterX.data(), in.CenterY.data(), in.CenterZ.data(),
+				out.CenterX.data(), out.CenterY.data(), out.CenterZ.data(), begin, count);
+			for (size_t j = begin; j < i; j += Ops::Width)
+			{
+				T ex = Ops::Load(in.ExtentX.data() + j), ey = Ops::Load(in.ExtentY.data() + j), ez = Ops::Load(in.ExtentZ.data() + j);
+				T rx = Ops::MulAdd(ez, a20, Ops::MulAdd(ey, a10, Ops::Mul(ex, a00)));
+				T ry = Ops::MulAdd(ez, a21, Ops::MulAdd(ey, a11, Ops::Mul(ex, a01)));
+				T rz = Ops::MulAdd(ez, a22, Ops::MulAdd(ey, a12, Ops::Mul(ex, a02)));
+				Ops::Store(out.ExtentX.data() + j, rx);
+				Ops::Store(out.ExtentY.data() + j, ry);
+				Ops::Store(out.ExtentZ.data() + j, rz);
+				Ops::Store(out.Radius.data() + j, Ops::Mul(Ops::Load(in.Radius.data() + j), scale));
+			}
+			return i;
+		}
+
+		void MultiplyAffineIndexedScalar(const Matrix4x3* lhs, const Matrix4x3* rhs, Matrix4x3* out, const uint32_t* indices, const uint32_t* rhsIndices, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+				out[indices[i]] = lhs[indices[i]] * rhs[rhsIndices[i]];
+		}
+
+#if defined(ZYH_SIMD_SSE)
+		static_assert(sizeof(Matrix4x3) == Matrix4x3::DIMENSION * sizeof(float));
+
+		// one matrix at a time with a row per register, the matrices are scattered so there is nothing to gain from
+		// transposing them into lanes. Rows are read and written 4 floats wide, the 4th float belongs to the next row
+		// and is overwritten right after, the last row is shifted so nothing outside the matrix is touched.
+		void MultiplyAffineIndexedSSE(const Matrix4x3* lhs, const Matrix4x3* rhs, Matrix4x3* out, const uint32_t* indices, const uint32_t* rhsIndices, size_t count)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				const float* a = reinterpret_cast<const float*>(lhs + indices[i]);
+				const float* b = reinterpret_cast<const float*>(rhs + rhsIndices[i]);
+				float* o = reinterpret_cast<float*>(out + indices[i]);
+
+				const __m128 b0 = _mm_loadu_ps(b + 0);
+				const __m128 b1 = _mm_loadu_ps(b + 3);
+				const __m128 b2 = _mm_loadu_ps(b + 6);
+				const __m128 b8 = _mm_loadu_ps(b + 8);
+				const __m128 b3 = _mm_shuffle_ps(b8, b8, _MM_SHUFFLE(3, 3, 2, 1));
+
+				__m128 c[4];
+				for (int row = 0; row < 4; ++row)
+				{
+					c[row] = _mm_add_ps(_mm_add_ps(
+						_mm_mul_ps(_mm_set1_ps(a[row * 3 + 0]), b0),
+						_mm_mul_ps(_mm_set1_ps(a[row * 3 + 1]), b1)),
+						_mm_mul_ps(_mm_set1_ps(a[row * 3 + 2]), b2));
+				}
+				c[3] = _mm_add_ps(c[3], b3);
+
+				_mm_storeu_ps(o + 0, c[0]);
+				_mm_storeu_ps(o + 3, c[1]);
+				_mm_storeu_ps(o + 6, c[2]);
+				// (c2.z, c3.x, c3.y, c3.z) to floats 8..11
+				const __m128 t = _mm_shuffle_ps(c[2], c[3], _MM_SHUFFLE(0, 0, 2, 2));
+				_mm_storeu_ps(o + 8, _mm_shuffle_ps(t, c[3], _MM_SHUFFLE(2, 1, 2, 0)));
+			}
+		}
+#endif
+
+		// widest available instruction set first, then narrower ones for the tail
+		template<template<typename> class TKernel, typename... Args>
+		void Dispatch(size_t count, Args&&... args)
+		{
+			size_t i = 0;
+#if defined(ZYH_SIMD_AVX)
+			i = TKernel<AVXOps>::Run(args..., i, count);
+#endif
+#if defined(ZYH_SIMD_SSE)
+			i = TKernel<SSEOps>::Run(args..., i, count);
+#endif
+			TKernel<ScalarOps>::Run(args..., i, count);
+		}
+
+#define ZYH_STREAM_KERNEL(NAME) \
+		template<typename Ops> struct NAME##Kernel { template<typename... Args> static size_t Run(Args&&... args) { return NAME##Impl<Ops>(args...); } };
+
+		ZYH_STREAM_KERNEL(TransformPoints)
+		ZYH_STREAM_KERNEL(TransformVectors)
+		ZYH_STREAM_KERNEL(Dot)
+		ZYH_STREAM_KERNEL(Cross)
+		ZYH_STREAM_KERNEL(Normalize)
+		ZYH_STREAM_KERNEL(TransformBounds)
+
+#undef ZYH_STREAM_KERNEL
+
+		float MaxAxisScale(const Matrix4x3& mat)
+		{
+			Vector3 scale = mat.GetScale();
+			return Max(scale.x, scale.y, scale.z);
+		}
+	}
+
+	namespace VectorStream
+	{
+		void TransformPoints(const Matrix4x3& mat, const Vector3Stream& points, Vector3Stream& outPoints)
+		{
+			outPoints.Resize(points.Size());
+			Dispatch<TransformPointsKernel>(points.Size(), mat, points.X(), points.Y(), points.Z(), outPoints.X(), outPoints.Y(), outPoints.Z());
+		}
+
+		void TransformVectors(const Matrix4x3& mat, const Vector3Stream& vectors, Vector3Stream& outVectors)
+		{
+			outVectors.Resize(vectors.Size());
+			Dispatch<TransformVectorsKernel>(vectors.Size(), mat, vectors.X(), vectors.Y(), vectors.Z(), outVectors.X(), outVectors.Y(), outVectors.Z());
+		}
+
+		void Dot(const Vector3Stream& lhs, const Vector3Stream& rhs, float* outDots)
+		{
+			HYBRID_CHECK(lhs.Size() == rhs.Size());
+			Dispatch<DotKernel>(lhs.Size(), lhs, rhs, outDots);
+		}
+
+		void Cross(const Vector3Stream& lhs, const Vector3Stream& rhs, Vector3Stream& outCross)
+		{
+			HYBRID_CHECK(lhs.Size() == rhs.Size());
+			outCross.Resize(lhs.Size());
+			Dispatch<CrossKernel>(lhs.Size(), lhs, rhs, outCross);
+		}
+
+		void Normalize(const Vector3Stream& vectors, Vector3Stream& outVectors)
+		{
+			outVectors.Resize(vectors.Size());
+			Dispatch<NormalizeKernel>(vectors.Size(), vectors, outVectors);
+		}
+
+		void TransformBounds(const Matrix4x3& mat, const BoundsStream& bounds, BoundsStream& outBounds)
+		{
+			outBounds.Resize(bounds.Size());
+			Dispatch<TransformBoundsKernel>(bounds.Size(), mat, MaxAxisScale(mat), bounds, outBounds);
+		}
+
+		void MultiplyAffineIndexed(const Matrix4x3* lhs, const Matrix4x3* rhs, Matrix4x3* out, const uint32_t* indices, const uint32_t* rhsIndices, size_t count)
+		{
+#if defined(ZYH_SIMD_SSE)
+			MultiplyAffineIndexedSSE(lhs, rhs, out, indices, rhsIndices, count);
+#else
+			MultiplyAffineIndexedScalar(lhs, rhs, out, indices, rhsIndices, count);
+#endif
+		}
+
+		namespace Scalar
+		{
+			void TransformPoints(const Matrix4x3& mat, const Vector3Stream& points, Vector3Stream& outPoints)
+			{
+				outPoints.Resize(points.Size());
+				TransformPointsImpl<ScalarOps>(mat, points.X(), points.Y(), points.Z(), outPoints.X(), outPoints.Y(), outPoints.Z(), 0, points.Size());
+			}
+
+			void TransformVectors(const Matrix4x3& mat, const Vector3Stream& vectors, Vector3Stream& outVectors)
+			{
+				outVectors.Resize(vectors.Size());
+				TransformVectorsImpl<ScalarOps>(mat, vectors.X(), vectors.Y(), vectors.Z(), outVectors.X(), outVectors.Y(), outVectors.Z(), 0, vectors.Size());
+			}
+
+			void Dot(const Vector3Stream& lhs, const Vector3Stream& rhs, float* outDots)
+			{
+				DotImpl<ScalarOps>(lhs, rhs, outDots, 0, lhs.Size());
+			}
+
+			void Cross(const Vector3Stream& lhs, const Vector3Stream& rhs, Vector3Stream& outCross)
+			{
+				outCross.Resize(lhs.Size());
+				CrossImpl<ScalarOps>(lhs, rhs, outCross, 0, lhs.Size());
+			}
+
+			void Normalize(const Vector3Stream& vectors, Vector3Stream& outVectors)
+			{
+				outVectors.Resize(vectors.Size());
+				NormalizeImpl<ScalarOps>(vectors, outVectors, 0, vectors.Size());
+			}
+
+			void TransformBounds(const Matrix4x3& mat, const BoundsStream& bounds, BoundsStream& outBounds)
+			{
+				outBounds.Resize(bounds.Size());
+				TransformBoundsImpl<ScalarOps>(mat, MaxAxisScale(mat), bounds, outBounds, 0, bounds.Size());
+			}
+
+			void MultiplyAffineIndexed(const Matrix4x3* lhs, const Matrix4x3* rhs, Matrix4x3* out, const uint32_t* indices, const uint32_t* rhsIndices, size_t count)
+			{
+				MultiplyAffineIndexedScalar(lhs, rhs, out, indices, rhsIndices, count);
+			}
+		}
+	}
+}
\ No newline at end of file
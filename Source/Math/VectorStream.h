@@ -0,0 +1,65 @@
+#pragma once
+#include "Common/Config.h"
+#include "Vector3.h"
+#include "Matrix4x3.h"
+#include "Frustum.h"
+
+
+namespace zyh
+{
+	// structure of arrays of Vector3, consumed by the batched kernels below
+	class Vector3Stream
+	{
+	public:
+		Vector3Stream() = default;
+		explicit Vector3Stream(size_t count) { Resize(count); }
+
+	public:
+		size_t Size() const { return mX_.size(); }
+		void Resize(size_t count) { mX_.resize(count); mY_.resize(count); mZ_.resize(count); }
+		void Clear() { mX_.clear(); mY_.clear(); mZ_.clear(); }
+
+		void PushBack(const Vector3& v) { mX_.push_back(v.x); mY_.push_back(v.y); mZ_.push_back(v.z); }
+		void Set(size_t i, const Vector3& v) { mX_[i] = v.x; mY_[i] = v.y; mZ_[i] = v.z; }
+		Vector3 Get(size_t i) const { return Vector3(mX_[i], mY_[i], mZ_[i]); }
+
+		float* X() { return mX_.data(); }
+		float* Y() { return mY_.data(); }
+		float* Z() { return mZ_.data(); }
+		const float* X() const { return mX_.data(); }
+		const float* Y() const { return mY_.data(); }
+		const float* Z() const { return mZ_.data(); }
+
+	protected:
+		std::vector<float> mX_, mY_, mZ_;
+	};
+
+	// Batched kernels, the instruction set is chosen at compile time (see SIMD.h).
+	// Output streams are resized to match the input, in place use (out == in) is allowed.
+	namespace VectorStream
+	{
+		void TransformPoints(const Matrix4x3& mat, const Vector3Stream& points, Vector3Stream& outPoints);
+		void TransformVectors(const Matrix4x3& mat, const Vector3Stream& vectors, Vector3Stream& outVectors);
+		void Dot(const Vector3Stream& lhs, const Vector3Stream& rhs, float* outDots);
+		void Cross(const Vector3Stream& lhs, const Vector3Stream& rhs, Vector3Stream& outCross);
+		// zero length vectors are left untouched, same as Vector3::Normalize
+		void Normalize(const Vector3Stream& vectors, Vector3Stream& outVectors);
+		// Arvo's method on center/extent, radius is scaled by the largest axis scale
+		void TransformBounds(const Matrix4x3& mat, const BoundsStream& bounds, BoundsStream& outBounds);
+		// out[indices[i]] = lhs[indices[i]] * rhs[rhsIndices[i]], e.g. world = local * parentWorld for one hierarchy level,
+		// out may be rhs as long as no entry of indices appears in rhsIndices
+		void MultiplyAffineIndexed(const Matrix4x3* lhs, const Matrix4x3* rhs, Matrix4x3* out, const uint32_t* indices, const uint32_t* rhsIndices, size_t count);
+
+		// reference implementations, always scalar
+		namespace Scalar
+		{
+			void TransformPoints(const Matrix4x3& mat, const Vector3Stream& points, Vector3Stream& outPoints);
+			void TransformVectors(const Matrix4x3& mat, const Vector3Stream& vectors, Vector3Stream& outVectors);
+			void Dot(const Vector3Stream& lhs, const Vector3Stream& rhs, float* outDots);
+			void Cross(const Vector3Stream& lhs, const Vector3Stream& rhs, Vector3Stream& outCross);
+			void Normalize(const Vector3Stream& vectors, Vector3Stream& outVectors);
+			void TransformBounds(const Matrix4x3& mat, const BoundsStream& bounds, BoundsStream& outBounds);
+			void MultiplyAffineIndexed(const Matrix4x3* lhs, const Matrix4x3* rhs, Matrix4x3* out, const uint32_t* indices, const uint32_t* rhsIndices, size_t count);
+		}
+	}
+}
\ No newline at end of file
@@ -1,11 +1,48 @@
+#if defined(_MSC_VER)
 #pragma comment(linker, "/subsystem:console")
+#endif
 #include <iostream>
 #include "Core/Engine.h"
 #include "Core/EventHelper.h"
+#include "Common/Setting.h"
 
 
-int main()
+// --headless --frames N --capture frame.ppm --width W --height H --pipeline-cache path
+// --fixed-timestep seconds --max-fps N
+static void ParseCommandLine(int argc, char** argv)
 {
+	for (int i = 1; i < argc; ++i)
+	{
+		const std::string arg = argv[i];
+		const bool hasValue = i + 1 < argc;
+		if (arg == "--headless")
+			Setting::IsHeadless = true;
+		else if (arg == "--frames" && hasValue)
+			Setting::FrameCount = std::stoull(argv[++i]);
+		else if (arg == "--capture" && hasValue)
+			Setting::CapturePath = argv[++i];
+		else if (arg == "--width" && hasValue)
+			Setting::AppWidth = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--height" && hasValue)
+			Setting::AppHeight = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (arg == "--pipeline-cache" && hasValue)
+			Setting::PipelineCachePath = argv[++i];
+		else if (arg == "--fixed-timestep" && hasValue)
+			Setting::FixedTimestep = std::stof(argv[++i]);
+		else if (arg == "--max-fps" && hasValue)
+			Setting::MaxFrameRate = std::stof(argv[++i]);
+		else
+			std::cerr << "unknown argument: " << arg << std::endl;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	ParseCommandLine(argc, argv);
+#if !defined(_WIN32)
+	// only the Win32 window and surface exist, run offscreen elsewhere
+	Setting::IsHeadless = true;
+#endif
 
 	zyh::GEngine->Run();
 